@@ -5,6 +5,7 @@
 #include <crypto/sha256.h>
 #include <crypto/common.h>
 
+#include <algorithm>
 #include <assert.h>
 #include <string.h>
 
@@ -22,11 +23,13 @@ void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks);
 namespace sha256d64_sse41
 {
 void Transform_4way(unsigned char* out, const unsigned char* in);
+void TransformState_4way(uint32_t* s, const unsigned char* in);
 }
 
 namespace sha256d64_avx2
 {
 void Transform_8way(unsigned char* out, const unsigned char* in);
+void TransformState_8way(uint32_t* s, const unsigned char* in);
 }
 
 namespace sha256d64_shani
@@ -416,6 +419,7 @@ void TransformD64(unsigned char* out, const unsigned char* in)
 
 typedef void (*TransformType)(uint32_t*, const unsigned char*, size_t);
 typedef void (*TransformD64Type)(unsigned char*, const unsigned char*);
+typedef void (*TransformStateType)(uint32_t*, const unsigned char*);
 
 template<TransformType tr>
 void TransformD64Wrapper(unsigned char* out, const unsigned char* in)
@@ -461,6 +465,8 @@ TransformD64Type TransformD64 = sha256::TransformD64;
 TransformD64Type TransformD64_2way = nullptr;
 TransformD64Type TransformD64_4way = nullptr;
 TransformD64Type TransformD64_8way = nullptr;
+TransformStateType TransformState_4way = nullptr;
+TransformStateType TransformState_8way = nullptr;
 
 [[maybe_unused]]
 bool SelfTest() {
@@ -545,6 +551,28 @@ bool SelfTest() {
         if (!std::equal(out_8way, out_8way + 256, result_d64)) return false;
     }
 
+    // Test the multi-lane state transforms against Transform(), giving each
+    // lane a different state and block.
+    uint32_t lane_states[64];
+    uint32_t expected_states[64];
+    for (size_t lane = 0; lane < 8; ++lane) {
+        std::copy(result[lane], result[lane] + 8, lane_states + lane * 8);
+        std::copy(result[lane], result[lane] + 8, expected_states + lane * 8);
+        Transform(expected_states + lane * 8, data + 1 + lane * 64, 1);
+    }
+    if (TransformState_4way) {
+        uint32_t states[32];
+        std::copy(lane_states, lane_states + 32, states);
+        TransformState_4way(states, data + 1);
+        if (!std::equal(states, states + 32, expected_states)) return false;
+    }
+    if (TransformState_8way) {
+        uint32_t states[64];
+        std::copy(lane_states, lane_states + 64, states);
+        TransformState_8way(states, data + 1);
+        if (!std::equal(states, states + 64, expected_states)) return false;
+    }
+
     return true;
 }
 
@@ -612,6 +640,7 @@ std::string SHA256AutoDetect()
 #endif
 #if defined(ENABLE_SSE41) && !defined(BUILD_BITCOIN_INTERNAL)
         TransformD64_4way = sha256d64_sse41::Transform_4way;
+        TransformState_4way = sha256d64_sse41::TransformState_4way;
         ret += ",sse41(4way)";
 #endif
     }
@@ -619,6 +648,7 @@ std::string SHA256AutoDetect()
 #if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
     if (have_avx2 && have_avx && enabled_avx) {
         TransformD64_8way = sha256d64_avx2::Transform_8way;
+        TransformState_8way = sha256d64_avx2::TransformState_8way;
         ret += ",avx2(8way)";
     }
 #endif
@@ -718,3 +748,72 @@ void SHA256D64(unsigned char* out, const unsigned char* in, size_t blocks)
         --blocks;
     }
 }
+
+namespace
+{
+/** Fill one 64-byte block of a padded message. */
+void FillBlock(unsigned char* block, const unsigned char* msg, size_t len, size_t index)
+{
+    const size_t start = index * 64;
+    size_t copied = 0;
+    if (start < len) {
+        copied = std::min<size_t>(64, len - start);
+        memcpy(block, msg + start, copied);
+    }
+    memset(block + copied, 0, 64 - copied);
+    if (start + copied == len && copied < 64) {
+        block[copied] = 0x80;
+    }
+    if (start + 64 >= len + 9) {
+        WriteBE64(block + 56, static_cast<uint64_t>(len) << 3);
+    }
+}
+
+/** Hash a group of lanes messages with a multi-lane state transform. */
+void HashLanes(TransformStateType tr, size_t lanes, unsigned char* out, const unsigned char* in, size_t len)
+{
+    uint32_t s[64];
+    unsigned char blocks[512];
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        sha256::Initialize(s + lane * 8);
+    }
+    const size_t n_blocks = (len + 9 + 63) / 64;
+    for (size_t i = 0; i < n_blocks; ++i) {
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            FillBlock(blocks + lane * 64, in + lane * len, len, i);
+        }
+        tr(s, blocks);
+    }
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        for (size_t word = 0; word < 8; ++word) {
+            WriteBE32(out + lane * 32 + word * 4, s[lane * 8 + word]);
+        }
+    }
+}
+} // namespace
+
+void SHA256Multi(unsigned char* out, const unsigned char* in, size_t len, size_t n)
+{
+    if (TransformState_8way) {
+        while (n >= 8) {
+            HashLanes(TransformState_8way, 8, out, in, len);
+            out += 256;
+            in += 8 * len;
+            n -= 8;
+        }
+    }
+    if (TransformState_4way) {
+        while (n >= 4) {
+            HashLanes(TransformState_4way, 4, out, in, len);
+            out += 128;
+            in += 4 * len;
+            n -= 4;
+        }
+    }
+    while (n) {
+        CSHA256().Write(in, len).Finalize(out);
+        out += 32;
+        in += len;
+        --n;
+    }
+}
@@ -38,4 +38,12 @@ std::string SHA256AutoDetect();
  */
 void SHA256D64(unsigned char* output, const unsigned char* input, size_t blocks);
 
+/** Compute the SHA256 hashes of multiple messages of the same length.
+ *  output:  pointer to an n*32 byte output buffer
+ *  input:   pointer to n messages of len bytes each, back to back
+ *  len:     the length of each message in bytes
+ *  n:       the number of messages to hash.
+ */
+void SHA256Multi(unsigned char* output, const unsigned char* input, size_t len, size_t n);
+
 #endif // BITCOIN_CRYPTO_SHA256_H
@@ -70,6 +70,30 @@ void inline Write8(unsigned char* out, int offset, __m256i v) {
     WriteLE32(out + 224 + offset, _mm256_extract_epi32(v, 0));
 }
 
+/** SHA-256 round constants. */
+const uint32_t ROUND_K[64] = {
+    0x428a2f98ul, 0x71374491ul, 0xb5c0fbcful, 0xe9b5dba5ul, 0x3956c25bul, 0x59f111f1ul, 0x923f82a4ul, 0xab1c5ed5ul,
+    0xd807aa98ul, 0x12835b01ul, 0x243185beul, 0x550c7dc3ul, 0x72be5d74ul, 0x80deb1feul, 0x9bdc06a7ul, 0xc19bf174ul,
+    0xe49b69c1ul, 0xefbe4786ul, 0x0fc19dc6ul, 0x240ca1ccul, 0x2de92c6ful, 0x4a7484aaul, 0x5cb0a9dcul, 0x76f988daul,
+    0x983e5152ul, 0xa831c66dul, 0xb00327c8ul, 0xbf597fc7ul, 0xc6e00bf3ul, 0xd5a79147ul, 0x06ca6351ul, 0x14292967ul,
+    0x27b70a85ul, 0x2e1b2138ul, 0x4d2c6dfcul, 0x53380d13ul, 0x650a7354ul, 0x766a0abbul, 0x81c2c92eul, 0x92722c85ul,
+    0xa2bfe8a1ul, 0xa81a664bul, 0xc24b8b70ul, 0xc76c51a3ul, 0xd192e819ul, 0xd6990624ul, 0xf40e3585ul, 0x106aa070ul,
+    0x19a4c116ul, 0x1e376c08ul, 0x2748774cul, 0x34b0bcb5ul, 0x391c0cb3ul, 0x4ed8aa4aul, 0x5b9cca4ful, 0x682e6ff3ul,
+    0x748f82eeul, 0x78a5636ful, 0x84c87814ul, 0x8cc70208ul, 0x90befffaul, 0xa4506cebul, 0xbef9a3f7ul, 0xc67178f2ul
+};
+
+/** Store one state word of each lane into a lane-major state array. */
+void inline Store8(uint32_t* s, int word, __m256i v) {
+    s[0 + word] = _mm256_extract_epi32(v, 7);
+    s[8 + word] = _mm256_extract_epi32(v, 6);
+    s[16 + word] = _mm256_extract_epi32(v, 5);
+    s[24 + word] = _mm256_extract_epi32(v, 4);
+    s[32 + word] = _mm256_extract_epi32(v, 3);
+    s[40 + word] = _mm256_extract_epi32(v, 2);
+    s[48 + word] = _mm256_extract_epi32(v, 1);
+    s[56 + word] = _mm256_extract_epi32(v, 0);
+}
+
 }
 
 void Transform_8way(unsigned char* out, const unsigned char* in)
@@ -323,6 +347,54 @@ void Transform_8way(unsigned char* out, const unsigned char* in)
     Write8(out, 28, Add(h, K(0x5be0cd19ul)));
 }
 
+/** Apply one SHA-256 compression to each of 8 independent states.
+ *  s:  8 lane-major states of 8 words each, updated in place
+ *  in: one 64-byte block per lane, back to back
+ */
+void TransformState_8way(uint32_t* s, const unsigned char* in)
+{
+    __m256i a = _mm256_set_epi32(s[0], s[8], s[16], s[24], s[32], s[40], s[48], s[56]);
+    __m256i b = _mm256_set_epi32(s[1], s[9], s[17], s[25], s[33], s[41], s[49], s[57]);
+    __m256i c = _mm256_set_epi32(s[2], s[10], s[18], s[26], s[34], s[42], s[50], s[58]);
+    __m256i d = _mm256_set_epi32(s[3], s[11], s[19], s[27], s[35], s[43], s[51], s[59]);
+    __m256i e = _mm256_set_epi32(s[4], s[12], s[20], s[28], s[36], s[44], s[52], s[60]);
+    __m256i f = _mm256_set_epi32(s[5], s[13], s[21], s[29], s[37], s[45], s[53], s[61]);
+    __m256i g = _mm256_set_epi32(s[6], s[14], s[22], s[30], s[38], s[46], s[54], s[62]);
+    __m256i h = _mm256_set_epi32(s[7], s[15], s[23], s[31], s[39], s[47], s[55], s[63]);
+    const __m256i a0 = a, b0 = b, c0 = c, d0 = d, e0 = e, f0 = f, g0 = g, h0 = h;
+
+    __m256i w[16];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = Read8(in, 4 * i);
+    }
+#pragma GCC unroll 64
+    for (int i = 0; i < 64; ++i) {
+        __m256i wi = w[i & 15];
+        if (i >= 16) {
+            wi = Inc(w[i & 15], sigma1(w[(i + 14) & 15]), w[(i + 9) & 15], sigma0(w[(i + 1) & 15]));
+        }
+        __m256i t1 = Add(h, Sigma1(e), Ch(e, f, g), Add(K(ROUND_K[i]), wi));
+        __m256i t2 = Add(Sigma0(a), Maj(a, b, c));
+        h = g;
+        g = f;
+        f = e;
+        e = Add(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = Add(t1, t2);
+    }
+
+    Store8(s, 0, Add(a, a0));
+    Store8(s, 1, Add(b, b0));
+    Store8(s, 2, Add(c, c0));
+    Store8(s, 3, Add(d, d0));
+    Store8(s, 4, Add(e, e0));
+    Store8(s, 5, Add(f, f0));
+    Store8(s, 6, Add(g, g0));
+    Store8(s, 7, Add(h, h0));
+}
+
 }
 
 #endif
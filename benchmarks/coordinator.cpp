@@ -0,0 +1,128 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "uhs/twophase/coordinator/controller.hpp"
+#include "uhs/twophase/coordinator/format.hpp"
+#include "util/raft/util.hpp"
+#include "util/serialization/format.hpp"
+
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <filesystem>
+#include <future>
+
+namespace {
+    using cbdc::coordinator::controller;
+    using cbdc::coordinator::state_machine;
+
+    constexpr auto g_txs_per_dtx = 10;
+    constexpr auto g_in_flight_dtxs = 100;
+    constexpr auto g_snapshot_dir = "coordinator_bench_snps";
+
+    auto make_command(const controller::sm_command& comm)
+        -> nuraft::ptr<nuraft::buffer> {
+        return cbdc::make_buffer<controller::sm_command,
+                                 nuraft::ptr<nuraft::buffer>>(comm);
+    }
+
+    // Raft log of a coordinator that has completed the given number of
+    // dtxs and has g_in_flight_dtxs more in the prepare phase
+    auto make_log(size_t completed_dtxs)
+        -> std::vector<nuraft::ptr<nuraft::buffer>> {
+        auto txs = controller::prepare_tx(g_txs_per_dtx);
+        for(size_t i = 0; i < txs.size(); i++) {
+            txs[i].m_id[0] = static_cast<unsigned char>(i);
+        }
+        auto complete = std::vector<bool>(txs.size(), true);
+        auto tx_idxs = std::vector<std::vector<uint64_t>>(
+            1,
+            std::vector<uint64_t>(txs.size()));
+
+        auto ret = std::vector<nuraft::ptr<nuraft::buffer>>();
+        for(size_t i = 0; i < completed_dtxs + g_in_flight_dtxs; i++) {
+            auto dtx_id = cbdc::hash_t();
+            std::memcpy(dtx_id.data(), &i, sizeof(i));
+            ret.push_back(make_command(
+                {{state_machine::command::prepare, dtx_id}, txs}));
+            if(i >= completed_dtxs) {
+                continue;
+            }
+            ret.push_back(
+                make_command({{state_machine::command::commit, dtx_id},
+                              std::make_pair(complete, tx_idxs)}));
+            ret.push_back(
+                make_command({{state_machine::command::discard, dtx_id}}));
+            ret.push_back(
+                make_command({{state_machine::command::done, dtx_id}}));
+        }
+        return ret;
+    }
+
+    void replay(state_machine& sm,
+                const std::vector<nuraft::ptr<nuraft::buffer>>& log) {
+        for(size_t i = 0; i < log.size(); i++) {
+            sm.commit(i + 1, *log[i]);
+        }
+    }
+}
+
+// benchmark rebuilding the coordinator state by replaying the whole log
+static void coordinator_failover_replay(benchmark::State& state) {
+    auto logger = std::make_shared<cbdc::logging::log>(
+        cbdc::logging::log_level::warn);
+    auto log = make_log(static_cast<size_t>(state.range(0)));
+    for(auto _ : state) {
+        state.PauseTiming();
+        std::filesystem::remove_all(g_snapshot_dir);
+        state.ResumeTiming();
+        auto sm = state_machine(logger, g_snapshot_dir);
+        replay(sm, log);
+        benchmark::DoNotOptimize(sm.last_commit_index());
+    }
+    std::filesystem::remove_all(g_snapshot_dir);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// benchmark rebuilding the coordinator state from a snapshot taken at the
+// end of the log
+static void coordinator_failover_snapshot(benchmark::State& state) {
+    auto logger = std::make_shared<cbdc::logging::log>(
+        cbdc::logging::log_level::warn);
+    auto log = make_log(static_cast<size_t>(state.range(0)));
+    std::filesystem::remove_all(g_snapshot_dir);
+    {
+        auto sm = state_machine(logger, g_snapshot_dir);
+        replay(sm, log);
+        auto snp = nuraft::snapshot(log.size(),
+                                    1,
+                                    nuraft::cs_new<nuraft::cluster_config>());
+        auto done = std::promise<bool>();
+        nuraft::async_result<bool>::handler_type when_done
+            = [&](bool& res, nuraft::ptr<std::exception>& /* err */) {
+                  done.set_value(res);
+              };
+        sm.create_snapshot(snp, when_done);
+        if(!done.get_future().get()) {
+            state.SkipWithError("Failed to create snapshot");
+            return;
+        }
+    }
+
+    for(auto _ : state) {
+        auto sm = state_machine(logger, g_snapshot_dir);
+        benchmark::DoNotOptimize(sm.last_commit_index());
+    }
+    std::filesystem::remove_all(g_snapshot_dir);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(coordinator_failover_replay)
+    ->RangeMultiplier(10)
+    ->Range(1000, 100000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(coordinator_failover_snapshot)
+    ->RangeMultiplier(10)
+    ->Range(1000, 100000)
+    ->Unit(benchmark::kMillisecond);
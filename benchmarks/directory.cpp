@@ -0,0 +1,128 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "parsec/directory/consistent_hash.hpp"
+#include "parsec/directory/impl.hpp"
+#include "util/serialization/format.hpp"
+#include "util/serialization/util.hpp"
+
+#include <benchmark/benchmark.h>
+#include <random>
+
+namespace {
+    using key_type = cbdc::parsec::runtime_locking_shard::key_type;
+
+    constexpr auto g_n_keys = 100000;
+    constexpr auto g_n_accesses = 1000000;
+    constexpr auto g_zipf_exponent = 1.1;
+
+    // Generates key accesses where the key of rank k is accessed with
+    // probability proportional to 1 / k^s
+    auto zipf_accesses() -> std::vector<key_type> {
+        auto weights = std::vector<double>();
+        weights.reserve(g_n_keys);
+        for(size_t i = 1; i <= g_n_keys; i++) {
+            weights.push_back(
+                1.0 / std::pow(static_cast<double>(i), g_zipf_exponent));
+        }
+        auto dist = std::discrete_distribution<uint64_t>(weights.begin(),
+                                                         weights.end());
+        auto rng = std::default_random_engine();
+        auto ret = std::vector<key_type>();
+        ret.reserve(g_n_accesses);
+        for(size_t i = 0; i < g_n_accesses; i++) {
+            ret.emplace_back(cbdc::make_buffer(dist(rng)));
+        }
+        return ret;
+    }
+
+    // Routes all the accesses and reports the load on the busiest shard
+    // relative to the mean load
+    void simulate(benchmark::State& state,
+                  cbdc::parsec::directory::interface& directory,
+                  const std::vector<key_type>& accesses,
+                  size_t n_shards) {
+        auto load = std::vector<uint64_t>(n_shards);
+        for(const auto& key : accesses) {
+            auto success = directory.key_location(key, [&](uint64_t shard) {
+                load[shard]++;
+            });
+            benchmark::DoNotOptimize(success);
+        }
+        auto max_load = *std::max_element(load.begin(), load.end());
+        state.counters["max_mean_load_ratio"]
+            = static_cast<double>(max_load * n_shards)
+            / static_cast<double>(accesses.size());
+        state.SetItemsProcessed(static_cast<int64_t>(accesses.size()));
+    }
+}
+
+// load distribution with keys mapped to shards using the key hash modulo the
+// number of shards
+static void directory_zipf_modulo(benchmark::State& state) {
+    auto n_shards = static_cast<size_t>(state.range(0));
+    auto accesses = zipf_accesses();
+    for(auto _ : state) {
+        auto directory = cbdc::parsec::directory::impl(n_shards);
+        simulate(state, directory, accesses, n_shards);
+    }
+}
+
+// load distribution with keys mapped to shards using consistent hashing
+static void directory_zipf_consistent_hash(benchmark::State& state) {
+    auto n_shards = static_cast<size_t>(state.range(0));
+    auto accesses = zipf_accesses();
+    for(auto _ : state) {
+        auto directory
+            = cbdc::parsec::directory::consistent_hash(n_shards);
+        simulate(state, directory, accesses, n_shards);
+    }
+}
+
+// fraction of keys which move to a different shard when a shard is added
+static void directory_consistent_hash_rebalance(benchmark::State& state) {
+    auto n_shards = static_cast<size_t>(state.range(0));
+    auto keys = std::vector<key_type>();
+    for(uint64_t i = 0; i < g_n_keys; i++) {
+        keys.emplace_back(cbdc::make_buffer(i));
+    }
+    for(auto _ : state) {
+        auto directory
+            = cbdc::parsec::directory::consistent_hash(n_shards, 128, 0);
+        auto before = std::vector<uint64_t>();
+        for(const auto& key : keys) {
+            auto success = directory.key_location(key, [&](uint64_t shard) {
+                before.push_back(shard);
+            });
+            benchmark::DoNotOptimize(success);
+        }
+        directory.add_shard();
+        size_t moved{0};
+        for(size_t i = 0; i < keys.size(); i++) {
+            auto success
+                = directory.key_location(keys[i], [&](uint64_t shard) {
+                      if(shard != before[i]) {
+                          moved++;
+                      }
+                  });
+            benchmark::DoNotOptimize(success);
+        }
+        state.counters["moved_fraction"]
+            = static_cast<double>(moved) / static_cast<double>(keys.size());
+    }
+}
+
+BENCHMARK(directory_zipf_modulo)
+    ->RangeMultiplier(2)
+    ->Range(4, 32)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(directory_zipf_consistent_hash)
+    ->RangeMultiplier(2)
+    ->Range(4, 32)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(directory_consistent_hash_rebalance)
+    ->RangeMultiplier(2)
+    ->Range(4, 32)
+    ->Unit(benchmark::kMillisecond);
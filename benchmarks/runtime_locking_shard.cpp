@@ -0,0 +1,67 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "parsec/runtime_locking_shard/impl.hpp"
+#include "util/serialization/format.hpp"
+#include "util/serialization/util.hpp"
+
+#include <benchmark/benchmark.h>
+
+namespace {
+    // Each agent lock, prepare, commit and finish tickets on its own keys so
+    // the shard should scale with the number of agents
+    constexpr auto g_keys_per_agent = 64;
+
+    std::shared_ptr<cbdc::parsec::runtime_locking_shard::impl> g_shard;
+}
+
+// benchmark how many transactions agents on disjoint keys can complete
+static void runtime_locking_shard_disjoint(benchmark::State& state) {
+    using namespace cbdc::parsec::runtime_locking_shard;
+    if(state.thread_index() == 0) {
+        auto log = std::make_shared<cbdc::logging::log>(
+            cbdc::logging::log_level::warn);
+        g_shard = std::make_shared<impl>(log);
+    }
+
+    auto keys = std::vector<key_type>();
+    for(size_t i = 0; i < g_keys_per_agent; i++) {
+        keys.emplace_back(cbdc::make_buffer(
+            std::make_pair(static_cast<uint64_t>(state.thread_index()),
+                           static_cast<uint64_t>(i))));
+    }
+    auto val = cbdc::make_buffer(uint64_t{1});
+
+    auto agents = static_cast<ticket_number_type>(state.threads());
+    auto ticket_number
+        = static_cast<ticket_number_type>(state.thread_index());
+    size_t i = 0;
+    for(auto _ : state) {
+        const auto& key = keys[i % keys.size()];
+        auto success = g_shard->try_lock(ticket_number,
+                                         0,
+                                         key,
+                                         lock_type::write,
+                                         true,
+                                         [](const auto& /* res */) {});
+        success = success
+               && g_shard->prepare(ticket_number,
+                                   0,
+                                   {{key, val}},
+                                   [](const auto& /* res */) {});
+        success = success
+               && g_shard->commit(ticket_number,
+                                  [](const auto& /* res */) {});
+        success = success
+               && g_shard->finish(ticket_number,
+                                  [](const auto& /* res */) {});
+        benchmark::DoNotOptimize(success);
+        ticket_number += agents;
+        i++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(runtime_locking_shard_disjoint)->ThreadRange(1, 16)->UseRealTime();
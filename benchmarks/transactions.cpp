@@ -3,6 +3,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include "crypto/sha256.h"
 #include "uhs/transaction/transaction.hpp"
 #include "uhs/transaction/validation.hpp"
 #include "uhs/transaction/wallet.hpp"
@@ -133,6 +134,70 @@ static void Nto2_tx(benchmark::State& state) {
     state.SetComplexityN(state.range(0));
 }
 
+// Signing an N input transaction spending outputs locked to one key
+static void sign_Nin_tx(benchmark::State& state) {
+    cbdc::transaction::wallet wallet;
+    auto n_in = static_cast<uint64_t>(state.range(0));
+    wallet.seed({1}, 2, 0, n_in);
+    auto tx = wallet.send_to(n_in, 1, wallet.generate_key(), false).value();
+    for(auto _ : state) {
+        auto unsigned_tx = tx;
+        wallet.sign(unsigned_tx);
+        benchmark::DoNotOptimize(unsigned_tx);
+    }
+    state.SetComplexityN(state.range(0));
+}
+
+// Signing a batch of N single input transactions
+static void sign_tx_batch(benchmark::State& state) {
+    cbdc::transaction::wallet wallet;
+    auto n_txs = static_cast<uint64_t>(state.range(0));
+    wallet.seed({1}, 2, 0, n_txs);
+    auto payee = wallet.generate_key();
+    auto txs = std::vector<cbdc::transaction::full_tx>();
+    for(uint64_t i = 0; i < n_txs; i++) {
+        txs.push_back(wallet.send_to(1, 1, payee, false).value());
+    }
+    for(auto _ : state) {
+        auto unsigned_txs = txs;
+        wallet.sign(unsigned_txs);
+        benchmark::DoNotOptimize(unsigned_txs);
+    }
+    state.SetComplexityN(state.range(0));
+}
+
+// Converting an N input, N output transaction to a compact transaction
+static void compact_Nin_Nout_tx(benchmark::State& state) {
+    SHA256AutoDetect();
+    cbdc::transaction::wallet wallet;
+    auto n = static_cast<uint64_t>(state.range(0));
+    wallet.seed({1}, 2, 0, n);
+    auto tx = wallet.send_to(n, n, wallet.generate_key(), false).value();
+    for(auto _ : state) {
+        auto ctx = cbdc::transaction::compact_tx(tx);
+        benchmark::DoNotOptimize(ctx);
+    }
+    state.SetComplexityN(state.range(0));
+}
+
+// Converting a batch of N seeded transactions to compact transactions
+static void compact_tx_batch(benchmark::State& state) {
+    SHA256AutoDetect();
+    cbdc::transaction::wallet wallet;
+    wallet.seed_readonly({1}, 2, 0, 1);
+    auto tx = wallet.create_seeded_transaction(0).value();
+    auto txs = std::vector<cbdc::transaction::full_tx>();
+    for(int64_t i = 0; i < state.range(0); i++) {
+        tx.m_inputs[0].m_prevout.m_index = static_cast<uint64_t>(i);
+        txs.push_back(tx);
+    }
+    for(auto _ : state) {
+        auto ctxs = cbdc::transaction::compact_txs(txs);
+        benchmark::DoNotOptimize(ctxs);
+    }
+    state.SetComplexityN(state.range(0));
+}
+
 // Benchmark declarations
 BENCHMARK(Nto1_tx)
     ->RangeMultiplier(2)
@@ -144,3 +209,22 @@ BENCHMARK(Nto2_tx)
     ->Range(1, SWEEP_MAX)
     ->Complexity(benchmark::oAuto);
 
+BENCHMARK(sign_Nin_tx)
+    ->RangeMultiplier(4)
+    ->Range(1, 1024)
+    ->Complexity(benchmark::oAuto);
+
+BENCHMARK(sign_tx_batch)
+    ->RangeMultiplier(4)
+    ->Range(1, 1024)
+    ->Complexity(benchmark::oAuto);
+
+BENCHMARK(compact_Nin_Nout_tx)
+    ->RangeMultiplier(4)
+    ->Range(1, 256)
+    ->Complexity(benchmark::oAuto);
+
+BENCHMARK(compact_tx_batch)
+    ->RangeMultiplier(4)
+    ->Range(1, 4096)
+    ->Complexity(benchmark::oAuto);
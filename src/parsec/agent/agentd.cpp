@@ -5,6 +5,7 @@
 
 #include "broker/impl.hpp"
 #include "crypto/sha256.h"
+#include "directory/consistent_hash.hpp"
 #include "directory/impl.hpp"
 #include "format.hpp"
 #include "impl.hpp"
@@ -23,6 +24,7 @@
 #include "util/serialization/format.hpp"
 
 #include <csignal>
+#include <future>
 
 auto main(int argc, char** argv) -> int {
     auto log = std::make_shared<cbdc::logging::log>(
@@ -70,8 +72,16 @@ auto main(int argc, char** argv) -> int {
         return 1;
     }
 
-    auto directory
-        = std::make_shared<cbdc::parsec::directory::impl>(shards.size());
+    auto directory = std::shared_ptr<cbdc::parsec::directory::interface>();
+    if(cfg->m_directory_vnodes > 0) {
+        directory
+            = std::make_shared<cbdc::parsec::directory::consistent_hash>(
+                shards.size(),
+                cfg->m_directory_vnodes);
+    } else {
+        directory
+            = std::make_shared<cbdc::parsec::directory::impl>(shards.size());
+    }
     auto broker
         = std::make_shared<cbdc::parsec::broker::impl>(cfg->m_component_id,
                                                        shards,
@@ -447,14 +447,7 @@ namespace cbdc::parsec::agent::runner {
         if(!tn) {
             tn = m_ticket_number;
         }
-        auto tn_buf = cbdc::make_buffer(tn.value());
-        CSHA256 sha;
-        hash_t log_index_hash;
-        sha.Write(addr.bytes, sizeof(addr.bytes));
-        sha.Write(tn_buf.c_ptr(), tn_buf.size());
-        sha.Finalize(log_index_hash.data());
-
-        return make_buffer(log_index_hash);
+        return runner::log_index_key(addr, tn.value());
     }
 
     auto evm_host::get_log_index_keys() const -> std::vector<cbdc::buffer> {
@@ -466,6 +459,17 @@ namespace cbdc::parsec::agent::runner {
         return keys;
     }
 
+    auto evm_host::get_log_block_index_keys() const
+        -> std::vector<cbdc::buffer> {
+        auto logs = get_sorted_logs();
+        auto keys = std::vector<cbdc::buffer>();
+        for(auto& log : logs) {
+            keys.push_back(runner::log_block_index_key(log.first,
+                                                       m_ticket_number));
+        }
+        return keys;
+    }
+
     auto evm_host::get_sorted_logs() const
         -> std::unordered_map<evmc::address, std::vector<evm_log>> {
         auto ret = std::unordered_map<evmc::address, std::vector<evm_log>>();
@@ -107,6 +107,12 @@ namespace cbdc::parsec::agent::runner {
         /// \return list of keys to set to 1 for the log index
         auto get_log_index_keys() const -> std::vector<cbdc::buffer>;
 
+        /// Return the keys of the log block index entries which need to
+        /// record the host's ticket number for each address which emitted
+        /// logs.
+        /// \return list of log block index keys to update.
+        auto get_log_block_index_keys() const -> std::vector<cbdc::buffer>;
+
         /// Return the changes to the state resulting from transaction
         /// execution.
         /// \return list of updates keys and values.
@@ -26,11 +26,14 @@ namespace cbdc::parsec::agent::rpc {
                              const cbdc::parsec::config& cfg)
         : server_interface(std::move(broker), std::move(log), cfg),
           m_srv(std::move(srv)) {
+        register_supported();
+        register_static();
+        register_unsupported();
         m_srv->register_handler_callback(
             [&](const std::string& method,
-                const Json::Value& params,
+                Json::Value params,
                 const server_type::result_callback_type& callback) {
-                return request_handler(method, params, callback);
+                return request_handler(method, std::move(params), callback);
             });
     }
 
@@ -46,223 +49,147 @@ namespace cbdc::parsec::agent::rpc {
 
     auto http_server::request_handler(
         const std::string& method,
-        const Json::Value& params,
+        Json::Value params,
         const server_type::result_callback_type& callback) -> bool {
         m_log->trace("http_server::request_handler() received request",
                      method);
 
-        auto maybe_handled = handle_supported(method, params, callback);
-        if(maybe_handled.has_value()) {
-            return maybe_handled.value();
-        }
-
-        maybe_handled = handle_static(method, params, callback);
-        if(maybe_handled.has_value()) {
-            return maybe_handled.value();
+        auto it = m_handlers.find(method);
+        if(it != m_handlers.end()) {
+            return it->second(std::move(params), callback);
         }
 
-        return handle_unsupported(method, params, callback);
+        m_log->warn("Unknown method", method);
+        return handle_error(params,
+                            callback,
+                            error_code::unknown_method,
+                            "Unknown method: " + method);
     }
 
-    auto http_server::handle_supported(
-        const std::string& method,
-        const Json::Value& params,
-        const server_type::result_callback_type& callback)
-        -> std::optional<bool> {
-        if(method == "eth_sendRawTransaction") {
-            return handle_send_raw_transaction(params, callback);
-        }
-
-        if(method == "eth_sendTransaction") {
-            return handle_send_transaction(params, callback);
-        }
-
-        if(method == "eth_getTransactionCount") {
-            return handle_get_transaction_count(params, callback);
-        }
-
-        if(method == "eth_call") {
-            return handle_call(params, callback);
-        }
-
-        if(method == "eth_gasPrice") {
-            return handle_gas_price(params, callback);
-        }
-
-        if(method == "eth_getCode") {
-            return handle_get_code(params, callback);
-        }
-
-        if(method == "eth_getBalance") {
-            return handle_get_balance(params, callback);
-        }
-
-        if(method == "eth_accounts") {
-            return handle_accounts(params, callback);
-        }
-
-        if(method == "eth_getTransactionByHash") {
-            return handle_get_transaction_by_hash(params, callback);
-        }
-
-        if(method == "eth_getTransactionReceipt") {
-            return handle_get_transaction_receipt(params, callback);
-        }
-
-        if(method == "eth_getBlockByNumber"
-           || method == "eth_getBlockByHash") {
-            return handle_get_block(params, callback);
-        }
-
-        if(method == "eth_getBlockTransactionCountByHash"
-           || method == "eth_getBlockTransactionCountByNumber") {
-            return handle_get_block_txcount(params, callback);
-        }
-
-        if(method == "eth_getTransactionByBlockHashAndIndex"
-           || method == "eth_getTransactionByBlockNumberAndIndex") {
-            return handle_get_block_tx(params, callback);
-        }
-
-        if(method == "eth_blockNumber") {
-            return handle_block_number(params, callback);
-        }
-
-        if(method == "eth_feeHistory") {
-            return handle_fee_history(params, callback);
-        }
-
-        if(method == "eth_getLogs") {
-            return handle_get_logs(params, callback);
+    template<typename F>
+    void http_server::add_handler(std::initializer_list<const char*> methods,
+                                  F fn) {
+        auto handler = method_handler_type();
+        if constexpr(std::is_member_function_pointer_v<F>) {
+            handler = [this, fn](
+                          Json::Value params,
+                          const server_type::result_callback_type& callback) {
+                return (this->*fn)(std::move(params), callback);
+            };
+        } else {
+            handler = [fn](Json::Value params,
+                           const server_type::result_callback_type& callback) {
+                return fn(std::move(params), callback);
+            };
         }
-
-        if(method == "eth_getStorageAt") {
-            return handle_get_storage_at(params, callback);
+        for(const auto* method : methods) {
+            m_handlers.emplace(method, handler);
         }
-
-        return std::nullopt;
     }
 
-    auto http_server::handle_static(
-        const std::string& method,
-        const Json::Value& params,
-        const server_type::result_callback_type& callback)
-        -> std::optional<bool> {
-        if(method == "eth_chainId" || method == "net_version") {
-            return handle_chain_id(params, callback);
-        }
-
-        if(method == "web3_clientVersion") {
-            return handle_client_version(params, callback);
-        }
-
-        if(method == "eth_decodeRawTransaction") {
-            return handle_decode_raw_transaction(params, callback);
-        }
-
-        if(method == "web3_sha3") {
-            return handle_sha3(params, callback);
-        }
-
-        if(method == "eth_estimateGas") {
-            return handle_estimate_gas(params, callback);
-        }
-
-        return std::nullopt;
+    void http_server::register_supported() {
+        add_handler({"eth_sendRawTransaction"},
+                    &http_server::handle_send_raw_transaction);
+        add_handler({"eth_sendTransaction"},
+                    &http_server::handle_send_transaction);
+        add_handler({"eth_getTransactionCount"},
+                    &http_server::handle_get_transaction_count);
+        add_handler({"eth_call"}, &http_server::handle_call);
+        add_handler({"eth_gasPrice"}, &http_server::handle_gas_price);
+        add_handler({"eth_getCode"}, &http_server::handle_get_code);
+        add_handler({"eth_getBalance"}, &http_server::handle_get_balance);
+        add_handler({"eth_accounts"}, &http_server::handle_accounts);
+        add_handler({"eth_getTransactionByHash"},
+                    &http_server::handle_get_transaction_by_hash);
+        add_handler({"eth_getTransactionReceipt"},
+                    &http_server::handle_get_transaction_receipt);
+        add_handler({"eth_getBlockByNumber", "eth_getBlockByHash"},
+                    &http_server::handle_get_block);
+        add_handler({"eth_getBlockTransactionCountByHash",
+                     "eth_getBlockTransactionCountByNumber"},
+                    &http_server::handle_get_block_txcount);
+        add_handler({"eth_getTransactionByBlockHashAndIndex",
+                     "eth_getTransactionByBlockNumberAndIndex"},
+                    &http_server::handle_get_block_tx);
+        add_handler({"eth_blockNumber"}, &http_server::handle_block_number);
+        add_handler({"eth_feeHistory"}, &http_server::handle_fee_history);
+        add_handler({"eth_getLogs"}, &http_server::handle_get_logs);
+        add_handler({"eth_getStorageAt"},
+                    &http_server::handle_get_storage_at);
     }
 
-    auto http_server::handle_unsupported(
-        const std::string& method,
-        const Json::Value& params,
-        const server_type::result_callback_type& callback) -> bool {
-        if(method == "eth_signTransaction" || method == "eth_sign") {
-            return handle_error(
-                params,
-                callback,
-                error_code::wallet_not_supported,
-                "Wallet support not enabled - sign transactions "
-                "locally before submitting");
-        }
-
-        if(method == "eth_uninstallFilter"
-           || method == "eth_newPendingTransactionFilter"
-           || method == "eth_newFilter" || method == "eth_newBlockFilter"
-           || method == "eth_getFilterLogs"
-           || method == "eth_getFilterChanges") {
-            return handle_error(params,
-                                callback,
-                                error_code::wallet_not_supported,
-                                "OpenCBDC does not support filters");
-        }
-
-        if(method == "eth_getWork" || method == "eth_submitWork"
-           || method == "eth_submitHashrate") {
-            return handle_error(params,
-                                callback,
-                                error_code::mining_not_supported,
-                                "OpenCBDC does not use mining");
-        }
-
-        if(method == "evm_increaseTime") {
-            return handle_error(params,
-                                callback,
-                                error_code::time_travel_not_supported,
-                                "OpenCBDC does not support time travel");
-        }
-
-        if(method == "eth_getCompilers" || method == "eth_compileSolidity"
-           || method == "eth_compileLLL" || method == "eth_compileSerpent") {
-            return handle_error(params,
-                                callback,
-                                error_code::compiler_not_supported,
-                                "OpenCBDC does not provide compiler support - "
-                                "compile contracts locally before submitting");
-        }
-
-        if(method == "eth_coinbase") {
-            return handle_error(params,
-                                callback,
-                                error_code::coinbase_not_supported,
-                                "Coinbase payouts are not used in OpenCBDC");
-        }
-
-        if(method == "eth_getUncleByBlockHashAndIndex"
-           || method == "eth_getUncleByBlockNumberAndIndex") {
-            // There are no uncle blocks in OpenCBDC ever
-            return handle_error(params,
-                                callback,
-                                error_code::uncles_not_supported,
-                                "Uncle block not found");
-        }
-
-        if(method == "eth_getUncleCountByBlockHash"
-           || method == "eth_getUncleCountByBlockNumber"
-           || method == "eth_hashrate") {
-            // There are no uncle blocks in OpenCBDC ever
-            return handle_number(params, callback, 0);
-        }
-
-        if(method == "eth_mining") {
-            return handle_boolean(params, callback, false);
-        }
-
-        if(method == "eth_syncing") {
-            return handle_boolean(params, callback, false);
-        }
-
-        if(method == "net_listening") {
-            return handle_boolean(params, callback, false);
-        }
-
-        if(method == "net_peerCount") {
-            return handle_number(params, callback, 1);
-        }
+    void http_server::register_static() {
+        add_handler({"eth_chainId", "net_version"},
+                    &http_server::handle_chain_id);
+        add_handler({"web3_clientVersion"},
+                    &http_server::handle_client_version);
+        add_handler({"eth_decodeRawTransaction"},
+                    &http_server::handle_decode_raw_transaction);
+        add_handler({"web3_sha3"}, &http_server::handle_sha3);
+        add_handler({"eth_estimateGas"}, &http_server::handle_estimate_gas);
+    }
 
-        m_log->warn("Unknown method", method);
-        return handle_error(params,
-                            callback,
-                            error_code::unknown_method,
-                            "Unknown method: " + method);
+    void http_server::register_unsupported() {
+        auto error = [](int code, std::string message) {
+            return [code, msg = std::move(message)](
+                       const Json::Value& params,
+                       const server_type::result_callback_type& callback) {
+                return handle_error(params, callback, code, msg);
+            };
+        };
+        auto number = [](uint64_t n) {
+            return [n](const Json::Value& params,
+                       const server_type::result_callback_type& callback) {
+                return handle_number(params, callback, n);
+            };
+        };
+        auto boolean = [](bool b) {
+            return [b](const Json::Value& params,
+                       const server_type::result_callback_type& callback) {
+                return handle_boolean(params, callback, b);
+            };
+        };
+
+        add_handler({"eth_signTransaction", "eth_sign"},
+                    error(error_code::wallet_not_supported,
+                          "Wallet support not enabled - sign transactions "
+                          "locally before submitting"));
+        add_handler({"eth_uninstallFilter",
+                     "eth_newPendingTransactionFilter",
+                     "eth_newFilter",
+                     "eth_newBlockFilter",
+                     "eth_getFilterLogs",
+                     "eth_getFilterChanges"},
+                    error(error_code::wallet_not_supported,
+                          "OpenCBDC does not support filters"));
+        add_handler({"eth_getWork", "eth_submitWork", "eth_submitHashrate"},
+                    error(error_code::mining_not_supported,
+                          "OpenCBDC does not use mining"));
+        add_handler({"evm_increaseTime"},
+                    error(error_code::time_travel_not_supported,
+                          "OpenCBDC does not support time travel"));
+        add_handler({"eth_getCompilers",
+                     "eth_compileSolidity",
+                     "eth_compileLLL",
+                     "eth_compileSerpent"},
+                    error(error_code::compiler_not_supported,
+                          "OpenCBDC does not provide compiler support - "
+                          "compile contracts locally before submitting"));
+        add_handler({"eth_coinbase"},
+                    error(error_code::coinbase_not_supported,
+                          "Coinbase payouts are not used in OpenCBDC"));
+        // There are no uncle blocks in OpenCBDC ever
+        add_handler({"eth_getUncleByBlockHashAndIndex",
+                     "eth_getUncleByBlockNumberAndIndex"},
+                    error(error_code::uncles_not_supported,
+                          "Uncle block not found"));
+        add_handler({"eth_getUncleCountByBlockHash",
+                     "eth_getUncleCountByBlockNumber",
+                     "eth_hashrate"},
+                    number(0));
+        add_handler({"eth_mining", "eth_syncing", "net_listening"},
+                    boolean(false));
+        add_handler({"net_peerCount"}, number(1));
     }
 
     auto http_server::handle_decode_raw_transaction(
@@ -366,25 +293,19 @@ namespace cbdc::parsec::agent::rpc {
         }
 
         auto params_str = params[0].asString();
-        auto maybe_runner_params
-            = cbdc::buffer::from_hex(params_str.substr(2));
-        if(!maybe_runner_params.has_value()) {
+        auto maybe_key = cbdc::buffer::from_hex(params_str.substr(2));
+        if(!maybe_key.has_value()) {
             m_log->warn("Unable to decode params", params_str);
             return false;
         }
-        auto runner_params = std::move(maybe_runner_params.value());
-        return exec_tx(
+        auto key = std::move(maybe_key.value());
+        return read_key(
+            std::move(key),
             callback,
-            runner::evm_runner_function::read_account,
-            runner_params,
-            true,
-            [callback, runner_params](interface::exec_return_type res) {
+            [callback](const broker::value_type& value) {
                 auto ret = Json::Value();
 
-                auto& updates = std::get<return_type>(res);
-                auto it = updates.find(runner_params);
-
-                if(it == updates.end() || it->second.size() == 0) {
+                if(value.size() == 0) {
                     // For accounts that don't exist yet, return 1
                     ret["result"] = to_hex_trimmed(evmc::uint256be(1));
                     callback(ret);
@@ -392,7 +313,7 @@ namespace cbdc::parsec::agent::rpc {
                 }
 
                 auto maybe_acc
-                    = cbdc::from_buffer<runner::evm_account>(it->second);
+                    = cbdc::from_buffer<runner::evm_account>(value);
                 if(!maybe_acc.has_value()) {
                     ret["error"] = Json::Value();
                     ret["error"]["code"] = error_code::internal_error;
@@ -418,23 +339,18 @@ namespace cbdc::parsec::agent::rpc {
         }
 
         auto params_str = params[0].asString();
-        auto maybe_runner_params
-            = cbdc::buffer::from_hex(params_str.substr(2));
-        if(!maybe_runner_params.has_value()) {
+        auto maybe_key = cbdc::buffer::from_hex(params_str.substr(2));
+        if(!maybe_key.has_value()) {
             m_log->warn("Unable to decode params", params_str);
             return false;
         }
-        auto runner_params = std::move(maybe_runner_params.value());
-        return exec_tx(
+        auto key = std::move(maybe_key.value());
+        return read_key(
+            std::move(key),
             callback,
-            runner::evm_runner_function::read_account,
-            runner_params,
-            true,
-            [callback, runner_params](interface::exec_return_type res) {
+            [callback](const broker::value_type& value) {
                 auto ret = Json::Value();
-                auto& updates = std::get<return_type>(res);
-                auto it = updates.find(runner_params);
-                if(it == updates.end() || it->second.size() == 0) {
+                if(value.size() == 0) {
                     // Return 0 for non-existent accounts
                     ret["result"] = "0x0";
                     callback(ret);
@@ -442,7 +358,7 @@ namespace cbdc::parsec::agent::rpc {
                 }
 
                 auto maybe_acc
-                    = cbdc::from_buffer<runner::evm_account>(it->second);
+                    = cbdc::from_buffer<runner::evm_account>(value);
                 if(!maybe_acc.has_value()) {
                     ret["error"] = Json::Value();
                     ret["error"]["code"] = error_code::internal_error;
@@ -478,25 +394,21 @@ namespace cbdc::parsec::agent::rpc {
             return false;
         }
 
-        auto runner_params = cbdc::make_buffer(
+        auto key = cbdc::make_buffer(
             storage_key{maybe_addr.value(), maybe_key.value()});
-        return exec_tx(
+        return read_key(
+            std::move(key),
             callback,
-            runner::evm_runner_function::read_account_storage,
-            runner_params,
-            true,
-            [callback, runner_params](interface::exec_return_type res) {
+            [callback](const broker::value_type& value) {
                 auto ret = Json::Value();
-                auto& updates = std::get<return_type>(res);
-                auto it = updates.find(runner_params);
-                if(it == updates.end() || it->second.size() == 0) {
+                if(value.size() == 0) {
                     // Return empty for non-existent data
                     ret["result"] = "0x";
                     callback(ret);
                     return;
                 }
 
-                ret["result"] = "0x" + it->second.to_hex();
+                ret["result"] = "0x" + value.to_hex();
                 callback(ret);
             });
     }
@@ -509,23 +421,18 @@ namespace cbdc::parsec::agent::rpc {
             return false;
         }
         auto params_str = params[0].asString();
-        auto maybe_runner_params
-            = cbdc::buffer::from_hex(params_str.substr(2));
-        if(!maybe_runner_params.has_value()) {
+        auto maybe_key = cbdc::buffer::from_hex(params_str.substr(2));
+        if(!maybe_key.has_value()) {
             m_log->warn("Unable to decode params", params_str);
             return false;
         }
-        auto runner_params = std::move(maybe_runner_params.value());
-        return exec_tx(
+        auto key = std::move(maybe_key.value());
+        return read_key(
+            std::move(key),
             callback,
-            runner::evm_runner_function::get_transaction_receipt,
-            runner_params,
-            true,
-            [callback, runner_params, this](interface::exec_return_type res) {
+            [callback, this](const broker::value_type& value) {
                 auto ret = Json::Value();
-                auto& updates = std::get<return_type>(res);
-                auto it = updates.find(runner_params);
-                if(it == updates.end() || it->second.size() == 0) {
+                if(value.size() == 0) {
                     ret["error"] = Json::Value();
                     ret["error"]["code"] = error_code::not_found;
                     ret["error"]["message"] = "Transaction not found";
@@ -534,7 +441,7 @@ namespace cbdc::parsec::agent::rpc {
                 }
 
                 auto maybe_tx
-                    = cbdc::from_buffer<runner::evm_tx_receipt>(it->second);
+                    = cbdc::from_buffer<runner::evm_tx_receipt>(value);
                 if(!maybe_tx.has_value()) {
                     ret["error"] = Json::Value();
                     ret["error"]["code"] = error_code::internal_error;
@@ -738,33 +645,27 @@ namespace cbdc::parsec::agent::rpc {
 
     void http_server::handle_get_logs_result(
         const server_type::result_callback_type& callback,
-        const cbdc::buffer& runner_params,
         const runner::evm_log_query& qry,
-        interface::exec_return_type res) {
+        const std::vector<broker::value_type>& values) {
         auto ret = Json::Value();
-        auto& updates = std::get<return_type>(res);
-        auto it = updates.find(runner_params);
-        if(it == updates.end() || it->second.size() == 0) {
-            ret["error"] = Json::Value();
-            ret["error"]["code"] = error_code::not_found;
-            ret["error"]["message"] = "Logs not found";
-            callback(ret);
-            return;
-        }
+        ret["result"] = Json::Value(Json::arrayValue);
+        for(const auto& value : values) {
+            if(value.size() == 0) {
+                // No logs for the address at this ticket
+                continue;
+            }
 
-        auto maybe_logs
-            = cbdc::from_buffer<std::vector<evm_log_index>>(it->second);
-        if(!maybe_logs.has_value()) {
-            ret["error"] = Json::Value();
-            ret["error"]["code"] = error_code::internal_error;
-            ret["error"]["message"] = "Internal error";
-            callback(ret);
-            return;
-        }
+            auto maybe_log_idx = cbdc::from_buffer<evm_log_index>(value);
+            if(!maybe_log_idx.has_value()) {
+                ret = Json::Value();
+                ret["error"] = Json::Value();
+                ret["error"]["code"] = error_code::internal_error;
+                ret["error"]["message"] = "Internal error";
+                callback(ret);
+                return;
+            }
 
-        auto& logs = maybe_logs.value();
-        ret["result"] = Json::Value(Json::arrayValue);
-        for(auto& log_idx : logs) {
+            auto& log_idx = maybe_log_idx.value();
             for(auto& log : log_idx.m_logs) {
                 auto match = false;
                 for(auto& have_topic : log.m_topics) {
@@ -810,17 +711,42 @@ namespace cbdc::parsec::agent::rpc {
             return true;
         }
         auto qry = maybe_qry.value();
-        auto runner_params = cbdc::make_buffer(qry);
-        return exec_tx(
+
+        // Read the block index first to find the buckets of tickets which
+        // emitted logs for each address, then read the logs for only the
+        // tickets in those buckets
+        auto keys = std::vector<broker::key_type>();
+        for(auto& addr : qry.m_addresses) {
+            for(auto& key : log_block_index_keys(addr,
+                                                 qry.m_from_block,
+                                                 qry.m_to_block)) {
+                keys.push_back(std::move(key));
+            }
+        }
+
+        return read_keys(
+            std::move(keys),
             callback,
-            runner::evm_runner_function::get_logs,
-            runner_params,
-            true,
-            [callback, runner_params, qry](interface::exec_return_type res) {
-                handle_get_logs_result(callback,
-                                       runner_params,
-                                       qry,
-                                       std::move(res));
+            [this, callback, qry](
+                const std::vector<broker::value_type>& flags) {
+                auto success = read_keys(
+                    log_index_keys(qry.m_addresses,
+                                   flags,
+                                   qry.m_from_block,
+                                   qry.m_to_block),
+                    callback,
+                    [callback,
+                     qry](const std::vector<broker::value_type>& values) {
+                        handle_get_logs_result(callback, qry, values);
+                    });
+                if(!success) {
+                    m_log->error("Failed to read log index keys");
+                    auto ret = Json::Value();
+                    ret["error"] = Json::Value();
+                    ret["error"]["code"] = error_code::internal_error;
+                    ret["error"]["message"] = "Internal error";
+                    callback(ret);
+                }
             });
     }
 
@@ -838,23 +764,18 @@ namespace cbdc::parsec::agent::rpc {
             return false;
         }
         auto params_str = params[0].asString();
-        auto maybe_runner_params
-            = cbdc::buffer::from_hex(params_str.substr(2));
-        if(!maybe_runner_params.has_value()) {
+        auto maybe_key = cbdc::buffer::from_hex(params_str.substr(2));
+        if(!maybe_key.has_value()) {
             m_log->warn("Unable to decode params", params_str);
             return false;
         }
-        auto runner_params = std::move(maybe_runner_params.value());
-        return exec_tx(
+        auto key = std::move(maybe_key.value());
+        return read_key(
+            std::move(key),
             callback,
-            runner::evm_runner_function::get_transaction_receipt,
-            runner_params,
-            true,
-            [callback, runner_params, this](interface::exec_return_type res) {
+            [callback, this](const broker::value_type& value) {
                 auto ret = Json::Value();
-                auto& updates = std::get<return_type>(res);
-                auto it = updates.find(runner_params);
-                if(it == updates.end() || it->second.size() == 0) {
+                if(value.size() == 0) {
                     ret["error"] = Json::Value();
                     ret["error"]["code"] = error_code::not_found;
                     ret["error"]["message"] = "Transaction not found";
@@ -863,7 +784,7 @@ namespace cbdc::parsec::agent::rpc {
                 }
 
                 auto maybe_rcpt
-                    = cbdc::from_buffer<runner::evm_tx_receipt>(it->second);
+                    = cbdc::from_buffer<runner::evm_tx_receipt>(value);
                 if(!maybe_rcpt.has_value()) {
                     ret["error"] = Json::Value();
                     ret["error"]["code"] = error_code::internal_error;
@@ -893,9 +814,9 @@ namespace cbdc::parsec::agent::rpc {
         }
 
         auto params_str = params[0].asString();
-        auto maybe_runner_params
-            = cbdc::buffer::from_hex(params_str.substr(2));
-        if(!maybe_runner_params.has_value()) {
+        auto maybe_addr = cbdc::buffer::from_hex(params_str.substr(2));
+        if(!maybe_addr.has_value()
+           || maybe_addr->size() != sizeof(evmc::address::bytes)) {
             m_log->warn("Unable to decode params", params_str);
             auto ret = Json::Value();
             ret["error"] = Json::Value();
@@ -905,23 +826,20 @@ namespace cbdc::parsec::agent::rpc {
             callback(ret);
             return false;
         }
-        auto runner_params = std::move(maybe_runner_params.value());
-        return exec_tx(
+        auto addr = evmc::address();
+        std::memcpy(addr.bytes, maybe_addr->data(), maybe_addr->size());
+        return read_key(
+            cbdc::make_buffer(code_key{addr}),
             callback,
-            runner::evm_runner_function::read_account_code,
-            runner_params,
-            true,
-            [callback, runner_params](interface::exec_return_type res) {
+            [callback](const broker::value_type& value) {
                 auto ret = Json::Value();
-                auto& updates = std::get<return_type>(res);
-                auto it = updates.find(runner_params);
-                if(it == updates.end() || it->second.size() == 0) {
+                if(value.size() == 0) {
                     // Return empty buffer when code not found
                     ret["result"] = "0x";
                     callback(ret);
                     return;
                 }
-                ret["result"] = "0x" + it->second.to_hex();
+                ret["result"] = "0x" + value.to_hex();
                 callback(ret);
             });
     }
@@ -1441,4 +1359,78 @@ namespace cbdc::parsec::agent::rpc {
         }();
         return a->exec();
     }
+
+    auto http_server::read_key(
+        broker::key_type key,
+        const server_type::result_callback_type& json_ret_callback,
+        const std::function<void(const broker::value_type&)>& res_success_cb)
+        -> bool {
+        auto keys = std::vector<broker::key_type>();
+        keys.emplace_back(std::move(key));
+        return read_keys(
+            std::move(keys),
+            json_ret_callback,
+            [res_success_cb](const std::vector<broker::value_type>& values) {
+                res_success_cb(values.front());
+            });
+    }
+
+    auto http_server::read_keys(
+        std::vector<broker::key_type> keys,
+        const server_type::result_callback_type& json_ret_callback,
+        const std::function<void(const std::vector<broker::value_type>&)>&
+            res_success_cb) -> bool {
+        struct read_state {
+            std::mutex m_mut;
+            std::vector<broker::value_type> m_values;
+            size_t m_pending{};
+            bool m_failed{false};
+        };
+
+        if(keys.empty()) {
+            res_success_cb({});
+            return true;
+        }
+
+        auto state = std::make_shared<read_state>();
+        state->m_values.resize(keys.size());
+        state->m_pending = keys.size();
+
+        for(size_t i = 0; i < keys.size(); i++) {
+            auto success = m_broker->read(
+                std::move(keys[i]),
+                std::nullopt,
+                [this, state, i, json_ret_callback, res_success_cb](
+                    broker::interface::read_return_type res) {
+                    std::unique_lock l(state->m_mut);
+                    if(state->m_failed) {
+                        return;
+                    }
+                    if(!std::holds_alternative<broker::value_type>(res)) {
+                        state->m_failed = true;
+                        l.unlock();
+                        m_log->warn("Failed to read key from shards");
+                        auto ret = Json::Value();
+                        ret["error"] = Json::Value();
+                        ret["error"]["code"] = error_code::execution_error;
+                        ret["error"]["message"] = "Execution error";
+                        json_ret_callback(ret);
+                        return;
+                    }
+                    state->m_values[i]
+                        = std::move(std::get<broker::value_type>(res));
+                    if(--state->m_pending == 0) {
+                        l.unlock();
+                        res_success_cb(state->m_values);
+                    }
+                });
+            if(!success) {
+                std::unique_lock l(state->m_mut);
+                state->m_failed = true;
+                return false;
+            }
+        }
+
+        return true;
+    }
 }
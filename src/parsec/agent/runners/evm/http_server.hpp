@@ -19,6 +19,7 @@
 #include <atomic>
 #include <secp256k1.h>
 #include <thread>
+#include <unordered_map>
 
 namespace cbdc::parsec::agent::rpc {
     /// RPC server for a agent. Manages retrying function execution if it fails
@@ -75,8 +76,31 @@ namespace cbdc::parsec::agent::rpc {
             execution_error = -32088,
         };
 
+        /// Handler for one JSON-RPC method.
+        using method_handler_type
+            = std::function<bool(Json::Value,
+                                 const server_type::result_callback_type&)>;
+
+        /// Handlers by method name.
+        std::unordered_map<std::string, method_handler_type> m_handlers;
+
+        /// Adds a handler for each of the given methods. The handler may be
+        /// a member function of the server or any other callable.
+        template<typename F>
+        void add_handler(std::initializer_list<const char*> methods, F fn);
+
+        /// Adds the handlers for the methods the agent implements.
+        void register_supported();
+
+        /// Adds the handlers for methods with fixed or local results.
+        void register_static();
+
+        /// Adds the handlers for methods the agent does not implement,
+        /// which return an error or a placeholder result.
+        void register_unsupported();
+
         auto request_handler(const std::string& method,
-                             const Json::Value& params,
+                             Json::Value params,
                              const server_type::result_callback_type& callback)
             -> bool;
 
@@ -208,23 +232,6 @@ namespace cbdc::parsec::agent::rpc {
                 const std::function<void(interface::exec_return_type)>&
                     res_success_cb) -> bool;
 
-        auto
-        handle_unsupported(const std::string& method,
-                           const Json::Value& params,
-                           const server_type::result_callback_type& callback)
-            -> bool;
-
-        auto
-        handle_supported(const std::string& method,
-                         const Json::Value& params,
-                         const server_type::result_callback_type& callback)
-            -> std::optional<bool>;
-
-        auto handle_static(const std::string& method,
-                           const Json::Value& params,
-                           const server_type::result_callback_type& callback)
-            -> std::optional<bool>;
-
         static auto extract_evm_log_query_addresses(
             Json::Value params,
             const server_type::result_callback_type& callback,
@@ -242,9 +249,26 @@ namespace cbdc::parsec::agent::rpc {
 
         static void handle_get_logs_result(
             const server_type::result_callback_type& callback,
-            const cbdc::buffer& runner_params,
             const runner::evm_log_query& qry,
-            interface::exec_return_type res);
+            const std::vector<broker::value_type>& values);
+
+        /// Reads the committed value of a key directly from the shards,
+        /// without running an agent, acquiring a ticket or taking locks.
+        auto read_key(
+            broker::key_type key,
+            const server_type::result_callback_type& json_ret_callback,
+            const std::function<void(const broker::value_type&)>&
+                res_success_cb) -> bool;
+
+        /// Reads the committed values of several keys concurrently. Calls
+        /// the success callback once with the values in the same order as
+        /// the keys, or reports an error to the JSON-RPC client if any read
+        /// fails.
+        auto read_keys(
+            std::vector<broker::key_type> keys,
+            const server_type::result_callback_type& json_ret_callback,
+            const std::function<void(const std::vector<broker::value_type>&)>&
+                res_success_cb) -> bool;
     };
 }
 
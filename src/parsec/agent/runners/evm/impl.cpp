@@ -14,7 +14,9 @@
 #include "util.hpp"
 #include "util/serialization/format.hpp"
 
+#include <algorithm>
 #include <future>
+#include <mutex>
 
 namespace cbdc::parsec::agent::runner {
     evm_runner::evm_runner(std::shared_ptr<logging::log> logger,
@@ -226,91 +228,67 @@ namespace cbdc::parsec::agent::runner {
         }
         auto qry = maybe_qry.value();
 
-        // First, determine the keys to query for log existence
+        // First, read the block index to find the buckets of tickets which
+        // emitted logs for each address
         auto keys = std::vector<cbdc::buffer>();
-        for(auto blk = qry.m_from_block; blk <= qry.m_to_block; blk++) {
-            for(auto& it : qry.m_addresses) {
-                keys.push_back(m_host->log_index_key(it, blk));
+        for(auto& addr : qry.m_addresses) {
+            for(auto& key : log_block_index_keys(addr,
+                                                 qry.m_from_block,
+                                                 qry.m_to_block)) {
+                keys.push_back(std::move(key));
             }
         }
 
         m_log->info(m_ticket_number,
                     "getting",
                     keys.size(),
-                    "keys from shards");
+                    "block index keys from shards");
 
-        auto log_indexes_mut = std::make_shared<std::mutex>();
-        auto log_indexes = std::make_shared<std::vector<evm_log_index>>();
-        auto acquired = std::make_shared<std::atomic<size_t>>();
-        for(auto& key : keys) {
-            auto success = m_try_lock_callback(
-                key,
-                broker::lock_type::read,
-                [this,
-                 acquired,
-                 log_indexes,
-                 log_indexes_mut,
-                 key_count = keys.size(),
-                 qry](const broker::interface::try_lock_return_type& res) {
-                    handle_get_logs_try_lock_response(qry,
-                                                      log_indexes,
-                                                      acquired,
-                                                      log_indexes_mut,
-                                                      key_count,
-                                                      res);
-                });
-            if(!success) {
-                m_log->error("Unable to lock logs index key");
-                m_result_callback(error_code::internal_error);
-                return false;
-            }
-        }
+        lock_keys(std::move(keys),
+                  broker::lock_type::read,
+                  [this, qry](const std::vector<broker::value_type>& values) {
+                      handle_get_logs_block_index(qry, values);
+                  });
 
         return true;
     }
 
-    void evm_runner::handle_get_logs_try_lock_response(
+    void evm_runner::handle_get_logs_block_index(
         const evm_log_query& qry,
-        const std::shared_ptr<std::vector<evm_log_index>>& log_indexes,
-        const std::shared_ptr<std::atomic<size_t>>& acquired,
-        const std::shared_ptr<std::mutex>& log_indexes_mut,
-        size_t key_count,
-        const broker::interface::try_lock_return_type& res) {
-        if(!std::holds_alternative<broker::value_type>(res)) {
-            m_log->error("Unable to read log key");
-            m_result_callback(error_code::function_load);
-            return;
-        }
+        const std::vector<broker::value_type>& flags) {
+        auto keys = log_index_keys(qry.m_addresses,
+                                   flags,
+                                   qry.m_from_block,
+                                   qry.m_to_block);
 
-        m_log->info(m_ticket_number, "got value from shard");
+        m_log->info(m_ticket_number,
+                    "getting",
+                    keys.size(),
+                    "log index keys from shards");
 
-        auto v = std::get<broker::value_type>(res);
-        auto maybe_logs = cbdc::from_buffer<evm_log_index>(v);
-        if(maybe_logs) {
-            // Found potentially relevant logs, add
-            std::unique_lock<std::mutex> lck(*log_indexes_mut);
-            log_indexes->push_back(maybe_logs.value());
-        }
-        if(++(*acquired) == key_count) {
-            handle_complete_get_logs(qry, log_indexes_mut, log_indexes);
-        }
+        lock_keys(std::move(keys),
+                  broker::lock_type::read,
+                  [this, qry](const std::vector<broker::value_type>& values) {
+                      handle_complete_get_logs(qry, values);
+                  });
     }
 
     void evm_runner::handle_complete_get_logs(
         const evm_log_query& qry,
-        const std::shared_ptr<std::mutex>& log_indexes_mut,
-        const std::shared_ptr<std::vector<evm_log_index>>& log_indexes) {
+        const std::vector<broker::value_type>& log_indexes) {
         m_log->info(m_ticket_number,
                     "completed all queries, filtering",
-                    log_indexes->size(),
+                    log_indexes.size(),
                     "logs");
 
-        // Scanned them all - finish
-        std::unique_lock<std::mutex> lck(*log_indexes_mut);
-
         // Filter the final logs by topics
         auto final_logs = std::vector<evm_log_index>();
-        for(auto& log_idx : *log_indexes) {
+        for(const auto& v : log_indexes) {
+            auto maybe_log_idx = cbdc::from_buffer<evm_log_index>(v);
+            if(!maybe_log_idx) {
+                continue;
+            }
+            auto& log_idx = maybe_log_idx.value();
             auto match = false;
             for(auto& log : log_idx.m_logs) {
                 for(auto& have_topic : log.m_topics) {
@@ -326,10 +304,9 @@ namespace cbdc::parsec::agent::runner {
                 }
             }
             if(match) {
-                final_logs.push_back(log_idx);
+                final_logs.push_back(std::move(log_idx));
             }
         }
-        lck.unlock();
 
         m_log->info(m_ticket_number,
                     "returning",
@@ -585,36 +562,106 @@ namespace cbdc::parsec::agent::runner {
             m_log->trace("EVM output data:", out_buf.to_hex());
 
             m_log->trace("Result status: ", result.status_code);
-            auto fn = [this, gas_left = result.gas_left]() {
+            auto fn = [this, gas_left = result.gas_left](
+                          runtime_locking_shard::state_update_type
+                              index_updates) {
                 auto gas_used = m_msg.gas - gas_left;
                 m_host->finalize(gas_left, gas_used);
                 auto state_updates = m_host->get_state_updates();
+                state_updates.merge(index_updates);
                 m_result_callback(state_updates);
             };
             lock_index_keys(fn);
         }
     }
 
-    void evm_runner::lock_index_keys(const std::function<void()>& callback) {
+    void evm_runner::lock_index_keys(
+        const std::function<void(runtime_locking_shard::state_update_type)>&
+            callback) {
         auto keys = m_host->get_log_index_keys();
         if(keys.empty()) {
-            callback();
+            callback({});
             return;
         }
-        auto acquired = std::make_shared<std::atomic<size_t>>();
-        for(auto& key : keys) {
+        // Transactions emitting logs for the same address share the block
+        // index flag of their bucket, so only take a read lock on it unless
+        // this is the first transaction to set it. Read locks do not
+        // conflict, so these transactions still commit concurrently.
+        auto flag_keys = m_host->get_log_block_index_keys();
+        lock_keys(
+            flag_keys,
+            broker::lock_type::read,
+            [this, callback, keys, flag_keys](
+                const std::vector<broker::value_type>& flags) {
+                auto write_keys = keys;
+                auto ret = runtime_locking_shard::state_update_type();
+                for(size_t i = 0; i < flag_keys.size(); i++) {
+                    if(flags[i].size() == 0) {
+                        write_keys.push_back(flag_keys[i]);
+                        ret[flag_keys[i]] = make_buffer(true);
+                    }
+                }
+                lock_keys(std::move(write_keys),
+                          broker::lock_type::write,
+                          [callback, ret](const std::vector<
+                                          broker::value_type>& /* values */) {
+                              callback(ret);
+                          });
+            });
+    }
+
+    void evm_runner::lock_keys(
+        std::vector<broker::key_type> keys,
+        broker::lock_type locktype,
+        const std::function<void(const std::vector<broker::value_type>&)>&
+            callback) {
+        struct lock_state {
+            std::mutex m_mut;
+            std::vector<broker::value_type> m_values;
+            size_t m_pending{};
+            bool m_failed{false};
+        };
+
+        if(keys.empty()) {
+            callback({});
+            return;
+        }
+
+        auto state = std::make_shared<lock_state>();
+        state->m_values.resize(keys.size());
+        state->m_pending = keys.size();
+
+        for(size_t i = 0; i < keys.size(); i++) {
             auto success = m_try_lock_callback(
-                key,
-                broker::lock_type::write,
-                [acquired, callback, key_count = keys.size()](
-                    const broker::interface::try_lock_return_type&) {
-                    if(++(*acquired) == key_count) {
-                        callback();
+                std::move(keys[i]),
+                locktype,
+                [this, state, i, callback](
+                    const broker::interface::try_lock_return_type& res) {
+                    std::unique_lock l(state->m_mut);
+                    if(state->m_failed) {
+                        return;
+                    }
+                    if(!std::holds_alternative<broker::value_type>(res)) {
+                        state->m_failed = true;
+                        l.unlock();
+                        m_log->debug("Failed to lock key");
+                        m_result_callback(error_code::wounded);
+                        return;
+                    }
+                    state->m_values[i] = std::get<broker::value_type>(res);
+                    if(--state->m_pending == 0) {
+                        l.unlock();
+                        callback(state->m_values);
                     }
                 });
             if(!success) {
-                m_log->error("Unable to lock logs index key");
-                m_result_callback(error_code::internal_error);
+                std::unique_lock l(state->m_mut);
+                if(!state->m_failed) {
+                    state->m_failed = true;
+                    l.unlock();
+                    m_log->error("Unable to lock key");
+                    m_result_callback(error_code::internal_error);
+                }
                 return;
             }
         }
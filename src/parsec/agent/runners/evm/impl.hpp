@@ -111,7 +111,14 @@ namespace cbdc::parsec::agent::runner {
             const broker::interface::try_lock_return_type& res);
 
         void lock_ticket_number_key();
-        void lock_index_keys(const std::function<void()>& callback);
+        void lock_index_keys(
+            const std::function<
+                void(runtime_locking_shard::state_update_type)>& callback);
+        void lock_keys(
+            std::vector<broker::key_type> keys,
+            broker::lock_type locktype,
+            const std::function<void(const std::vector<broker::value_type>&)>&
+                callback);
         void schedule_exec();
 
         void schedule(const std::function<void()>& fn);
@@ -121,18 +128,13 @@ namespace cbdc::parsec::agent::runner {
         static auto make_pretend_block(interface::ticket_number_type tn)
             -> evm_pretend_block;
 
-        void handle_get_logs_try_lock_response(
+        void handle_get_logs_block_index(
             const evm_log_query& qry,
-            const std::shared_ptr<std::vector<evm_log_index>>& log_indexes,
-            const std::shared_ptr<std::atomic<size_t>>& acquired,
-            const std::shared_ptr<std::mutex>& log_indexes_mut,
-            size_t key_count,
-            const broker::interface::try_lock_return_type& res);
+            const std::vector<broker::value_type>& flags);
 
         void handle_complete_get_logs(
             const evm_log_query& qry,
-            const std::shared_ptr<std::mutex>& log_indexes_mut,
-            const std::shared_ptr<std::vector<evm_log_index>>& log_indexes);
+            const std::vector<broker::value_type>& log_indexes);
 
         void lock_tx_receipt(const broker::value_type& value,
                              const ticket_number_type& ticket_number);
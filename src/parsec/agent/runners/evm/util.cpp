@@ -15,6 +15,8 @@
 #include "util/common/hash.hpp"
 #include "util/serialization/util.hpp"
 
+#include <algorithm>
+#include <cassert>
 #include <future>
 #include <optional>
 #include <secp256k1.h>
@@ -24,6 +26,89 @@ namespace cbdc::parsec::agent::runner {
         return evmc::load64be(&v.bytes[sizeof(v.bytes) - sizeof(uint64_t)]);
     }
 
+    auto log_index_key(const evmc::address& addr,
+                       interface::ticket_number_type tn) -> cbdc::buffer {
+        auto tn_buf = cbdc::make_buffer(tn);
+        CSHA256 sha;
+        hash_t log_index_hash;
+        sha.Write(addr.bytes, sizeof(addr.bytes));
+        sha.Write(tn_buf.c_ptr(), tn_buf.size());
+        sha.Finalize(log_index_hash.data());
+
+        return make_buffer(log_index_hash);
+    }
+
+    namespace {
+        auto log_block_index_bucket_key(const evmc::address& addr,
+                                        interface::ticket_number_type bucket)
+            -> cbdc::buffer {
+            auto bucket_buf = cbdc::make_buffer(bucket);
+            CSHA256 sha;
+            hash_t log_block_index_hash;
+            sha.Write(addr.bytes, sizeof(addr.bytes));
+            sha.Write(bucket_buf.c_ptr(), bucket_buf.size());
+            sha.Finalize(log_block_index_hash.data());
+
+            return make_buffer(log_block_index_hash);
+        }
+    }
+
+    auto log_block_index_key(const evmc::address& addr,
+                             interface::ticket_number_type tn)
+        -> cbdc::buffer {
+        return log_block_index_bucket_key(addr,
+                                          tn / log_block_index_bucket_size);
+    }
+
+    auto log_block_index_keys(const evmc::address& addr,
+                              interface::ticket_number_type from_tn,
+                              interface::ticket_number_type to_tn)
+        -> std::vector<cbdc::buffer> {
+        auto keys = std::vector<cbdc::buffer>();
+        if(to_tn < from_tn) {
+            return keys;
+        }
+        for(auto bucket = from_tn / log_block_index_bucket_size;
+            bucket <= to_tn / log_block_index_bucket_size;
+            bucket++) {
+            keys.push_back(log_block_index_bucket_key(addr, bucket));
+        }
+        return keys;
+    }
+
+    auto log_index_keys(const std::vector<evmc::address>& addrs,
+                        const std::vector<cbdc::buffer>& flags,
+                        interface::ticket_number_type from_tn,
+                        interface::ticket_number_type to_tn)
+        -> std::vector<cbdc::buffer> {
+        auto keys = std::vector<cbdc::buffer>();
+        if(to_tn < from_tn) {
+            return keys;
+        }
+        const auto first_bucket = from_tn / log_block_index_bucket_size;
+        const auto n_buckets
+            = to_tn / log_block_index_bucket_size - first_bucket + 1;
+        assert(flags.size() == addrs.size() * n_buckets);
+        for(size_t i = 0; i < flags.size(); i++) {
+            if(flags[i].size() == 0) {
+                // No logs for the address in this bucket
+                continue;
+            }
+            const auto& addr = addrs[i / n_buckets];
+            const auto bucket = first_bucket + i % n_buckets;
+            const auto first
+                = std::max(from_tn, bucket * log_block_index_bucket_size);
+            const auto last
+                = std::min(to_tn,
+                           bucket * log_block_index_bucket_size
+                               + (log_block_index_bucket_size - 1));
+            for(auto tn = first; tn <= last; tn++) {
+                keys.push_back(log_index_key(addr, tn));
+            }
+        }
+        return keys;
+    }
+
     auto to_hex(const evmc::address& addr) -> std::string {
         return evmc::hex(evmc::bytes(addr.bytes, sizeof(addr.bytes)));
     }
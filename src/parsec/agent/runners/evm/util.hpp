@@ -77,6 +77,57 @@ namespace cbdc::parsec::agent::runner {
     auto uint256be_from_hex(const std::string& hex)
         -> std::optional<evmc::uint256be>;
 
+    /// Returns the key for the indicator of the existence of logs for a
+    /// particular address at a particular ticket.
+    /// \param addr address which emitted the logs.
+    /// \param tn ticket number which emitted the logs.
+    /// \return log index key.
+    auto log_index_key(const evmc::address& addr,
+                       interface::ticket_number_type tn) -> cbdc::buffer;
+
+    /// Number of consecutive ticket numbers covered by each flag of the log
+    /// block index.
+    static constexpr interface::ticket_number_type
+        log_block_index_bucket_size = 64;
+
+    /// Returns the key of the log block index flag which is set once an
+    /// address emits logs at any ticket in a bucket. The flag is only
+    /// written by the first transaction to emit logs for the address in the
+    /// bucket, so later ones only need a read lock on it. Logs emitted
+    /// before the index existed have no flag and are not found by log
+    /// queries.
+    /// \param addr address which emitted the logs.
+    /// \param tn ticket number which emitted the logs.
+    /// \return log block index key.
+    auto log_block_index_key(const evmc::address& addr,
+                             interface::ticket_number_type tn)
+        -> cbdc::buffer;
+
+    /// Returns the keys of the log block index flags for each bucket which
+    /// overlaps a range of ticket numbers, in ascending order.
+    /// \param addr address which emitted the logs.
+    /// \param from_tn first ticket number in the range.
+    /// \param to_tn last ticket number in the range, inclusive.
+    /// \return log block index keys.
+    auto log_block_index_keys(const evmc::address& addr,
+                              interface::ticket_number_type from_tn,
+                              interface::ticket_number_type to_tn)
+        -> std::vector<cbdc::buffer>;
+
+    /// Returns the log index keys to read for the tickets within a range in
+    /// the buckets where the log block index flag is set.
+    /// \param addrs addresses whose logs to read.
+    /// \param flags values of the keys returned by log_block_index_keys for
+    ///              each address in turn, empty where the flag is unset.
+    /// \param from_tn first ticket number in the range.
+    /// \param to_tn last ticket number in the range, inclusive.
+    /// \return log index keys.
+    auto log_index_keys(const std::vector<evmc::address>& addrs,
+                        const std::vector<cbdc::buffer>& flags,
+                        interface::ticket_number_type from_tn,
+                        interface::ticket_number_type to_tn)
+        -> std::vector<cbdc::buffer>;
+
     /// Mints a set of initial accounts with funds, bypassing the agent.
     /// \param log logger instance.
     /// \param broker broker instance to mint with.
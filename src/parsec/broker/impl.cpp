@@ -801,6 +801,52 @@ namespace cbdc::parsec::broker {
         }
     }
 
+    auto impl::read(key_type key,
+                    std::optional<ticket_number_type> as_of,
+                    read_callback_type result_callback) -> bool {
+        if(!m_directory->key_location(
+               key,
+               [=, this](std::optional<parsec::directory::interface::
+                                           key_location_return_type> res) {
+                   handle_read_find_key(key, as_of, result_callback, res);
+               })) {
+            m_log->error("Failed to make key location directory request");
+            result_callback(error_code::directory_unreachable);
+        }
+
+        return true;
+    }
+
+    void impl::handle_read_find_key(
+        key_type key,
+        std::optional<ticket_number_type> as_of,
+        const read_callback_type& result_callback,
+        std::optional<parsec::directory::interface::key_location_return_type>
+            res) {
+        if(!res.has_value()) {
+            result_callback(error_code::directory_unreachable);
+            return;
+        }
+
+        auto shard_idx = res.value();
+        assert(shard_idx < m_shards.size());
+        if(!m_shards[shard_idx]->read(
+               std::move(key),
+               as_of,
+               [result_callback](
+                   const parsec::runtime_locking_shard::interface::
+                       read_return_type& read_res) {
+                   std::visit(
+                       [&](auto&& v) {
+                           result_callback(v);
+                       },
+                       read_res);
+               })) {
+            m_log->error("Failed to make read shard request");
+            result_callback(error_code::shard_unreachable);
+        }
+    }
+
     void impl::handle_finish(
         const finish_callback_type& result_callback,
         ticket_number_type ticket_number,
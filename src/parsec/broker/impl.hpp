@@ -80,6 +80,18 @@ namespace cbdc::parsec::broker {
         /// \return true if requests to all shards were initiated successfully.
         auto recover(recover_callback_type result_callback) -> bool override;
 
+        /// Determines the shard responsible for the given key and issues a
+        /// lock-free read request for the key.
+        /// \param key key to read.
+        /// \param as_of ticket number as of which to read the key, or
+        ///              std::nullopt to read the latest committed value.
+        /// \param result_callback function to call with read result.
+        /// \return true if the request to the directory was initiated
+        ///         successfully.
+        auto read(key_type key,
+                  std::optional<ticket_number_type> as_of,
+                  read_callback_type result_callback) -> bool override;
+
         /// Get the highest ticket number that was used. This is not to be
         /// used for calculating a next ticket number, but is used to calculate
         /// the pretend height of the chain in the evm runner, which is derived
@@ -192,6 +204,13 @@ namespace cbdc::parsec::broker {
             std::optional<
                 parsec::directory::interface::key_location_return_type> res);
 
+        void handle_read_find_key(
+            key_type key,
+            std::optional<ticket_number_type> as_of,
+            const read_callback_type& result_callback,
+            std::optional<
+                parsec::directory::interface::key_location_return_type> res);
+
         void handle_finish(
             const finish_callback_type& result_callback,
             ticket_number_type ticket_number,
@@ -185,6 +185,27 @@ namespace cbdc::parsec::broker {
         recover(recover_callback_type result_callback) -> bool
             = 0;
 
+        /// Return type from a read operation. Either the value associated
+        /// with the requested key, a broker error, or a shard error.
+        using read_return_type = try_lock_return_type;
+        /// Callback function type for a read operation.
+        using read_callback_type = std::function<void(read_return_type)>;
+
+        /// Reads the committed value of the given key from the appropriate
+        /// shard without a ticket and without acquiring any locks. Intended
+        /// for read-only queries which do not need to be serialized with
+        /// concurrent transactions.
+        /// \param key key to read.
+        /// \param as_of ticket number as of which to read the key, or
+        ///              std::nullopt to read the latest committed value.
+        /// \param result_callback function to call with read result.
+        /// \return true if the operation was initiated successfully.
+        [[nodiscard]] virtual auto read(key_type key,
+                                        std::optional<ticket_number_type> as_of,
+                                        read_callback_type result_callback)
+            -> bool
+            = 0;
+
         /// Get the highest ticket number that was used. This is not to be
         /// used for calculating a next ticket number, but is used to calculate
         /// the pretend height of the chain in the evm runner, which is derived
@@ -0,0 +1,174 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "consistent_hash.hpp"
+
+#include "util/serialization/format.hpp"
+#include "util/serialization/util.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace cbdc::parsec::directory {
+    consistent_hash::consistent_hash(size_t n_shards,
+                                     size_t vnodes,
+                                     size_t max_tracked_keys,
+                                     size_t sample_interval)
+        : m_vnodes(std::max(vnodes, size_t{1})),
+          m_max_tracked_keys(max_tracked_keys),
+          m_sample_interval(std::max(sample_interval, size_t{1})) {
+        m_ring.reserve(n_shards * m_vnodes);
+        for(size_t i = 0; i < n_shards; i++) {
+            add_vnodes(m_next_shard_id++);
+        }
+    }
+
+    auto
+    consistent_hash::key_location(runtime_locking_shard::key_type key,
+                                  key_location_callback_type result_callback)
+        -> bool {
+        auto key_hash = m_siphash(key);
+        record_access(key, key_hash);
+        auto shard = [&]() {
+            std::shared_lock l(m_mut);
+            assert(!m_ring.empty());
+            return successor(key_hash)->second;
+        }();
+        result_callback(shard);
+        return true;
+    }
+
+    auto consistent_hash::add_shard() -> key_location_return_type {
+        std::unique_lock l(m_mut);
+        auto shard_id = m_next_shard_id++;
+        add_vnodes(shard_id);
+        return shard_id;
+    }
+
+    auto consistent_hash::remove_shard(key_location_return_type shard_id)
+        -> bool {
+        std::unique_lock l(m_mut);
+        if(!has_shard(shard_id)) {
+            return false;
+        }
+        if(m_ring.size() == m_vnodes) {
+            return false;
+        }
+        m_ring.erase(std::remove_if(m_ring.begin(),
+                                    m_ring.end(),
+                                    [&](const vnode_type& vnode) {
+                                        return vnode.second == shard_id;
+                                    }),
+                     m_ring.end());
+        return true;
+    }
+
+    auto consistent_hash::access_count(
+        const runtime_locking_shard::key_type& key) const -> uint64_t {
+        const auto& stripe = m_counters[m_siphash(key) % n_counter_stripes];
+        std::unique_lock l(stripe.m_mut);
+        auto it = stripe.m_counts.find(key);
+        if(it == stripe.m_counts.end()) {
+            return 0;
+        }
+        return it->second * m_sample_interval;
+    }
+
+    auto consistent_hash::hot_keys(size_t n) const
+        -> std::vector<std::pair<runtime_locking_shard::key_type, uint64_t>> {
+        auto ret = std::vector<
+            std::pair<runtime_locking_shard::key_type, uint64_t>>();
+        for(const auto& stripe : m_counters) {
+            std::unique_lock l(stripe.m_mut);
+            ret.insert(ret.end(),
+                       stripe.m_counts.begin(),
+                       stripe.m_counts.end());
+        }
+        n = std::min(n, ret.size());
+        std::partial_sort(ret.begin(),
+                          ret.begin() + static_cast<ptrdiff_t>(n),
+                          ret.end(),
+                          [](const auto& a, const auto& b) {
+                              return a.second > b.second;
+                          });
+        ret.resize(n);
+        for(auto& [key, count] : ret) {
+            count *= m_sample_interval;
+        }
+        return ret;
+    }
+
+    void consistent_hash::reset_access_counts() {
+        for(auto& stripe : m_counters) {
+            std::unique_lock l(stripe.m_mut);
+            stripe.m_counts.clear();
+        }
+    }
+
+    void consistent_hash::add_vnodes(key_location_return_type shard_id) {
+        for(uint64_t i = 0; i < m_vnodes; i++) {
+            auto pos = m_siphash(make_buffer(std::make_pair(shard_id, i)));
+            m_ring.emplace_back(pos, shard_id);
+        }
+        std::sort(m_ring.begin(), m_ring.end());
+    }
+
+    auto consistent_hash::has_shard(key_location_return_type shard_id) const
+        -> bool {
+        return std::any_of(m_ring.begin(),
+                           m_ring.end(),
+                           [&](const vnode_type& vnode) {
+                               return vnode.second == shard_id;
+                           });
+    }
+
+    auto consistent_hash::successor(uint64_t key_hash) const
+        -> std::vector<vnode_type>::const_iterator {
+        auto it = std::lower_bound(
+            m_ring.begin(),
+            m_ring.end(),
+            key_hash,
+            [](const vnode_type& vnode, uint64_t h) {
+                return vnode.first < h;
+            });
+        // Wrap around to the start of the ring
+        if(it == m_ring.end()) {
+            it = m_ring.begin();
+        }
+        return it;
+    }
+
+    void
+    consistent_hash::record_access(const runtime_locking_shard::key_type& key,
+                                   uint64_t key_hash) {
+        if(m_max_tracked_keys == 0) {
+            return;
+        }
+        // Only every m_sample_interval'th lookup on each thread takes a
+        // stripe lock, so lookups of hot keys rarely contend
+        thread_local uint64_t n_lookups{0};
+        if(++n_lookups % m_sample_interval != 0) {
+            return;
+        }
+        auto& stripe = m_counters[key_hash % n_counter_stripes];
+        std::unique_lock l(stripe.m_mut);
+        stripe.m_counts[key]++;
+        auto max_stripe_keys
+            = std::max(m_max_tracked_keys / n_counter_stripes, size_t{1});
+        if(stripe.m_counts.size() <= max_stripe_keys) {
+            return;
+        }
+        // Age all the counts so that frequently accessed keys remain
+        // tracked while rarely accessed keys are dropped
+        for(auto it = stripe.m_counts.begin(); it != stripe.m_counts.end();) {
+            it->second /= 2;
+            if(it->second == 0) {
+                it = stripe.m_counts.erase(it);
+            } else {
+                it++;
+            }
+        }
+    }
+}
@@ -0,0 +1,131 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef OPENCBDC_TX_SRC_PARSEC_DIRECTORY_CONSISTENT_HASH_H_
+#define OPENCBDC_TX_SRC_PARSEC_DIRECTORY_CONSISTENT_HASH_H_
+
+#include "interface.hpp"
+#include "util/common/hashmap.hpp"
+
+#include <array>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace cbdc::parsec::directory {
+    /// Directory which maps keys to shard IDs using a consistent hash ring.
+    /// Each shard is placed on the ring at a number of virtual nodes, and
+    /// keys belong to the shard of the first virtual node following the
+    /// hash of the key. Adding or removing a shard only moves the keys
+    /// adjacent to its virtual nodes. Samples accesses to each key to
+    /// report the hottest keys. Thread-safe.
+    class consistent_hash : public interface {
+      public:
+        /// Default number of virtual nodes per shard.
+        static constexpr size_t default_vnodes = 128;
+        /// Default maximum number of keys with tracked access counts.
+        static constexpr size_t default_max_tracked_keys = 65536;
+        /// Default number of key lookups per sampled access.
+        static constexpr size_t default_sample_interval = 64;
+
+        /// Constructor.
+        /// \param n_shards number of shards available to the directory.
+        /// \param vnodes number of virtual nodes to place on the ring for
+        ///               each shard. Must be at least one.
+        /// \param max_tracked_keys maximum number of keys for which to track
+        ///                         access counts. When exceeded, all counts
+        ///                         are halved and keys with no remaining
+        ///                         accesses are no longer tracked. Zero
+        ///                         disables access counting.
+        /// \param sample_interval number of key lookups by each thread per
+        ///                        recorded access. Lookups which are not
+        ///                        sampled do not touch the access counts.
+        ///                        Must be at least one.
+        explicit consistent_hash(size_t n_shards,
+                                 size_t vnodes = default_vnodes,
+                                 size_t max_tracked_keys
+                                 = default_max_tracked_keys,
+                                 size_t sample_interval
+                                 = default_sample_interval);
+
+        /// Returns the shard ID owning the given key on the ring. Samples
+        /// an access to the key. Calls the callback before returning.
+        /// \param key key to locate.
+        /// \param result_callback function to call with key location.
+        /// \return true.
+        auto key_location(runtime_locking_shard::key_type key,
+                          key_location_callback_type result_callback)
+            -> bool override;
+
+        /// Adds a new shard to the ring, taking over the keys adjacent to its
+        /// virtual nodes.
+        /// \return ID of the new shard.
+        auto add_shard() -> key_location_return_type;
+
+        /// Removes a shard from the ring. Its keys move to the shards
+        /// following its virtual nodes.
+        /// \param shard_id ID of the shard to remove.
+        /// \return false if the shard is not on the ring or is the last
+        ///         shard on the ring.
+        auto remove_shard(key_location_return_type shard_id) -> bool;
+
+        /// Returns the estimated number of accesses to the given key.
+        /// \param key key to query.
+        /// \return sampled access count multiplied by the sample interval.
+        [[nodiscard]] auto
+        access_count(const runtime_locking_shard::key_type& key) const
+            -> uint64_t;
+
+        /// Returns the keys with the most sampled accesses.
+        /// \param n maximum number of keys to return.
+        /// \return keys and their estimated access counts, in descending
+        ///         order of access count.
+        [[nodiscard]] auto hot_keys(size_t n) const -> std::vector<
+            std::pair<runtime_locking_shard::key_type, uint64_t>>;
+
+        /// Clears all recorded access counts.
+        void reset_access_counts();
+
+      private:
+        using vnode_type = std::pair<uint64_t, key_location_return_type>;
+
+        struct counter_stripe_type {
+            mutable std::mutex m_mut;
+            std::unordered_map<runtime_locking_shard::key_type,
+                               uint64_t,
+                               hashing::const_sip_hash<
+                                   runtime_locking_shard::key_type>>
+                m_counts;
+        };
+
+        static constexpr size_t n_counter_stripes = 16;
+
+        size_t m_vnodes;
+        size_t m_max_tracked_keys;
+        size_t m_sample_interval;
+        hashing::const_sip_hash<runtime_locking_shard::key_type> m_siphash{};
+
+        mutable std::shared_mutex m_mut;
+        /// Virtual nodes sorted by position on the ring.
+        std::vector<vnode_type> m_ring;
+        key_location_return_type m_next_shard_id{};
+
+        std::array<counter_stripe_type, n_counter_stripes> m_counters;
+
+        void add_vnodes(key_location_return_type shard_id);
+
+        [[nodiscard]] auto has_shard(key_location_return_type shard_id) const
+            -> bool;
+
+        [[nodiscard]] auto successor(uint64_t key_hash) const
+            -> std::vector<vnode_type>::const_iterator;
+
+        void record_access(const runtime_locking_shard::key_type& key,
+                           uint64_t key_hash);
+    };
+}
+
+#endif
@@ -106,4 +106,17 @@ namespace cbdc::parsec::runtime_locking_shard::rpc {
                     std::get<get_tickets_return_type>(resp.value()));
             });
     }
+
+    auto client::read(key_type key,
+                      std::optional<ticket_number_type> as_of,
+                      read_callback_type result_callback) -> bool {
+        auto req = read_request{std::move(key), as_of};
+        return m_client->call(
+            std::move(req),
+            [result_callback](std::optional<response> resp) {
+                assert(resp.has_value());
+                assert(std::holds_alternative<read_return_type>(resp.value()));
+                result_callback(std::get<read_return_type>(resp.value()));
+            });
+    }
 }
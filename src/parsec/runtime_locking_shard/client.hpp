@@ -86,6 +86,16 @@ namespace cbdc::parsec::runtime_locking_shard::rpc {
                          get_tickets_callback_type result_callback)
             -> bool override;
 
+        /// Requests a lock-free read operation from the remote shard.
+        /// \param key key to read.
+        /// \param as_of ticket number as of which to read the key, or
+        ///              std::nullopt to read the latest committed value.
+        /// \param result_callback function to call with the read result.
+        /// \return true if the request was sent successfully.
+        auto read(key_type key,
+                  std::optional<ticket_number_type> as_of,
+                  read_callback_type result_callback) -> bool override;
+
       private:
         std::unique_ptr<cbdc::rpc::tcp_client<request, response>> m_client;
     };
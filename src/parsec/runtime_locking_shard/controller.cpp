@@ -16,7 +16,8 @@ namespace cbdc::parsec::runtime_locking_shard {
                            size_t node_id,
                            network::endpoint_t server_endpoint,
                            std::vector<network::endpoint_t> raft_endpoints,
-                           std::shared_ptr<logging::log> logger)
+                           std::shared_ptr<logging::log> logger,
+                           cbdc::config::raft_log_store_type log_store_type)
         : m_logger(std::move(logger)),
           m_state_machine(nuraft::cs_new<state_machine>()),
           m_raft_serv(std::make_shared<raft::node>(
@@ -30,7 +31,8 @@ namespace cbdc::parsec::runtime_locking_shard {
               [&](auto&& res, auto&& err) {
                   return raft_callback(std::forward<decltype(res)>(res),
                                        std::forward<decltype(err)>(err));
-              })),
+              },
+              log_store_type)),
           m_raft_client(
               std::make_shared<replicated_shard_client>(m_raft_serv)),
           m_raft_endpoints(std::move(raft_endpoints)),
@@ -24,11 +24,14 @@ namespace cbdc::parsec::runtime_locking_shard {
         /// \param raft_endpoints vector of raft endpoints for nodes in the
         ///                       cluster.
         /// \param logger log to use for output.
+        /// \param log_store_type storage implementation for the raft log.
         controller(size_t component_id,
                    size_t node_id,
                    network::endpoint_t server_endpoint,
                    std::vector<network::endpoint_t> raft_endpoints,
-                   std::shared_ptr<logging::log> logger);
+                   std::shared_ptr<logging::log> logger,
+                   cbdc::config::raft_log_store_type log_store_type
+                   = cbdc::config::defaults::raft_log_store);
         ~controller() = default;
 
         controller() = delete;
@@ -85,6 +85,18 @@ namespace cbdc {
         return deser >> req.m_broker_id;
     }
 
+    auto
+    operator<<(serializer& ser,
+               const parsec::runtime_locking_shard::rpc::read_request& req)
+        -> serializer& {
+        return ser << req.m_key << req.m_as_of;
+    }
+    auto operator>>(serializer& deser,
+                    parsec::runtime_locking_shard::rpc::read_request& req)
+        -> serializer& {
+        return deser >> req.m_key >> req.m_as_of;
+    }
+
     auto operator<<(serializer& ser,
                     const parsec::runtime_locking_shard::shard_error& err)
         -> serializer& {
@@ -59,6 +59,14 @@ namespace cbdc {
                parsec::runtime_locking_shard::rpc::get_tickets_request& req)
         -> serializer&;
 
+    auto
+    operator<<(serializer& ser,
+               const parsec::runtime_locking_shard::rpc::read_request& req)
+        -> serializer&;
+    auto operator>>(serializer& deser,
+                    parsec::runtime_locking_shard::rpc::read_request& req)
+        -> serializer&;
+
     auto operator<<(serializer& ser,
                     const parsec::runtime_locking_shard::shard_error& err)
         -> serializer&;
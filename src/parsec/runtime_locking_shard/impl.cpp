@@ -5,11 +5,17 @@
 
 #include "impl.hpp"
 
+#include <algorithm>
 #include <cassert>
 
 namespace cbdc::parsec::runtime_locking_shard {
-    impl::impl(std::shared_ptr<logging::log> logger)
-        : m_log(std::move(logger)) {}
+    impl::impl(std::shared_ptr<logging::log> logger,
+               size_t max_versions,
+               size_t segments)
+        : m_log(std::move(logger)),
+          m_max_versions(std::max(max_versions, size_t{1})),
+          m_key_segments(std::max(segments, size_t{1})),
+          m_ticket_segments(std::max(segments, size_t{1})) {}
 
     auto impl::try_lock(ticket_number_type ticket_number,
                         broker_id_type broker_id,
@@ -17,75 +23,52 @@ namespace cbdc::parsec::runtime_locking_shard {
                         lock_type locktype,
                         bool first_lock,
                         try_lock_callback_type result_callback) -> bool {
+        if(auto res = try_lock_uncontended(ticket_number,
+                                           broker_id,
+                                           key,
+                                           locktype,
+                                           first_lock)) {
+            result_callback(std::move(res.value()));
+            return true;
+        }
+
         auto callbacks = pending_callbacks_list_type();
-        auto w_details = std::optional<wounded_details>();
-        auto maybe_error = [&]() -> std::optional<error_code> {
-            std::unique_lock<std::mutex> l(m_mut);
+        auto maybe_error = [&]() -> std::optional<shard_error> {
+            std::unique_lock l(m_mut);
 
             m_log->trace(ticket_number,
                          "requesting lock on",
                          key.to_hex(),
                          static_cast<int>(locktype));
 
-            auto it = m_tickets.find(ticket_number);
-            if(first_lock && it != m_tickets.end()) {
+            auto& tickets = ticket_segment(ticket_number).m_tickets;
+            auto it = tickets.find(ticket_number);
+            if(first_lock && it != tickets.end()) {
                 m_log->fatal(ticket_number,
                              "called try_lock with first lock but ticket "
                              "already exists");
             }
-            if(it == m_tickets.end()) {
+            if(it == tickets.end()) {
                 if(!first_lock) {
                     m_log->error(ticket_number,
                                  "called try_lock with unknown ticket");
-                    return error_code::unknown_ticket;
+                    return shard_error{error_code::unknown_ticket,
+                                       std::nullopt};
                 }
-                it = m_tickets.emplace(ticket_number, ticket_state_type{})
+                it = tickets.emplace(ticket_number, ticket_state_type{})
                          .first;
             }
             auto& ticket = it->second;
 
-            // Callers shouldn't be using try_lock after prepare
-            if(ticket.m_state == ticket_state::prepared) {
-                m_log->error(ticket_number, "called try_lock after prepare");
-                return error_code::prepared;
-            }
-
-            if(ticket.m_state == ticket_state::committed) {
-                m_log->error(ticket_number, "called try_lock after commit");
-                return error_code::committed;
-            }
-
-            // If the ticket way wounded don't bother trying to acquire any
-            // locks
-            if(ticket.m_state == ticket_state::wounded) {
-                m_log->trace(ticket_number,
-                             "called try_lock after being wounded");
-                w_details = ticket.m_wounded_details;
-                return error_code::wounded;
-            }
-
-            // Make sure the ticket doesn't already hold a lock on the key
-            if(auto lock_it = ticket.m_locks_held.find(key);
-               lock_it != ticket.m_locks_held.end()
-               && lock_it->second >= locktype) {
-                m_log->warn(this,
-                            ticket_number,
-                            "tried to acquire already held lock");
-                return error_code::lock_held;
-            }
-
-            if(ticket.m_queued_locks.find(key)
-               != ticket.m_queued_locks.end()) {
-                m_log->warn(ticket_number,
-                            "tried to acquire already queued lock");
-                return error_code::lock_queued;
+            if(auto err
+               = check_try_lock(ticket_number, key, locktype, ticket)) {
+                return err;
             }
 
             ticket.m_broker_id = broker_id;
 
-            // Grab the requested state element
-            auto& state_element = m_state[key];
-            auto& lock = state_element.m_lock;
+            // Grab the requested lock
+            auto& lock = lock_state(key);
 
             // Queue the lock
             lock.m_queue.emplace(
@@ -98,14 +81,12 @@ namespace cbdc::parsec::runtime_locking_shard {
             callbacks
                 = wound_tickets(std::move(key), waiting_on, ticket_number);
 
-            w_details = ticket.m_wounded_details;
-
             m_log->trace(this, "shard handled try_lock for", ticket_number);
             return std::nullopt;
         }();
 
         if(maybe_error.has_value()) {
-            result_callback(shard_error{maybe_error.value(), w_details});
+            result_callback(maybe_error.value());
         } else {
             // Call all the result callbacks without holding the lock
             for(auto& callback : callbacks) {
@@ -116,6 +97,114 @@ namespace cbdc::parsec::runtime_locking_shard {
         return true;
     }
 
+    auto impl::try_lock_uncontended(ticket_number_type ticket_number,
+                                    broker_id_type broker_id,
+                                    const key_type& key,
+                                    lock_type locktype,
+                                    bool first_lock)
+        -> std::optional<try_lock_return_type> {
+        std::shared_lock l(m_mut);
+
+        m_log->trace(ticket_number,
+                     "requesting lock on",
+                     key.to_hex(),
+                     static_cast<int>(locktype));
+
+        auto& t_segment = ticket_segment(ticket_number);
+        std::unique_lock tl(t_segment.m_mut);
+        auto it = t_segment.m_tickets.find(ticket_number);
+        if(first_lock && it != t_segment.m_tickets.end()) {
+            m_log->fatal(ticket_number,
+                         "called try_lock with first lock but ticket "
+                         "already exists");
+        }
+        if(it == t_segment.m_tickets.end()) {
+            if(!first_lock) {
+                m_log->error(ticket_number,
+                             "called try_lock with unknown ticket");
+                return shard_error{error_code::unknown_ticket, std::nullopt};
+            }
+        } else if(auto err
+                  = check_try_lock(ticket_number, key, locktype, it->second)) {
+            return err;
+        }
+
+        auto& k_segment = key_segment(key);
+        std::unique_lock kl(k_segment.m_mut);
+        auto& lock = k_segment.m_state[key].m_lock;
+
+        // Only grant the lock here if no other ticket is involved, otherwise
+        // the caller needs to queue the lock under the exclusive latch
+        if(!lock.m_queue.empty() || lock.m_writer.has_value()) {
+            return std::nullopt;
+        }
+        if(locktype == lock_type::write) {
+            if(lock.m_readers.size() > 1
+               || (lock.m_readers.size() == 1
+                   && *lock.m_readers.begin() != ticket_number)) {
+                return std::nullopt;
+            }
+            // Upgrade from a read to a write lock if necessary
+            lock.m_readers.clear();
+            lock.m_writer = ticket_number;
+        } else {
+            lock.m_readers.insert(ticket_number);
+        }
+
+        if(it == t_segment.m_tickets.end()) {
+            it = t_segment.m_tickets
+                     .emplace(ticket_number, ticket_state_type{})
+                     .first;
+        }
+        auto& ticket = it->second;
+        ticket.m_broker_id = broker_id;
+        ticket.m_locks_held[key] = locktype;
+
+        m_log->trace("Assigning lock on", key.to_hex(), "to", ticket_number);
+        return latest_value(key);
+    }
+
+    auto impl::check_try_lock(ticket_number_type ticket_number,
+                              const key_type& key,
+                              lock_type locktype,
+                              const ticket_state_type& ticket) const
+        -> std::optional<shard_error> {
+        // Callers shouldn't be using try_lock after prepare
+        if(ticket.m_state == ticket_state::prepared) {
+            m_log->error(ticket_number, "called try_lock after prepare");
+            return shard_error{error_code::prepared, std::nullopt};
+        }
+
+        if(ticket.m_state == ticket_state::committed) {
+            m_log->error(ticket_number, "called try_lock after commit");
+            return shard_error{error_code::committed, std::nullopt};
+        }
+
+        // If the ticket way wounded don't bother trying to acquire any
+        // locks
+        if(ticket.m_state == ticket_state::wounded) {
+            m_log->trace(ticket_number, "called try_lock after being wounded");
+            return shard_error{error_code::wounded, ticket.m_wounded_details};
+        }
+
+        // Make sure the ticket doesn't already hold a lock on the key
+        if(auto lock_it = ticket.m_locks_held.find(key);
+           lock_it != ticket.m_locks_held.end()
+           && lock_it->second >= locktype) {
+            m_log->warn(this,
+                        ticket_number,
+                        "tried to acquire already held lock");
+            return shard_error{error_code::lock_held, std::nullopt};
+        }
+
+        if(ticket.m_queued_locks.find(key) != ticket.m_queued_locks.end()) {
+            m_log->warn(ticket_number, "tried to acquire already queued lock");
+            return shard_error{error_code::lock_queued, std::nullopt};
+        }
+
+        return std::nullopt;
+    }
+
     auto impl::wound_tickets(
         key_type key,
         const std::vector<ticket_number_type>& blocking_tickets,
@@ -123,7 +212,8 @@ namespace cbdc::parsec::runtime_locking_shard {
         auto callbacks = pending_callbacks_list_type();
         auto keys = key_set_type();
         for(auto blocking_ticket_number : blocking_tickets) {
-            auto& blocking_ticket = m_tickets[blocking_ticket_number];
+            auto& blocking_ticket = ticket_segment(blocking_ticket_number)
+                                        .m_tickets[blocking_ticket_number];
             // Tickets can't be deadlocked by prepared tickets and
             // we're not allowed to wound them anyway
             if(blocking_ticket.m_state == ticket_state::prepared) {
@@ -182,10 +272,13 @@ namespace cbdc::parsec::runtime_locking_shard {
                        state_update_type state_update,
                        prepare_callback_type result_callback) -> bool {
         auto result = [&]() -> std::optional<shard_error> {
-            std::unique_lock<std::mutex> l(m_mut);
+            // Preparing only touches the ticket itself
+            std::shared_lock l(m_mut);
+            auto& segment = ticket_segment(ticket_number);
+            std::unique_lock tl(segment.m_mut);
             // Grab the ticket and ensure it exists
-            auto ticket_it = m_tickets.find(ticket_number);
-            if(ticket_it == m_tickets.end()) {
+            auto ticket_it = segment.m_tickets.find(ticket_number);
+            if(ticket_it == segment.m_tickets.end()) {
                 m_log->error(this,
                              ticket_number,
                              "does not exist on shard for prepare");
@@ -246,12 +339,18 @@ namespace cbdc::parsec::runtime_locking_shard {
 
     auto impl::commit(ticket_number_type ticket_number,
                       commit_callback_type result_callback) -> bool {
+        if(auto res = commit_uncontended(ticket_number)) {
+            result_callback(res.value());
+            return true;
+        }
+
         auto callbacks = pending_callbacks_list_type();
         auto result = [&]() -> std::optional<shard_error> {
-            std::unique_lock<std::mutex> l(m_mut);
+            std::unique_lock l(m_mut);
             // Grab the ticket and ensure it exists
-            auto ticket_it = m_tickets.find(ticket_number);
-            if(ticket_it == m_tickets.end()) {
+            auto& tickets = ticket_segment(ticket_number).m_tickets;
+            auto ticket_it = tickets.find(ticket_number);
+            if(ticket_it == tickets.end()) {
                 m_log->error(this,
                              ticket_number,
                              "does not exist on shard for commit");
@@ -265,9 +364,7 @@ namespace cbdc::parsec::runtime_locking_shard {
                 return shard_error{error_code::not_prepared, std::nullopt};
             }
 
-            for(auto&& [key, value] : ticket.m_state_update) {
-                m_state[key].m_value = std::move(value);
-            }
+            publish(ticket_number, ticket.m_state_update);
 
             auto [wounded_callbacks, affected_keys]
                 = release_locks(ticket_number, ticket);
@@ -298,14 +395,74 @@ namespace cbdc::parsec::runtime_locking_shard {
         return true;
     }
 
+    auto impl::commit_uncontended(ticket_number_type ticket_number)
+        -> std::optional<commit_return_type> {
+        std::shared_lock l(m_mut);
+        auto& t_segment = ticket_segment(ticket_number);
+        std::unique_lock tl(t_segment.m_mut);
+        // Grab the ticket and ensure it exists
+        auto ticket_it = t_segment.m_tickets.find(ticket_number);
+        if(ticket_it == t_segment.m_tickets.end()) {
+            m_log->error(this,
+                         ticket_number,
+                         "does not exist on shard for commit");
+            return shard_error{error_code::unknown_ticket, std::nullopt};
+        }
+        auto& ticket = ticket_it->second;
+
+        // If the ticket is not prepared we can't commit
+        if(ticket.m_state != ticket_state::prepared) {
+            m_log->warn(ticket_number, "called commit but not prepared");
+            return shard_error{error_code::not_prepared, std::nullopt};
+        }
+
+        // Latch the segments of all the keys held by the ticket in
+        // ascending order
+        auto indices = std::vector<size_t>();
+        indices.reserve(ticket.m_locks_held.size());
+        for(const auto& [key, lt] : ticket.m_locks_held) {
+            indices.push_back(key_segment_index(key));
+        }
+        std::sort(indices.begin(), indices.end());
+        indices.erase(std::unique(indices.begin(), indices.end()),
+                      indices.end());
+        auto latches = std::vector<std::unique_lock<std::mutex>>();
+        latches.reserve(indices.size());
+        for(auto idx : indices) {
+            latches.emplace_back(m_key_segments[idx].m_mut);
+        }
+
+        // Releasing the locks must not hand them over to any other ticket
+        for(const auto& [key, lt] : ticket.m_locks_held) {
+            if(!lock_state(key).m_queue.empty()) {
+                return std::nullopt;
+            }
+        }
+
+        publish(ticket_number, ticket.m_state_update);
+
+        for(const auto& [key, lt] : ticket.m_locks_held) {
+            auto& lk = lock_state(key);
+            if(lt == lock_type::read) {
+                lk.m_readers.erase(ticket_number);
+            } else {
+                lk.m_writer.reset();
+            }
+        }
+        ticket.m_locks_held.clear();
+        ticket.m_state = ticket_state::committed;
+
+        m_log->trace(this, "Shard executed commit for", ticket_number);
+        return commit_return_type();
+    }
+
     auto impl::release_locks(ticket_number_type ticket_number,
                              ticket_state_type& ticket)
         -> std::pair<pending_callbacks_list_type, key_set_type> {
         auto callbacks = pending_callbacks_list_type();
         // Unqueue any pending locks
         for(const auto& lock_key : ticket.m_queued_locks) {
-            auto& queued_element = m_state[lock_key];
-            auto& lk = queued_element.m_lock;
+            auto& lk = lock_state(lock_key);
             auto queue_node = lk.m_queue.extract(ticket_number);
             auto& queued_lock_element = queue_node.mapped();
             // Notify the ticket the queued lock was aborted
@@ -319,8 +476,7 @@ namespace cbdc::parsec::runtime_locking_shard {
 
         for(auto& [lock_key, lt] : ticket.m_locks_held) {
             // Release any locks held by the blocking ticket
-            auto& locked_element = m_state[lock_key];
-            auto& lk = locked_element.m_lock;
+            auto& lk = lock_state(lock_key);
             // Release the read lock held by the wounded ticket
             if(lt == lock_type::read) {
                 m_log->trace("Releasing read lock on",
@@ -358,10 +514,11 @@ namespace cbdc::parsec::runtime_locking_shard {
                         rollback_callback_type result_callback) -> bool {
         auto callbacks = pending_callbacks_list_type();
         auto result = [&]() -> std::optional<shard_error> {
-            std::unique_lock<std::mutex> l(m_mut);
+            std::unique_lock l(m_mut);
             // Grab the ticket and ensure it exists
-            auto ticket_it = m_tickets.find(ticket_number);
-            if(ticket_it == m_tickets.end()) {
+            auto& tickets = ticket_segment(ticket_number).m_tickets;
+            auto ticket_it = tickets.find(ticket_number);
+            if(ticket_it == tickets.end()) {
                 m_log->error(this,
                              ticket_number,
                              "does not exist on shard for rollback");
@@ -380,7 +537,7 @@ namespace cbdc::parsec::runtime_locking_shard {
             // We erase the ticket here as we won't need the ticket for
             // recovery. No need for a "rolled back" state and subsequent
             // finish.
-            m_tickets.erase(ticket_it);
+            tickets.erase(ticket_it);
 
             m_log->trace(this, "Shard handled rollback for", ticket_number);
 
@@ -398,9 +555,11 @@ namespace cbdc::parsec::runtime_locking_shard {
     auto impl::finish(ticket_number_type ticket_number,
                       finish_callback_type result_callback) -> bool {
         auto maybe_error = [&]() -> std::optional<shard_error> {
-            std::unique_lock l(m_mut);
-            auto ticket_it = m_tickets.find(ticket_number);
-            if(ticket_it == m_tickets.end()) {
+            std::shared_lock l(m_mut);
+            auto& segment = ticket_segment(ticket_number);
+            std::unique_lock tl(segment.m_mut);
+            auto ticket_it = segment.m_tickets.find(ticket_number);
+            if(ticket_it == segment.m_tickets.end()) {
                 m_log->error(this,
                              ticket_number,
                              "does not exist on shard for finish");
@@ -416,7 +575,7 @@ namespace cbdc::parsec::runtime_locking_shard {
                 return shard_error{error_code::not_committed, std::nullopt};
             }
 
-            m_tickets.erase(ticket_it);
+            segment.m_tickets.erase(ticket_it);
 
             m_log->trace(this, "Shard handled finish for", ticket_number);
 
@@ -431,11 +590,14 @@ namespace cbdc::parsec::runtime_locking_shard {
     auto impl::get_tickets(broker_id_type broker_id,
                            get_tickets_callback_type result_callback) -> bool {
         auto result = [&]() -> get_tickets_success_type {
-            std::unique_lock l(m_mut);
+            std::shared_lock l(m_mut);
             auto ret = get_tickets_success_type();
-            for(auto& [ticket_number, ticket] : m_tickets) {
-                if(ticket.m_broker_id == broker_id) {
-                    ret.emplace(ticket_number, ticket.m_state);
+            for(auto& segment : m_ticket_segments) {
+                std::unique_lock tl(segment.m_mut);
+                for(auto& [ticket_number, ticket] : segment.m_tickets) {
+                    if(ticket.m_broker_id == broker_id) {
+                        ret.emplace(ticket_number, ticket.m_state);
+                    }
                 }
             }
             return ret;
@@ -449,15 +611,30 @@ namespace cbdc::parsec::runtime_locking_shard {
     auto impl::recover(const replicated_shard::state_type& state,
                        const replicated_shard::tickets_type& tickets) -> bool {
         std::unique_lock l(m_mut);
-        if(!m_tickets.empty() && !m_state.empty()) {
+        auto has_tickets = std::any_of(
+            m_ticket_segments.begin(),
+            m_ticket_segments.end(),
+            [](const auto& segment) {
+                return !segment.m_tickets.empty();
+            });
+        auto has_state = std::any_of(m_key_segments.begin(),
+                                     m_key_segments.end(),
+                                     [](const auto& segment) {
+                                         return !segment.m_state.empty();
+                                     });
+        if(has_tickets && has_state) {
             m_log->error("Shard state is not empty, cannot recover");
             return false;
         }
-        m_state.reserve(state.size());
         for(auto&& [k, v] : state) {
-            m_state.emplace(k, state_element_type{v, {}});
+            // The history of recovered keys is unknown so only the
+            // recovered value can be served to readers
+            auto& segment = key_segment(k);
+            std::unique_lock vl(segment.m_values_mut);
+            auto& versions = segment.m_values[k];
+            versions.m_versions = {{ticket_number_type{}, v}};
+            versions.m_truncated = true;
         }
-        m_tickets.reserve(tickets.size());
         for(auto&& [tn, t] : tickets) {
             auto ticket = ticket_state_type{};
             ticket.m_broker_id = t.m_broker_id;
@@ -469,20 +646,19 @@ namespace cbdc::parsec::runtime_locking_shard {
                     ticket.m_state = ticket_state::prepared;
                     for(const auto& [k, v] : t.m_state_update) {
                         ticket.m_locks_held.emplace(k, lock_type::write);
-                        m_state[k].m_lock.m_writer = tn;
+                        lock_state(k).m_writer = tn;
                     }
                     break;
             }
             ticket.m_state_update = t.m_state_update;
-            m_tickets.emplace(tn, std::move(ticket));
+            ticket_segment(tn).m_tickets.emplace(tn, std::move(ticket));
         }
         return true;
     }
 
     auto impl::acquire_lock(const key_type& key,
                             pending_callbacks_list_type& callbacks) -> bool {
-        auto& locked_element = m_state[key];
-        auto& lk = locked_element.m_lock;
+        auto& lk = lock_state(key);
         if(lk.m_queue.empty()) {
             return false;
         }
@@ -490,7 +666,8 @@ namespace cbdc::parsec::runtime_locking_shard {
         auto queue_node = lk.m_queue.begin();
         const auto& queued_ticket_number = queue_node->first;
         auto& queued_lock_element = queue_node->second;
-        auto& queued_ticket = m_tickets[queued_ticket_number];
+        auto& queued_ticket = ticket_segment(queued_ticket_number)
+                                  .m_tickets[queued_ticket_number];
         // Acquire the read lock if the ticket requested a
         // read
         if(queued_lock_element.m_type == lock_type::read) {
@@ -533,9 +710,120 @@ namespace cbdc::parsec::runtime_locking_shard {
         // Notify the ticket that the lock was acquired
         callbacks.emplace_back(pending_callback_element_type{
             std::move(queued_lock_element.m_callback),
-            locked_element.m_value,
+            latest_value(key),
             queued_ticket_number});
         lk.m_queue.erase(queue_node);
         return acquire_next;
     }
+
+    auto impl::read(key_type key,
+                    std::optional<ticket_number_type> as_of,
+                    read_callback_type result_callback) -> bool {
+        auto result = [&]() -> read_return_type {
+            const auto& segment = key_segment(key);
+            std::shared_lock l(segment.m_values_mut);
+            auto it = segment.m_values.find(key);
+            if(it == segment.m_values.end()) {
+                return value_type();
+            }
+            const auto& versions = it->second.m_versions;
+            if(!as_of.has_value()) {
+                return versions.back().second;
+            }
+            // Versions are kept in commit order, which may differ from
+            // ticket number order when a younger ticket commits first
+            for(auto v_it = versions.rbegin(); v_it != versions.rend();
+                v_it++) {
+                if(v_it->first <= as_of.value()) {
+                    return v_it->second;
+                }
+            }
+            if(it->second.m_truncated) {
+                m_log->trace(this,
+                             "version of",
+                             key.to_hex(),
+                             "as of",
+                             as_of.value(),
+                             "no longer retained");
+                return shard_error{error_code::version_unavailable,
+                                   std::nullopt};
+            }
+            return value_type();
+        }();
+
+        result_callback(std::move(result));
+
+        return true;
+    }
+
+    auto impl::latest_value(const key_type& key) const -> value_type {
+        const auto& segment = key_segment(key);
+        std::shared_lock l(segment.m_values_mut);
+        auto it = segment.m_values.find(key);
+        if(it == segment.m_values.end()) {
+            return value_type();
+        }
+        return it->second.m_versions.back().second;
+    }
+
+    void impl::publish(ticket_number_type ticket_number,
+                       state_update_type& state_update) {
+        // Publish all the updates from the ticket at once so readers never
+        // observe a partially committed ticket
+        auto indices = std::vector<size_t>();
+        indices.reserve(state_update.size());
+        for(const auto& [key, value] : state_update) {
+            indices.push_back(key_segment_index(key));
+        }
+        std::sort(indices.begin(), indices.end());
+        indices.erase(std::unique(indices.begin(), indices.end()),
+                      indices.end());
+        auto latches = std::vector<std::unique_lock<std::shared_mutex>>();
+        latches.reserve(indices.size());
+        for(auto idx : indices) {
+            latches.emplace_back(m_key_segments[idx].m_values_mut);
+        }
+        for(auto&& [key, value] : state_update) {
+            put_version(key_segment(key),
+                        key,
+                        ticket_number,
+                        std::move(value));
+        }
+    }
+
+    void impl::put_version(key_segment_type& segment,
+                           const key_type& key,
+                           ticket_number_type ticket_number,
+                           value_type value) const {
+        auto& entry = segment.m_values[key];
+        auto& versions = entry.m_versions;
+        versions.emplace_back(ticket_number, std::move(value));
+        if(versions.size() > m_max_versions) {
+            versions.erase(versions.begin());
+            entry.m_truncated = true;
+        }
+    }
+
+    auto impl::key_segment_index(const key_type& key) const -> size_t {
+        return hashing::const_sip_hash<key_type>()(key)
+             % m_key_segments.size();
+    }
+
+    auto impl::key_segment(const key_type& key) -> key_segment_type& {
+        return m_key_segments[key_segment_index(key)];
+    }
+
+    auto impl::key_segment(const key_type& key) const
+        -> const key_segment_type& {
+        return m_key_segments[key_segment_index(key)];
+    }
+
+    auto impl::ticket_segment(ticket_number_type ticket_number)
+        -> ticket_segment_type& {
+        return m_ticket_segments[ticket_number % m_ticket_segments.size()];
+    }
+
+    auto impl::lock_state(const key_type& key) -> rw_lock_type& {
+        return key_segment(key).m_state[key].m_lock;
+    }
 }
@@ -13,17 +13,39 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace cbdc::parsec::runtime_locking_shard {
     /// Implementation of a runtime locking shard. Stores keys in memory using
-    /// a hash map. Thread-safe.
+    /// a hash map. Retains a bounded number of committed versions of each
+    /// key so that reads can be served without acquiring locks.
+    /// Keys and tickets are partitioned into independently latched segments.
+    /// Operations which only touch a single ticket and keys without queued
+    /// lock requests proceed concurrently. Operations which wound tickets or
+    /// hand locks over to queued tickets take an exclusive latch over the
+    /// whole shard. Thread-safe.
     class impl : public interface {
       public:
+        /// Default number of committed versions to retain for each key.
+        static constexpr size_t default_max_versions = 8;
+
+        /// Default number of segments to partition keys and tickets into.
+        static constexpr size_t default_segments = 64;
+
         /// Constructor.
         /// \param logger log instance.
-        explicit impl(std::shared_ptr<logging::log> logger);
+        /// \param max_versions number of committed versions to retain for
+        ///                     each key. Must be at least one.
+        /// \param segments number of independently latched segments to
+        ///                 partition keys and tickets into. Must be at least
+        ///                 one.
+        explicit impl(std::shared_ptr<logging::log> logger,
+                      size_t max_versions = default_max_versions,
+                      size_t segments = default_segments);
 
         /// Locks the given key for a ticket and returns the associated value.
         /// If lock is unavailable, lock will be queued. May wound other
@@ -84,6 +106,18 @@ namespace cbdc::parsec::runtime_locking_shard {
                          get_tickets_callback_type result_callback)
             -> bool override;
 
+        /// Returns the committed value of a key without acquiring a lock.
+        /// Only contends with concurrent commits of the same shard, never
+        /// with lock requests.
+        /// \param key key to read.
+        /// \param as_of ticket number as of which to read the key, or
+        ///              std::nullopt to read the latest committed value.
+        /// \param result_callback function to call with read result.
+        /// \return true.
+        auto read(key_type key,
+                  std::optional<ticket_number_type> as_of,
+                  read_callback_type result_callback) -> bool override;
+
         /// Restores the state of another shard instance.
         /// \param state keys and values to store.
         /// \param tickets unfinished tickets that have reached the prepare or
@@ -105,10 +139,16 @@ namespace cbdc::parsec::runtime_locking_shard {
         };
 
         struct state_element_type {
-            value_type m_value;
             rw_lock_type m_lock;
         };
 
+        struct version_list_type {
+            /// Committed values and their ticket numbers in commit order.
+            std::vector<std::pair<ticket_number_type, value_type>> m_versions;
+            /// True if older versions have been discarded.
+            bool m_truncated{false};
+        };
+
         using key_set_type
             = std::unordered_set<key_type, hashing::const_sip_hash<key_type>>;
 
@@ -133,14 +173,43 @@ namespace cbdc::parsec::runtime_locking_shard {
         using pending_callbacks_list_type
             = std::vector<pending_callback_element_type>;
 
-        mutable std::mutex m_mut;
+        /// Lock state and committed values of the keys within a segment.
+        struct key_segment_type {
+            /// Latches m_state during shared access to the shard.
+            std::mutex m_mut;
+            std::unordered_map<key_type,
+                               state_element_type,
+                               hashing::const_sip_hash<key_type>>
+                m_state;
+
+            /// Latches m_values independently of the shard latch so reads
+            /// never wait for lock requests.
+            mutable std::shared_mutex m_values_mut;
+            std::unordered_map<key_type,
+                               version_list_type,
+                               hashing::const_sip_hash<key_type>>
+                m_values;
+        };
+
+        /// Tickets within a segment.
+        struct ticket_segment_type {
+            /// Latches m_tickets during shared access to the shard.
+            std::mutex m_mut;
+            std::unordered_map<ticket_number_type, ticket_state_type>
+                m_tickets;
+        };
+
+        /// Held shared by operations which only touch a single ticket and
+        /// keys without queued lock requests, and exclusively by all other
+        /// operations. Segment latches must only be acquired while holding
+        /// this latch shared, with the ticket segment latch before any key
+        /// segment latches, and key segment latches in ascending order.
+        mutable std::shared_mutex m_mut;
         std::shared_ptr<logging::log> m_log;
+        size_t m_max_versions;
 
-        std::unordered_map<key_type,
-                           state_element_type,
-                           hashing::const_sip_hash<key_type>>
-            m_state;
-        std::unordered_map<ticket_number_type, ticket_state_type> m_tickets;
+        std::vector<key_segment_type> m_key_segments;
+        std::vector<ticket_segment_type> m_ticket_segments;
 
         auto
         wound_tickets(key_type key,
@@ -162,6 +231,43 @@ namespace cbdc::parsec::runtime_locking_shard {
 
         auto acquire_lock(const key_type& key,
                           pending_callbacks_list_type& callbacks) -> bool;
+
+        auto try_lock_uncontended(ticket_number_type ticket_number,
+                                  broker_id_type broker_id,
+                                  const key_type& key,
+                                  lock_type locktype,
+                                  bool first_lock)
+            -> std::optional<try_lock_return_type>;
+
+        auto check_try_lock(ticket_number_type ticket_number,
+                            const key_type& key,
+                            lock_type locktype,
+                            const ticket_state_type& ticket) const
+            -> std::optional<shard_error>;
+
+        auto commit_uncontended(ticket_number_type ticket_number)
+            -> std::optional<commit_return_type>;
+
+        auto key_segment_index(const key_type& key) const -> size_t;
+
+        auto key_segment(const key_type& key) -> key_segment_type&;
+
+        auto key_segment(const key_type& key) const -> const key_segment_type&;
+
+        auto ticket_segment(ticket_number_type ticket_number)
+            -> ticket_segment_type&;
+
+        auto lock_state(const key_type& key) -> rw_lock_type&;
+
+        auto latest_value(const key_type& key) const -> value_type;
+
+        void publish(ticket_number_type ticket_number,
+                     state_update_type& state_update);
+
+        void put_version(key_segment_type& segment,
+                         const key_type& key,
+                         ticket_number_type ticket_number,
+                         value_type value) const;
     };
 }
 
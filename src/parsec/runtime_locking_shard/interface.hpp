@@ -60,7 +60,10 @@ namespace cbdc::parsec::runtime_locking_shard {
         /// Request invalid because ticket is not in the committed state.
         not_committed,
         /// Request failed because of a transient internal error.
-        internal_error
+        internal_error,
+        /// The requested version of the key is no longer retained by the
+        /// shard.
+        version_unavailable
     };
 
     /// Details about wounded error code
@@ -232,6 +235,28 @@ namespace cbdc::parsec::runtime_locking_shard {
                                  get_tickets_callback_type result_callback)
             -> bool
             = 0;
+
+        /// Return type from a read operation. Either the value at the
+        /// requested key or an error code.
+        using read_return_type = std::variant<value_type, shard_error>;
+        /// Callback function type for the result of a read operation.
+        using read_callback_type = std::function<void(read_return_type)>;
+
+        /// Returns the committed value of the given key without acquiring a
+        /// lock or requiring a ticket. Reads never wound or wait on other
+        /// tickets, so the returned value may be superseded by a ticket
+        /// which is concurrently committing.
+        /// \param key key to read.
+        /// \param as_of if provided, return the value committed by the
+        ///              newest ticket no younger than the given ticket
+        ///              number. Otherwise return the latest committed value.
+        /// \param result_callback function to call with the value or error
+        ///                        code.
+        /// \return true if the operation was initiated successfully.
+        virtual auto read(key_type key,
+                          std::optional<ticket_number_type> as_of,
+                          read_callback_type result_callback) -> bool
+            = 0;
     };
 }
 
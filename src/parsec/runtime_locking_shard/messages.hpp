@@ -58,13 +58,23 @@ namespace cbdc::parsec::runtime_locking_shard::rpc {
         broker_id_type m_broker_id;
     };
 
+    /// Lock-free read request message.
+    struct read_request {
+        /// Key to read.
+        key_type m_key;
+        /// Ticket number as of which to read the key, or std::nullopt for
+        /// the latest committed value.
+        std::optional<ticket_number_type> m_as_of;
+    };
+
     /// RPC request message type.
     using request = std::variant<try_lock_request,
                                  prepare_request,
                                  commit_request,
                                  rollback_request,
                                  finish_request,
-                                 get_tickets_request>;
+                                 get_tickets_request,
+                                 read_request>;
     /// RPC response message type.
     using response = std::variant<interface::try_lock_return_type,
                                   interface::prepare_return_type,
@@ -41,7 +41,8 @@ auto main(int argc, char** argv) -> int {
         *cfg->m_node_id,
         cfg->m_shard_endpoints[cfg->m_component_id][*cfg->m_node_id],
         raft_endpoints,
-        log);
+        log,
+        cfg->m_raft_log_store);
     if(!controller.init()) {
         log->error("Failed to start raft server");
         return 1;
@@ -80,6 +80,16 @@ namespace cbdc::parsec::runtime_locking_shard::rpc {
                         [callback](interface::get_tickets_return_type ret) {
                             callback(std::move(ret));
                         });
+                },
+                [&](const rpc::read_request& msg) {
+                    // Reads only observe committed state so do not need to
+                    // go through the replicated state machine
+                    return m_impl->read(
+                        msg.m_key,
+                        msg.m_as_of,
+                        [callback](interface::read_return_type ret) {
+                            callback(std::move(ret));
+                        });
                 }},
             req);
         return success;
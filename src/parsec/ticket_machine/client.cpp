@@ -8,9 +8,11 @@
 #include "util/serialization/format.hpp"
 
 namespace cbdc::parsec::ticket_machine::rpc {
-    client::client(std::vector<network::endpoint_t> endpoints)
+    client::client(std::vector<network::endpoint_t> endpoints,
+                   ticket_number_type prefetch_threshold)
         : m_client(std::make_unique<decltype(m_client)::element_type>(
-            std::move(endpoints))) {}
+            std::move(endpoints))),
+          m_prefetch_threshold(prefetch_threshold) {}
 
     auto client::init() -> bool {
         return m_client->init();
@@ -19,29 +21,81 @@ namespace cbdc::parsec::ticket_machine::rpc {
     auto
     client::get_ticket_number(get_ticket_number_callback_type result_callback)
         -> bool {
-        auto num = ticket_number_type{};
-        {
-            std::unique_lock l(m_mut);
-            constexpr auto fetch_threshold = 500;
-            if(m_tickets.size() < fetch_threshold && !m_fetching_tickets) {
-                auto res = fetch_tickets();
-                if(res) {
-                    m_fetching_tickets = true;
-                }
-                if(m_tickets.empty() && !res) {
+        auto num = take_ticket();
+        if(num.has_value()) {
+            // Exactly one caller takes the ticket number at the threshold,
+            // so only that caller needs to check whether to prefetch
+            if(m_end.load() - num.value() == m_prefetch_threshold) {
+                std::unique_lock l(m_mut);
+                if(!prefetch_locked()) {
                     return false;
                 }
             }
-            if(m_tickets.empty()) {
+        } else {
+            std::unique_lock l(m_mut);
+            num = take_ticket_locked();
+            if(!num.has_value()) {
+                if(!prefetch_locked()) {
+                    return false;
+                }
                 m_callbacks.emplace(std::move(result_callback));
                 return true;
             }
+            if(m_end.load() - num.value() <= m_prefetch_threshold
+               && !prefetch_locked()) {
+                return false;
+            }
+        }
+
+        result_callback(ticket_number_range_type{num.value(), num.value()});
+        return true;
+    }
+
+    auto client::take_ticket() -> std::optional<ticket_number_type> {
+        // Ranges from the ticket machine never overlap so m_next cannot
+        // return to a previously observed value after a new lease has been
+        // installed. A successful exchange therefore means the ticket number
+        // came from the lease which was current when it was loaded.
+        auto num = m_next.load();
+        while(num < m_end.load()) {
+            if(m_next.compare_exchange_weak(num, num + 1)) {
+                return num;
+            }
+        }
+        return std::nullopt;
+    }
+
+    auto client::take_ticket_locked() -> std::optional<ticket_number_type> {
+        auto num = take_ticket();
+        while(!num.has_value() && !m_leases.empty()) {
+            install_lease(m_leases.front());
+            m_leases.pop();
+            num = take_ticket();
+        }
+        return num;
+    }
 
-            num = m_tickets.front();
-            m_tickets.pop();
+    void client::install_lease(ticket_number_range_type range) {
+        // Close the current lease before moving the counter so concurrent
+        // callers fall back to the slow path instead of taking a ticket
+        // number from a half-installed lease
+        m_end = 0;
+        m_next = range.first;
+        m_end = range.second;
+        if(range.second - range.first <= m_prefetch_threshold) {
+            // Lease is too small to ever reach the threshold
+            [[maybe_unused]] auto res = prefetch_locked();
         }
+    }
 
-        result_callback(ticket_number_range_type{num, num});
+    auto client::prefetch_locked() -> bool {
+        if(m_fetching_tickets || !m_leases.empty()) {
+            return true;
+        }
+        if(!fetch_tickets()) {
+            return false;
+        }
+        m_fetching_tickets = true;
         return true;
     }
 
@@ -71,34 +125,30 @@ namespace cbdc::parsec::ticket_machine::rpc {
     }
 
     void client::handle_ticket_numbers(ticket_number_range_type range) {
-        auto callbacks = decltype(m_callbacks)();
-        auto tickets = decltype(m_tickets)();
+        auto callbacks = std::vector<
+            std::pair<get_ticket_number_callback_type, ticket_number_type>>();
         {
             std::unique_lock ll(m_mut);
-            for(ticket_number_type i = range.first; i < range.second; i++) {
-                m_tickets.push(i);
-            }
-            while(!m_tickets.empty() && !m_callbacks.empty()) {
-                callbacks.push(std::move(m_callbacks.front()));
+            m_fetching_tickets = false;
+            m_leases.push(range);
+            while(!m_callbacks.empty()) {
+                auto num = take_ticket_locked();
+                if(!num.has_value()) {
+                    break;
+                }
+                callbacks.emplace_back(std::move(m_callbacks.front()),
+                                       num.value());
                 m_callbacks.pop();
-                tickets.push(m_tickets.front());
-                m_tickets.pop();
             }
-            if(m_callbacks.empty()) {
-                m_fetching_tickets = false;
-            } else {
-                auto fetch_res = fetch_tickets();
-                if(!fetch_res) {
-                    m_fetching_tickets = false;
-                }
+            if(!m_callbacks.empty() || m_leases.empty()) {
+                // Either callers are still waiting for ticket numbers, or
+                // the new range was installed as the current lease and we
+                // need to start fetching the one after it
+                [[maybe_unused]] auto res = prefetch_locked();
             }
         }
-        while(!callbacks.empty()) {
-            assert(!tickets.empty());
-            callbacks.front()(
-                ticket_number_range_type{tickets.front(), tickets.front()});
-            callbacks.pop();
-            tickets.pop();
+        for(auto& [cb, num] : callbacks) {
+            cb(ticket_number_range_type{num, num});
         }
     }
 }
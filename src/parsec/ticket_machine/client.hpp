@@ -10,14 +10,31 @@
 #include "messages.hpp"
 #include "util/rpc/tcp_client.hpp"
 
+#include <atomic>
+#include <mutex>
+#include <queue>
+
 namespace cbdc::parsec::ticket_machine::rpc {
-    /// RPC client for a remote ticket machine.
+    /// RPC client for a remote ticket machine. Leases ranges of ticket
+    /// numbers from the ticket machine and hands them out locally so that
+    /// acquiring a ticket number does not require a network round trip.
     class client : public interface {
       public:
+        /// Default number of unused ticket numbers remaining in the current
+        /// lease at which the next range is requested.
+        static constexpr ticket_number_type default_prefetch_threshold = 500;
+
         /// Constructor.
         /// \param endpoints RPC server endpoints for the ticket machine
         ///                  cluster.
-        explicit client(std::vector<network::endpoint_t> endpoints);
+        /// \param prefetch_threshold number of unused ticket numbers
+        ///                           remaining in the current lease at
+        ///                           which to asynchronously request the
+        ///                           next range from the ticket machine.
+        explicit client(
+            std::vector<network::endpoint_t> endpoints,
+            ticket_number_type prefetch_threshold
+            = default_prefetch_threshold);
 
         client() = delete;
         ~client() override = default;
@@ -30,11 +47,13 @@ namespace cbdc::parsec::ticket_machine::rpc {
         /// \return true if the client initialized successfully.
         auto init() -> bool;
 
-        /// Requests a new batch of ticket numbers from the remote ticket
-        /// machine. Always returns a single ticket number (range size of 1).
-        /// Caches ticket numbers to avoid making an RPC request per call. If a
-        /// ticket number is available in the cache, calls the callback before
-        /// returning.
+        /// Returns a single ticket number (range size of 1) from the current
+        /// lease. Takes the ticket number using an atomic counter without
+        /// locking when the lease is not exhausted, and calls the callback
+        /// before returning. Requests the next range from the remote ticket
+        /// machine ahead of the current lease being exhausted. If no ticket
+        /// numbers are available, the callback is called once the next
+        /// range is received.
         /// \param result_callback function to call with the new ticket number.
         /// \return true if the request was initiated successfully.
         auto get_ticket_number(get_ticket_number_callback_type result_callback)
@@ -42,13 +61,28 @@ namespace cbdc::parsec::ticket_machine::rpc {
 
       private:
         std::unique_ptr<cbdc::rpc::tcp_client<request, response>> m_client;
-        std::queue<ticket_number_type> m_tickets;
-        bool m_fetching_tickets{false};
+        ticket_number_type m_prefetch_threshold;
+
+        /// Next unused ticket number in the current lease.
+        std::atomic<ticket_number_type> m_next{};
+        /// End of the current lease, exclusive. Zero while a new lease is
+        /// being installed.
+        std::atomic<ticket_number_type> m_end{};
 
         mutable std::mutex m_mut;
+        std::queue<ticket_number_range_type> m_leases;
+        bool m_fetching_tickets{false};
 
         std::queue<get_ticket_number_callback_type> m_callbacks;
 
+        auto take_ticket() -> std::optional<ticket_number_type>;
+
+        auto take_ticket_locked() -> std::optional<ticket_number_type>;
+
+        void install_lease(ticket_number_range_type range);
+
+        auto prefetch_locked() -> bool;
+
         auto fetch_tickets() -> bool;
 
         void handle_ticket_numbers(ticket_number_range_type range);
@@ -14,7 +14,8 @@ namespace cbdc::parsec::ticket_machine {
     controller::controller(size_t node_id,
                            network::endpoint_t server_endpoint,
                            std::vector<network::endpoint_t> raft_endpoints,
-                           std::shared_ptr<logging::log> logger)
+                           std::shared_ptr<logging::log> logger,
+                           cbdc::config::raft_log_store_type log_store_type)
         : m_logger(std::move(logger)),
           m_state_machine(
               nuraft::cs_new<state_machine>(m_logger, m_batch_size)),
@@ -29,7 +30,8 @@ namespace cbdc::parsec::ticket_machine {
               [&](auto&& res, auto&& err) {
                   return raft_callback(std::forward<decltype(res)>(res),
                                        std::forward<decltype(err)>(err));
-              })),
+              },
+              log_store_type)),
           m_raft_endpoints(std::move(raft_endpoints)),
           m_server_endpoint(std::move(server_endpoint)) {}
 
@@ -22,10 +22,13 @@ namespace cbdc::parsec::ticket_machine {
         /// \param raft_endpoints vector of endpoints for the raft nodes in the
         ///                       cluster.
         /// \param logger log to use for output.
+        /// \param log_store_type storage implementation for the raft log.
         controller(size_t node_id,
                    network::endpoint_t server_endpoint,
                    std::vector<network::endpoint_t> raft_endpoints,
-                   std::shared_ptr<logging::log> logger);
+                   std::shared_ptr<logging::log> logger,
+                   cbdc::config::raft_log_store_type log_store_type
+                   = cbdc::config::defaults::raft_log_store);
         ~controller() = default;
 
         controller() = delete;
@@ -37,7 +37,8 @@ auto main(int argc, char** argv) -> int {
         cfg->m_component_id,
         cfg->m_ticket_machine_endpoints[cfg->m_component_id],
         raft_endpoints,
-        log);
+        log,
+        cfg->m_raft_log_store);
     if(!raft_server.init()) {
         log->error("Failed to start raft server");
         return 1;
@@ -176,6 +176,28 @@ namespace cbdc::parsec {
             cfg.m_loadgen_accounts = std::stoull(it->second);
         }
 
+        constexpr auto directory_vnodes_key = "directory_vnodes";
+        it = opts->find(directory_vnodes_key);
+        if(it != opts->end()) {
+            cfg.m_directory_vnodes = std::stoull(it->second);
+        }
+
+        constexpr auto rpc_batch_size_key = "rpc_batch_size";
+        it = opts->find(rpc_batch_size_key);
+        if(it != opts->end()) {
+            cfg.m_rpc_batch_size = std::stoull(it->second);
+        }
+
+        it = opts->find(cbdc::config::raft_log_store_key);
+        if(it != opts->end()) {
+            const auto log_store_type
+                = cbdc::config::parse_raft_log_store(it->second);
+            if(!log_store_type.has_value()) {
+                return std::nullopt;
+            }
+            cfg.m_raft_log_store = *log_store_type;
+        }
+
         constexpr auto runner_type_key = "runner_type";
         it = opts->find(runner_type_key);
         if(it != opts->end()) {
@@ -51,6 +51,17 @@ namespace cbdc::parsec {
         /// The percentage of transactions that are using the same account
         /// to simulate contention
         double m_contention_rate;
+        /// Number of virtual nodes per shard to use when mapping keys to
+        /// shards with consistent hashing. Zero maps keys to shards using
+        /// the key hash modulo the number of shards.
+        size_t m_directory_vnodes{0};
+        /// Maximum number of calls the EVM load generator sends to an agent
+        /// in one JSON-RPC batch request.
+        size_t m_rpc_batch_size{1};
+        /// Storage implementation for the raft logs of the ticket machine
+        /// and shard clusters.
+        cbdc::config::raft_log_store_type m_raft_log_store{
+            cbdc::config::defaults::raft_log_store};
     };
 
     /// Reads the configuration parameters from the program arguments.
@@ -5,6 +5,7 @@
 
 #include "client.hpp"
 
+#include "format.hpp"
 #include "uhs/atomizer/atomizer/format.hpp"
 #include "util/serialization/format.hpp"
 
@@ -20,27 +21,179 @@ namespace cbdc::archiver {
         return m_sock.connect(m_endpoint);
     }
 
-    auto client::get_block(uint64_t height)
-        -> std::optional<cbdc::atomizer::block> {
-        m_logger->info("Requesting block", height, "from archiver...");
-        if(!m_sock.send(height)) {
-            m_logger->error("Error requesting block from archiver.");
+    auto block_range_request::operator==(const block_range_request& rhs) const
+        -> bool {
+        return m_start == rhs.m_start && m_count == rhs.m_count;
+    }
+
+    auto block_stream_request::operator==(
+        const block_stream_request& rhs) const -> bool {
+        return m_start == rhs.m_start && m_count == rhs.m_count;
+    }
+
+    auto tx_location_request::operator==(const tx_location_request& rhs) const
+        -> bool {
+        return m_tx_id == rhs.m_tx_id;
+    }
+
+    auto
+    uhs_location_request::operator==(const uhs_location_request& rhs) const
+        -> bool {
+        return m_uhs_id == rhs.m_uhs_id;
+    }
+
+    auto tx_location::operator==(const tx_location& rhs) const -> bool {
+        return m_height == rhs.m_height && m_position == rhs.m_position;
+    }
+
+    template<typename T>
+    auto client::call(const request& req) -> std::optional<T> {
+        if(!m_sock.send(req)) {
+            m_logger->error("Error sending request to archiver.");
             return std::nullopt;
         }
 
         m_logger->info("Waiting for archiver response...");
         cbdc::buffer resp_pkt;
         if(!m_sock.receive(resp_pkt)) {
-            m_logger->error("Error receiving block from archiver.");
+            m_logger->error("Error receiving response from archiver.");
             return std::nullopt;
         }
 
-        auto resp = cbdc::from_buffer<response>(resp_pkt);
+        auto resp = cbdc::from_buffer<T>(resp_pkt);
         if(!resp.has_value()) {
             m_logger->error("Invalid response packet");
             return std::nullopt;
         }
 
+        return resp;
+    }
+
+    auto client::get_block(uint64_t height)
+        -> std::optional<cbdc::atomizer::block> {
+        m_logger->info("Requesting block", height, "from archiver...");
+        auto resp = call<response>(block_request{height});
+        if(!resp.has_value()) {
+            return std::nullopt;
+        }
+        return resp.value();
+    }
+
+    auto client::get_blocks(uint64_t start, uint64_t count)
+        -> std::optional<block_range_response> {
+        m_logger->info("Requesting",
+                       count,
+                       "blocks from",
+                       start,
+                       "from archiver...");
+        return call<block_range_response>(block_range_request{start, count});
+    }
+
+    auto client::stream_blocks(uint64_t start,
+                               uint64_t count,
+                               const block_callback_type& cb)
+        -> std::optional<uint64_t> {
+        m_logger->info("Streaming",
+                       count,
+                       "blocks from",
+                       start,
+                       "from archiver...");
+        auto requested = uint64_t{};
+        auto windows = std::queue<uint64_t>();
+        // After a failure, the archiver may still be streaming the rest of
+        // the windows. Reconnect so the next request does not read them
+        // as its response.
+        auto fail = [&]() -> std::optional<uint64_t> {
+            if(!windows.empty() && !m_sock.reconnect()) {
+                m_logger->error("Failed to reconnect to archiver.");
+            }
+            return std::nullopt;
+        };
+        auto send_window = [&]() {
+            auto n = std::min(count - requested, max_stream_blocks);
+            if(!m_sock.send(request{block_stream_request{start + requested,
+                                                         n}})) {
+                m_logger->error("Error sending request to archiver.");
+                return false;
+            }
+            requested += n;
+            windows.push(n);
+            return true;
+        };
+
+        while(windows.size() < stream_pipeline_depth && requested < count) {
+            if(!send_window()) {
+                return fail();
+            }
+        }
+
+        auto received = uint64_t{};
+        auto complete = true;
+        while(!windows.empty()) {
+            // Once a window comes back short, the following windows start
+            // past a missing block so their blocks are discarded.
+            auto n = receive_stream(windows.front(), complete ? &cb : nullptr);
+            if(!n.has_value()) {
+                return fail();
+            }
+            if(complete) {
+                received += n.value();
+                complete = n.value() == windows.front();
+            }
+            windows.pop();
+            if(complete && requested < count && !send_window()) {
+                return fail();
+            }
+        }
+        return received;
+    }
+
+    auto client::receive_stream(uint64_t expected,
+                                const block_callback_type* cb)
+        -> std::optional<uint64_t> {
+        auto received = uint64_t{};
+        while(true) {
+            cbdc::buffer resp_pkt;
+            if(!m_sock.receive(resp_pkt)) {
+                m_logger->error("Error receiving response from archiver.");
+                return std::nullopt;
+            }
+            auto chunk = cbdc::from_buffer<block_range_response>(resp_pkt);
+            if(!chunk.has_value()) {
+                m_logger->error("Invalid response packet");
+                return std::nullopt;
+            }
+            received += chunk->size();
+            if(received > expected) {
+                m_logger->error("Archiver streamed too many blocks");
+                return std::nullopt;
+            }
+            if(cb != nullptr) {
+                for(auto& blk : chunk.value()) {
+                    (*cb)(std::move(blk));
+                }
+            }
+            if(chunk->size() < max_range_blocks) {
+                return received;
+            }
+        }
+    }
+
+    auto client::get_tx_location(const hash_t& tx_id)
+        -> std::optional<tx_location> {
+        auto resp = call<location_response>(tx_location_request{tx_id});
+        if(!resp.has_value()) {
+            return std::nullopt;
+        }
+        return resp.value();
+    }
+
+    auto client::get_uhs_location(const hash_t& uhs_id)
+        -> std::optional<tx_location> {
+        auto resp = call<location_response>(uhs_location_request{uhs_id});
+        if(!resp.has_value()) {
+            return std::nullopt;
+        }
         return resp.value();
     }
 }
@@ -10,13 +10,96 @@
 #include "util/common/logging.hpp"
 #include "util/network/tcp_socket.hpp"
 
+#include <functional>
+#include <queue>
+#include <variant>
+
 namespace cbdc::archiver {
     /// Height of the block to fetch from the archiver.
-    using request = uint64_t;
+    using block_request = uint64_t;
+
+    /// Request for a range of consecutive blocks.
+    struct block_range_request {
+        /// Height of the first block to fetch.
+        uint64_t m_start{};
+        /// Number of blocks to fetch. The archiver returns at most
+        /// \ref max_range_blocks blocks per request.
+        uint64_t m_count{};
+
+        auto operator==(const block_range_request& rhs) const -> bool;
+    };
+
+    /// \brief Request to stream consecutive blocks.
+    ///
+    /// The archiver replies with a sequence of \ref block_range_response
+    /// packets holding up to \ref max_range_blocks blocks each, read with
+    /// a single sequential scan. The stream ends with the first packet
+    /// holding fewer than \ref max_range_blocks blocks, which may be empty.
+    struct block_stream_request {
+        /// Height of the first block to stream.
+        uint64_t m_start{};
+        /// Number of blocks to stream. The archiver streams at most
+        /// \ref max_stream_blocks blocks per request.
+        uint64_t m_count{};
+
+        auto operator==(const block_stream_request& rhs) const -> bool;
+    };
+
+    /// Request for the location of the transaction with the given ID.
+    struct tx_location_request {
+        /// Transaction ID.
+        hash_t m_tx_id{};
+
+        auto operator==(const tx_location_request& rhs) const -> bool;
+    };
+
+    /// Request for the location of the transaction that created the given
+    /// UHS ID.
+    struct uhs_location_request {
+        /// UHS ID.
+        hash_t m_uhs_id{};
+
+        auto operator==(const uhs_location_request& rhs) const -> bool;
+    };
+
+    /// Requests the archiver can process.
+    using request = std::variant<block_request,
+                                 block_range_request,
+                                 tx_location_request,
+                                 uhs_location_request,
+                                 block_stream_request>;
 
     /// The requested block, or std::nullopt if not found.
     using response = std::optional<cbdc::atomizer::block>;
 
+    /// The requested blocks, stopping at the first missing block.
+    using block_range_response = std::vector<cbdc::atomizer::block>;
+
+    /// Position of a transaction in the archived blocks.
+    struct tx_location {
+        /// Height of the block containing the transaction.
+        uint64_t m_height{};
+        /// Index of the transaction in the block.
+        uint64_t m_position{};
+
+        auto operator==(const tx_location& rhs) const -> bool;
+    };
+
+    /// The requested transaction location, or std::nullopt if not found.
+    using location_response = std::optional<tx_location>;
+
+    /// Maximum number of blocks returned for a block range request, and
+    /// in each packet of a block stream.
+    static constexpr uint64_t max_range_blocks{64};
+
+    /// Maximum number of blocks streamed for a single block stream request.
+    /// Bounds how far the archiver can run ahead of a slow subscriber.
+    static constexpr uint64_t max_stream_blocks{1024};
+
+    /// Number of block stream requests a client keeps in flight, so the
+    /// archiver starts the next window while the previous one is consumed.
+    static constexpr size_t stream_pipeline_depth{2};
+
     /// \brief Retrieves blocks from a remote archiver via the network.
     ///
     /// \warning Not thread-safe. Only one thread can use the client without
@@ -40,7 +123,59 @@ namespace cbdc::archiver {
         auto get_block(uint64_t height)
             -> std::optional<cbdc::atomizer::block>;
 
+        /// Retrieves consecutive blocks from the archiver.
+        /// \param start height of the first block to retrieve.
+        /// \param count number of blocks to retrieve. At most
+        ///              \ref max_range_blocks blocks are returned.
+        /// \return blocks in height order, stopping at the first block the
+        ///         archiver does not have, or std::nullopt if the request
+        ///         failed.
+        auto get_blocks(uint64_t start, uint64_t count)
+            -> std::optional<block_range_response>;
+
+        /// Function called with each block received from a block stream.
+        using block_callback_type
+            = std::function<void(cbdc::atomizer::block&&)>;
+
+        /// \brief Streams consecutive blocks from the archiver.
+        ///
+        /// Splits the range into windows of \ref max_stream_blocks blocks
+        /// and keeps \ref stream_pipeline_depth windows in flight. Stops
+        /// at the first block the archiver does not have.
+        /// \param start height of the first block to retrieve.
+        /// \param count number of blocks to retrieve.
+        /// \param cb function to call with each block, in height order.
+        /// \return number of blocks passed to the callback, or std::nullopt
+        ///         if the stream failed. After a failure the client
+        ///         reconnects to the archiver, discarding any blocks still
+        ///         being streamed.
+        auto stream_blocks(uint64_t start,
+                           uint64_t count,
+                           const block_callback_type& cb)
+            -> std::optional<uint64_t>;
+
+        /// Retrieves the location of the transaction with the given ID.
+        /// \param tx_id transaction ID.
+        /// \return location of the transaction, or std::nullopt if not found
+        ///         or the request failed.
+        auto get_tx_location(const hash_t& tx_id)
+            -> std::optional<tx_location>;
+
+        /// Retrieves the location of the transaction that created the given
+        /// UHS ID.
+        /// \param uhs_id UHS ID.
+        /// \return location of the transaction, or std::nullopt if not found
+        ///         or the request failed.
+        auto get_uhs_location(const hash_t& uhs_id)
+            -> std::optional<tx_location>;
+
       private:
+        template<typename T>
+        auto call(const request& req) -> std::optional<T>;
+
+        auto receive_stream(uint64_t expected, const block_callback_type* cb)
+            -> std::optional<uint64_t>;
+
         network::tcp_socket m_sock;
         network::endpoint_t m_endpoint;
         std::shared_ptr<logging::log> m_logger;
@@ -5,14 +5,35 @@
 
 #include "controller.hpp"
 
+#include "format.hpp"
 #include "uhs/atomizer/atomizer/format.hpp"
 #include "util/serialization/format.hpp"
 #include "util/serialization/util.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <cstring>
 #include <leveldb/write_batch.h>
 #include <utility>
 
 namespace cbdc::archiver {
+    namespace {
+        // Big-endian so the database orders blocks by height
+        auto height_key(uint64_t height) -> std::string {
+            auto ret = std::string(sizeof(height), '\0');
+            std::memcpy(ret.data(), &height, sizeof(height));
+            if constexpr(std::endian::native == std::endian::little) {
+                std::reverse(ret.begin(), ret.end());
+            }
+            return ret;
+        }
+
+        auto index_key(char prefix, const hash_t& id) -> std::string {
+            auto ret = std::string(1 + id.size(), prefix);
+            std::memcpy(&ret[1], id.data(), id.size());
+            return ret;
+        }
+    }
 
     leveldbWriteOptions::leveldbWriteOptions(bool do_sync) {
         // Set base class member:
@@ -20,6 +41,7 @@ namespace cbdc::archiver {
     }
 
     const leveldbWriteOptions controller::m_write_options{true};
+    const leveldbWriteOptions controller::m_async_write_options{false};
 
     controller::controller(uint32_t archiver_id,
                            cbdc::config::options opts,
@@ -43,6 +65,8 @@ namespace cbdc::archiver {
         if(m_archiver_server.joinable()) {
             m_archiver_server.join();
         }
+
+        sync();
     }
 
     auto controller::init() -> bool {
@@ -68,7 +92,9 @@ namespace cbdc::archiver {
         leveldb::Options opt;
         opt.create_if_missing = true;
         opt.paranoid_checks = true;
-        opt.compression = leveldb::kNoCompression;
+        opt.compression = m_opts.m_archiver_compression
+                            ? leveldb::kSnappyCompression
+                            : leveldb::kNoCompression;
 
         leveldb::DB* db_ptr{};
         const auto res
@@ -96,6 +122,7 @@ namespace cbdc::archiver {
             }
         }
         m_best_height = static_cast<uint64_t>(std::stoul(bestblock_val));
+        m_synced_height = m_best_height;
         return true;
     }
 
@@ -151,8 +178,38 @@ namespace cbdc::archiver {
             m_logger->error("Invalid request packet");
             return std::nullopt;
         }
-        auto blk = get_block(req.value());
-        return cbdc::make_buffer(blk);
+        using ret_type = std::optional<cbdc::buffer>;
+        return std::visit(
+            overloaded{[&](block_request height) -> ret_type {
+                           return cbdc::make_buffer(get_block(height));
+                       },
+                       [&](const block_range_request& r) -> ret_type {
+                           auto count = std::min(r.m_count, max_range_blocks);
+                           return cbdc::make_buffer(
+                               get_blocks(r.m_start, count));
+                       },
+                       [&](const tx_location_request& r) -> ret_type {
+                           return cbdc::make_buffer(
+                               get_tx_location(r.m_tx_id));
+                       },
+                       [&](const uhs_location_request& r) -> ret_type {
+                           return cbdc::make_buffer(
+                               get_uhs_location(r.m_uhs_id));
+                       },
+                       [&](const block_stream_request& r) -> ret_type {
+                           // The handler thread serves one request at a
+                           // time, so the chunks reach the peer in order
+                           // and before any later response.
+                           stream_blocks(
+                               r.m_start,
+                               r.m_count,
+                               [&](block_range_response&& chunk) {
+                                   m_archiver_network.send(chunk,
+                                                           pkt.m_peer_id);
+                               });
+                           return std::nullopt;
+                       }},
+            req.value());
     }
 
     auto controller::atomizer_handler(cbdc::network::message_t&& pkt)
@@ -184,6 +241,7 @@ namespace cbdc::archiver {
             if(blk_res.ok()) {
                 m_best_height
                     = static_cast<uint64_t>(std::stoul(bestblock_val));
+                m_synced_height = m_best_height;
             }
         }
 
@@ -200,8 +258,15 @@ namespace cbdc::archiver {
                 // Not contiguous, check prev block isn't deferred already
                 auto it = m_deferred.find(blk.m_height - 1);
                 if(it == m_deferred.end()) {
-                    // Request previous block from atomizer cluster
-                    request_block(blk.m_height - 1);
+                    // Request the whole gap below this block from the
+                    // atomizer cluster. Gaps below deferred blocks were
+                    // requested when those blocks arrived.
+                    auto start = m_best_height + 1;
+                    auto prev = m_deferred.lower_bound(blk.m_height);
+                    if(prev != m_deferred.begin()) {
+                        start = std::max(start, std::prev(prev)->first + 1);
+                    }
+                    request_blocks(start, blk.m_height - start);
                 }
                 m_deferred.emplace(blk.m_height, blk);
                 return;
@@ -213,14 +278,29 @@ namespace cbdc::archiver {
 
             auto blk_bytes = make_buffer(blk);
             leveldb::Slice blk_slice(blk_bytes.c_str(), blk_bytes.size());
+            batch.Put(height_key(blk.m_height), blk_slice);
+
+            for(uint64_t i{0}; i < blk.m_transactions.size(); i++) {
+                const auto& tx = blk.m_transactions[i];
+                auto loc_bytes = make_buffer(tx_location{blk.m_height, i});
+                leveldb::Slice loc_slice(loc_bytes.c_str(), loc_bytes.size());
+                batch.Put(index_key(m_tx_index_prefix, tx.m_id), loc_slice);
+                for(const auto& uhs_id : tx.m_uhs_outputs) {
+                    batch.Put(index_key(m_uhs_index_prefix, uhs_id),
+                              loc_slice);
+                }
+            }
 
-            const auto height_str = std::to_string(blk.m_height);
-
-            batch.Put(height_str, blk_slice);
-            batch.Put(m_bestblock_key, height_str);
+            batch.Put(m_bestblock_key, std::to_string(blk.m_height));
             m_best_height++;
 
-            const auto res = m_db->Write(m_write_options, &batch);
+            // Group commit: the sync also covers the unsynced writes of
+            // the preceding blocks
+            const auto do_sync = m_best_height - m_synced_height
+                              >= m_opts.m_archiver_sync_interval;
+            const auto res = m_db->Write(
+                do_sync ? m_write_options : m_async_write_options,
+                &batch);
             assert(res.ok());
 
             m_logger->trace("Digested block ", blk.m_height);
@@ -238,8 +318,12 @@ namespace cbdc::archiver {
             }
 
             // Tell the atomizer cluster to prune all blocks <
-            // m_best_height
-            request_prune(m_best_height);
+            // m_synced_height. Unsynced blocks might be lost in a crash so
+            // the atomizers must keep them.
+            if(do_sync) {
+                m_synced_height = m_best_height;
+                request_prune(m_synced_height);
+            }
 
             auto it = m_deferred.find(blk.m_height + 1);
             if(it != m_deferred.end()) {
@@ -261,12 +345,11 @@ namespace cbdc::archiver {
     auto controller::get_block(uint64_t height)
         -> std::optional<cbdc::atomizer::block> {
         m_logger->trace(__func__, "(", height, ")");
-        std::string height_str = std::to_string(height);
         std::string blk_str;
         // Assume blocks with 100k 256-byte transactions.
         static constexpr const auto expected_entry_sz = 256 * 100000;
         blk_str.reserve(expected_entry_sz);
-        auto s = m_db->Get(m_read_options, height_str, &blk_str);
+        auto s = m_db->Get(m_read_options, height_key(height), &blk_str);
 
         if(!s.ok()) {
             m_logger->warn("block", height, "not found");
@@ -283,12 +366,104 @@ namespace cbdc::archiver {
         return blk.value();
     }
 
-    void controller::request_block(uint64_t height) {
-        m_logger->trace("Requesting block", height);
-        auto req = atomizer::get_block_request{height};
+    auto controller::get_blocks(uint64_t start, uint64_t count)
+        -> std::vector<cbdc::atomizer::block> {
+        m_logger->trace(__func__, "(", start, ",", count, ")");
+        auto ret = std::vector<cbdc::atomizer::block>();
+        scan_blocks(start, count, [&](cbdc::atomizer::block&& blk) {
+            ret.emplace_back(std::move(blk));
+        });
+        return ret;
+    }
+
+    auto controller::stream_blocks(uint64_t start,
+                                   uint64_t count,
+                                   const chunk_callback_type& cb)
+        -> uint64_t {
+        m_logger->trace(__func__, "(", start, ",", count, ")");
+        auto streamed = uint64_t{};
+        auto chunk = block_range_response();
+        scan_blocks(start,
+                    std::min(count, max_stream_blocks),
+                    [&](cbdc::atomizer::block&& blk) {
+                        chunk.emplace_back(std::move(blk));
+                        if(chunk.size() == max_range_blocks) {
+                            streamed += chunk.size();
+                            cb(std::move(chunk));
+                            chunk = block_range_response();
+                        }
+                    });
+        streamed += chunk.size();
+        cb(std::move(chunk));
+        return streamed;
+    }
+
+    void controller::scan_blocks(
+        uint64_t start,
+        uint64_t count,
+        const std::function<void(cbdc::atomizer::block&&)>& cb) {
+        auto it = std::unique_ptr<leveldb::Iterator>(
+            m_db->NewIterator(m_read_options));
+        auto expected = start;
+        for(it->Seek(height_key(start));
+            it->Valid() && expected - start < count;
+            it->Next()) {
+            if(it->key() != height_key(expected)) {
+                // Reached a gap or the end of the blocks
+                break;
+            }
+            auto buf = cbdc::buffer();
+            buf.append(it->value().data(), it->value().size());
+            auto blk = from_buffer<atomizer::block>(buf);
+            assert(blk.has_value());
+            cb(std::move(blk.value()));
+            expected++;
+        }
+    }
+
+    auto controller::get_tx_location(const hash_t& tx_id)
+        -> std::optional<tx_location> {
+        return get_location(m_tx_index_prefix, tx_id);
+    }
+
+    auto controller::get_uhs_location(const hash_t& uhs_id)
+        -> std::optional<tx_location> {
+        return get_location(m_uhs_index_prefix, uhs_id);
+    }
+
+    auto controller::get_location(char prefix, const hash_t& id)
+        -> std::optional<tx_location> {
+        std::string loc_str;
+        auto s = m_db->Get(m_read_options, index_key(prefix, id), &loc_str);
+        if(!s.ok()) {
+            return std::nullopt;
+        }
+        auto buf = cbdc::buffer();
+        buf.append(loc_str.data(), loc_str.size());
+        return from_buffer<tx_location>(buf);
+    }
+
+    void controller::sync() {
+        if(!m_db || m_synced_height == m_best_height) {
+            return;
+        }
+        // An empty synced write flushes all the preceding writes
+        leveldb::WriteBatch batch;
+        const auto res = m_db->Write(m_write_options, &batch);
+        if(!res.ok()) {
+            m_logger->error("Failed to sync archiver database:",
+                            res.ToString());
+            return;
+        }
+        m_synced_height = m_best_height;
+    }
+
+    void controller::request_blocks(uint64_t start, uint64_t count) {
+        m_logger->trace("Requesting", count, "blocks from", start);
+        auto req = atomizer::get_blocks_request{start, count};
         auto pkt = make_shared_buffer(atomizer::request{req});
         if(!m_atomizer_network.send_to_one(pkt)) {
-            m_logger->error("Failed to request block", height);
+            m_logger->error("Failed to request blocks from", start);
         }
     }
 
@@ -27,6 +27,14 @@ namespace cbdc::archiver {
     ///
     /// Connects to the atomizer cluster to receive new blocks and listens for
     /// historical block requests from clients.
+    ///
+    /// Blocks are keyed by their big-endian height so they are laid out in
+    /// height order in the database. Each transaction ID and created UHS ID
+    /// is indexed to the height and position of its transaction. Blocks are
+    /// written without syncing and a sync is issued every
+    /// \ref config::options::m_archiver_sync_interval blocks, covering all
+    /// the preceding writes. Atomizers are only asked to prune blocks up to
+    /// the last synced height.
     class controller {
       public:
         controller() = delete;
@@ -94,10 +102,10 @@ namespace cbdc::archiver {
         ///
         /// Initializes the best block height field on its first call. If the
         /// controller's known best block height is not contiguous with the
-        /// height of the provided block, recursively requests preceding blocks
-        /// from the atomizer. Stores each received block in a deferred
-        /// processing cache until receiving the next contiguous block, then
-        /// digests each block in order.
+        /// height of the provided block, requests all the missing blocks
+        /// from the atomizer with a single request. Stores each received
+        /// block in a deferred processing cache until receiving the next
+        /// contiguous block, then digests each block in order.
         ///
         /// Instructs connected atomizers to prune digested blocks.
         /// \param blk block to digest.
@@ -111,6 +119,50 @@ namespace cbdc::archiver {
         auto get_block(uint64_t height)
             -> std::optional<cbdc::atomizer::block>;
 
+        /// Queries the archiver database for consecutive blocks with a
+        /// single sequential scan.
+        /// \param start height of the first block to retrieve.
+        /// \param count number of blocks to retrieve.
+        /// \return blocks in height order, stopping at the first block the
+        ///         database does not contain.
+        auto get_blocks(uint64_t start, uint64_t count)
+            -> std::vector<cbdc::atomizer::block>;
+
+        /// Function called with each packet of a block stream.
+        using chunk_callback_type
+            = std::function<void(block_range_response&&)>;
+
+        /// \brief Streams consecutive blocks from the archiver database.
+        ///
+        /// Reads the blocks with a single sequential scan and passes them
+        /// to the callback in chunks of \ref max_range_blocks blocks. The
+        /// last chunk always holds fewer than \ref max_range_blocks blocks
+        /// and may be empty, marking the end of the stream.
+        /// \param start height of the first block to stream.
+        /// \param count number of blocks to stream. At most
+        ///              \ref max_stream_blocks blocks are streamed.
+        /// \param cb function to call with each chunk of blocks.
+        /// \return number of blocks streamed. Stops at the first block the
+        ///         database does not contain.
+        auto stream_blocks(uint64_t start,
+                           uint64_t count,
+                           const chunk_callback_type& cb) -> uint64_t;
+
+        /// Queries the transaction index for the given transaction ID.
+        /// \param tx_id transaction ID.
+        /// \return height and position of the transaction, or std::nullopt
+        ///         if the transaction has not been archived.
+        auto get_tx_location(const hash_t& tx_id)
+            -> std::optional<tx_location>;
+
+        /// Queries the transaction index for the transaction which created
+        /// the given UHS ID.
+        /// \param uhs_id UHS ID.
+        /// \return height and position of the transaction, or std::nullopt
+        ///         if the UHS ID has not been archived.
+        auto get_uhs_location(const hash_t& uhs_id)
+            -> std::optional<tx_location>;
+
         /// \brief Returns true if this archiver is receiving blocks
         /// from the atomizer.
         ///
@@ -126,6 +178,8 @@ namespace cbdc::archiver {
 
         std::unique_ptr<leveldb::DB> m_db;
         uint64_t m_best_height{0};
+        /// Height of the most recent block synced to disk.
+        uint64_t m_synced_height{0};
         /// Blocks pending digestion, waiting for the archiver to digest
         /// preceding blocks from the atomizer, keyed by height.
         /// \see \ref digest_block
@@ -148,9 +202,23 @@ namespace cbdc::archiver {
         const std::string m_bestblock_key = "bestblock";
         static constexpr const leveldb::ReadOptions m_read_options{};
         static const leveldbWriteOptions m_write_options;
+        static const leveldbWriteOptions m_async_write_options;
 
-        void request_block(uint64_t height);
+        static constexpr char m_tx_index_prefix = 't';
+        static constexpr char m_uhs_index_prefix = 'u';
+
+        void request_blocks(uint64_t start, uint64_t count);
         void request_prune(uint64_t height);
+
+        void sync();
+
+        [[nodiscard]] auto get_location(char prefix, const hash_t& id)
+            -> std::optional<tx_location>;
+
+        void scan_blocks(
+            uint64_t start,
+            uint64_t count,
+            const std::function<void(cbdc::atomizer::block&&)>& cb);
     };
 }
 
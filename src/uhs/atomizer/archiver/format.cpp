@@ -0,0 +1,60 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "format.hpp"
+
+#include "util/serialization/format.hpp"
+
+namespace cbdc {
+    auto operator<<(serializer& ser, const archiver::block_range_request& r)
+        -> serializer& {
+        return ser << r.m_start << r.m_count;
+    }
+
+    auto operator>>(serializer& deser, archiver::block_range_request& r)
+        -> serializer& {
+        return deser >> r.m_start >> r.m_count;
+    }
+
+    auto operator<<(serializer& ser, const archiver::block_stream_request& r)
+        -> serializer& {
+        return ser << r.m_start << r.m_count;
+    }
+
+    auto operator>>(serializer& deser, archiver::block_stream_request& r)
+        -> serializer& {
+        return deser >> r.m_start >> r.m_count;
+    }
+
+    auto operator<<(serializer& ser, const archiver::tx_location_request& r)
+        -> serializer& {
+        return ser << r.m_tx_id;
+    }
+
+    auto operator>>(serializer& deser, archiver::tx_location_request& r)
+        -> serializer& {
+        return deser >> r.m_tx_id;
+    }
+
+    auto operator<<(serializer& ser, const archiver::uhs_location_request& r)
+        -> serializer& {
+        return ser << r.m_uhs_id;
+    }
+
+    auto operator>>(serializer& deser, archiver::uhs_location_request& r)
+        -> serializer& {
+        return deser >> r.m_uhs_id;
+    }
+
+    auto operator<<(serializer& ser, const archiver::tx_location& loc)
+        -> serializer& {
+        return ser << loc.m_height << loc.m_position;
+    }
+
+    auto operator>>(serializer& deser, archiver::tx_location& loc)
+        -> serializer& {
+        return deser >> loc.m_height >> loc.m_position;
+    }
+}
@@ -0,0 +1,39 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef OPENCBDC_TX_SRC_ARCHIVER_FORMAT_H_
+#define OPENCBDC_TX_SRC_ARCHIVER_FORMAT_H_
+
+#include "client.hpp"
+#include "util/serialization/serializer.hpp"
+
+namespace cbdc {
+    auto operator<<(serializer& ser, const archiver::block_range_request& r)
+        -> serializer&;
+    auto operator>>(serializer& deser, archiver::block_range_request& r)
+        -> serializer&;
+
+    auto operator<<(serializer& ser, const archiver::block_stream_request& r)
+        -> serializer&;
+    auto operator>>(serializer& deser, archiver::block_stream_request& r)
+        -> serializer&;
+
+    auto operator<<(serializer& ser, const archiver::tx_location_request& r)
+        -> serializer&;
+    auto operator>>(serializer& deser, archiver::tx_location_request& r)
+        -> serializer&;
+
+    auto operator<<(serializer& ser, const archiver::uhs_location_request& r)
+        -> serializer&;
+    auto operator>>(serializer& deser, archiver::uhs_location_request& r)
+        -> serializer&;
+
+    auto operator<<(serializer& ser, const archiver::tx_location& loc)
+        -> serializer&;
+    auto operator>>(serializer& deser, archiver::tx_location& loc)
+        -> serializer&;
+}
+
+#endif // OPENCBDC_TX_SRC_ARCHIVER_FORMAT_H_
@@ -25,10 +25,12 @@ namespace cbdc::atomizer {
                false,
                nuraft::cs_new<state_machine>(
                    stxo_cache_depth,
+                   opts.m_atomizer_block_cache_size,
                    "atomizer_snps_" + std::to_string(atomizer_id)),
                0,
                logger,
-               std::move(raft_callback)),
+               std::move(raft_callback),
+               opts.m_raft_log_store),
           m_log(std::move(logger)),
           m_opts(std::move(opts)) {}
 
@@ -4,9 +4,39 @@
 
 #include "block.hpp"
 
+#include <algorithm>
+#include <iterator>
+
 namespace cbdc {
     auto cbdc::atomizer::block::operator==(const block& rhs) const -> bool {
         return (rhs.m_height == m_height)
             && (rhs.m_transactions == m_transactions);
     }
+
+    auto atomizer::project_block(const block& blk,
+                                 const config::shard_range_t& range)
+        -> block {
+        auto ret = block();
+        ret.m_height = blk.m_height;
+        auto in_range = [&](const hash_t& id) {
+            return config::hash_in_shard_range(range, id);
+        };
+        for(const auto& tx : blk.m_transactions) {
+            auto proj = transaction::compact_tx();
+            std::copy_if(tx.m_inputs.begin(),
+                         tx.m_inputs.end(),
+                         std::back_inserter(proj.m_inputs),
+                         in_range);
+            std::copy_if(tx.m_uhs_outputs.begin(),
+                         tx.m_uhs_outputs.end(),
+                         std::back_inserter(proj.m_uhs_outputs),
+                         in_range);
+            if(proj.m_inputs.empty() && proj.m_uhs_outputs.empty()) {
+                continue;
+            }
+            proj.m_id = tx.m_id;
+            ret.m_transactions.emplace_back(std::move(proj));
+        }
+        return ret;
+    }
 }
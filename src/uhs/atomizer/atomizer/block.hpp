@@ -8,6 +8,7 @@
 
 #include "uhs/transaction/transaction.hpp"
 #include "util/common/buffer.hpp"
+#include "util/common/config.hpp"
 
 #include <cassert>
 #include <cstddef>
@@ -25,6 +26,18 @@ namespace cbdc::atomizer {
         /// Compact transactions settled by the atomizer in this block.
         std::vector<transaction::compact_tx> m_transactions;
     };
+
+    /// \brief Returns the part of a block relevant to a shard.
+    ///
+    /// Keeps only the inputs and UHS outputs within the given UHS ID prefix
+    /// range, drops transactions left with neither and clears attestations.
+    /// A shard digesting the projection reaches the same state as when
+    /// digesting the full block.
+    /// \param blk block to project.
+    /// \param range inclusive UHS ID prefix range of the shard.
+    /// \return block at the same height with the filtered transactions.
+    auto project_block(const block& blk, const config::shard_range_t& range)
+        -> block;
 }
 
 #endif // OPENCBDC_TX_SRC_ATOMIZER_BLOCK_H_
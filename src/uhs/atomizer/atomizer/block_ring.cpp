@@ -0,0 +1,98 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "block_ring.hpp"
+
+#include <utility>
+
+namespace cbdc::atomizer {
+    block_ring::block_ring(size_t capacity) : m_slots(capacity) {
+        assert(capacity > 0);
+    }
+
+    void block_ring::push(block blk) {
+        if(m_size > 0 && blk.m_height != m_first_height + m_size) {
+            clear();
+        }
+        if(m_size == 0) {
+            m_first_height = blk.m_height;
+        } else if(m_size == m_slots.size()) {
+            grow();
+        }
+        m_slots[slot(blk.m_height)] = std::move(blk);
+        m_size++;
+    }
+
+    auto block_ring::find(uint64_t height) const -> const block* {
+        if(height < m_first_height || height - m_first_height >= m_size) {
+            return nullptr;
+        }
+        return &m_slots[slot(height)];
+    }
+
+    auto block_ring::prune(uint64_t height) -> size_t {
+        size_t count{0};
+        while(m_size > 0 && m_first_height < height) {
+            m_slots[slot(m_first_height)] = block();
+            m_first_height++;
+            m_size--;
+            count++;
+        }
+        return count;
+    }
+
+    void block_ring::clear() {
+        prune(m_first_height + m_size);
+    }
+
+    auto block_ring::size() const -> size_t {
+        return m_size;
+    }
+
+    auto block_ring::empty() const -> bool {
+        return m_size == 0;
+    }
+
+    auto block_ring::capacity() const -> size_t {
+        return m_slots.size();
+    }
+
+    auto block_ring::first_height() const -> std::optional<uint64_t> {
+        if(m_size == 0) {
+            return std::nullopt;
+        }
+        return m_first_height;
+    }
+
+    auto block_ring::operator==(const block_ring& rhs) const -> bool {
+        if(m_size != rhs.m_size) {
+            return false;
+        }
+        if(m_size == 0) {
+            return true;
+        }
+        if(m_first_height != rhs.m_first_height) {
+            return false;
+        }
+        for(uint64_t h = m_first_height; h < m_first_height + m_size; h++) {
+            if(!(*find(h) == *rhs.find(h))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    auto block_ring::slot(uint64_t height) const -> size_t {
+        return static_cast<size_t>(height % m_slots.size());
+    }
+
+    void block_ring::grow() {
+        auto slots = std::vector<block>(m_slots.size() * 2);
+        for(uint64_t h = m_first_height; h < m_first_height + m_size; h++) {
+            slots[h % slots.size()] = std::move(m_slots[slot(h)]);
+        }
+        m_slots = std::move(slots);
+    }
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef OPENCBDC_TX_SRC_ATOMIZER_BLOCK_RING_H_
+#define OPENCBDC_TX_SRC_ATOMIZER_BLOCK_RING_H_
+
+#include "block.hpp"
+
+#include <optional>
+#include <vector>
+
+namespace cbdc::atomizer {
+    /// \brief Cache of a contiguous range of recent blocks, indexed by
+    ///        height.
+    ///
+    /// Blocks are stored in a ring buffer at the slot given by their height
+    /// modulo the ring capacity, so lookups by height are constant time and
+    /// pruning only touches the blocks being evicted. Blocks are never
+    /// overwritten before they are pruned: if a block is pushed while the
+    /// ring is full, the capacity is doubled instead.
+    class block_ring {
+      public:
+        /// Default number of blocks the ring holds before growing.
+        static constexpr size_t default_capacity{1024};
+
+        /// Constructor.
+        /// \param capacity initial number of block slots. Must be positive.
+        explicit block_ring(size_t capacity = default_capacity);
+
+        /// Appends a block to the ring. Blocks are expected to be pushed in
+        /// consecutive height order. If the block does not immediately
+        /// follow the highest cached block, the ring is cleared first.
+        /// \param blk block to append.
+        void push(block blk);
+
+        /// Returns the cached block at the given height.
+        /// \param height block height.
+        /// \return pointer to the block, or nullptr if the block is not in
+        ///         the cache. Invalidated by subsequent modifications.
+        [[nodiscard]] auto find(uint64_t height) const -> const block*;
+
+        /// Evicts all cached blocks below the given height.
+        /// \param height height below which to evict blocks.
+        /// \return number of blocks evicted.
+        auto prune(uint64_t height) -> size_t;
+
+        /// Evicts all cached blocks.
+        void clear();
+
+        /// Returns the number of cached blocks.
+        /// \return block count.
+        [[nodiscard]] auto size() const -> size_t;
+
+        /// Returns whether the ring contains no blocks.
+        /// \return true if the ring is empty.
+        [[nodiscard]] auto empty() const -> bool;
+
+        /// Returns the number of block slots in the ring.
+        /// \return ring capacity.
+        [[nodiscard]] auto capacity() const -> size_t;
+
+        /// Returns the height of the lowest cached block.
+        /// \return block height, or std::nullopt if the ring is empty.
+        [[nodiscard]] auto first_height() const -> std::optional<uint64_t>;
+
+        /// Compares the cached blocks of two rings, ignoring their
+        /// capacities.
+        /// \param rhs ring to compare with.
+        /// \return true if both rings contain the same blocks.
+        auto operator==(const block_ring& rhs) const -> bool;
+
+      private:
+        std::vector<block> m_slots;
+        uint64_t m_first_height{};
+        size_t m_size{};
+
+        [[nodiscard]] auto slot(uint64_t height) const -> size_t;
+        void grow();
+    };
+}
+
+#endif // OPENCBDC_TX_SRC_ATOMIZER_BLOCK_RING_H_
@@ -121,7 +121,17 @@ namespace cbdc::atomizer {
                     m_notification_queue.push(notif);
                 },
                 [&](const prune_request& p) {
-                    m_raft_node.make_request(p, nullptr);
+                    record_prune(p.m_block_height);
+                },
+                [&](const block_subscription_request& s) {
+                    m_logger->debug("Peer",
+                                    pkt.m_peer_id,
+                                    "subscribed to shard range",
+                                    static_cast<int>(s.m_range.first),
+                                    "-",
+                                    static_cast<int>(s.m_range.second));
+                    std::unique_lock<std::mutex> l(m_subscriptions_mut);
+                    m_subscriptions[pkt.m_peer_id] = s.m_range;
                 },
                 [&](const get_block_request& g) {
                     auto result_fn = [&, peer_id = pkt.m_peer_id](
@@ -149,6 +159,33 @@ namespace cbdc::atomizer {
                         m_atomizer_network.send(resp.m_blk, peer_id);
                     };
                     m_raft_node.make_request(g, result_fn);
+                },
+                [&](const get_blocks_request& g) {
+                    // One log entry serves the whole range, and the blocks
+                    // are sent to the peer in height order
+                    auto result_fn = [&, peer_id = pkt.m_peer_id](
+                                         raft::result_type& r,
+                                         nuraft::ptr<std::exception>& err) {
+                        if(err) {
+                            m_logger->error("Exception handling log entry:",
+                                            err->what());
+                            return;
+                        }
+
+                        const auto res = r.get();
+                        assert(res);
+                        auto maybe_resp
+                            = from_buffer<state_machine::response>(*res);
+                        assert(maybe_resp.has_value());
+                        assert(std::holds_alternative<get_blocks_response>(
+                            maybe_resp.value()));
+                        auto& resp = std::get<get_blocks_response>(
+                            maybe_resp.value());
+                        for(const auto& blk : resp.m_blks) {
+                            m_atomizer_network.send(blk, peer_id);
+                        }
+                    };
+                    m_raft_node.make_request(g, result_fn);
                 }},
             maybe_req.value());
 
@@ -191,6 +228,7 @@ namespace cbdc::atomizer {
                     m_logger->error("Failed to make block at time",
                                     last_time.time_since_epoch().count());
                 }
+                replicate_prune();
             }
         }
     }
@@ -209,9 +247,7 @@ namespace cbdc::atomizer {
             std::holds_alternative<make_block_response>(maybe_resp.value()));
         auto& resp = std::get<make_block_response>(maybe_resp.value());
 
-        auto blk_pkt = make_shared_buffer(resp.m_blk);
-
-        m_atomizer_network.broadcast(blk_pkt);
+        broadcast_block(resp.m_blk);
 
         m_logger->info("Block h:",
                        resp.m_blk.m_height,
@@ -263,8 +299,13 @@ namespace cbdc::atomizer {
             if(m_atomizer_server.joinable()) {
                 m_atomizer_server.join();
             }
-            // Reset the client network so we can use it again.
+            // Reset the client network so we can use it again. Peers must
+            // subscribe again after reconnecting.
             m_atomizer_network.reset();
+            {
+                std::unique_lock<std::mutex> l(m_subscriptions_mut);
+                m_subscriptions.clear();
+            }
             // Start listening on our client endpoint and start the handler
             // thread.
             auto as = m_atomizer_network.start_server(
@@ -282,6 +323,64 @@ namespace cbdc::atomizer {
         return nuraft::cb_func::ReturnCode::Ok;
     }
 
+    void controller::broadcast_block(const block& blk) {
+        // Build each distinct projection once and send it to every peer
+        // subscribed to that range. Unsubscribed peers, such as archivers
+        // and watchtowers, receive the full block.
+        auto ranges = std::map<config::shard_range_t,
+                               std::vector<network::peer_id_t>>();
+        auto subscribed = std::unordered_set<network::peer_id_t>();
+        {
+            std::unique_lock<std::mutex> l(m_subscriptions_mut);
+            for(auto it = m_subscriptions.begin();
+                it != m_subscriptions.end();) {
+                if(!m_atomizer_network.connected(it->first)) {
+                    it = m_subscriptions.erase(it);
+                    continue;
+                }
+                ranges[it->second].push_back(it->first);
+                subscribed.insert(it->first);
+                it++;
+            }
+        }
+
+        for(const auto& [range, peers] : ranges) {
+            auto pkt = make_shared_buffer(project_block(blk, range));
+            for(const auto& peer_id : peers) {
+                m_atomizer_network.send(pkt, peer_id);
+            }
+        }
+
+        auto blk_pkt = make_shared_buffer(blk);
+        m_atomizer_network.broadcast_except(blk_pkt, subscribed);
+    }
+
+    void controller::record_prune(uint64_t height) {
+        // Several archivers may request pruning after every block. Keep
+        // only the highest requested height and let the block loop replicate
+        // it at a lower rate.
+        auto current = m_prune_height.load();
+        while(current < height
+              && !m_prune_height.compare_exchange_weak(current, height)) {}
+    }
+
+    void controller::replicate_prune() {
+        m_blocks_since_prune++;
+        if(m_blocks_since_prune < m_opts.m_atomizer_prune_interval) {
+            return;
+        }
+        const auto height = m_prune_height.load();
+        if(height <= m_pruned_height) {
+            return;
+        }
+        m_blocks_since_prune = 0;
+        if(!m_raft_node.make_request(prune_request{height}, nullptr)) {
+            m_logger->warn("Failed to replicate prune below", height);
+            return;
+        }
+        m_pruned_height = height;
+    }
+
     void controller::notification_consumer() {
         while(m_running) {
             auto notif = tx_notify_request();
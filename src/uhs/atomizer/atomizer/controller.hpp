@@ -11,7 +11,9 @@
 #include "util/common/config.hpp"
 #include "util/network/connection_manager.hpp"
 
+#include <map>
 #include <memory>
+#include <mutex>
 
 namespace cbdc::atomizer {
     /// Wrapper for the atomizer raft executable implementation.
@@ -55,6 +57,13 @@ namespace cbdc::atomizer {
         blocking_queue<tx_notify_request> m_notification_queue;
         std::vector<std::thread> m_notification_threads;
 
+        std::mutex m_subscriptions_mut;
+        std::map<network::peer_id_t, config::shard_range_t> m_subscriptions;
+
+        std::atomic<uint64_t> m_prune_height{0};
+        uint64_t m_pruned_height{0};
+        size_t m_blocks_since_prune{0};
+
         auto server_handler(cbdc::network::message_t&& pkt)
             -> std::optional<cbdc::buffer>;
         void tx_notify_handler();
@@ -67,6 +76,9 @@ namespace cbdc::atomizer {
                            nuraft::cb_func::Param* param)
             -> nuraft::cb_func::ReturnCode;
         void notification_consumer();
+        void record_prune(uint64_t height);
+        void broadcast_block(const block& blk);
+        void replicate_prune();
     };
 }
 
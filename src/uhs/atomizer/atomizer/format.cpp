@@ -10,6 +10,9 @@
 #include "util/serialization/format.hpp"
 #include "util/serialization/util.hpp"
 
+#include <algorithm>
+#include <limits>
+
 namespace cbdc {
     auto operator<<(serializer& packet, const cbdc::atomizer::block& blk)
         -> serializer& {
@@ -21,6 +24,80 @@ namespace cbdc {
         return packet >> blk.m_height >> blk.m_transactions;
     }
 
+    namespace {
+        // Leads the serialized block cache, ahead of the block count. Older
+        // versions serialized the cache as a map from height to block,
+        // which starts with the number of blocks and never with a count
+        // this large. Each format version decrements the tag.
+        constexpr auto block_ring_format_v1
+            = std::numeric_limits<uint64_t>::max() - 1;
+
+        // Reads the block cache written by versions without a format tag,
+        // given the block count read in place of the tag
+        auto read_legacy_blocks(serializer& deser,
+                                uint64_t count,
+                                atomizer::block_ring& blks) -> serializer& {
+            auto blocks = std::vector<atomizer::block>();
+            for(uint64_t i = 0; i < count; i++) {
+                uint64_t height{};
+                auto blk = atomizer::block();
+                if(!(deser >> height >> blk)) {
+                    return deser;
+                }
+                blocks.push_back(std::move(blk));
+            }
+            // The map was unordered but the ring needs consecutive heights
+            std::sort(blocks.begin(),
+                      blocks.end(),
+                      [](const auto& lhs, const auto& rhs) {
+                          return lhs.m_height < rhs.m_height;
+                      });
+            for(auto& blk : blocks) {
+                blks.push(std::move(blk));
+            }
+            return deser;
+        }
+    }
+
+    auto operator<<(serializer& ser, const atomizer::block_ring& blks)
+        -> serializer& {
+        ser << block_ring_format_v1 << static_cast<uint64_t>(blks.size());
+        if(blks.empty()) {
+            return ser;
+        }
+        const auto first = blks.first_height().value();
+        for(uint64_t h = first; h < first + blks.size(); h++) {
+            ser << *blks.find(h);
+        }
+        return ser;
+    }
+
+    auto operator>>(serializer& deser, atomizer::block_ring& blks)
+        -> serializer& {
+        uint64_t tag{};
+        if(!(deser >> tag)) {
+            return deser;
+        }
+        if(tag != block_ring_format_v1) {
+            // A tag from a newer format is read as an impossibly large
+            // legacy block count, so deserialization runs out of input and
+            // fails
+            return read_legacy_blocks(deser, tag, blks);
+        }
+        uint64_t count{};
+        if(!(deser >> count)) {
+            return deser;
+        }
+        for(uint64_t i = 0; i < count; i++) {
+            auto blk = atomizer::block();
+            if(!(deser >> blk)) {
+                return deser;
+            }
+            blks.push(std::move(blk));
+        }
+        return deser;
+    }
+
     auto operator<<(serializer& ser,
                     const atomizer::state_machine::snapshot& snp)
         -> serializer& {
@@ -114,6 +191,25 @@ namespace cbdc {
         return deser >> r.m_block_height;
     }
 
+    auto operator<<(serializer& ser, const atomizer::get_blocks_request& r)
+        -> serializer& {
+        return ser << r.m_start_height << r.m_count;
+    }
+    auto operator>>(serializer& deser, atomizer::get_blocks_request& r)
+        -> serializer& {
+        return deser >> r.m_start_height >> r.m_count;
+    }
+
+    auto operator<<(serializer& ser,
+                    const atomizer::block_subscription_request& r)
+        -> serializer& {
+        return ser << r.m_range;
+    }
+    auto operator>>(serializer& deser,
+                    atomizer::block_subscription_request& r) -> serializer& {
+        return deser >> r.m_range;
+    }
+
     auto operator<<(serializer& ser, const atomizer::make_block_response& r)
         -> serializer& {
         return ser << r.m_blk << r.m_errs;
@@ -131,4 +227,13 @@ namespace cbdc {
         -> serializer& {
         return deser >> r.m_blk;
     }
+
+    auto operator<<(serializer& ser, const atomizer::get_blocks_response& r)
+        -> serializer& {
+        return ser << r.m_blks;
+    }
+    auto operator>>(serializer& deser, atomizer::get_blocks_response& r)
+        -> serializer& {
+        return deser >> r.m_blks;
+    }
 }
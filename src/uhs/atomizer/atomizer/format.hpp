@@ -38,6 +38,15 @@ namespace cbdc {
     auto operator>>(serializer& packet, cbdc::atomizer::block& blk)
         -> serializer&;
 
+    /// Serializes the cached blocks in height order, preceded by a format
+    /// version tag.
+    auto operator<<(serializer& ser, const atomizer::block_ring& blks)
+        -> serializer&;
+    /// Deserializes cached blocks, including the untagged map from height
+    /// to block written by older versions.
+    auto operator>>(serializer& deser, atomizer::block_ring& blks)
+        -> serializer&;
+
     auto operator<<(serializer& ser, const atomizer::prune_request& r)
         -> serializer&;
     auto operator>>(serializer& deser, atomizer::prune_request& r)
@@ -53,6 +62,17 @@ namespace cbdc {
     auto operator>>(serializer& deser, atomizer::get_block_request& r)
         -> serializer&;
 
+    auto operator<<(serializer& ser, const atomizer::get_blocks_request& r)
+        -> serializer&;
+    auto operator>>(serializer& deser, atomizer::get_blocks_request& r)
+        -> serializer&;
+
+    auto operator<<(serializer& ser,
+                    const atomizer::block_subscription_request& r)
+        -> serializer&;
+    auto operator>>(serializer& deser,
+                    atomizer::block_subscription_request& r) -> serializer&;
+
     auto operator<<(serializer& ser, const atomizer::make_block_response& r)
         -> serializer&;
     auto operator>>(serializer& deser, atomizer::make_block_response& r)
@@ -62,6 +82,11 @@ namespace cbdc {
         -> serializer&;
     auto operator>>(serializer& deser, atomizer::get_block_response& r)
         -> serializer&;
+
+    auto operator<<(serializer& ser, const atomizer::get_blocks_response& r)
+        -> serializer&;
+    auto operator>>(serializer& deser, atomizer::get_blocks_response& r)
+        -> serializer&;
 }
 
 #endif // OPENCBDC_TX_SRC_ATOMIZER_FORMAT_H_
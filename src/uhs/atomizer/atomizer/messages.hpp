@@ -76,6 +76,25 @@ namespace cbdc::atomizer {
         uint64_t m_block_height{};
     };
 
+    /// Retrieve a range of cached blocks request.
+    struct get_blocks_request {
+        /// Height of the first block to retrieve.
+        uint64_t m_start_height{};
+        /// Number of blocks to retrieve.
+        uint64_t m_count{};
+    };
+
+    /// \brief Subscribes the sender to the block projection for a shard.
+    ///
+    /// The atomizer then sends the sender, instead of full blocks, only the
+    /// inputs and outputs in the given range. Not replicated; the
+    /// subscription lasts for the connection to the current leader.
+    /// \see project_block
+    struct block_subscription_request {
+        /// Inclusive UHS ID prefix range of the subscribing shard.
+        config::shard_range_t m_range{};
+    };
+
     /// List of watchtower errors returned by the atomizer state machine.
     using errors = std::vector<watchtower::tx_error>;
 
@@ -93,9 +112,19 @@ namespace cbdc::atomizer {
         block m_blk;
     };
 
+    /// Atomizer state machine response from get blocks request.
+    struct get_blocks_response {
+        /// Consecutive cached blocks from the requested start height,
+        /// stopping at the first block not in the cache.
+        std::vector<block> m_blks;
+    };
+
     /// Atomizer RPC request.
-    using request
-        = std::variant<tx_notify_request, prune_request, get_block_request>;
+    using request = std::variant<tx_notify_request,
+                                 prune_request,
+                                 get_block_request,
+                                 get_blocks_request,
+                                 block_subscription_request>;
 }
 
 #endif
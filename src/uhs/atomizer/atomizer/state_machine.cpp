@@ -21,11 +21,14 @@
 
 namespace cbdc::atomizer {
     state_machine::state_machine(size_t stxo_cache_depth,
+                                 size_t block_cache_size,
                                  std::string snapshot_dir)
         : m_snapshot_dir(std::move(snapshot_dir)),
-          m_stxo_cache_depth(stxo_cache_depth) {
+          m_stxo_cache_depth(stxo_cache_depth),
+          m_block_cache_size(block_cache_size) {
         m_atomizer = std::make_shared<atomizer>(0, m_stxo_cache_depth);
-        m_blocks = std::make_shared<decltype(m_blocks)::element_type>();
+        m_blocks = std::make_shared<decltype(m_blocks)::element_type>(
+            m_block_cache_size);
         auto err = std::error_code();
         std::filesystem::create_directory(m_snapshot_dir, err);
         if(err) {
@@ -71,24 +74,30 @@ namespace cbdc::atomizer {
                 [&](const make_block_request& /* r */)
                     -> std::optional<response> {
                     auto [blk, errs] = m_atomizer->make_block();
-                    m_blocks->emplace(blk.m_height, blk);
+                    m_blocks->push(blk);
                     return make_block_response{blk, errs};
                 },
                 [&](const get_block_request& r) -> std::optional<response> {
-                    auto it = m_blocks->find(r.m_block_height);
-                    if(it != m_blocks->end()) {
-                        return get_block_response{it->second};
+                    const auto* blk = m_blocks->find(r.m_block_height);
+                    if(blk != nullptr) {
+                        return get_block_response{*blk};
                     }
                     return std::nullopt;
                 },
-                [&](const prune_request& r) -> std::optional<response> {
-                    for(auto it = m_blocks->begin(); it != m_blocks->end();) {
-                        if(it->second.m_height < r.m_block_height) {
-                            it = m_blocks->erase(it);
-                        } else {
-                            it++;
+                [&](const get_blocks_request& r) -> std::optional<response> {
+                    auto ret = get_blocks_response();
+                    for(uint64_t i = 0; i < r.m_count; i++) {
+                        const auto* blk
+                            = m_blocks->find(r.m_start_height + i);
+                        if(blk == nullptr) {
+                            break;
                         }
+                        ret.m_blks.push_back(*blk);
                     }
+                    return ret;
+                },
+                [&](const prune_request& r) -> std::optional<response> {
+                    m_blocks->prune(r.m_block_height);
                     return std::nullopt;
                 },
             },
@@ -321,7 +330,8 @@ namespace cbdc::atomizer {
         }
         auto deser = cbdc::istream_serializer(ss);
         auto new_atm = std::make_shared<atomizer>(0, m_stxo_cache_depth);
-        auto new_blocks = std::make_shared<decltype(m_blocks)::element_type>();
+        auto new_blocks = std::make_shared<decltype(m_blocks)::element_type>(
+            m_block_cache_size);
         auto snp
             = snapshot{std::move(new_atm), nullptr, std::move(new_blocks)};
         if(!(deser >> snp)) {
@@ -7,6 +7,7 @@
 #define OPENCBDC_TX_SRC_ATOMIZER_STATE_MACHINE_H_
 
 #include "atomizer.hpp"
+#include "block_ring.hpp"
 #include "messages.hpp"
 
 #include <libnuraft/nuraft.hxx>
@@ -17,24 +18,33 @@ namespace cbdc::atomizer {
     ///
     /// Contains a \ref atomizer and a cache of recently created blocks.
     /// Accepts requests to retrieve and prune recent blocks from the cache.
+    /// Cached blocks are held in a \ref block_ring so retrieving a block is
+    /// constant time and pruning only touches the evicted blocks.
     class state_machine : public nuraft::state_machine {
       public:
         /// Constructor.
         /// \param stxo_cache_depth depth of the spent transaction output
         ///                         cache, passed to the atomizer.
+        /// \param block_cache_size initial capacity of the recent block
+        ///                         cache, in blocks.
         /// \param snapshot_dir path to directory in which to store snapshots.
         ///                     Will create the directory if it doesn't exist.
-        state_machine(size_t stxo_cache_depth, std::string snapshot_dir);
+        state_machine(size_t stxo_cache_depth,
+                      size_t block_cache_size,
+                      std::string snapshot_dir);
 
         /// Atomizer state machine request.
         using request = std::variant<aggregate_tx_notify_request,
                                      make_block_request,
                                      get_block_request,
-                                     prune_request>;
+                                     prune_request,
+                                     get_blocks_request>;
 
         /// Atomizer state machine response.
-        using response
-            = std::variant<make_block_response, get_block_response, errors>;
+        using response = std::variant<make_block_response,
+                                      get_block_response,
+                                      errors,
+                                      get_blocks_response>;
 
         /// Executes the committed the raft log entry at the given index and
         /// return the state machine execution result.
@@ -114,9 +124,8 @@ namespace cbdc::atomizer {
         /// \return transaction notification count.
         [[nodiscard]] auto tx_notify_count() -> uint64_t;
 
-        /// Maps block heights to blocks.
-        using blockstore_t
-            = std::unordered_map<uint64_t, cbdc::atomizer::block>;
+        /// Cache of recent blocks indexed by height.
+        using blockstore_t = block_ring;
 
         /// Represents a snapshot of the state machine with associated
         /// metadata.
@@ -150,6 +159,7 @@ namespace cbdc::atomizer {
         std::string m_snapshot_dir;
 
         size_t m_stxo_cache_depth{};
+        size_t m_block_cache_size{};
 
         std::shared_mutex m_snp_mut;
     };
@@ -7,7 +7,9 @@
 
 #include "uhs/sentinel/format.hpp"
 #include "util/rpc/tcp_server.hpp"
+#include "util/serialization/buffer_serializer.hpp"
 
+#include <algorithm>
 #include <random>
 #include <utility>
 
@@ -17,7 +19,14 @@ namespace cbdc::sentinel {
                            std::shared_ptr<logging::log> logger)
         : m_sentinel_id(sentinel_id),
           m_opts(std::move(opts)),
-          m_logger(std::move(logger)) {}
+          m_logger(std::move(logger)),
+          m_validation_queue(m_opts.m_sentinel_queue_depth),
+          m_attestation_queue(m_opts.m_sentinel_queue_depth),
+          m_routing_queue(m_opts.m_sentinel_queue_depth) {}
+
+    controller::~controller() {
+        stop();
+    }
 
     auto controller::init() -> bool {
         auto skey = m_opts.m_sentinel_private_keys.find(m_sentinel_id);
@@ -52,13 +61,19 @@ namespace cbdc::sentinel {
 
         m_shard_dist = decltype(m_shard_dist)(0, m_shard_data.size() - 1);
 
+        for(size_t i{0}; i < m_shard_data.size(); i++) {
+            m_shard_batches.emplace_back(std::make_unique<shard_batch>());
+        }
+        update_routes();
+
         for(const auto& ep : m_opts.m_sentinel_endpoints) {
             if(ep == m_opts.m_sentinel_endpoints[m_sentinel_id]) {
                 continue;
             }
             auto client = std::make_unique<sentinel::rpc::client>(
                 std::vector<network::endpoint_t>{ep},
-                m_logger);
+                m_logger,
+                std::chrono::microseconds(m_opts.m_rpc_coalesce_window));
             if(!client->init()) {
                 m_logger->error("Failed to start sentinel client");
                 return false;
@@ -68,6 +83,27 @@ namespace cbdc::sentinel {
 
         m_dist = decltype(m_dist)(0, m_sentinel_clients.size() - 1);
 
+        auto n_threads = std::thread::hardware_concurrency() / 2;
+        if(n_threads < 1) {
+            n_threads = 1;
+        }
+        start_workers(m_validation_threads,
+                      m_opts.m_sentinel_validation_threads != 0
+                          ? m_opts.m_sentinel_validation_threads
+                          : n_threads,
+                      &controller::validation_worker);
+        start_workers(m_attestation_threads,
+                      m_opts.m_sentinel_attestation_threads != 0
+                          ? m_opts.m_sentinel_attestation_threads
+                          : n_threads,
+                      &controller::attestation_worker);
+        start_workers(m_routing_threads,
+                      std::max(m_opts.m_sentinel_routing_threads, size_t{1}),
+                      &controller::routing_worker);
+        m_batch_thread = std::thread([&]() {
+            batch_worker();
+        });
+
         auto rpc_server = std::make_unique<
             cbdc::rpc::tcp_server<cbdc::rpc::async_server<request, response>>>(
             m_opts.m_sentinel_endpoints[m_sentinel_id]);
@@ -83,47 +119,143 @@ namespace cbdc::sentinel {
         return true;
     }
 
-    auto controller::execute_transaction(transaction::full_tx tx)
-        -> std::optional<cbdc::sentinel::execute_response> {
-        const auto res = transaction::validation::check_tx(tx);
-        tx_status status{tx_status::pending};
-        if(res.has_value()) {
-            status = tx_status::static_invalid;
+    void controller::stop() {
+        // Stop accepting requests before dropping queued ones. The workers
+        // keep draining the queues until the server has shut down, so
+        // handlers waiting for space in a queue can finish.
+        m_rpc_server.reset();
+
+        // Destroy the sentinel clients while the queues they push to still
+        // exist, once any in-flight use has finished. Responses handled
+        // until then see m_running is false and stop requesting more
+        // attestations.
+        m_running = false;
+        {
+            std::unique_lock l(m_sentinel_clients_mut);
         }
+        m_sentinel_clients.clear();
 
-        auto tx_id = transaction::tx_id(tx);
+        m_validation_queue.clear();
+        m_attestation_queue.clear();
+        m_routing_queue.clear();
 
-        if(!res.has_value()) {
-            m_logger->debug("Accepted tx:", cbdc::to_string(tx_id));
-        } else {
-            m_logger->debug("Rejected tx:", cbdc::to_string(tx_id));
+        for(auto* threads : {&m_validation_threads,
+                             &m_attestation_threads,
+                             &m_routing_threads}) {
+            for(auto& t : *threads) {
+                if(t.joinable()) {
+                    t.join();
+                }
+            }
+            threads->clear();
         }
 
-        // Only forward transactions that are valid
-        if(!res.has_value()) {
-            send_transaction(tx);
+        if(m_batch_thread.joinable()) {
+            m_batch_thread.join();
         }
 
-        return execute_response{status, res};
+        // Send what the routing threads batched since the last tick
+        for(size_t i{0}; i < m_shard_batches.size(); i++) {
+            send_batch(i);
+        }
     }
 
-    void controller::send_transaction(const transaction::full_tx& tx) {
-        auto compact_tx = cbdc::transaction::compact_tx(tx);
-        auto attestation = compact_tx.sign(m_secp.get(), m_privkey);
-        compact_tx.m_attestations.insert(attestation);
+    void controller::start_workers(std::vector<std::thread>& threads,
+                                   size_t n_threads,
+                                   void (controller::*worker)()) {
+        for(size_t i = 0; i < n_threads; i++) {
+            threads.emplace_back([this, worker]() {
+                (this->*worker)();
+            });
+        }
+    }
 
-        gather_attestations(tx, compact_tx, {});
+    void controller::validation_worker() {
+        while(m_running) {
+            auto v = queued_validation();
+            if(m_validation_queue.pop(v)) {
+                auto& [tx, cb] = v;
+                auto err = transaction::validation::check_tx(tx);
+                cb(std::move(tx), std::move(err));
+            }
+        }
     }
 
-    auto controller::validate_transaction(transaction::full_tx tx)
-        -> std::optional<validate_response> {
-        const auto res = transaction::validation::check_tx(tx);
-        if(res.has_value()) {
-            return std::nullopt;
+    void controller::attestation_worker() {
+        while(m_running) {
+            auto v = queued_attestation();
+            if(m_attestation_queue.pop(v)) {
+                auto& [tx, cb] = v;
+                auto ctx = cbdc::transaction::compact_tx(tx);
+                auto attestation = ctx.sign(m_secp.get(), m_privkey);
+                ctx.m_attestations.insert(attestation);
+                cb(tx, std::move(ctx));
+            }
         }
-        auto compact_tx = cbdc::transaction::compact_tx(tx);
-        auto attestation = compact_tx.sign(m_secp.get(), m_privkey);
-        return attestation;
+    }
+
+    void controller::routing_worker() {
+        while(m_running) {
+            auto ctx = transaction::compact_tx();
+            if(m_routing_queue.pop(ctx)) {
+                send_compact_tx(ctx);
+            }
+        }
+    }
+
+    auto controller::execute_transaction(
+        transaction::full_tx tx,
+        execute_result_callback_type result_callback) -> bool {
+        m_validation_queue.push(
+            {std::move(tx),
+             [this, result_callback](
+                 transaction::full_tx tx2,
+                 std::optional<transaction::validation::tx_error> err) {
+                 if(err.has_value()) {
+                     m_logger->debug(
+                         "Rejected tx:",
+                         cbdc::to_string(transaction::tx_id(tx2)));
+                     result_callback(
+                         execute_response{tx_status::static_invalid, err});
+                     return;
+                 }
+
+                 result_callback(
+                     execute_response{tx_status::pending, std::nullopt});
+
+                 // Only forward transactions that are valid
+                 m_attestation_queue.push(
+                     {std::move(tx2),
+                      [this](const transaction::full_tx& tx3,
+                             transaction::compact_tx ctx) {
+                          m_logger->debug("Accepted tx:",
+                                          cbdc::to_string(ctx.m_id));
+                          gather_attestations(tx3, ctx, {});
+                      }});
+             }});
+        return true;
+    }
+
+    auto controller::validate_transaction(
+        transaction::full_tx tx,
+        validate_result_callback_type result_callback) -> bool {
+        m_validation_queue.push(
+            {std::move(tx),
+             [this, result_callback](
+                 transaction::full_tx tx2,
+                 std::optional<transaction::validation::tx_error> err) {
+                 if(err.has_value()) {
+                     result_callback(std::nullopt);
+                     return;
+                 }
+                 m_attestation_queue.push(
+                     {std::move(tx2),
+                      [result_callback](const transaction::full_tx& /* tx */,
+                                        transaction::compact_tx ctx) {
+                          result_callback(*ctx.m_attestations.begin());
+                      }});
+             }});
+        return true;
     }
 
     void
@@ -145,8 +277,9 @@ namespace cbdc::sentinel {
                                     const transaction::compact_tx& ctx,
                                     std::unordered_set<size_t> requested) {
         if(ctx.m_attestations.size() < m_opts.m_attestation_threshold) {
+            std::shared_lock clients_lock(m_sentinel_clients_mut);
             auto success = false;
-            while(!success) {
+            while(!success && m_running) {
                 auto sentinel_id = [&]() {
                     std::unique_lock l(m_rand_mut);
                     return m_dist(m_rand);
@@ -166,40 +299,184 @@ namespace cbdc::sentinel {
             return;
         }
 
-        send_compact_tx(ctx);
+        m_routing_queue.push(ctx);
     }
 
     void controller::send_compact_tx(const transaction::compact_tx& ctx) {
-        auto ctx_pkt = std::make_shared<cbdc::buffer>(cbdc::make_buffer(ctx));
+        // Buffers are reused across calls to avoid allocating for every
+        // transaction
+        thread_local auto ctx_buf = cbdc::buffer();
+        thread_local auto targets = std::vector<size_t>();
+        route_compact_tx(ctx, std::nullopt, ctx_buf, targets);
+    }
 
+    auto controller::route_compact_tx(const transaction::compact_tx& ctx,
+                                      std::optional<size_t> failed_shard,
+                                      cbdc::buffer& ctx_buf,
+                                      std::vector<size_t>& targets) -> bool {
         auto offset = [&]() {
             std::unique_lock l(m_rand_mut);
             return m_shard_dist(m_rand);
         }();
-        auto inputs_sent = std::unordered_set<size_t>();
-        for(size_t i = 0; i < m_shard_data.size(); i++) {
-            auto idx = (i + offset) % m_shard_data.size();
-            const auto& range = m_shard_data[idx].m_range;
-            const auto& pid = m_shard_data[idx].m_peer_id;
-            if(inputs_sent.size() == ctx.m_inputs.size()) {
+
+        // Send the transaction once to a single replica of each shard range
+        // holding one of its inputs
+        targets.clear();
+        {
+            std::shared_lock l(m_route_mut);
+            for(const auto& input : ctx.m_inputs) {
+                if(failed_shard.has_value()) {
+                    const auto& range = m_shard_data[*failed_shard].m_range;
+                    if(input[0] < range.first || input[0] > range.second) {
+                        continue;
+                    }
+                }
+                const auto& shards = m_prefix_shards[input[0]];
+                if(shards.empty()) {
+                    continue;
+                }
+                targets.push_back(shards[offset % shards.size()]);
+            }
+        }
+        if(failed_shard.has_value()) {
+            // The routes may not have been rebuilt yet if another thread
+            // is doing so
+            targets.erase(
+                std::remove(targets.begin(), targets.end(), *failed_shard),
+                targets.end());
+        }
+        if(targets.empty()) {
+            return false;
+        }
+        std::sort(targets.begin(), targets.end());
+        targets.erase(std::unique(targets.begin(), targets.end()),
+                      targets.end());
+
+        ctx_buf.clear();
+        auto ser = cbdc::buffer_serializer(ctx_buf);
+        ser << ctx;
+
+        for(auto idx : targets) {
+            auto& batch = *m_shard_batches[idx];
+            auto full = [&]() {
+                std::unique_lock l(batch.m_mut);
+                batch.m_buf.append(ctx_buf.data(), ctx_buf.size());
+                batch.m_count++;
+                return batch.m_count >= max_batch_txs;
+            }();
+            if(full || m_opts.m_sentinel_batch_interval == 0) {
+                send_batch(idx);
+            }
+        }
+        return true;
+    }
+
+    void controller::send_batch(size_t shard_idx) {
+        auto& batch = *m_shard_batches[shard_idx];
+        auto pkt = std::make_shared<cbdc::buffer>();
+        {
+            std::unique_lock l(batch.m_mut);
+            if(batch.m_count == 0) {
+                return;
+            }
+            std::swap(*pkt, batch.m_buf);
+            batch.m_count = 0;
+            // The packet keeps the batch's allocation, so size the next
+            // batch like this one to avoid regrowing it while appending
+            batch.m_buf.reserve(pkt->size());
+        }
+
+        const auto peer_id = m_shard_data[shard_idx].m_peer_id;
+        if(!m_shard_network.connected(peer_id)) {
+            // Stop routing to the shard now rather than at the next refresh,
+            // which may be up to route_refresh_interval away when batching
+            // is disabled
+            m_logger->warn("Shard", shard_idx, "disconnected");
+            update_routes();
+            reroute_batch(shard_idx, *pkt);
+            return;
+        }
+        m_shard_network.send(pkt, peer_id);
+    }
+
+    void controller::reroute_batch(size_t shard_idx, cbdc::buffer& pkt) {
+        // Not the thread_local buffers of send_compact_tx, which may be in
+        // use further up the stack
+        auto ctx_buf = cbdc::buffer();
+        auto targets = std::vector<size_t>();
+        size_t dropped{0};
+        auto deser = cbdc::buffer_serializer(pkt);
+        while(!deser.end_of_buffer()) {
+            auto ctx = transaction::compact_tx();
+            if(!(deser >> ctx)) {
+                m_logger->error("Failed to deserialize batch for shard",
+                                shard_idx);
                 break;
             }
-            if(!m_shard_network.connected(pid)) {
-                continue;
+            if(!route_compact_tx(ctx, shard_idx, ctx_buf, targets)) {
+                dropped++;
             }
-            auto should_send = false;
-            for(size_t j = 0; j < ctx.m_inputs.size(); j++) {
-                if(inputs_sent.find(j) != inputs_sent.end()) {
-                    continue;
-                }
-                if(!config::hash_in_shard_range(range, ctx.m_inputs[i])) {
-                    continue;
+        }
+        if(dropped > 0) {
+            auto total = m_dropped_txs += dropped;
+            m_logger->error("Dropped",
+                            dropped,
+                            "transactions with no connected shard for their "
+                            "inputs after shard",
+                            shard_idx,
+                            "disconnected,",
+                            total,
+                            "in total");
+        }
+    }
+
+    void controller::update_routes() {
+        auto connected = std::vector<bool>(m_shard_data.size());
+        for(size_t i{0}; i < m_shard_data.size(); i++) {
+            connected[i]
+                = m_shard_network.connected(m_shard_data[i].m_peer_id);
+        }
+        {
+            std::shared_lock l(m_route_mut);
+            if(connected == m_shard_connected) {
+                return;
+            }
+        }
+
+        // Read the connectivity again under the exclusive lock so a thread
+        // holding an older snapshot cannot overwrite a newer table
+        std::unique_lock l(m_route_mut);
+        for(size_t i{0}; i < m_shard_data.size(); i++) {
+            connected[i]
+                = m_shard_network.connected(m_shard_data[i].m_peer_id);
+        }
+        if(connected == m_shard_connected) {
+            return;
+        }
+        for(size_t prefix{0}; prefix < m_prefix_shards.size(); prefix++) {
+            auto& shards = m_prefix_shards[prefix];
+            shards.clear();
+            for(size_t i{0}; i < m_shard_data.size(); i++) {
+                const auto& range = m_shard_data[i].m_range;
+                if(connected[i] && prefix >= range.first
+                   && prefix <= range.second) {
+                    shards.push_back(i);
                 }
-                inputs_sent.insert(j);
-                should_send = true;
             }
-            if(should_send) {
-                m_shard_network.send(ctx_pkt, pid);
+        }
+        m_shard_connected = std::move(connected);
+    }
+
+    void controller::batch_worker() {
+        const auto interval
+            = m_opts.m_sentinel_batch_interval == 0
+                ? std::chrono::microseconds(route_refresh_interval)
+                : std::chrono::microseconds(m_opts.m_sentinel_batch_interval);
+        while(m_running) {
+            std::this_thread::sleep_for(interval);
+            update_routes();
+            for(size_t i{0}; i < m_shard_batches.size(); i++) {
+                send_batch(i);
             }
         }
     }
@@ -9,16 +9,30 @@
 #include "server.hpp"
 #include "uhs/sentinel/async_interface.hpp"
 #include "uhs/sentinel/client.hpp"
-#include "uhs/sentinel/interface.hpp"
+#include "util/common/blocking_queue.hpp"
 #include "util/common/config.hpp"
 #include "util/network/connection_manager.hpp"
 
+#include <array>
 #include <memory>
 #include <random>
+#include <shared_mutex>
+#include <thread>
 
 namespace cbdc::sentinel {
-    /// Sentinel implementation.
-    class controller : public interface {
+    /// \brief Sentinel implementation.
+    ///
+    /// Transactions move through a pipeline of stages, each with its own
+    /// bounded queue and worker threads: static validation, compaction and
+    /// signing, gathering attestations from remote sentinels, and routing
+    /// to the shards. Gathering attestations is driven by the sentinel
+    /// client callbacks rather than a worker pool. A full queue blocks the
+    /// previous stage, and ultimately the RPC server.
+    ///
+    /// Compact transactions are routed with a table from the first byte of
+    /// each input to the connected shards holding it, and batched into one
+    /// packet per shard per \ref config::options::m_sentinel_batch_interval.
+    class controller : public async_interface {
       public:
         controller() = delete;
         controller(const controller&) = delete;
@@ -34,29 +48,51 @@ namespace cbdc::sentinel {
                    config::options opts,
                    std::shared_ptr<logging::log> logger);
 
-        ~controller() override = default;
+        ~controller() override;
 
         /// Initializes the controller. Establishes connections to the shards
+        /// and starts the pipeline worker threads.
         /// \return true if initialization succeeded.
         auto init() -> bool;
 
-        /// Validate transaction, forward it to shards for processing,
-        /// and return the validation result to send back to the originating
-        /// client.
+        /// Queues a transaction for validation. Once validated, returns the
+        /// validation result to the originating client via the callback and
+        /// forwards valid transactions to the shards for processing.
         /// \param tx transaction to execute.
-        /// \return response with the transaction status to send to the client.
-        auto execute_transaction(transaction::full_tx tx)
-            -> std::optional<cbdc::sentinel::execute_response> override;
-
-        /// Validate transaction and generate a sentinel attestation if the
-        /// transaction is valid.
+        /// \param result_callback function to call with the transaction
+        ///                        status.
+        /// \return true.
+        auto execute_transaction(transaction::full_tx tx,
+                                 execute_result_callback_type result_callback)
+            -> bool override;
+
+        /// Queues a transaction for validation and generates a sentinel
+        /// attestation if the transaction is valid.
         /// \param tx transaction to validate and attest to.
-        /// \return sentinel attestation for the given transaction, or
-        ///         std::nullopt if the transaction is invalid.
-        auto validate_transaction(transaction::full_tx tx)
-            -> std::optional<validate_response> override;
+        /// \param result_callback function to call with the attestation, or
+        ///                        std::nullopt if the transaction is invalid.
+        /// \return true.
+        auto
+        validate_transaction(transaction::full_tx tx,
+                             validate_result_callback_type result_callback)
+            -> bool override;
+
+        /// Stops the RPC server and the pipeline worker threads.
+        void stop();
 
       private:
+        using validation_callback = std::function<void(
+            transaction::full_tx,
+            std::optional<transaction::validation::tx_error>)>;
+        using queued_validation
+            = std::pair<transaction::full_tx, validation_callback>;
+
+        using attestation_callback = std::function<void(
+            const transaction::full_tx&,
+            transaction::compact_tx)>;
+        using queued_attestation
+            = std::pair<transaction::full_tx, attestation_callback>;
+
         uint32_t m_sentinel_id;
         cbdc::config::options m_opts;
         std::shared_ptr<logging::log> m_logger;
@@ -74,6 +110,9 @@ namespace cbdc::sentinel {
 
         std::vector<std::unique_ptr<sentinel::rpc::client>>
             m_sentinel_clients{};
+        /// Held shared while using m_sentinel_clients so stop() can wait
+        /// for in-flight requests before destroying the clients.
+        std::shared_mutex m_sentinel_clients_mut;
 
         std::random_device m_r{};
         std::default_random_engine m_rand{m_r()};
@@ -83,7 +122,53 @@ namespace cbdc::sentinel {
 
         privkey_t m_privkey{};
 
-        void send_transaction(const transaction::full_tx& tx);
+        blocking_queue<queued_validation> m_validation_queue;
+        std::vector<std::thread> m_validation_threads;
+
+        blocking_queue<queued_attestation> m_attestation_queue;
+        std::vector<std::thread> m_attestation_threads;
+
+        blocking_queue<transaction::compact_tx> m_routing_queue;
+        std::vector<std::thread> m_routing_threads;
+
+        std::atomic<bool> m_running{true};
+
+        /// Maximum number of compact transactions batched for a shard before
+        /// the batch is sent without waiting for the next tick.
+        static constexpr size_t max_batch_txs{1024};
+
+        /// Interval at which shard connectivity is checked when batching is
+        /// disabled. Sending to a disconnected shard also triggers a check.
+        static constexpr auto route_refresh_interval
+            = std::chrono::milliseconds(100);
+
+        /// Compact transactions waiting to be sent to a shard.
+        struct shard_batch {
+            std::mutex m_mut;
+            cbdc::buffer m_buf;
+            size_t m_count{0};
+        };
+
+        /// Indexes into m_shard_data of the connected shards holding each
+        /// UHS ID prefix. Rebuilt when shard connectivity changes.
+        std::array<std::vector<size_t>, 256> m_prefix_shards{};
+        std::vector<bool> m_shard_connected;
+        std::shared_mutex m_route_mut;
+
+        std::vector<std::unique_ptr<shard_batch>> m_shard_batches;
+        std::thread m_batch_thread;
+
+        /// Number of compact transactions dropped because no connected
+        /// shard held their inputs when their batch was re-routed.
+        std::atomic<size_t> m_dropped_txs{0};
+
+        void validation_worker();
+        void attestation_worker();
+        void routing_worker();
+
+        void start_workers(std::vector<std::thread>& threads,
+                           size_t n_threads,
+                           void (controller::*worker)());
 
         void validate_result_handler(async_interface::validate_result v_res,
                                      const transaction::full_tx& tx,
@@ -95,6 +180,30 @@ namespace cbdc::sentinel {
                                  std::unordered_set<size_t> requested);
 
         void send_compact_tx(const transaction::compact_tx& ctx);
+
+        /// Appends a compact transaction to the batch of a connected shard
+        /// holding each of its inputs, sending any batches which fill up.
+        /// \param ctx compact transaction to route.
+        /// \param failed_shard if set, only route the inputs held by this
+        ///                     shard, to shards other than it.
+        /// \param ctx_buf scratch buffer for the serialized transaction.
+        /// \param targets scratch vector for the target shard indexes.
+        /// \return false if no connected shard held any of the inputs.
+        auto route_compact_tx(const transaction::compact_tx& ctx,
+                              std::optional<size_t> failed_shard,
+                              cbdc::buffer& ctx_buf,
+                              std::vector<size_t>& targets) -> bool;
+
+        /// Routes each compact transaction in a batch which could not be
+        /// sent to its shard through the current routing table.
+        /// \param shard_idx index of the disconnected shard.
+        /// \param pkt serialized compact transactions from its batch.
+        void reroute_batch(size_t shard_idx, cbdc::buffer& pkt);
+
+        /// Rebuilds m_prefix_shards if shard connectivity has changed.
+        void update_routes();
+        void send_batch(size_t shard_idx);
+        void batch_worker();
     };
 }
 
@@ -6,22 +6,24 @@
 #ifndef OPENCBDC_TX_SRC_SENTINEL_SERVER_H_
 #define OPENCBDC_TX_SRC_SENTINEL_SERVER_H_
 
-#include "uhs/sentinel/interface.hpp"
+#include "uhs/sentinel/async_interface.hpp"
 #include "uhs/transaction/messages.hpp"
 #include "util/rpc/async_server.hpp"
 #include "util/rpc/format.hpp"
 
 namespace cbdc::sentinel::rpc {
-    /// RPC server for a sentinel.
+    /// RPC server for a sentinel. Requests are passed straight to the
+    /// sentinel implementation, which queues them for its own workers.
     class server {
       public:
         /// Constructor. Registers the sentinel implementation with the RPC
         /// server using a request handler callback.
         /// \param impl pointer to a sentinel implementation.
-        /// \param srv pointer to a blocking RPC server.
+        /// \param srv pointer to an asynchronous RPC server.
         server(
-            interface* impl, // TODO: convert sentinel::controller to
-                             //       contain a shared_ptr to an implementation
+            async_interface* impl, // TODO: convert sentinel::controller to
+                                   //       contain a shared_ptr to an
+                                   //       implementation
             std::unique_ptr<cbdc::rpc::async_server<request, response>> srv);
 
         ~server();
@@ -32,16 +34,12 @@ namespace cbdc::sentinel::rpc {
         auto operator=(server&&) -> server& = delete;
 
       private:
-        using callback_type = std::function<void(std::optional<response>)>;
-        using request_type = std::pair<request, callback_type>;
+        using callback_type = async_interface::result_callback_type;
 
-        interface* m_impl;
+        async_interface* m_impl;
         std::unique_ptr<cbdc::rpc::async_server<request, response>> m_srv;
-        blocking_queue<request_type> m_queue;
 
-        std::vector<std::thread> m_threads;
-
-        auto handle_request() -> bool;
+        auto handle_request(request req, callback_type callback) -> bool;
     };
 }
 
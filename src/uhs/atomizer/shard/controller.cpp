@@ -7,6 +7,7 @@
 
 #include "uhs/atomizer/atomizer/atomizer_raft.hpp"
 #include "uhs/transaction/messages.hpp"
+#include "util/serialization/buffer_serializer.hpp"
 
 #include <utility>
 
@@ -67,6 +68,8 @@ namespace cbdc::shard {
             return atomizer_handler(std::forward<decltype(pkt)>(pkt));
         });
 
+        subscribe();
+
         constexpr auto max_wait = 3;
         for(size_t i = 0; i < max_wait && m_shard.best_block_height() < 1;
             i++) {
@@ -105,7 +108,16 @@ namespace cbdc::shard {
 
     auto controller::server_handler(cbdc::network::message_t&& pkt)
         -> std::optional<cbdc::buffer> {
-        m_request_queue.push(pkt);
+        // Sentinels may batch several compact transactions into one packet
+        auto deser = cbdc::buffer_serializer(*pkt.m_pkt);
+        while(!deser.end_of_buffer()) {
+            auto tx = transaction::compact_tx();
+            if(!(deser >> tx)) {
+                m_logger->error("Invalid transaction packet");
+                break;
+            }
+            m_request_queue.push(std::move(tx));
+        }
         return std::nullopt;
     }
 
@@ -121,6 +133,16 @@ namespace cbdc::shard {
 
         m_logger->info("Digesting block", blk.m_height, "...");
 
+        // Subscriptions do not survive reconnecting to a new atomizer
+        // leader, and a gap usually means we reconnected. Subscribe again
+        // then, and periodically in case we reconnected without missing a
+        // block. Until then the atomizer sends full blocks.
+        static constexpr uint64_t resubscribe_interval{64};
+        if(blk.m_height != m_shard.best_block_height() + 1
+           || blk.m_height % resubscribe_interval == 0) {
+            subscribe();
+        }
+
         // If the block is not contiguous, catch up by requesting
         // blocks from the archiver.
         while(!m_shard.digest_block(blk)) {
@@ -133,19 +155,20 @@ namespace cbdc::shard {
                 break;
             }
 
-            // Attempt to catch up to the latest block
-            for(uint64_t i = m_shard.best_block_height() + 1; i < blk.m_height;
-                i++) {
-                const auto past_blk = m_archiver_client.get_block(i);
-                if(past_blk) {
-                    m_shard.digest_block(past_blk.value());
-                } else {
-                    m_logger->info("Waiting for archiver sync");
-                    const auto wait_time = std::chrono::milliseconds(10);
-                    std::this_thread::sleep_for(wait_time);
-                    i--;
-                    continue;
-                }
+            // Attempt to catch up to the latest block by streaming the
+            // missing blocks from the archiver
+            const auto start = m_shard.best_block_height() + 1;
+            const auto streamed = m_archiver_client.stream_blocks(
+                start,
+                blk.m_height - start,
+                [&](atomizer::block&& past_blk) {
+                    m_shard.digest_block(past_blk);
+                });
+            if(!streamed.has_value()
+               || streamed.value() < blk.m_height - start) {
+                m_logger->info("Waiting for archiver sync");
+                const auto wait_time = std::chrono::milliseconds(10);
+                std::this_thread::sleep_for(wait_time);
             }
         }
 
@@ -153,17 +176,17 @@ namespace cbdc::shard {
         return std::nullopt;
     }
 
-    void controller::request_consumer() {
-        auto pkt = network::message_t();
-        while(m_request_queue.pop(pkt)) {
-            auto maybe_tx = from_buffer<transaction::compact_tx>(*pkt.m_pkt);
-            if(!maybe_tx.has_value()) {
-                m_logger->error("Invalid transaction packet");
-                continue;
-            }
-
-            auto& tx = maybe_tx.value();
+    void controller::subscribe() {
+        // Only the atomizer leader is listening, so send the request to
+        // all of them
+        m_atomizer_network.broadcast(
+            atomizer::request{atomizer::block_subscription_request{
+                m_opts.m_shard_ranges[m_shard_id]}});
+    }
 
+    void controller::request_consumer() {
+        auto tx = transaction::compact_tx();
+        while(m_request_queue.pop(tx)) {
             m_logger->info("Digesting transaction", to_string(tx.m_id), "...");
 
             if(!transaction::validation::check_attestations(
@@ -57,7 +57,7 @@ namespace cbdc::shard {
 
         cbdc::archiver::client m_archiver_client;
 
-        blocking_queue<network::message_t> m_request_queue;
+        blocking_queue<transaction::compact_tx> m_request_queue;
         std::vector<std::thread> m_handler_threads;
 
         auto server_handler(cbdc::network::message_t&& pkt)
@@ -65,6 +65,7 @@ namespace cbdc::shard {
         auto atomizer_handler(cbdc::network::message_t&& pkt)
             -> std::optional<cbdc::buffer>;
         void request_consumer();
+        void subscribe();
     };
 }
 
@@ -5,6 +5,8 @@
 
 #include "shard.hpp"
 
+#include <algorithm>
+#include <fstream>
 #include <utility>
 
 namespace cbdc::shard {
@@ -170,6 +172,128 @@ namespace cbdc::shard {
         return m_best_block_height;
     }
 
+    auto shard::export_snapshot(std::ostream& out, uint64_t chunk_size)
+        -> std::optional<uhs_snapshot_info> {
+        std::shared_ptr<const leveldb::Snapshot> snp{};
+        uint64_t snp_height{};
+        {
+            std::shared_lock<std::shared_mutex> l(m_snp_mut);
+            snp_height = m_snp_height;
+            snp = m_snp;
+        }
+
+        auto read_options = m_read_options;
+        read_options.snapshot = snp.get();
+        read_options.fill_cache = false;
+
+        auto writer
+            = uhs_snapshot_writer(out, snp_height, m_prefix_range, chunk_size);
+        auto it = std::unique_ptr<leveldb::Iterator>(
+            m_db->NewIterator(read_options));
+        const auto first = static_cast<char>(m_prefix_range.first);
+        for(it->Seek(leveldb::Slice(&first, 1)); it->Valid(); it->Next()) {
+            const auto key = it->key();
+            // Skip metadata such as the best block height
+            if(key.size() != sizeof(hash_t)) {
+                continue;
+            }
+            auto uhs_id = hash_t();
+            std::memcpy(uhs_id.data(), key.data(), uhs_id.size());
+            if(uhs_id[0] > m_prefix_range.second) {
+                break;
+            }
+            if(!writer.add(uhs_id)) {
+                return std::nullopt;
+            }
+        }
+        if(!it->status().ok()) {
+            return std::nullopt;
+        }
+        return writer.finish();
+    }
+
+    auto shard::import_snapshot(const std::string& path, size_t n_threads)
+        -> std::optional<std::string> {
+        auto in = std::ifstream(path, std::ios::binary);
+        if(!in.good()) {
+            return "Failed to open snapshot file " + path;
+        }
+        const auto info = read_uhs_snapshot_info(in);
+        if(!info.has_value()) {
+            return "Malformed snapshot file " + path;
+        }
+        if(info->m_range != m_prefix_range) {
+            return "Snapshot range does not match shard range";
+        }
+        if(m_best_block_height != 0) {
+            return "Shard database is not empty";
+        }
+
+        n_threads = std::clamp(n_threads,
+                               size_t{1},
+                               std::max(info->m_chunks.size(), size_t{1}));
+        auto errors = std::vector<std::optional<std::string>>(n_threads);
+        auto threads = std::vector<std::thread>();
+        threads.reserve(n_threads);
+        for(size_t t = 0; t < n_threads; t++) {
+            threads.emplace_back([&, t]() {
+                auto chunk_in = std::ifstream(path, std::ios::binary);
+                for(size_t i = t; i < info->m_chunks.size(); i += n_threads) {
+                    const auto ids
+                        = read_uhs_snapshot_chunk(chunk_in, info->m_chunks[i]);
+                    if(!ids.has_value()) {
+                        errors[t] = "Corrupt snapshot chunk "
+                                  + std::to_string(i);
+                        return;
+                    }
+                    leveldb::WriteBatch batch;
+                    for(const auto& id : ids.value()) {
+                        if(!is_output_on_shard(id)) {
+                            errors[t] = "Snapshot chunk " + std::to_string(i)
+                                      + " contains out of range UHS ID";
+                            return;
+                        }
+                        batch.Put(leveldb::Slice(
+                                      reinterpret_cast<const char*>(id.data()),
+                                      id.size()),
+                                  leveldb::Slice());
+                    }
+                    const auto res = m_db->Write(m_write_options, &batch);
+                    if(!res.ok()) {
+                        errors[t] = res.ToString();
+                        return;
+                    }
+                }
+            });
+        }
+        for(auto& thread : threads) {
+            thread.join();
+        }
+        for(auto& err : errors) {
+            if(err.has_value()) {
+                return err;
+            }
+        }
+
+        // Only move the best block height once all chunks are written
+        m_best_block_height = info->m_height;
+        std::array<char, sizeof(m_best_block_height)> height_arr{};
+        std::memcpy(height_arr.data(),
+                    &m_best_block_height,
+                    sizeof(m_best_block_height));
+        const auto res
+            = m_db->Put(m_write_options,
+                        m_best_block_height_key,
+                        leveldb::Slice(height_arr.data(), height_arr.size()));
+        if(!res.ok()) {
+            return res.ToString();
+        }
+
+        update_snapshot();
+
+        return std::nullopt;
+    }
+
     auto shard::is_output_on_shard(const hash_t& uhs_hash) const -> bool {
         return config::hash_in_shard_range(m_prefix_range, uhs_hash);
     }
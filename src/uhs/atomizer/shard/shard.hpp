@@ -10,6 +10,7 @@
 #ifndef OPENCBDC_TX_SRC_SHARD_SHARD_H_
 #define OPENCBDC_TX_SRC_SHARD_SHARD_H_
 
+#include "uhs_snapshot.hpp"
 #include "uhs/atomizer/atomizer/atomizer_raft.hpp"
 #include "uhs/atomizer/atomizer/block.hpp"
 #include "uhs/atomizer/atomizer/format.hpp"
@@ -65,6 +66,28 @@ namespace cbdc::shard {
         /// \return the best block height.
         [[nodiscard]] auto best_block_height() const -> uint64_t;
 
+        /// Writes the UHS IDs in the shard's most recent snapshot to a
+        /// sorted, chunked snapshot file.
+        /// \see uhs_snapshot.hpp
+        /// \param out stream to write the snapshot to.
+        /// \param chunk_size maximum number of UHS IDs per chunk.
+        /// \return snapshot header and index, or std::nullopt if writing the
+        ///         snapshot failed.
+        auto export_snapshot(std::ostream& out,
+                             uint64_t chunk_size
+                             = default_snapshot_chunk_size)
+            -> std::optional<uhs_snapshot_info>;
+
+        /// Loads the UHS IDs from a snapshot file into an empty shard and
+        /// sets the best block height to the snapshot height. Chunks are
+        /// read, verified and written to the database in parallel.
+        /// \param path path to the snapshot file.
+        /// \param n_threads number of threads to load chunks with.
+        /// \return nullopt if the snapshot was loaded. Otherwise, returns the
+        ///         error message.
+        auto import_snapshot(const std::string& path, size_t n_threads)
+            -> std::optional<std::string>;
+
       private:
         [[nodiscard]] auto is_output_on_shard(const hash_t& uhs_hash) const
             -> bool;
@@ -6,18 +6,67 @@
 #include "controller.hpp"
 #include "util/common/config.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <csignal>
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <thread>
 
 // LCOV_EXCL_START
+// Exports the shard's UHS to, or imports it from, a snapshot file
+auto run_snapshot(const cbdc::config::options& opts,
+                  size_t shard_id,
+                  const std::string& mode,
+                  const std::string& path,
+                  const std::shared_ptr<cbdc::logging::log>& logger) -> int {
+    auto shard = cbdc::shard::shard(opts.m_shard_ranges[shard_id]);
+    if(auto err = shard.open_db(opts.m_shard_db_dirs[shard_id])) {
+        logger->error("Failed to open shard DB:", err.value());
+        return -1;
+    }
+
+    if(mode == "import") {
+        if(auto err = shard.import_snapshot(
+               path,
+               std::max(std::thread::hardware_concurrency(), 1U))) {
+            logger->error("Failed to import snapshot:", err.value());
+            return -1;
+        }
+        auto in = std::ifstream(path, std::ios::binary);
+        const auto info = cbdc::shard::read_uhs_snapshot_info(in);
+        assert(info.has_value());
+        logger->info("Imported",
+                     info->m_count,
+                     "UHS IDs at height",
+                     shard.best_block_height(),
+                     "with root",
+                     cbdc::to_string(info->m_root));
+        return 0;
+    }
+
+    auto out = std::ofstream(path, std::ios::binary | std::ios::trunc);
+    const auto info = shard.export_snapshot(out);
+    if(!info.has_value()) {
+        logger->error("Failed to export snapshot to", path);
+        return -1;
+    }
+    logger->info("Exported",
+                 info->m_count,
+                 "UHS IDs at height",
+                 info->m_height,
+                 "with root",
+                 cbdc::to_string(info->m_root));
+    return 0;
+}
+
 auto main(int argc, char** argv) -> int {
     auto args = cbdc::config::get_args(argc, argv);
-    if(args.size() < 3) {
+    if(args.size() < 3 || args.size() == 4 || args.size() > 5
+       || (args.size() == 5 && args[3] != "export" && args[3] != "import")) {
         std::cerr << "Usage: " << args[0] << " <config file> <shard id>"
-                  << std::endl;
+                  << " [export|import <snapshot file>]" << std::endl;
         return 0;
     }
 
@@ -39,6 +88,10 @@ auto main(int argc, char** argv) -> int {
     auto logger = std::make_shared<cbdc::logging::log>(
         opts.m_shard_loglevels[shard_id]);
 
+    if(args.size() == 5) {
+        return run_snapshot(opts, shard_id, args[3], args[4], logger);
+    }
+
     auto ctl = cbdc::shard::controller{static_cast<uint32_t>(shard_id),
                                        opts,
                                        logger};
@@ -0,0 +1,244 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "uhs_snapshot.hpp"
+
+#include "crypto/sha256.h"
+#include "util/serialization/format.hpp"
+#include "util/serialization/istream_serializer.hpp"
+#include "util/serialization/ostream_serializer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace cbdc::shard {
+    namespace {
+        constexpr std::array<char, 8> snapshot_magic
+            = {'U', 'H', 'S', 'S', 'N', 'A', 'P', '1'};
+        // Size of an encoded chunk index entry
+        constexpr uint64_t chunk_info_size
+            = sizeof(uint64_t) * 3 + std::tuple_size<hash_t>::value;
+
+        auto chunk_hash(const std::vector<hash_t>& ids) -> hash_t {
+            auto bytes = std::vector<std::byte>(ids.size() * sizeof(hash_t));
+            for(size_t i = 0; i < ids.size(); i++) {
+                std::memcpy(&bytes[i * sizeof(hash_t)],
+                            ids[i].data(),
+                            sizeof(hash_t));
+            }
+            return hash_data(bytes.data(), bytes.size());
+        }
+
+        auto shared_prefix(const hash_t& a, const hash_t& b) -> uint8_t {
+            auto mismatch = std::mismatch(a.begin(), a.end(), b.begin());
+            return static_cast<uint8_t>(mismatch.first - a.begin());
+        }
+
+        auto stream_size(std::istream& in) -> std::optional<uint64_t> {
+            in.seekg(0, std::ios::end);
+            auto end = in.tellg();
+            if(!in.good() || end < 0) {
+                return std::nullopt;
+            }
+            return static_cast<uint64_t>(end);
+        }
+    }
+
+    auto uhs_snapshot_root(std::vector<hash_t> hashes) -> hash_t {
+        if(hashes.empty()) {
+            return hash_t{};
+        }
+        while(hashes.size() > 1) {
+            const auto pairs = hashes.size() / 2;
+            auto in = std::vector<unsigned char>(pairs * 2 * sizeof(hash_t));
+            std::memcpy(in.data(), hashes.data(), in.size());
+            auto out = std::vector<unsigned char>(pairs * sizeof(hash_t));
+            SHA256D64(out.data(), in.data(), pairs);
+            auto next = std::vector<hash_t>(pairs);
+            std::memcpy(next.data(), out.data(), out.size());
+            if(hashes.size() % 2 != 0) {
+                next.push_back(hashes.back());
+            }
+            hashes = std::move(next);
+        }
+        return hashes.front();
+    }
+
+    uhs_snapshot_writer::uhs_snapshot_writer(std::ostream& out,
+                                             uint64_t height,
+                                             config::shard_range_t range,
+                                             uint64_t chunk_size)
+        : m_out(out) {
+        assert(chunk_size > 0);
+        m_info.m_height = height;
+        m_info.m_range = range;
+        m_info.m_chunk_size = chunk_size;
+        auto ser = ostream_serializer(m_out);
+        ser << snapshot_magic << m_info.m_height << m_info.m_range
+            << m_info.m_chunk_size;
+        m_good = static_cast<bool>(ser);
+    }
+
+    auto uhs_snapshot_writer::add(const hash_t& uhs_id) -> bool {
+        if(!m_good || (m_last.has_value() && !(m_last.value() < uhs_id))
+           || !config::hash_in_shard_range(m_info.m_range, uhs_id)) {
+            return false;
+        }
+        m_last = uhs_id;
+        m_chunk.push_back(uhs_id);
+        if(m_chunk.size() == m_info.m_chunk_size) {
+            return flush_chunk();
+        }
+        return true;
+    }
+
+    auto uhs_snapshot_writer::flush_chunk() -> bool {
+        auto buf = std::vector<char>();
+        buf.reserve(m_chunk.size() * (sizeof(hash_t) + 1));
+        for(size_t i = 0; i < m_chunk.size(); i++) {
+            const auto& id = m_chunk[i];
+            const auto shared = i == 0 ? 0 : shared_prefix(m_chunk[i - 1], id);
+            buf.push_back(static_cast<char>(shared));
+            buf.insert(buf.end(), id.begin() + shared, id.end());
+        }
+
+        auto chunk = uhs_snapshot_chunk_info();
+        chunk.m_offset = static_cast<uint64_t>(m_out.tellp());
+        chunk.m_size = buf.size();
+        chunk.m_count = m_chunk.size();
+        chunk.m_hash = chunk_hash(m_chunk);
+        m_out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        m_good = m_out.good();
+
+        m_info.m_count += chunk.m_count;
+        m_info.m_chunks.push_back(chunk);
+        m_chunk.clear();
+        return m_good;
+    }
+
+    auto uhs_snapshot_writer::finish() -> std::optional<uhs_snapshot_info> {
+        if(m_good && !m_chunk.empty()) {
+            flush_chunk();
+        }
+        if(!m_good) {
+            return std::nullopt;
+        }
+
+        auto hashes = std::vector<hash_t>();
+        hashes.reserve(m_info.m_chunks.size());
+        for(const auto& chunk : m_info.m_chunks) {
+            hashes.push_back(chunk.m_hash);
+        }
+        m_info.m_root = uhs_snapshot_root(std::move(hashes));
+
+        const auto index_offset = static_cast<uint64_t>(m_out.tellp());
+        auto ser = ostream_serializer(m_out);
+        ser << m_info.m_count << static_cast<uint64_t>(m_info.m_chunks.size());
+        for(const auto& chunk : m_info.m_chunks) {
+            ser << chunk.m_offset << chunk.m_size << chunk.m_count
+                << chunk.m_hash;
+        }
+        ser << m_info.m_root << index_offset;
+        m_out.flush();
+        if(!ser || !m_out.good()) {
+            m_good = false;
+            return std::nullopt;
+        }
+        return m_info;
+    }
+
+    auto read_uhs_snapshot_info(std::istream& in)
+        -> std::optional<uhs_snapshot_info> {
+        const auto size = stream_size(in);
+        auto info = uhs_snapshot_info();
+        auto magic = std::array<char, snapshot_magic.size()>();
+        auto deser = istream_serializer(in);
+        deser.reset();
+        if(!size.has_value()
+           || !(deser >> magic >> info.m_height >> info.m_range
+                >> info.m_chunk_size)
+           || magic != snapshot_magic || info.m_chunk_size == 0) {
+            return std::nullopt;
+        }
+        const auto header_end = static_cast<uint64_t>(in.tellg());
+
+        auto index_offset = uint64_t{};
+        in.seekg(static_cast<std::streamoff>(size.value() - sizeof(uint64_t)));
+        auto n_chunks = uint64_t{};
+        if(!(deser >> index_offset) || index_offset < header_end
+           || index_offset > size.value()) {
+            return std::nullopt;
+        }
+        in.seekg(static_cast<std::streamoff>(index_offset));
+        if(!(deser >> info.m_count >> n_chunks)
+           || n_chunks > (size.value() - index_offset) / chunk_info_size) {
+            return std::nullopt;
+        }
+
+        auto total = uint64_t{};
+        auto next_offset = header_end;
+        auto hashes = std::vector<hash_t>();
+        for(uint64_t i = 0; i < n_chunks; i++) {
+            auto chunk = uhs_snapshot_chunk_info();
+            if(!(deser >> chunk.m_offset >> chunk.m_size >> chunk.m_count
+                 >> chunk.m_hash)) {
+                return std::nullopt;
+            }
+            // Chunks must be contiguous, non-empty and precede the index
+            if(chunk.m_offset != next_offset || chunk.m_count == 0
+               || chunk.m_count > info.m_chunk_size
+               || chunk.m_size > index_offset - chunk.m_offset) {
+                return std::nullopt;
+            }
+            next_offset = chunk.m_offset + chunk.m_size;
+            total += chunk.m_count;
+            hashes.push_back(chunk.m_hash);
+            info.m_chunks.push_back(chunk);
+        }
+        if(!(deser >> info.m_root) || next_offset != index_offset
+           || total != info.m_count
+           || uhs_snapshot_root(std::move(hashes)) != info.m_root) {
+            return std::nullopt;
+        }
+        return info;
+    }
+
+    auto read_uhs_snapshot_chunk(std::istream& in,
+                                 const uhs_snapshot_chunk_info& chunk)
+        -> std::optional<std::vector<hash_t>> {
+        auto buf = std::vector<char>(chunk.m_size);
+        in.seekg(static_cast<std::streamoff>(chunk.m_offset));
+        in.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+        if(!in.good()) {
+            return std::nullopt;
+        }
+
+        auto ret = std::vector<hash_t>();
+        ret.reserve(chunk.m_count);
+        size_t pos{0};
+        for(uint64_t i = 0; i < chunk.m_count; i++) {
+            if(pos >= buf.size()) {
+                return std::nullopt;
+            }
+            const auto shared = static_cast<uint8_t>(buf[pos++]);
+            const auto rest = sizeof(hash_t) - shared;
+            if(shared >= sizeof(hash_t) || (i == 0 && shared != 0)
+               || rest > buf.size() - pos) {
+                return std::nullopt;
+            }
+            auto id = i == 0 ? hash_t{} : ret.back();
+            std::memcpy(id.data() + shared, &buf[pos], rest);
+            pos += rest;
+            if(i != 0 && !(ret.back() < id)) {
+                return std::nullopt;
+            }
+            ret.push_back(id);
+        }
+        if(pos != buf.size() || chunk_hash(ret) != chunk.m_hash) {
+            return std::nullopt;
+        }
+        return ret;
+    }
+}
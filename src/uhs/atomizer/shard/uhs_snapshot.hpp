@@ -0,0 +1,130 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/** \file uhs_snapshot.hpp
+ * Sorted, chunked export format for the UHS IDs held by a shard.
+ *
+ * A snapshot file holds a header, the encoded chunks, a chunk index and a
+ * footer with the offset of the index:
+ *
+ *     magic | height | range | chunk size
+ *     chunk 0 | ... | chunk n-1
+ *     UHS ID count | chunk count | (offset, size, count, hash) * n | root
+ *     index offset
+ *
+ * UHS IDs are stored in ascending order. Within a chunk, each ID is stored
+ * as the length of the prefix it shares with the preceding ID followed by
+ * the remaining bytes. Chunks restart the encoding so each one can be read
+ * and verified on its own, given the index. Each chunk is hashed over its
+ * raw IDs and the root is a binary hash tree over the chunk hashes, so two
+ * shards can compare their state by root alone.
+ */
+
+#ifndef OPENCBDC_TX_SRC_SHARD_UHS_SNAPSHOT_H_
+#define OPENCBDC_TX_SRC_SHARD_UHS_SNAPSHOT_H_
+
+#include "util/common/config.hpp"
+#include "util/common/hash.hpp"
+
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+namespace cbdc::shard {
+    /// Default number of UHS IDs per snapshot chunk.
+    static constexpr uint64_t default_snapshot_chunk_size{4096};
+
+    /// Location and contents summary of a snapshot chunk.
+    struct uhs_snapshot_chunk_info {
+        /// Offset of the encoded chunk in the snapshot file.
+        uint64_t m_offset{};
+        /// Size of the encoded chunk in bytes.
+        uint64_t m_size{};
+        /// Number of UHS IDs in the chunk.
+        uint64_t m_count{};
+        /// Hash of the raw UHS IDs in the chunk.
+        hash_t m_hash{};
+    };
+
+    /// Header and index of a snapshot file.
+    struct uhs_snapshot_info {
+        /// Height of the block the snapshot reflects.
+        uint64_t m_height{};
+        /// Inclusive UHS ID prefix range covered by the snapshot.
+        config::shard_range_t m_range{};
+        /// Maximum number of UHS IDs per chunk.
+        uint64_t m_chunk_size{};
+        /// Total number of UHS IDs.
+        uint64_t m_count{};
+        /// Chunks in UHS ID order.
+        std::vector<uhs_snapshot_chunk_info> m_chunks;
+        /// Root of the hash tree over the chunk hashes.
+        hash_t m_root{};
+    };
+
+    /// Computes the root of the binary hash tree over the given chunk
+    /// hashes. Unpaired nodes are promoted to the next level unchanged.
+    /// \param hashes chunk hashes in order.
+    /// \return root hash, or a zero hash if there are no chunks.
+    auto uhs_snapshot_root(std::vector<hash_t> hashes) -> hash_t;
+
+    /// \brief Streams sorted UHS IDs into a snapshot file.
+    class uhs_snapshot_writer {
+      public:
+        /// Constructor. Writes the snapshot header.
+        /// \param out stream to write the snapshot to.
+        /// \param height height of the block the snapshot reflects.
+        /// \param range UHS ID prefix range covered by the snapshot.
+        /// \param chunk_size maximum number of UHS IDs per chunk. Must be
+        ///                   positive.
+        uhs_snapshot_writer(std::ostream& out,
+                            uint64_t height,
+                            config::shard_range_t range,
+                            uint64_t chunk_size
+                            = default_snapshot_chunk_size);
+
+        /// Appends a UHS ID to the snapshot.
+        /// \param uhs_id UHS ID. Must be greater than the previous ID and
+        ///               within the snapshot range.
+        /// \return false if the ID is out of order or out of range, or
+        ///         writing to the stream failed.
+        auto add(const hash_t& uhs_id) -> bool;
+
+        /// Writes the last chunk, the index and the footer.
+        /// \return snapshot header and index, or std::nullopt if writing to
+        ///         the stream failed.
+        auto finish() -> std::optional<uhs_snapshot_info>;
+
+      private:
+        std::ostream& m_out;
+        uhs_snapshot_info m_info;
+        std::vector<hash_t> m_chunk;
+        std::optional<hash_t> m_last;
+        bool m_good{true};
+
+        auto flush_chunk() -> bool;
+    };
+
+    /// Reads and checks the header and index of a snapshot file. Verifies
+    /// the root against the chunk hashes but does not read the chunks.
+    /// \param in stream to read the snapshot from. Must be seekable.
+    /// \return snapshot header and index, or std::nullopt if the snapshot
+    ///         is malformed.
+    auto read_uhs_snapshot_info(std::istream& in)
+        -> std::optional<uhs_snapshot_info>;
+
+    /// Reads, decodes and verifies a single chunk of a snapshot file.
+    /// Chunks can be read concurrently through separate streams.
+    /// \param in stream to read the snapshot from. Must be seekable.
+    /// \param chunk index entry of the chunk to read.
+    /// \return UHS IDs in the chunk, or std::nullopt if the chunk is
+    ///         malformed or does not match its hash.
+    auto read_uhs_snapshot_chunk(std::istream& in,
+                                 const uhs_snapshot_chunk_info& chunk)
+        -> std::optional<std::vector<hash_t>>;
+}
+
+#endif // OPENCBDC_TX_SRC_SHARD_UHS_SNAPSHOT_H_
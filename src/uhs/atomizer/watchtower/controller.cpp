@@ -107,18 +107,20 @@ auto cbdc::watchtower::controller::atomizer_handler(
     if(blk.m_height != (m_last_blk_height + 1)) {
         m_logger->warn("Block not contiguous. Last block:", m_last_blk_height);
         while(blk.m_height != (m_last_blk_height + 1)) {
-            auto missed_blk
-                = m_archiver_client.get_block(m_last_blk_height + 1);
-            if(!missed_blk) {
+            const auto start = m_last_blk_height + 1;
+            const auto streamed = m_archiver_client.stream_blocks(
+                start,
+                blk.m_height - start,
+                [&](atomizer::block&& missed_blk) {
+                    m_last_blk_height = missed_blk.m_height;
+                    m_watchtower.add_block(std::move(missed_blk));
+                });
+            if(!streamed.has_value() || streamed.value() == 0) {
                 m_logger->warn("Waiting for archiver sync");
                 static constexpr auto archiver_wait_time
                     = std::chrono::milliseconds(100);
                 std::this_thread::sleep_for(archiver_wait_time);
-                continue;
             }
-
-            m_last_blk_height = (*missed_blk).m_height;
-            m_watchtower.add_block(std::move(*missed_blk));
         }
     }
     m_last_blk_height = blk.m_height;
@@ -19,6 +19,7 @@
 
 #include <filesystem>
 #include <iomanip>
+#include <thread>
 #include <utility>
 
 namespace cbdc {
@@ -64,16 +65,21 @@ namespace cbdc {
                    std::string client_file)
         : m_opts(std::move(opts)),
           m_logger(std::move(logger)),
-          m_sentinel_client(m_opts.m_sentinel_endpoints, m_logger),
           m_client_file(std::move(client_file)),
-          m_wallet_file(std::move(wallet_file)) {}
+          m_wallet_file(std::move(wallet_file)),
+          m_sentinel_client(
+              m_opts.m_sentinel_endpoints,
+              m_logger,
+              std::chrono::microseconds(m_opts.m_rpc_coalesce_window)) {}
 
     auto client::init() -> bool {
-        if(std::filesystem::exists(m_wallet_file)) {
-            m_wallet.load(m_wallet_file);
-        } else {
+        if(!std::filesystem::exists(m_wallet_file)) {
             m_logger->warn("Existing wallet file not found");
         }
+        if(!m_wallet.open(m_wallet_file)) {
+            m_logger->error("Failed to open wallet journal.");
+            return false;
+        }
 
         load_client_state();
 
@@ -110,6 +116,7 @@ namespace cbdc {
     }
 
     void client::register_pending_tx(const transaction::full_tx& tx) {
+        std::unique_lock<std::recursive_mutex> l(m_state_mut);
         // Mark all inputs as pending spend
         for(const auto& in : tx.m_inputs) {
             m_pending_spend.insert({in.hash(), in});
@@ -194,6 +201,160 @@ namespace cbdc {
         return res;
     }
 
+    auto client::send_async(uint32_t value,
+                            const pubkey_t& payee,
+                            send_callback_type result_callback) -> bool {
+        auto tx = create_transaction(value, payee);
+        if(!tx.has_value()) {
+            m_logger->error("Failed to generate wallet spend tx.");
+            return false;
+        }
+
+        return send_transaction_async(tx.value(), std::move(result_callback));
+    }
+
+    auto client::send_transaction_async(const transaction::full_tx& tx,
+                                        send_callback_type result_callback)
+        -> bool {
+        import_transaction(tx);
+
+        auto seq = [&]() {
+            std::unique_lock<std::mutex> l(m_in_flight_mut);
+            wait_in_flight(l, [&]() {
+                return m_in_flight.size() < m_opts.m_window_size;
+            });
+            auto deadline = std::chrono::steady_clock::now()
+                          + std::chrono::milliseconds(m_opts.m_send_timeout);
+            auto s = m_send_seq++;
+            m_in_flight.emplace(
+                s,
+                in_flight_send{
+                    tx,
+                    std::make_shared<send_callback_type>(
+                        std::move(result_callback)),
+                    deadline});
+            return s;
+        }();
+
+        for(size_t attempt = 0; attempt < max_send_attempts; attempt++) {
+            if(attempt > 0) {
+                // Give the connection manager time to reconnect
+                std::this_thread::sleep_for(send_retry_delay);
+            }
+            auto sent = m_sentinel_client.execute_transaction(
+                tx,
+                [this,
+                 seq](std::optional<cbdc::sentinel::execute_response> res) {
+                    complete_send(seq, std::move(res));
+                });
+            if(sent) {
+                return true;
+            }
+        }
+
+        m_logger->error("Failed to send transaction to sentinel.");
+        {
+            std::unique_lock<std::mutex> l(m_in_flight_mut);
+            m_in_flight.erase(seq);
+        }
+        m_in_flight_cv.notify_all();
+        return false;
+    }
+
+    void client::complete_send(
+        uint64_t seq,
+        std::optional<cbdc::sentinel::execute_response> res) {
+        auto send = [&]() -> std::optional<in_flight_send> {
+            std::unique_lock<std::mutex> l(m_in_flight_mut);
+            auto it = m_in_flight.find(seq);
+            if(it == m_in_flight.end() || it->second.m_done) {
+                return std::nullopt;
+            }
+            it->second.m_done = true;
+            return it->second;
+        }();
+        if(!send.has_value()) {
+            // The send already timed out and its callback was called
+            return;
+        }
+        finish_send(seq, send.value(), std::move(res));
+    }
+
+    void client::finish_send(
+        uint64_t seq,
+        const in_flight_send& send,
+        std::optional<cbdc::sentinel::execute_response> res) {
+        const auto& tx = send.m_tx;
+        if(!res.has_value()) {
+            m_logger->error("No response from sentinel for",
+                            to_string(transaction::tx_id(tx)));
+        } else {
+            m_logger->info("Sentinel responded:",
+                           cbdc::sentinel::to_string(res.value().m_tx_status),
+                           "for",
+                           to_string(transaction::tx_id(tx)));
+            if(res.value().m_tx_status == sentinel::tx_status::confirmed) {
+                confirm_transaction(transaction::tx_id(tx));
+            }
+        }
+
+        (*send.m_callback)(tx, std::move(res));
+
+        {
+            std::unique_lock<std::mutex> l(m_in_flight_mut);
+            m_in_flight.erase(seq);
+        }
+        m_in_flight_cv.notify_all();
+    }
+
+    void client::wait_in_flight(std::unique_lock<std::mutex>& l,
+                                const std::function<bool()>& pred) {
+        while(!pred()) {
+            // Sends are ordered by deadline, so stop at the first one that
+            // has not expired
+            const auto now = std::chrono::steady_clock::now();
+            auto expired = std::vector<std::pair<uint64_t, in_flight_send>>();
+            auto next_deadline
+                = std::optional<std::chrono::steady_clock::time_point>();
+            for(auto& [seq, send] : m_in_flight) {
+                if(send.m_done) {
+                    continue;
+                }
+                if(send.m_deadline > now) {
+                    next_deadline = send.m_deadline;
+                    break;
+                }
+                send.m_done = true;
+                expired.emplace_back(seq, send);
+            }
+
+            if(!expired.empty()) {
+                l.unlock();
+                for(auto& [seq, send] : expired) {
+                    m_logger->warn("Timed out waiting for sentinel to respond "
+                                   "to",
+                                   to_string(transaction::tx_id(send.m_tx)));
+                    finish_send(seq, send, std::nullopt);
+                }
+                l.lock();
+                continue;
+            }
+
+            if(next_deadline.has_value()) {
+                m_in_flight_cv.wait_until(l, next_deadline.value());
+            } else {
+                m_in_flight_cv.wait(l);
+            }
+        }
+    }
+
+    void client::flush() {
+        std::unique_lock<std::mutex> l(m_in_flight_mut);
+        wait_in_flight(l, [&]() {
+            return m_in_flight.empty();
+        });
+    }
+
     auto client::export_send_inputs(const transaction::full_tx& send_tx,
                                     const pubkey_t& payee)
         -> std::vector<transaction::input> {
@@ -202,6 +363,7 @@ namespace cbdc {
 
     void client::import_send_input(const transaction::input& in) {
         if(m_wallet.is_spendable(in)) {
+            std::unique_lock<std::recursive_mutex> l(m_state_mut);
             m_pending_inputs.insert({in.m_prevout.m_tx_id, in});
             save();
         } else {
@@ -224,14 +386,17 @@ namespace cbdc {
     }
 
     auto client::pending_tx_count() -> size_t {
+        std::unique_lock<std::recursive_mutex> l(m_state_mut);
         return m_pending_txs.size();
     }
 
     auto client::pending_input_count() -> size_t {
+        std::unique_lock<std::recursive_mutex> l(m_state_mut);
         return m_pending_inputs.size();
     }
 
     void client::import_transaction(const transaction::full_tx& tx) {
+        std::unique_lock<std::recursive_mutex> l(m_state_mut);
         m_pending_txs.insert({transaction::tx_id(tx), tx});
         save();
     }
@@ -240,6 +405,7 @@ namespace cbdc {
         // TODO: This can probably be done more efficiently, but we
         // might have to keep a secondary map to index the pending tx set on
         // input hash?
+        std::unique_lock<std::recursive_mutex> l(m_state_mut);
         for(auto& it : m_pending_txs) {
             for(auto& in : it.second.m_inputs) {
                 if(in == inp) {
@@ -251,6 +417,7 @@ namespace cbdc {
     }
 
     auto client::abandon_transaction(const hash_t& tx_id) -> bool {
+        std::unique_lock<std::recursive_mutex> l(m_state_mut);
         bool success{false};
         const auto it = m_pending_txs.find(tx_id);
         if(it != m_pending_txs.end()) {
@@ -280,6 +447,7 @@ namespace cbdc {
     auto client::confirm_transaction(const hash_t& tx_id) -> bool {
         // TODO: Should abandon and confirm be combined somehow?
         // for instance: finish_transaction(hash_t tx_id, bool succeeded)
+        std::unique_lock<std::recursive_mutex> l(m_state_mut);
         bool success{false};
         const auto it = m_pending_txs.find(tx_id);
         if(it != m_pending_txs.end()) {
@@ -321,6 +489,7 @@ namespace cbdc {
     }
 
     void client::save_client_state() {
+        std::unique_lock<std::recursive_mutex> l(m_state_mut);
         std::ofstream client_file(m_client_file,
                                   std::ios::binary | std::ios::trunc
                                       | std::ios::out);
@@ -334,17 +503,19 @@ namespace cbdc {
     }
 
     void client::save() {
+        // The wallet saves its own changes to its journal
         save_client_state();
-        m_wallet.save(m_wallet_file);
     }
 
     auto client::pending_txs() const
         -> std::unordered_map<hash_t, transaction::full_tx, hashing::null> {
+        std::unique_lock<std::recursive_mutex> l(m_state_mut);
         return m_pending_txs;
     }
 
     auto client::pending_inputs() const
         -> std::unordered_map<hash_t, transaction::input, hashing::null> {
+        std::unique_lock<std::recursive_mutex> l(m_state_mut);
         return m_pending_inputs;
     }
 }
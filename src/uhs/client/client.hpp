@@ -10,6 +10,11 @@
 #include "uhs/transaction/validation.hpp"
 #include "uhs/transaction/wallet.hpp"
 
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
 namespace cbdc {
     namespace address {
         static constexpr auto bits_per_byte = 8;
@@ -99,6 +104,60 @@ namespace cbdc {
             -> std::pair<std::optional<transaction::full_tx>,
                          std::optional<cbdc::sentinel::execute_response>>;
 
+        /// Callback for the result of an asynchronous send: the transaction
+        /// and the response from the sentinel, or std::nullopt if no
+        /// sentinel responded.
+        using send_callback_type = std::function<void(
+            transaction::full_tx,
+            std::optional<cbdc::sentinel::execute_response>)>;
+
+        /// \brief Sends a specified amount from this client's wallet to a
+        ///        target address without waiting for the sentinel.
+        ///
+        /// Generates the transaction and submits it via \ref
+        /// send_transaction_async, so many transactions can be in flight
+        /// over one sentinel connection.
+        /// \param value the amount to send, in the base unit of the currency.
+        /// \param payee the destination address of the transfer.
+        /// \param result_callback function to call with the sentinel's
+        ///                        response.
+        /// \return false if generating or transmitting the transaction
+        ///         failed, in which case the callback is not called.
+        auto send_async(uint32_t value,
+                        const pubkey_t& payee,
+                        send_callback_type result_callback) -> bool;
+
+        /// \brief Sends the given transaction to a sentinel without waiting
+        ///        for its response.
+        ///
+        /// Blocks while the configured window of transactions is already
+        /// awaiting responses. Confirms the transaction once the sentinel
+        /// responds that it is confirmed, then calls the callback on the
+        /// sentinel client's response thread. If no sentinel is connected,
+        /// sending is retried a few times while the connections are
+        /// re-established. If the sentinel does not respond within the
+        /// configured send timeout, for example because it disconnected,
+        /// the send is failed with no response. Its callback is called once
+        /// a later send or \ref flush waits for it. The transaction stays
+        /// pending until \ref sync resolves it, and a late response is
+        /// ignored.
+        /// \note Like \ref send_transaction, this function adds the
+        ///       transaction to the client's pending transaction set.
+        /// \warning Do not call from a send callback, as the window cannot
+        ///          drain while the response thread is blocked.
+        /// \param tx the transaction to send.
+        /// \param result_callback function to call with the sentinel's
+        ///                        response.
+        /// \return false if no sentinel was reachable, in which case the
+        ///         callback is not called.
+        auto send_transaction_async(const transaction::full_tx& tx,
+                                    send_callback_type result_callback)
+            -> bool;
+
+        /// Blocks until every asynchronous send has completed, or timed out,
+        /// and its callback has returned.
+        void flush();
+
         /// \brief Extracts the transaction data that recipients need from
         ///        senders to confirm pending transfers.
         ///
@@ -274,7 +333,32 @@ namespace cbdc {
         cbdc::config::options m_opts;
         std::shared_ptr<logging::log> m_logger;
 
-        cbdc::sentinel::rpc::client m_sentinel_client;
+        /// Number of times an asynchronous send is attempted when no
+        /// sentinel is connected, and the delay between attempts.
+        static constexpr size_t max_send_attempts{3};
+        static constexpr auto send_retry_delay
+            = std::chrono::milliseconds(100);
+
+        /// Locks access to the pending transaction and input sets and the
+        /// client file, which sentinel responses update from the response
+        /// thread.
+        mutable std::recursive_mutex m_state_mut;
+
+        /// An asynchronous send awaiting a response.
+        struct in_flight_send {
+            transaction::full_tx m_tx;
+            std::shared_ptr<send_callback_type> m_callback;
+            std::chrono::steady_clock::time_point m_deadline;
+            /// Set once the response or the timeout claims the send.
+            bool m_done{false};
+        };
+
+        /// Asynchronous sends awaiting a response, keyed by a sequence
+        /// number so they are ordered by deadline.
+        std::mutex m_in_flight_mut;
+        std::condition_variable m_in_flight_cv;
+        std::map<uint64_t, in_flight_send> m_in_flight;
+        uint64_t m_send_seq{0};
 
         /// List of pending transactions submitted to the system awaiting
         /// confirmation, keyed by Tx ID.
@@ -297,6 +381,28 @@ namespace cbdc {
         std::string m_client_file;
         std::string m_wallet_file;
 
+        /// Declared last so it is destroyed first, stopping its response
+        /// thread while the state that responses update is still valid.
+        cbdc::sentinel::rpc::client m_sentinel_client;
+
+        /// Completes an asynchronous send with the sentinel's response,
+        /// unless it already timed out.
+        void complete_send(
+            uint64_t seq,
+            std::optional<cbdc::sentinel::execute_response> res);
+
+        /// Logs and applies the result of an asynchronous send, then calls
+        /// its callback and frees its slot in the window.
+        void finish_send(
+            uint64_t seq,
+            const in_flight_send& send,
+            std::optional<cbdc::sentinel::execute_response> res);
+
+        /// Waits until the predicate holds, failing sends whose deadline
+        /// passes in the meantime. Requires m_in_flight_mut.
+        void wait_in_flight(std::unique_lock<std::mutex>& l,
+                            const std::function<bool()>& pred);
+
         /// Add the provided transaction to the memory pool, awaiting
         /// confirmation from the network.
         /// \param tx transaction to add.
@@ -7,6 +7,8 @@
 
 #include "uhs/transaction/messages.hpp"
 
+#include <future>
+
 namespace cbdc {
     twophase_client::twophase_client(
         const cbdc::config::options& opts,
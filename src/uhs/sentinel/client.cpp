@@ -11,9 +11,10 @@
 
 namespace cbdc::sentinel::rpc {
     client::client(std::vector<network::endpoint_t> endpoints,
-                   std::shared_ptr<logging::log> logger)
+                   std::shared_ptr<logging::log> logger,
+                   std::chrono::microseconds coalesce_window)
         : m_logger(std::move(logger)),
-          m_client(std::move(endpoints)) {}
+          m_client(std::move(endpoints), coalesce_window) {}
 
     auto client::init(std::optional<bool> error_fatal) -> bool {
         if(!m_client.init(error_fatal)) {
@@ -19,8 +19,13 @@ namespace cbdc::sentinel::rpc {
         /// Constructor.
         /// \param endpoints sentinel cluster RPC endpoints.
         /// \param logger pointer shared logger.
+        /// \param coalesce_window time to wait for more requests to send in
+        ///                        one packet. Zero sends each request in its
+        ///                        own packet.
         client(std::vector<network::endpoint_t> endpoints,
-               std::shared_ptr<logging::log> logger);
+               std::shared_ptr<logging::log> logger,
+               std::chrono::microseconds coalesce_window
+               = std::chrono::microseconds::zero());
 
         ~client() override = default;
 
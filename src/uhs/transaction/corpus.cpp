@@ -0,0 +1,168 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "corpus.hpp"
+
+#include "messages.hpp"
+#include "util/serialization/buffer_serializer.hpp"
+#include "util/serialization/format.hpp"
+#include "util/serialization/ostream_serializer.hpp"
+#include "util/serialization/util.hpp"
+
+#include <array>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cbdc::transaction {
+    namespace {
+        constexpr std::array<char, 8> corpus_magic
+            = {'T', 'X', 'C', 'O', 'R', 'P', 'U', '1'};
+        constexpr uint64_t header_size
+            = corpus_magic.size() + sizeof(uint64_t) * 2 + sizeof(uint32_t)
+            + std::tuple_size<hash_t>::value;
+    }
+
+    auto corpus_seed::operator==(const corpus_seed& rhs) const -> bool {
+        return m_seed_from == rhs.m_seed_from && m_seed_to == rhs.m_seed_to
+            && m_seed_value == rhs.m_seed_value
+            && m_seed_witness_commitment == rhs.m_seed_witness_commitment;
+    }
+
+    corpus_writer::corpus_writer(const std::string& path,
+                                 const corpus_seed& seed)
+        : m_out(path, std::ios::binary | std::ios::trunc) {
+        auto ser = ostream_serializer(m_out);
+        ser << corpus_magic << seed.m_seed_from << seed.m_seed_to
+            << seed.m_seed_value << seed.m_seed_witness_commitment;
+        m_pos = header_size;
+    }
+
+    auto corpus_writer::add(const full_tx& tx) -> bool {
+        return add(make_buffer(tx));
+    }
+
+    auto corpus_writer::add(const buffer& tx) -> bool {
+        m_out.write(static_cast<const char*>(tx.data()),
+                    static_cast<std::streamsize>(tx.size()));
+        m_pos += tx.size();
+        m_offsets.push_back(m_pos);
+        return m_out.good();
+    }
+
+    auto corpus_writer::finish() -> bool {
+        auto ser = ostream_serializer(m_out);
+        for(const auto offset : m_offsets) {
+            ser << offset;
+        }
+        ser << static_cast<uint64_t>(m_offsets.size());
+        m_out.close();
+        return !m_out.fail();
+    }
+
+    corpus::~corpus() {
+        if(!m_map.empty()) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+            ::munmap(const_cast<std::byte*>(m_map.data()), m_map.size());
+        }
+    }
+
+    auto corpus::init(const std::string& path) -> bool {
+        if(!m_map.empty()) {
+            return false;
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+        const auto fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) {
+            return false;
+        }
+        struct stat st {};
+        if(::fstat(fd, &st) != 0
+           || static_cast<uint64_t>(st.st_size)
+                  < header_size + sizeof(uint64_t)) {
+            ::close(fd);
+            return false;
+        }
+        const auto size = static_cast<size_t>(st.st_size);
+        auto* map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        // The mapping stays valid after the descriptor is closed
+        ::close(fd);
+        if(map == MAP_FAILED) {
+            return false;
+        }
+        m_map = std::span(static_cast<const std::byte*>(map), size);
+        ::madvise(map, size, MADV_SEQUENTIAL);
+
+        auto header = buffer();
+        header.append(m_map.data(), header_size);
+        auto deser = buffer_serializer(header);
+        auto magic = std::array<char, corpus_magic.size()>();
+        deser >> magic >> m_seed.m_seed_from >> m_seed.m_seed_to
+            >> m_seed.m_seed_value >> m_seed.m_seed_witness_commitment;
+        if(!deser || magic != corpus_magic) {
+            return false;
+        }
+
+        uint64_t count{};
+        std::memcpy(&count,
+                    &m_map[m_map.size() - sizeof(count)],
+                    sizeof(count));
+        const auto max_count
+            = (m_map.size() - header_size - sizeof(count)) / sizeof(uint64_t);
+        if(count > max_count) {
+            return false;
+        }
+        const auto table_size = count * sizeof(uint64_t);
+        const auto table_start = m_map.size() - sizeof(count) - table_size;
+        m_offsets = m_map.subspan(table_start, table_size);
+        m_data_start = header_size;
+        m_count = count;
+
+        // Offsets must increase and stay within the transaction data
+        uint64_t prev{m_data_start};
+        for(size_t i = 0; i < m_count; i++) {
+            const auto end = end_offset(i);
+            if(end <= prev || end > table_start) {
+                m_count = 0;
+                return false;
+            }
+            prev = end;
+        }
+        if(prev != table_start) {
+            m_count = 0;
+            return false;
+        }
+        return true;
+    }
+
+    auto corpus::size() const -> size_t {
+        return m_count;
+    }
+
+    auto corpus::seed() const -> const corpus_seed& {
+        return m_seed;
+    }
+
+    auto corpus::raw(size_t idx) const -> std::span<const std::byte> {
+        assert(idx < m_count);
+        const auto begin = idx == 0 ? m_data_start : end_offset(idx - 1);
+        return m_map.subspan(begin, end_offset(idx) - begin);
+    }
+
+    auto corpus::get(size_t idx) const -> std::optional<full_tx> {
+        const auto bytes = raw(idx);
+        auto buf = buffer();
+        buf.append(bytes.data(), bytes.size());
+        return from_buffer<full_tx>(buf);
+    }
+
+    auto corpus::end_offset(size_t idx) const -> uint64_t {
+        uint64_t ret{};
+        std::memcpy(&ret, &m_offsets[idx * sizeof(ret)], sizeof(ret));
+        return ret;
+    }
+}
@@ -0,0 +1,124 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/** \file corpus.hpp
+ * File of pre-generated, signed transactions for load generators to replay.
+ *
+ * The file holds a header describing the seeded outputs the transactions
+ * spend, the serialized transactions back to back, a table with the end
+ * offset of each transaction and a footer with the transaction count:
+ *
+ *     magic | seed from | seed to | seed value | seed witness commitment
+ *     tx 0 | ... | tx n-1
+ *     end offset * n
+ *     tx count
+ *
+ * Readers map the file into memory, so transactions can be fetched by index
+ * without reading the whole corpus up front.
+ */
+
+#ifndef OPENCBDC_TX_SRC_TRANSACTION_CORPUS_H_
+#define OPENCBDC_TX_SRC_TRANSACTION_CORPUS_H_
+
+#include "transaction.hpp"
+
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace cbdc::transaction {
+    /// Seeded outputs spent by the transactions in a corpus. Shards must be
+    /// pre-seeded with at least this range before the corpus is replayed.
+    struct corpus_seed {
+        /// First seed index spent by the corpus.
+        uint64_t m_seed_from{};
+        /// End of the seed index range spent by the corpus, exclusive.
+        uint64_t m_seed_to{};
+        /// Value of each seeded output.
+        uint32_t m_seed_value{};
+        /// Witness program commitment of the seeded outputs.
+        hash_t m_seed_witness_commitment{};
+
+        auto operator==(const corpus_seed& rhs) const -> bool;
+    };
+
+    /// \brief Writes transactions to a corpus file.
+    class corpus_writer {
+      public:
+        /// Constructor. Creates the file and writes the corpus header.
+        /// \param path path of the corpus file to create.
+        /// \param seed seeded outputs spent by the transactions.
+        corpus_writer(const std::string& path, const corpus_seed& seed);
+
+        /// Appends a transaction to the corpus.
+        /// \param tx transaction to append.
+        /// \return false if writing to the file failed.
+        auto add(const full_tx& tx) -> bool;
+
+        /// Appends a serialized transaction to the corpus.
+        /// \param tx serialized transaction to append.
+        /// \return false if writing to the file failed.
+        auto add(const buffer& tx) -> bool;
+
+        /// Writes the offset table and footer and closes the file.
+        /// \return false if writing to the file failed.
+        auto finish() -> bool;
+
+      private:
+        std::ofstream m_out;
+        std::vector<uint64_t> m_offsets;
+        uint64_t m_pos{};
+    };
+
+    /// \brief Read-only, memory-mapped view of a corpus file.
+    class corpus {
+      public:
+        corpus() = default;
+        ~corpus();
+
+        corpus(const corpus&) = delete;
+        auto operator=(const corpus&) -> corpus& = delete;
+        corpus(corpus&&) = delete;
+        auto operator=(corpus&&) -> corpus& = delete;
+
+        /// Maps a corpus file and checks its header and offset table.
+        /// \param path path of the corpus file.
+        /// \return false if the file could not be mapped or is malformed.
+        auto init(const std::string& path) -> bool;
+
+        /// Returns the number of transactions in the corpus.
+        /// \return transaction count.
+        [[nodiscard]] auto size() const -> size_t;
+
+        /// Returns the seeded outputs spent by the corpus.
+        /// \return corpus seed.
+        [[nodiscard]] auto seed() const -> const corpus_seed&;
+
+        /// Returns the serialized transaction at the given index.
+        /// \param idx transaction index.
+        /// \return view of the serialized transaction in the mapped file.
+        [[nodiscard]] auto raw(size_t idx) const
+            -> std::span<const std::byte>;
+
+        /// Deserializes the transaction at the given index.
+        /// \param idx transaction index.
+        /// \return transaction, or std::nullopt if it could not be
+        ///         deserialized.
+        [[nodiscard]] auto get(size_t idx) const -> std::optional<full_tx>;
+
+      private:
+        std::span<const std::byte> m_map;
+        corpus_seed m_seed;
+        uint64_t m_data_start{};
+        std::span<const std::byte> m_offsets;
+        size_t m_count{};
+
+        [[nodiscard]] auto end_offset(size_t idx) const -> uint64_t;
+    };
+}
+
+#endif // OPENCBDC_TX_SRC_TRANSACTION_CORPUS_H_
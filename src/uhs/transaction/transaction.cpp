@@ -7,10 +7,62 @@
 
 #include "crypto/sha256.h"
 #include "messages.hpp"
+#include "util/serialization/buffer_serializer.hpp"
 #include "util/serialization/format.hpp"
+#include "util/serialization/hashing_serializer.hpp"
 #include "util/serialization/util.hpp"
 
 namespace cbdc::transaction {
+    namespace {
+        /// Below this many messages, laying the preimages out for
+        /// SHA256Multi costs more than hashing them one at a time.
+        constexpr size_t min_multi_hashes{4};
+
+        auto input_size() -> size_t {
+            static const auto size = serialized_size(input());
+            return size;
+        }
+
+        auto output_size() -> size_t {
+            static const auto size = serialized_size(output());
+            return size;
+        }
+
+        auto uhs_preimage_size() -> size_t {
+            return hash_size + sizeof(uint64_t) + output_size();
+        }
+
+        /// Hashes n fixed-size preimages written by the given function.
+        template<typename F>
+        auto hash_preimages(size_t n, size_t len, const F& write)
+            -> std::vector<hash_t> {
+            auto ret = std::vector<hash_t>(n);
+            if(n < min_multi_hashes) {
+                auto ser = hashing_serializer();
+                for(size_t i = 0; i < n; i++) {
+                    write(ser, i);
+                    ret[i] = ser.finalize();
+                }
+                return ret;
+            }
+            auto buf = buffer();
+            buf.extend(n * len);
+            auto ser = buffer_serializer(buf);
+            for(size_t i = 0; i < n; i++) {
+                write(ser, i);
+            }
+            assert(ser.end_of_buffer());
+            static_assert(sizeof(hash_t) == hash_size);
+            SHA256Multi(ret.data()->data(), buf.c_ptr(), len, n);
+            return ret;
+        }
+
+        auto tx_preimage_size(const full_tx& tx) -> size_t {
+            return sizeof(uint64_t) * 2 + tx.m_inputs.size() * input_size()
+                 + tx.m_outputs.size() * output_size();
+        }
+    }
+
     auto out_point::operator==(const out_point& rhs) const -> bool {
         return m_tx_id == rhs.m_tx_id && m_index == rhs.m_index;
     }
@@ -46,15 +98,7 @@ namespace cbdc::transaction {
     }
 
     auto input::hash() const -> hash_t {
-        auto buf = cbdc::make_buffer(*this);
-
-        CSHA256 sha;
-        hash_t result;
-
-        sha.Write(buf.c_ptr(), buf.size());
-        sha.Finalize(result.data());
-
-        return result;
+        return hash_serialized(*this);
     }
 
     auto full_tx::operator==(const full_tx& rhs) const -> bool {
@@ -70,18 +114,9 @@ namespace cbdc::transaction {
     }
 
     auto tx_id(const full_tx& tx) noexcept -> hash_t {
-        CSHA256 sha;
-
-        auto inp_buf = cbdc::make_buffer(tx.m_inputs);
-        sha.Write(inp_buf.c_ptr(), inp_buf.size());
-
-        auto out_buf = cbdc::make_buffer(tx.m_outputs);
-        sha.Write(out_buf.c_ptr(), out_buf.size());
-
-        hash_t ret;
-        sha.Finalize(ret.data());
-
-        return ret;
+        auto ser = hashing_serializer();
+        ser << tx.m_inputs << tx.m_outputs;
+        return ser.finalize();
     }
 
     auto input_from_output(const full_tx& tx, size_t i, const hash_t& txid)
@@ -105,18 +140,9 @@ namespace cbdc::transaction {
     auto uhs_id_from_output(const hash_t& entropy,
                             uint64_t i,
                             const output& output) -> hash_t {
-        CSHA256 sha;
-        hash_t ret;
-        sha.Write(entropy.data(), entropy.size());
-        std::array<unsigned char, sizeof(i)> index_arr{};
-        std::memcpy(index_arr.data(), &i, sizeof(i));
-        sha.Write(index_arr.data(), sizeof(i));
-
-        auto buf = cbdc::make_buffer(output);
-
-        sha.Write(buf.c_ptr(), buf.size());
-        sha.Finalize(ret.data());
-        return ret;
+        auto ser = hashing_serializer();
+        ser << entropy << i << output;
+        return ser.finalize();
     }
 
     auto compact_tx::operator==(const compact_tx& tx) const noexcept -> bool {
@@ -125,13 +151,8 @@ namespace cbdc::transaction {
 
     compact_tx::compact_tx(const full_tx& tx) {
         m_id = tx_id(tx);
-        for(const auto& inp : tx.m_inputs) {
-            m_inputs.push_back(inp.hash());
-        }
-        for(uint64_t i = 0; i < tx.m_outputs.size(); i++) {
-            m_uhs_outputs.push_back(
-                uhs_id_from_output(m_id, i, tx.m_outputs[i]));
-        }
+        m_inputs = input_hashes(tx.m_inputs);
+        m_uhs_outputs = uhs_ids_from_outputs(m_id, tx.m_outputs);
     }
 
     auto compact_tx::sign(secp256k1_context* ctx, const privkey_t& key) const
@@ -156,15 +177,13 @@ namespace cbdc::transaction {
     }
 
     auto compact_tx::hash() const -> hash_t {
-        // Don't include the attesations in the hash
-        auto ctx = *this;
-        ctx.m_attestations.clear();
-        auto buf = make_buffer(ctx);
-        auto sha = CSHA256();
-        sha.Write(buf.c_ptr(), buf.size());
-        auto ret = hash_t();
-        sha.Finalize(ret.data());
-        return ret;
+        // Don't include the attesations in the hash. Hash an empty set in
+        // their place so the result matches hashing a copy of the
+        // transaction with its attestations cleared.
+        auto ser = hashing_serializer();
+        ser << m_id << m_inputs << m_uhs_outputs
+            << decltype(m_attestations)();
+        return ser.finalize();
     }
 
     auto compact_tx::verify(secp256k1_context* ctx,
@@ -185,4 +204,96 @@ namespace cbdc::transaction {
 
         return true;
     }
+
+    auto tx_ids(const std::vector<full_tx>& txs) -> std::vector<hash_t> {
+        auto ret = std::vector<hash_t>();
+        ret.reserve(txs.size());
+        // Transactions with the same number of inputs and outputs have
+        // preimages of the same size, so runs of them can be hashed together
+        size_t run_start = 0;
+        while(run_start < txs.size()) {
+            const auto len = tx_preimage_size(txs[run_start]);
+            auto run_end = run_start + 1;
+            while(run_end < txs.size()
+                  && tx_preimage_size(txs[run_end]) == len) {
+                run_end++;
+            }
+            auto ids = hash_preimages(run_end - run_start,
+                                      len,
+                                      [&](serializer& ser, size_t i) {
+                                          const auto& tx = txs[run_start + i];
+                                          ser << tx.m_inputs << tx.m_outputs;
+                                      });
+            ret.insert(ret.end(), ids.begin(), ids.end());
+            run_start = run_end;
+        }
+        return ret;
+    }
+
+    auto input_hashes(const std::vector<input>& inputs)
+        -> std::vector<hash_t> {
+        return hash_preimages(inputs.size(),
+                              input_size(),
+                              [&](serializer& ser, size_t i) {
+                                  ser << inputs[i];
+                              });
+    }
+
+    auto uhs_ids_from_outputs(const hash_t& entropy,
+                              const std::vector<output>& outputs)
+        -> std::vector<hash_t> {
+        return hash_preimages(outputs.size(),
+                              uhs_preimage_size(),
+                              [&](serializer& ser, size_t i) {
+                                  ser << entropy << static_cast<uint64_t>(i)
+                                      << outputs[i];
+                              });
+    }
+
+    auto compact_txs(const std::vector<full_tx>& txs)
+        -> std::vector<compact_tx> {
+        auto ids = tx_ids(txs);
+
+        // Hash the inputs and outputs of every transaction together, then
+        // hand each transaction its share of the hashes
+        auto inputs = std::vector<const input*>();
+        auto outputs = std::vector<std::pair<size_t, uint64_t>>();
+        for(size_t t = 0; t < txs.size(); t++) {
+            for(const auto& inp : txs[t].m_inputs) {
+                inputs.push_back(&inp);
+            }
+            for(uint64_t i = 0; i < txs[t].m_outputs.size(); i++) {
+                outputs.emplace_back(t, i);
+            }
+        }
+        auto inp_hashes = hash_preimages(inputs.size(),
+                                         input_size(),
+                                         [&](serializer& ser, size_t i) {
+                                             ser << *inputs[i];
+                                         });
+        auto uhs_ids = hash_preimages(
+            outputs.size(),
+            uhs_preimage_size(),
+            [&](serializer& ser, size_t i) {
+                const auto [t, idx] = outputs[i];
+                ser << ids[t] << idx << txs[t].m_outputs[idx];
+            });
+
+        auto ret = std::vector<compact_tx>(txs.size());
+        auto inp_it = inp_hashes.begin();
+        auto out_it = uhs_ids.begin();
+        for(size_t t = 0; t < txs.size(); t++) {
+            auto& ctx = ret[t];
+            ctx.m_id = ids[t];
+            const auto n_inputs
+                = static_cast<std::ptrdiff_t>(txs[t].m_inputs.size());
+            const auto n_outputs
+                = static_cast<std::ptrdiff_t>(txs[t].m_outputs.size());
+            ctx.m_inputs.assign(inp_it, inp_it + n_inputs);
+            ctx.m_uhs_outputs.assign(out_it, out_it + n_outputs);
+            inp_it += n_inputs;
+            out_it += n_outputs;
+        }
+        return ret;
+    }
 }
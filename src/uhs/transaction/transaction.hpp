@@ -198,6 +198,36 @@ namespace cbdc::transaction {
     auto uhs_id_from_output(const hash_t& entropy,
                             uint64_t i,
                             const output& output) -> hash_t;
+
+    /// Calculates the transaction IDs of a batch of transactions, hashing
+    /// transactions with the same number of inputs and outputs several at a
+    /// time.
+    /// \param txs transactions to hash.
+    /// \return the result of \ref tx_id for each transaction, in order.
+    [[nodiscard]] auto tx_ids(const std::vector<full_tx>& txs)
+        -> std::vector<hash_t>;
+
+    /// Calculates the hashes of a batch of inputs, several at a time.
+    /// \param inputs inputs to hash.
+    /// \return the result of input::hash for each input, in order.
+    [[nodiscard]] auto input_hashes(const std::vector<input>& inputs)
+        -> std::vector<hash_t>;
+
+    /// Calculates the UHS IDs of a transaction's outputs, several at a time.
+    /// \param entropy entropy for the UHS IDs, usually the transaction ID.
+    /// \param outputs outputs of the transaction.
+    /// \return the result of \ref uhs_id_from_output for each output, in
+    ///         order.
+    [[nodiscard]] auto uhs_ids_from_outputs(const hash_t& entropy,
+                                            const std::vector<output>& outputs)
+        -> std::vector<hash_t>;
+
+    /// Converts a batch of transactions to compact transactions, hashing the
+    /// inputs and outputs of all the transactions together.
+    /// \param txs transactions to convert.
+    /// \return compact transaction for each transaction, in order.
+    [[nodiscard]] auto compact_txs(const std::vector<full_tx>& txs)
+        -> std::vector<compact_tx>;
 }
 
 #endif // OPENCBDC_TX_SRC_TRANSACTION_TRANSACTION_H_
@@ -0,0 +1,218 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "utxo_store.hpp"
+
+#include "crypto/siphash.h"
+
+#include <mutex>
+
+namespace cbdc::transaction {
+    auto utxo_store::out_point_hasher::operator()(
+        const out_point& op) const noexcept -> size_t {
+        static constexpr uint64_t siphash_key{0x1337};
+        auto hasher = CSipHasher(siphash_key, siphash_key);
+        hasher.Write(op.m_tx_id.data(), op.m_tx_id.size());
+        hasher.Write(op.m_index);
+        return hasher.Finalize();
+    }
+
+    auto utxo_store::add(const input& utxo) -> bool {
+        std::unique_lock<std::shared_mutex> l(m_mut);
+        const auto it = m_index.find(utxo.m_prevout);
+        if(it != m_index.end()
+           && std::atomic_ref(m_states[it->second]).load() == slot_unspent) {
+            return false;
+        }
+
+        append(utxo);
+        maybe_compact();
+        return true;
+    }
+
+    auto utxo_store::spend(const out_point& op) -> bool {
+        auto spent = false;
+        {
+            std::shared_lock<std::shared_mutex> l(m_mut);
+            const auto it = m_index.find(op);
+            if(it != m_index.end()) {
+                spent = try_reserve(it->second);
+            }
+        }
+        try_compact();
+        return spent;
+    }
+
+    auto utxo_store::reserve_oldest(size_t n)
+        -> std::optional<std::vector<input>> {
+        auto ret = std::vector<input>();
+        ret.reserve(n);
+        {
+            std::shared_lock<std::shared_mutex> l(m_mut);
+            for(auto slot = m_oldest.load();
+                slot < m_slab.size() && ret.size() < n;
+                slot++) {
+                if(try_reserve(slot)) {
+                    ret.push_back(m_slab[slot]);
+                }
+                // Slots are never unspent while a shared lock is held, so
+                // move the cursor past the spent prefix for later calls
+                auto expected = slot;
+                m_oldest.compare_exchange_strong(expected, slot + 1);
+            }
+        }
+
+        if(ret.size() < n) {
+            release(ret);
+            return std::nullopt;
+        }
+        try_compact();
+        return ret;
+    }
+
+    auto utxo_store::reserve_amount(uint64_t amount)
+        -> std::optional<std::vector<input>> {
+        auto ret = std::vector<input>();
+        uint64_t total{0};
+        {
+            std::shared_lock<std::shared_mutex> l(m_mut);
+            // Smallest single UTXO that covers the amount
+            for(auto it = m_by_value.lower_bound({amount, 0});
+                it != m_by_value.end();
+                it++) {
+                if(try_reserve(it->second)) {
+                    ret.push_back(m_slab[it->second]);
+                    total = it->first;
+                    break;
+                }
+            }
+
+            // Otherwise, the largest UTXOs until they cover the amount
+            for(auto it = m_by_value.rbegin();
+                it != m_by_value.rend() && total < amount;
+                it++) {
+                if(try_reserve(it->second)) {
+                    ret.push_back(m_slab[it->second]);
+                    total += it->first;
+                }
+            }
+        }
+
+        if(total < amount) {
+            release(ret);
+            return std::nullopt;
+        }
+        try_compact();
+        return ret;
+    }
+
+    void utxo_store::release(const std::vector<input>& utxos) {
+        if(utxos.empty()) {
+            return;
+        }
+        std::unique_lock<std::shared_mutex> l(m_mut);
+        for(const auto& utxo : utxos) {
+            const auto it = m_index.find(utxo.m_prevout);
+            if(it == m_index.end()) {
+                // Compaction dropped the reserved slot, so add it back
+                append(utxo);
+                continue;
+            }
+            const auto slot = it->second;
+            auto state = std::atomic_ref(m_states[slot]);
+            if(state.exchange(slot_unspent) == slot_spent) {
+                m_balance += m_slab[slot].m_prevout_data.m_value;
+                m_count++;
+                if(slot < m_oldest) {
+                    m_oldest = slot;
+                }
+            }
+        }
+    }
+
+    auto utxo_store::balance() const -> uint64_t {
+        return m_balance;
+    }
+
+    auto utxo_store::size() const -> size_t {
+        return m_count;
+    }
+
+    auto utxo_store::utxos() const -> std::vector<input> {
+        std::shared_lock<std::shared_mutex> l(m_mut);
+        auto ret = std::vector<input>();
+        ret.reserve(m_count);
+        for(size_t slot = m_oldest; slot < m_slab.size(); slot++) {
+            if(std::atomic_ref(m_states[slot]).load() == slot_unspent) {
+                ret.push_back(m_slab[slot]);
+            }
+        }
+        return ret;
+    }
+
+    void utxo_store::clear() {
+        std::unique_lock<std::shared_mutex> l(m_mut);
+        m_slab.clear();
+        m_states.clear();
+        m_index.clear();
+        m_by_value.clear();
+        m_oldest = 0;
+        m_balance = 0;
+        m_count = 0;
+    }
+
+    void utxo_store::append(const input& utxo) {
+        const auto slot = m_slab.size();
+        m_slab.push_back(utxo);
+        m_states.push_back(slot_unspent);
+        m_index.insert_or_assign(utxo.m_prevout, slot);
+        m_by_value.emplace(utxo.m_prevout_data.m_value, slot);
+        m_balance += utxo.m_prevout_data.m_value;
+        m_count++;
+    }
+
+    auto utxo_store::try_reserve(size_t slot) -> bool {
+        auto state = std::atomic_ref(m_states[slot]);
+        auto expected = slot_unspent;
+        if(!state.compare_exchange_strong(expected, slot_spent)) {
+            return false;
+        }
+        m_balance -= m_slab[slot].m_prevout_data.m_value;
+        m_count--;
+        return true;
+    }
+
+    void utxo_store::maybe_compact() {
+        const auto n_spent = m_slab.size() - m_count;
+        if(n_spent < min_compact_slots || n_spent <= m_count) {
+            return;
+        }
+
+        auto slab = std::vector<input>();
+        slab.reserve(m_count);
+        for(size_t slot = m_oldest; slot < m_slab.size(); slot++) {
+            if(m_states[slot] == slot_unspent) {
+                slab.push_back(m_slab[slot]);
+            }
+        }
+        m_slab = std::move(slab);
+        m_states.assign(m_slab.size(), slot_unspent);
+        m_index.clear();
+        m_by_value.clear();
+        for(size_t slot = 0; slot < m_slab.size(); slot++) {
+            const auto& utxo = m_slab[slot];
+            m_index.emplace(utxo.m_prevout, slot);
+            m_by_value.emplace(utxo.m_prevout_data.m_value, slot);
+        }
+        m_oldest = 0;
+    }
+
+    void utxo_store::try_compact() {
+        std::unique_lock<std::shared_mutex> l(m_mut, std::try_to_lock);
+        if(l.owns_lock()) {
+            maybe_compact();
+        }
+    }
+}
@@ -0,0 +1,126 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef OPENCBDC_TX_SRC_TRANSACTION_UTXO_STORE_H_
+#define OPENCBDC_TX_SRC_TRANSACTION_UTXO_STORE_H_
+
+#include "transaction.hpp"
+
+#include <atomic>
+#include <optional>
+#include <set>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace cbdc::transaction {
+    /// \brief Spendable outputs held by a wallet.
+    ///
+    /// UTXOs are kept in a contiguous slab in the order they were added,
+    /// with an index by out point and an index by value for coin selection.
+    /// Spending a UTXO flips its slot state with an atomic compare-and-swap
+    /// while holding a shared lock, so several sender threads can reserve
+    /// inputs at the same time. Spent slots stay in the slab until they
+    /// outnumber the unspent ones, when the slab is compacted. Compaction
+    /// also drops reserved slots, which \ref release adds back.
+    class utxo_store {
+      public:
+        utxo_store() = default;
+        ~utxo_store() = default;
+
+        utxo_store(const utxo_store&) = delete;
+        auto operator=(const utxo_store&) -> utxo_store& = delete;
+        utxo_store(utxo_store&&) = delete;
+        auto operator=(utxo_store&&) -> utxo_store& = delete;
+
+        /// Adds a spendable UTXO.
+        /// \param utxo UTXO to add.
+        /// \return false if the UTXO is already in the store and unspent.
+        auto add(const input& utxo) -> bool;
+
+        /// Marks a UTXO as spent.
+        /// \param op out point of the UTXO to spend.
+        /// \return true if the UTXO was in the store and unspent.
+        auto spend(const out_point& op) -> bool;
+
+        /// Reserves the given number of UTXOs, oldest first, by marking
+        /// them spent.
+        /// \param n number of UTXOs to reserve.
+        /// \return the reserved UTXOs, or std::nullopt if fewer than n
+        ///         UTXOs are unspent, in which case none are reserved.
+        auto reserve_oldest(size_t n) -> std::optional<std::vector<input>>;
+
+        /// Reserves UTXOs whose values add up to at least the given amount,
+        /// by marking them spent. Prefers the single smallest UTXO that
+        /// covers the amount, otherwise takes the largest UTXOs first.
+        /// \param amount minimum total value to reserve.
+        /// \return the reserved UTXOs, or std::nullopt if the unspent UTXOs
+        ///         do not cover the amount, in which case none are reserved.
+        auto reserve_amount(uint64_t amount)
+            -> std::optional<std::vector<input>>;
+
+        /// Marks reserved UTXOs as unspent again. Reserved UTXOs whose
+        /// slots were reclaimed by compaction are added back.
+        /// \param utxos UTXOs returned by \ref reserve_oldest or
+        ///              \ref reserve_amount.
+        void release(const std::vector<input>& utxos);
+
+        /// Returns the total value of the unspent UTXOs.
+        /// \return balance.
+        [[nodiscard]] auto balance() const -> uint64_t;
+
+        /// Returns the number of unspent UTXOs.
+        /// \return UTXO count.
+        [[nodiscard]] auto size() const -> size_t;
+
+        /// Returns the unspent UTXOs, oldest first.
+        /// \return unspent UTXOs.
+        [[nodiscard]] auto utxos() const -> std::vector<input>;
+
+        /// Removes all UTXOs from the store.
+        void clear();
+
+      private:
+        struct out_point_hasher {
+            auto operator()(const out_point& op) const noexcept -> size_t;
+        };
+
+        static constexpr uint8_t slot_unspent{0};
+        static constexpr uint8_t slot_spent{1};
+
+        /// Spent slots are only reclaimed once there are at least this many.
+        static constexpr size_t min_compact_slots{1024};
+
+        /// Locked exclusively to add, release or compact slots, and shared
+        /// to reserve or spend them.
+        mutable std::shared_mutex m_mut;
+        std::vector<input> m_slab;
+        /// Slot states, only accessed through std::atomic_ref.
+        mutable std::vector<uint8_t> m_states;
+        std::unordered_map<out_point, size_t, out_point_hasher> m_index;
+        std::set<std::pair<uint64_t, size_t>> m_by_value;
+
+        /// Every slot before this one is spent.
+        std::atomic<size_t> m_oldest{0};
+        std::atomic<uint64_t> m_balance{0};
+        std::atomic<size_t> m_count{0};
+
+        /// Adds an unspent slot for the UTXO. Requires an exclusive lock on
+        /// m_mut.
+        void append(const input& utxo);
+
+        /// Marks the slot spent if it is unspent. Requires m_mut.
+        auto try_reserve(size_t slot) -> bool;
+
+        /// Compacts the slab if the spent slots outnumber the unspent ones.
+        /// Requires an exclusive lock on m_mut.
+        void maybe_compact();
+
+        /// Compacts the slab without blocking if another thread holds m_mut.
+        void try_compact();
+    };
+}
+
+#endif // OPENCBDC_TX_SRC_TRANSACTION_UTXO_STORE_H_
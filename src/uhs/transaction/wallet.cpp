@@ -11,9 +11,47 @@
 #include "util/serialization/istream_serializer.hpp"
 #include "util/serialization/ostream_serializer.hpp"
 
+#include <filesystem>
 #include <secp256k1_schnorrsig.h>
+#include <thread>
 
 namespace cbdc {
+    namespace {
+        // Minimum amount of signing work to hand to each thread. Smaller
+        // jobs are signed on the calling thread, as starting a thread costs
+        // about as much as a signature.
+        constexpr size_t min_inputs_per_thread{64};
+        constexpr size_t min_txs_per_thread{32};
+
+        // Calls fn(begin, end) over contiguous chunks of [0, n) of at least
+        // min_chunk items each, on up to one thread per core. The calling
+        // thread handles the first chunk.
+        template<typename F>
+        void parallel_for(size_t n, size_t min_chunk, const F& fn) {
+            const auto n_threads = std::min(
+                static_cast<size_t>(
+                    std::max(std::thread::hardware_concurrency(), 1U)),
+                n / min_chunk);
+            if(n_threads <= 1) {
+                fn(0, n);
+                return;
+            }
+            const auto chunk = (n + n_threads - 1) / n_threads;
+            auto threads = std::vector<std::thread>();
+            threads.reserve(n_threads - 1);
+            for(size_t begin = chunk; begin < n; begin += chunk) {
+                const auto end = std::min(n, begin + chunk);
+                threads.emplace_back([&fn, begin, end]() {
+                    fn(begin, end);
+                });
+            }
+            fn(0, chunk);
+            for(auto& thread : threads) {
+                thread.join();
+            }
+        }
+    }
+
     transaction::wallet::wallet() {
         auto seed = std::chrono::high_resolution_clock::now()
                         .time_since_epoch()
@@ -47,7 +85,7 @@ namespace cbdc {
                                       const pubkey_t& payee,
                                       bool sign_tx)
         -> std::optional<transaction::full_tx> {
-        auto maybe_tx = accumulate_inputs(amount);
+        auto maybe_tx = reserve_inputs(0, amount);
         if(!maybe_tx.has_value()) {
             return std::nullopt;
         }
@@ -142,42 +180,88 @@ namespace cbdc {
         for(auto&& b : seckey) {
             b = keygen(*m_random_source);
         }
-        pubkey_t ret = pubkey_from_privkey(seckey, m_secp.get());
+
+        // Derive the public key from the keypair so the keypair can be
+        // cached for signing without computing it again
+        auto key = signing_key();
+        [[maybe_unused]] const auto create_ret
+            = secp256k1_keypair_create(m_secp.get(),
+                                       &key.m_keypair,
+                                       seckey.data());
+        assert(create_ret == 1);
+        secp256k1_xonly_pubkey xpub{};
+        [[maybe_unused]] const auto xonly_ret
+            = secp256k1_keypair_xonly_pub(m_secp.get(),
+                                          &xpub,
+                                          nullptr,
+                                          &key.m_keypair);
+        assert(xonly_ret == 1);
+        [[maybe_unused]] const auto ser_ret
+            = secp256k1_xonly_pubkey_serialize(m_secp.get(),
+                                               key.m_pubkey.data(),
+                                               &xpub);
+        assert(ser_ret == 1);
+
+        const auto ret = key.m_pubkey;
+        const auto witness_commitment
+            = transaction::validation::get_p2pk_witness_commitment(ret);
         {
             std::unique_lock<std::shared_mutex> lg(m_keys_mut);
-            m_pubkeys.push_back(ret);
-            m_keys.insert({ret, seckey});
-            m_witness_programs.insert(
-                {transaction::validation::get_p2pk_witness_commitment(ret),
-                 ret});
+            add_key_locked(ret, seckey);
+        }
+        {
+            std::unique_lock<std::shared_mutex> lg(m_signing_keys_mut);
+            m_signing_keys.emplace(witness_commitment, key);
         }
+        journal({std::make_pair(ret, seckey)});
 
         return ret;
     }
 
     void transaction::wallet::sign(transaction::full_tx& tx) const {
+        sign_tx(tx, true);
+    }
+
+    void
+    transaction::wallet::sign(std::vector<transaction::full_tx>& txs) const {
+        parallel_for(txs.size(), min_txs_per_thread, [&](size_t b, size_t e) {
+            for(size_t i = b; i < e; i++) {
+                sign_tx(txs[i], false);
+            }
+        });
+    }
+
+    void transaction::wallet::sign_tx(transaction::full_tx& tx,
+                                      bool parallel) const {
         // TODO: other sighash types besides SIGHASH_ALL?
         const auto sighash = transaction::tx_id(tx);
         tx.m_witness.resize(tx.m_inputs.size());
 
+        // Look up each distinct key once, rather than once per input
+        std::unordered_map<hash_t,
+                           std::optional<signing_key>,
+                           hashing::const_sip_hash<hash_t>>
+            keys;
+        auto input_keys = std::vector<const signing_key*>(tx.m_inputs.size());
         for(size_t i = 0; i < tx.m_inputs.size(); i++) {
             const auto& wit_commit
                 = tx.m_inputs[i].m_prevout_data.m_witness_program_commitment;
-
-            privkey_t seckey{};
-            pubkey_t pubkey{};
-            bool key_ours = false;
-            {
-                std::shared_lock<std::shared_mutex> sl(m_keys_mut);
-                const auto wit_prog = m_witness_programs.find(wit_commit);
-                key_ours = wit_prog != m_witness_programs.end();
-                if(key_ours) {
-                    pubkey = wit_prog->second;
-                    seckey = m_keys.at(pubkey);
-                }
+            auto it = keys.find(wit_commit);
+            if(it == keys.end()) {
+                it = keys.emplace(wit_commit, get_signing_key(wit_commit))
+                         .first;
             }
+            if(it->second.has_value()) {
+                input_keys[i] = &it->second.value();
+            }
+        }
 
-            if(key_ours) {
+        auto sign_inputs = [&](size_t begin, size_t end) {
+            for(size_t i = begin; i < end; i++) {
+                const auto* key = input_keys[i];
+                if(key == nullptr) {
+                    continue;
+                }
                 auto& sig = tx.m_witness[i];
                 sig.resize(transaction::validation::p2pk_witness_len);
                 sig[0] = std::byte(
@@ -185,22 +269,15 @@ namespace cbdc {
                 std::memcpy(
                     &sig[sizeof(
                         transaction::validation::witness_program_type)],
-                    pubkey.data(),
-                    pubkey.size());
-
-                secp256k1_keypair keypair{};
-                [[maybe_unused]] const auto ret
-                    = secp256k1_keypair_create(m_secp.get(),
-                                               &keypair,
-                                               seckey.data());
-                assert(ret == 1);
+                    key->m_pubkey.data(),
+                    key->m_pubkey.size());
 
                 std::array<unsigned char, sig_len> sig_arr{};
                 [[maybe_unused]] const auto sign_ret
                     = secp256k1_schnorrsig_sign(m_secp.get(),
                                                 sig_arr.data(),
                                                 sighash.data(),
-                                                &keypair,
+                                                &key->m_keypair,
                                                 nullptr,
                                                 nullptr);
                 std::memcpy(
@@ -209,28 +286,82 @@ namespace cbdc {
                     sizeof(sig_arr));
                 assert(sign_ret == 1);
             }
+        };
+
+        if(parallel) {
+            parallel_for(tx.m_inputs.size(),
+                         min_inputs_per_thread,
+                         sign_inputs);
+        } else {
+            sign_inputs(0, tx.m_inputs.size());
         }
     }
 
+    auto transaction::wallet::get_signing_key(
+        const hash_t& witness_commitment) const
+        -> std::optional<signing_key> {
+        {
+            std::shared_lock<std::shared_mutex> sl(m_signing_keys_mut);
+            const auto it = m_signing_keys.find(witness_commitment);
+            if(it != m_signing_keys.end()) {
+                return it->second;
+            }
+        }
+
+        privkey_t seckey{};
+        auto key = signing_key();
+        {
+            std::shared_lock<std::shared_mutex> sl(m_keys_mut);
+            const auto wit_prog = m_witness_programs.find(witness_commitment);
+            if(wit_prog == m_witness_programs.end()) {
+                return std::nullopt;
+            }
+            key.m_pubkey = wit_prog->second;
+            seckey = m_keys.at(key.m_pubkey);
+        }
+
+        [[maybe_unused]] const auto ret
+            = secp256k1_keypair_create(m_secp.get(),
+                                       &key.m_keypair,
+                                       seckey.data());
+        assert(ret == 1);
+
+        {
+            std::unique_lock<std::shared_mutex> ul(m_signing_keys_mut);
+            m_signing_keys.emplace(witness_commitment, key);
+        }
+        return key;
+    }
+
+    auto transaction::wallet::add_key_locked(const pubkey_t& pubkey,
+                                             const privkey_t& privkey)
+        -> bool {
+        if(!m_keys.insert({pubkey, privkey}).second) {
+            return false;
+        }
+        m_pubkeys.push_back(pubkey);
+        m_witness_programs.insert(
+            {transaction::validation::get_p2pk_witness_commitment(pubkey),
+             pubkey});
+        return true;
+    }
+
     void transaction::wallet::update_balance(
         const std::vector<transaction::input>& credits,
         const std::vector<transaction::input>& debits) {
-        std::unique_lock<std::shared_mutex> lu(m_utxos_mut);
+        auto records = std::vector<journal_record>();
         for(const auto& inp : credits) {
-            const auto added = m_utxos_set.insert(inp);
-            if(added.second) {
-                m_balance += inp.m_prevout_data.m_value;
-                m_spend_queue.push_back(inp);
+            if(m_utxos.add(inp)) {
+                records.emplace_back(inp);
             }
         }
 
         for(const auto& inp : debits) {
-            const auto erased = m_utxos_set.erase(inp) > 0;
-            if(erased) {
-                m_balance -= inp.m_prevout_data.m_value;
+            if(m_utxos.spend(inp.m_prevout)) {
+                records.emplace_back(inp.m_prevout);
             }
         }
-        assert(m_spend_queue.size() == m_utxos_set.size());
+        journal(records);
     }
 
     auto transaction::wallet::seed(const privkey_t& privkey,
@@ -249,10 +380,9 @@ namespace cbdc {
             if(!m_keys.empty()) {
                 return false;
             }
-            m_pubkeys.push_back(pubkey);
-            m_keys.insert({pubkey, privkey});
-            m_witness_programs.insert({witness_commitment, pubkey});
+            add_key_locked(pubkey, privkey);
         }
+        journal({std::make_pair(pubkey, privkey)});
         seed_readonly(witness_commitment, value, begin_seed, end_seed);
         return true;
     }
@@ -261,6 +391,7 @@ namespace cbdc {
                                             uint32_t value,
                                             size_t begin_seed,
                                             size_t end_seed) {
+        std::unique_lock<std::mutex> l(m_seed_mut);
         m_seed_from = begin_seed;
         m_seed_to = end_seed;
         m_seed_value = value;
@@ -286,9 +417,9 @@ namespace cbdc {
     }
 
     auto transaction::wallet::balance() const -> uint64_t {
-        std::shared_lock<std::shared_mutex> lg(m_utxos_mut);
+        std::unique_lock<std::mutex> l(m_seed_mut);
         // TODO: handle overflow
-        auto balance = m_balance;
+        auto balance = m_utxos.balance();
         if(m_seed_from != m_seed_to) {
             balance += (m_seed_to - m_seed_from) * m_seed_value;
         }
@@ -296,8 +427,8 @@ namespace cbdc {
     }
 
     auto transaction::wallet::count() const -> size_t {
-        std::shared_lock<std::shared_mutex> lg(m_utxos_mut);
-        auto size = m_utxos_set.size();
+        std::unique_lock<std::mutex> l(m_seed_mut);
+        auto size = m_utxos.size();
         if(m_seed_from != m_seed_to) {
             size += (m_seed_to - m_seed_from);
         }
@@ -320,10 +451,9 @@ namespace cbdc {
             ser << m_keys;
         }
 
-        {
-            std::shared_lock<std::shared_mutex> lu(m_utxos_mut);
-            ser << m_utxos_set;
-        }
+        // Written in the same format as the ordered set of UTXOs older
+        // wallet files hold, so both can be loaded
+        ser << m_utxos.utxos();
     }
 
     void transaction::wallet::load(const std::string& wallet_file) {
@@ -337,90 +467,178 @@ namespace cbdc {
                 m_pubkeys.clear();
                 m_witness_programs.clear();
 
-                deser >> m_keys;
-                for(const auto& k : m_keys) {
-                    m_pubkeys.push_back(k.first);
-                    m_witness_programs.insert(
-                        {transaction::validation::get_p2pk_witness_commitment(
-                             k.first),
-                         k.first});
+                auto keys = decltype(m_keys)();
+                deser >> keys;
+                for(const auto& [pubkey, privkey] : keys) {
+                    add_key_locked(pubkey, privkey);
                 }
             }
 
             {
-                std::unique_lock<std::shared_mutex> lu(m_utxos_mut);
-
-                m_utxos_set.clear();
-                m_spend_queue.clear();
-                m_balance = 0;
+                std::unique_lock<std::shared_mutex> lk(m_signing_keys_mut);
+                m_signing_keys.clear();
+            }
 
-                deser >> m_utxos_set;
-                for(const auto& utxo : m_utxos_set) {
-                    m_balance += utxo.m_prevout_data.m_value;
-                    m_spend_queue.push_back(utxo);
-                }
+            auto utxos = std::vector<transaction::input>();
+            deser >> utxos;
+            m_utxos.clear();
+            for(const auto& utxo : utxos) {
+                m_utxos.add(utxo);
             }
         }
     }
 
-    auto transaction::wallet::send_to(size_t input_count,
-                                      size_t output_count,
-                                      const pubkey_t& payee,
-                                      bool sign_tx)
-        -> std::optional<transaction::full_tx> {
-        assert(input_count > 0);
-        assert(output_count > 0);
+    auto transaction::wallet::open(const std::string& wallet_file) -> bool {
+        std::unique_lock<std::mutex> l(m_journal_mut);
+        m_journal.close();
+        m_wallet_file.clear();
+        m_journal_records = 0;
 
-        // TODO: handle overflow with large output values.
-        uint64_t total_amount = 0;
-        transaction::full_tx ret;
-        uint64_t output_val{};
+        load(wallet_file);
 
+        // Replay the journal on top of the snapshot. Every record can be
+        // applied more than once, so records already in the snapshot from
+        // an interrupted compaction are harmless.
+        const auto journal_file = wallet_file + ".journal";
+        std::streamoff good_size{0};
         {
-            std::unique_lock<std::shared_mutex> ul(m_utxos_mut);
-            if((m_utxos_set.size() + m_seed_to - m_seed_from) < input_count) {
-                return std::nullopt;
-            }
-
-            ret.m_inputs.reserve(input_count);
-
-            size_t seeded_inputs = 0;
-            while(m_seed_from != m_seed_to
-                  && ret.m_inputs.size() < input_count) {
-                auto seed_utxo = create_seeded_input(m_seed_from);
-                if(!seed_utxo) {
+            std::ifstream in(journal_file, std::ios::binary | std::ios::in);
+            auto deser = istream_serializer(in);
+            while(in.good()) {
+                uint8_t idx{};
+                if(!(deser >> idx)) {
+                    break;
+                }
+                if(idx == 0) {
+                    auto key = std::pair<pubkey_t, privkey_t>();
+                    if(!(deser >> key)) {
+                        break;
+                    }
+                    std::unique_lock<std::shared_mutex> lk(m_keys_mut);
+                    add_key_locked(key.first, key.second);
+                } else if(idx == 1) {
+                    auto utxo = transaction::input();
+                    if(!(deser >> utxo)) {
+                        break;
+                    }
+                    m_utxos.add(utxo);
+                } else if(idx == 2) {
+                    auto op = transaction::out_point();
+                    if(!(deser >> op)) {
+                        break;
+                    }
+                    m_utxos.spend(op);
+                } else {
                     break;
                 }
-                ret.m_inputs.push_back(seed_utxo.value());
-                ret.m_witness.emplace_back(sig_len, std::byte(0));
-                total_amount += m_seed_value;
-                m_seed_from++;
-                seeded_inputs++;
+                good_size = in.tellg();
+                m_journal_records++;
             }
+        }
 
-            for(auto utxo = m_spend_queue.begin();
-                (utxo != m_spend_queue.end())
-                && (ret.m_inputs.size() < input_count);
-                utxo++) {
-                ret.m_inputs.push_back(*utxo);
-                total_amount += utxo->m_prevout_data.m_value;
+        // Drop a record torn by a crash part way through writing it
+        auto ec = std::error_code();
+        const auto journal_size = std::filesystem::file_size(journal_file, ec);
+        if(!ec && journal_size > static_cast<uintmax_t>(good_size)) {
+            std::filesystem::resize_file(journal_file,
+                                         static_cast<uintmax_t>(good_size),
+                                         ec);
+            if(ec) {
+                return false;
             }
+        }
 
-            output_val = total_amount / output_count;
-            if(output_val == 0 && output_count > 1) {
-                // Caller asked for more outputs than we can make with the
-                // amount of coins we have.
-                m_seed_from -= seeded_inputs;
-                return std::nullopt;
-            }
+        m_journal.open(journal_file,
+                       std::ios::binary | std::ios::out | std::ios::app);
+        if(!m_journal.good()) {
+            m_journal.close();
+            return false;
+        }
+        m_wallet_file = wallet_file;
+        return true;
+    }
+
+    auto transaction::wallet::compact() -> bool {
+        std::unique_lock<std::mutex> l(m_journal_mut);
+        return compact_locked();
+    }
+
+    auto transaction::wallet::compact_locked() -> bool {
+        if(!m_journal.is_open()) {
+            return false;
+        }
 
-            for(size_t i = seeded_inputs; i < ret.m_inputs.size(); i++) {
-                auto& inp = ret.m_inputs[i];
-                m_balance -= inp.m_prevout_data.m_value;
-                m_utxos_set.erase(inp);
-                m_spend_queue.pop_front();
+        // Write the snapshot beside the wallet file and move it into place,
+        // so a crash leaves either the old or the new snapshot intact
+        const auto tmp_file = m_wallet_file + ".tmp";
+        {
+            std::ofstream wal_file(tmp_file,
+                                   std::ios::binary | std::ios::trunc
+                                       | std::ios::out);
+            auto ser = ostream_serializer(wal_file);
+            {
+                std::shared_lock<std::shared_mutex> lk(m_keys_mut);
+                ser << m_keys;
             }
+            ser << m_utxos.utxos();
+            wal_file.flush();
+            if(!wal_file.good()) {
+                return false;
+            }
+        }
+        auto ec = std::error_code();
+        std::filesystem::rename(tmp_file, m_wallet_file, ec);
+        if(ec) {
+            return false;
+        }
+
+        m_journal.close();
+        m_journal.open(m_wallet_file + ".journal",
+                       std::ios::binary | std::ios::out | std::ios::trunc);
+        m_journal_records = 0;
+        return m_journal.good();
+    }
+
+    void transaction::wallet::journal(
+        const std::vector<journal_record>& records) {
+        if(records.empty()) {
+            return;
+        }
+        std::unique_lock<std::mutex> l(m_journal_mut);
+        if(!m_journal.is_open()) {
+            return;
+        }
+        auto ser = ostream_serializer(m_journal);
+        for(const auto& record : records) {
+            ser << record;
+        }
+        m_journal.flush();
+        m_journal_records += records.size();
+        if(m_journal_records
+           >= std::max(min_compact_records, 2 * m_utxos.size())) {
+            compact_locked();
         }
+    }
+
+    auto transaction::wallet::send_to(size_t input_count,
+                                      size_t output_count,
+                                      const pubkey_t& payee,
+                                      bool sign_tx)
+        -> std::optional<transaction::full_tx> {
+        assert(input_count > 0);
+        assert(output_count > 0);
+
+        // Each output needs a non-zero value unless there is only one
+        auto maybe_tx
+            = reserve_inputs(input_count, output_count > 1 ? output_count : 0);
+        if(!maybe_tx.has_value()) {
+            return std::nullopt;
+        }
+
+        // TODO: handle overflow with large output values.
+        auto& ret = maybe_tx.value().first;
+        auto total_amount = maybe_tx.value().second;
+        const auto output_val = total_amount / output_count;
 
         auto wit_comm
             = transaction::validation::get_p2pk_witness_commitment(payee);
@@ -457,7 +675,7 @@ namespace cbdc {
                                   bool sign_tx)
         -> std::optional<transaction::full_tx> {
         const uint64_t amount = output_count * value;
-        auto maybe_tx = accumulate_inputs(amount);
+        auto maybe_tx = reserve_inputs(0, amount);
         if(!maybe_tx.has_value()) {
             return std::nullopt;
         }
@@ -491,45 +709,68 @@ namespace cbdc {
         return ret;
     }
 
-    auto transaction::wallet::accumulate_inputs(uint64_t amount)
+    auto transaction::wallet::reserve_inputs(size_t input_count,
+                                             uint64_t amount)
         -> std::optional<std::pair<full_tx, uint64_t>> {
         uint64_t total_amount = 0;
         auto ret = full_tx();
-        {
-            std::unique_lock<std::shared_mutex> ul(m_utxos_mut);
-            size_t seeded_inputs = 0;
-            while(m_seed_from != m_seed_to && total_amount < amount) {
-                auto seed_utxo = create_seeded_input(m_seed_from);
-                if(!seed_utxo) {
-                    break;
-                }
-                ret.m_inputs.push_back(seed_utxo.value());
-                ret.m_witness.emplace_back(sig_len, std::byte(0));
-                total_amount += m_seed_value;
-                m_seed_from++;
-                seeded_inputs++;
+        ret.m_inputs.reserve(input_count);
+
+        // Hold on to the seeded range while reserving UTXOs only if seeded
+        // inputs were taken, so they can be given back on failure
+        std::unique_lock<std::mutex> sl(m_seed_mut);
+        size_t seeded_inputs = 0;
+        while(m_seed_from != m_seed_to
+              && (input_count > 0 ? ret.m_inputs.size() < input_count
+                                  : total_amount < amount)) {
+            auto seed_utxo = create_seeded_input(m_seed_from);
+            if(!seed_utxo) {
+                break;
             }
+            ret.m_inputs.push_back(seed_utxo.value());
+            total_amount += m_seed_value;
+            m_seed_from++;
+            seeded_inputs++;
+        }
+        if(seeded_inputs == 0) {
+            sl.unlock();
+        }
 
-            auto utxo = m_spend_queue.begin();
-            while((total_amount < amount) && (utxo != m_spend_queue.end())) {
-                ret.m_inputs.push_back(*utxo);
-                ret.m_witness.emplace_back(sig_len, std::byte(0));
-                total_amount += utxo->m_prevout_data.m_value;
-                std::advance(utxo, 1);
+        auto utxos = std::optional<std::vector<input>>();
+        if(input_count > 0) {
+            utxos = m_utxos.reserve_oldest(input_count - ret.m_inputs.size());
+        } else if(total_amount < amount) {
+            utxos = m_utxos.reserve_amount(amount - total_amount);
+        } else {
+            utxos.emplace();
+        }
+        if(utxos.has_value()) {
+            for(const auto& utxo : utxos.value()) {
+                total_amount += utxo.m_prevout_data.m_value;
             }
+        }
 
-            if(total_amount < amount) {
-                m_seed_from -= seeded_inputs;
-                return std::nullopt;
+        if(!utxos.has_value() || total_amount < amount) {
+            if(utxos.has_value()) {
+                m_utxos.release(utxos.value());
             }
+            m_seed_from -= seeded_inputs;
+            return std::nullopt;
+        }
+        if(sl.owns_lock()) {
+            sl.unlock();
+        }
 
-            for(size_t i = seeded_inputs; i < ret.m_inputs.size(); i++) {
-                const auto del_utxo = m_spend_queue.begin();
-                m_balance -= del_utxo->m_prevout_data.m_value;
-                m_utxos_set.erase(*del_utxo);
-                m_spend_queue.pop_front();
-            }
+        auto records = std::vector<journal_record>();
+        records.reserve(utxos->size());
+        for(auto& utxo : utxos.value()) {
+            records.emplace_back(utxo.m_prevout);
+            ret.m_inputs.push_back(std::move(utxo));
         }
+        ret.m_witness.resize(ret.m_inputs.size(),
+                             witness_t(sig_len, std::byte(0)));
+        journal(records);
+
         return {{ret, total_amount}};
     }
 
@@ -7,28 +7,30 @@
 #define OPENCBDC_TX_SRC_TRANSACTION_WALLET_H_
 
 #include "uhs/transaction/transaction.hpp"
+#include "uhs/transaction/utxo_store.hpp"
 #include "util/common/config.hpp"
 #include "util/common/hashmap.hpp"
 #include "util/common/random_source.hpp"
 
 #include <atomic>
 #include <fstream>
-#include <list>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <random>
 #include <secp256k1.h>
-#include <set>
+#include <secp256k1_extrakeys.h>
 #include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
+#include <variant>
 
 namespace cbdc::transaction {
     /// \brief Cryptographic wallet for digital currency assets and secrets.
     ///
     /// Stores unspent transaction outputs (UTXOs), and public/private key
-    /// pairs for Pay-to-Public-Key transaction attestations.
+    /// pairs for Pay-to-Public-Key transaction attestations. Several threads
+    /// may create transactions from the same wallet at once.
     class wallet {
       public:
         /// \brief Constructor.
@@ -169,9 +171,15 @@ namespace cbdc::transaction {
         void confirm_transaction(const full_tx& tx);
 
         /// Signs each of the transaction's inputs using Schnorr signatures.
+        /// Transactions with many inputs are signed on multiple threads.
         /// \param tx the transaction whose inputs to sign.
         void sign(full_tx& tx) const;
 
+        /// Signs each of the inputs of a batch of transactions. Large batches
+        /// are signed on multiple threads.
+        /// \param txs the transactions whose inputs to sign.
+        void sign(std::vector<full_tx>& txs) const;
+
         /// Checks if the input is spendable by the current wallet.
         /// \param in the input to check.
         auto is_spendable(const input& in) const -> bool;
@@ -194,6 +202,24 @@ namespace cbdc::transaction {
         /// \param wallet_file path to wallet file location.
         void load(const std::string& wallet_file);
 
+        /// \brief Loads the wallet and keeps it saved incrementally.
+        ///
+        /// Loads the wallet file, if it exists, and replays the journal
+        /// next to it, then appends every later change to the keys and
+        /// UTXOs to the journal. Once the journal holds more records than
+        /// twice the number of UTXOs, the wallet file is rewritten and the
+        /// journal emptied.
+        /// \param wallet_file path to wallet file location. The journal is
+        ///                    kept at the same path with a ".journal"
+        ///                    suffix.
+        /// \return false if the journal could not be opened.
+        auto open(const std::string& wallet_file) -> bool;
+
+        /// Rewrites the wallet file opened with \ref open and empties its
+        /// journal.
+        /// \return false if no wallet file is open or writing it failed.
+        auto compact() -> bool;
+
         /// \brief Creates a new transaction from seeded outputs.
         ///
         /// Creates a new transaction that receives a spendable input from the
@@ -212,30 +238,19 @@ namespace cbdc::transaction {
         void confirm_inputs(const std::vector<input>& credits);
 
       private:
-        struct cmp_input {
-            auto operator()(const input& lhs, const input& rhs) const -> bool {
-                // First sort by tx hash then output index
-                return std::tie(lhs.m_prevout.m_tx_id, lhs.m_prevout.m_index)
-                     < std::tie(rhs.m_prevout.m_tx_id, rhs.m_prevout.m_index);
-            }
-        };
+        /// Spendable inputs. Synchronizes itself.
+        utxo_store m_utxos;
 
-        /// Locks access to m_utxos and m_balance (the sum of the UTXOs).
-        /// \warning Do not lock simultaneously with m_keys_mut.
-        mutable std::shared_mutex m_utxos_mut;
-        uint64_t m_balance{0};
-        /// Stores the current set of spendable inputs.
-        std::set<input, cmp_input> m_utxos_set;
+        /// Locks access to the seeded output range.
+        mutable std::mutex m_seed_mut;
         size_t m_seed_from{0};
         size_t m_seed_to{0};
         uint32_t m_seed_value{0};
         hash_t m_seed_witness_commitment{0};
-        /// Queue of spendable inputs, oldest first.
-        std::list<input> m_spend_queue;
 
         /// Locks access to m_keys and related members m_pubkeys and
         /// m_witness_programs.
-        /// \warning Do not lock simultaneously with m_utxos_mut.
+        /// \warning Do not lock simultaneously with m_seed_mut.
         mutable std::shared_mutex m_keys_mut;
         std::unordered_map<pubkey_t,
                            privkey_t,
@@ -249,6 +264,38 @@ namespace cbdc::transaction {
         std::unordered_map<hash_t, pubkey_t, hashing::const_sip_hash<hash_t>>
             m_witness_programs;
 
+        /// Public key and precomputed secp256k1 keypair for signing inputs
+        /// locked to one of the wallet's witness programs.
+        struct signing_key {
+            pubkey_t m_pubkey;
+            secp256k1_keypair m_keypair;
+        };
+
+        /// Locks access to m_signing_keys.
+        /// \warning Do not lock simultaneously with m_keys_mut.
+        mutable std::shared_mutex m_signing_keys_mut;
+        /// Signing keys by witness program commitment, populated when keys
+        /// are generated or first used to sign, so each key's keypair is
+        /// only computed once.
+        mutable std::unordered_map<hash_t,
+                                   signing_key,
+                                   hashing::const_sip_hash<hash_t>>
+            m_signing_keys;
+
+        /// Returns the signing key for a witness program commitment,
+        /// computing and caching its keypair if necessary.
+        /// \param witness_commitment witness program commitment.
+        /// \return signing key, or std::nullopt if the witness program does
+        ///         not belong to this wallet.
+        auto get_signing_key(const hash_t& witness_commitment) const
+            -> std::optional<signing_key>;
+
+        /// Signs each of the transaction's inputs.
+        /// \param tx the transaction whose inputs to sign.
+        /// \param parallel true if the inputs may be signed on multiple
+        ///                 threads.
+        void sign_tx(full_tx& tx, bool parallel) const;
+
         /// Creates a new input from the seed set based on the parameters
         /// passed in a preceding call to the \ref seed function.
         /// \param seed_idx the index in the seed set to generate the input
@@ -265,6 +312,39 @@ namespace cbdc::transaction {
         static const inline auto m_random_source
             = std::make_unique<random_source>(config::random_source);
 
+        /// Journal record: a generated key pair, a UTXO added to the wallet
+        /// or the out point of a UTXO the wallet spent.
+        using journal_record
+            = std::variant<std::pair<pubkey_t, privkey_t>, input, out_point>;
+
+        /// The wallet file is only rewritten once the journal holds at least
+        /// this many records.
+        static constexpr size_t min_compact_records{4096};
+
+        /// Locks access to the journal and wallet file path.
+        /// \warning Do not lock while holding m_keys_mut.
+        std::mutex m_journal_mut;
+        std::string m_wallet_file;
+        std::ofstream m_journal;
+        size_t m_journal_records{0};
+
+        /// Appends records to the journal if one is open, compacting the
+        /// wallet file once the journal grows large enough.
+        /// \warning Do not call while holding m_keys_mut.
+        /// \param records records to append.
+        void journal(const std::vector<journal_record>& records);
+
+        /// Rewrites the wallet file and empties the journal.
+        /// Requires m_journal_mut.
+        /// \return false if writing the wallet file failed.
+        auto compact_locked() -> bool;
+
+        /// Adds a key pair to the wallet's keys.
+        /// Requires an exclusive lock on m_keys_mut.
+        /// \return false if the wallet already has the key.
+        auto add_key_locked(const pubkey_t& pubkey, const privkey_t& privkey)
+            -> bool;
+
         /// Given a set of credit inputs and a set of debits, add and remove
         /// respective the UTXOs and update the wallet's balance.
         /// \param credits the inputs to add to the wallet's set of UTXOs.
@@ -272,7 +352,18 @@ namespace cbdc::transaction {
         void update_balance(const std::vector<input>& credits,
                             const std::vector<input>& debits);
 
-        auto accumulate_inputs(uint64_t amount)
+        /// \brief Reserves inputs for a new transaction.
+        ///
+        /// Takes seeded inputs first, then the wallet's UTXOs, and records
+        /// the UTXOs as spent in the journal.
+        /// \param input_count number of inputs to reserve, or zero to reserve
+        ///                    inputs until their value covers the amount.
+        /// \param amount minimum total value of the reserved inputs.
+        /// \return transaction with the reserved inputs and placeholder
+        ///         witnesses, and the total value of the inputs, or
+        ///         std::nullopt if the wallet does not hold enough inputs,
+        ///         in which case none are reserved.
+        auto reserve_inputs(size_t input_count, uint64_t amount)
             -> std::optional<std::pair<full_tx, uint64_t>>;
     };
 }
@@ -23,7 +23,10 @@ namespace cbdc::coordinator {
           m_coordinator_id(coordinator_id),
           m_opts(std::move(opts)),
           m_logger(std::move(logger)),
-          m_state_machine(nuraft::cs_new<state_machine>(m_logger)),
+          m_state_machine(nuraft::cs_new<state_machine>(
+              m_logger,
+              "coordinator" + std::to_string(m_coordinator_id) + "_snps_"
+                  + std::to_string(m_node_id))),
           m_shard_endpoints(m_opts.m_locking_shard_endpoints),
           m_shard_ranges(m_opts.m_shard_ranges),
           m_batch_size(m_opts.m_batch_size),
@@ -34,7 +37,8 @@ namespace cbdc::coordinator {
             = static_cast<int>(m_opts.m_election_timeout_upper);
         m_raft_params.heart_beat_interval_
             = static_cast<int>(m_opts.m_heartbeat);
-        m_raft_params.snapshot_distance_ = 0; // TODO: implement snapshots
+        m_raft_params.snapshot_distance_
+            = static_cast<int>(m_opts.m_snapshot_distance);
         m_raft_params.max_append_size_
             = static_cast<int>(m_opts.m_raft_max_batch);
     }
@@ -94,7 +98,8 @@ namespace cbdc::coordinator {
             [&](auto&& res, auto&& err) {
                 return raft_callback(std::forward<decltype(res)>(res),
                                      std::forward<decltype(err)>(err));
-            });
+            },
+            m_opts.m_raft_log_store);
 
         // Thread to handle starting and stopping the message handler and dtx
         // batch processing threads when triggered by the raft callback
@@ -491,7 +496,8 @@ namespace cbdc::coordinator {
             auto s = std::make_shared<locking_shard::rpc::client>(
                 m_shard_endpoints[i],
                 m_shard_ranges[i],
-                *m_logger);
+                *m_logger,
+                std::chrono::microseconds(m_opts.m_rpc_coalesce_window));
             if(!s->init()) {
                 m_logger->fatal("Failed to initialize shard client");
             }
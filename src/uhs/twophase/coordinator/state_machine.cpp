@@ -8,9 +8,82 @@
 #include "controller.hpp"
 #include "format.hpp"
 #include "util/raft/serialization.hpp"
+#include "util/serialization/format.hpp"
 #include "util/serialization/util.hpp"
 
+#include <limits>
+
 namespace cbdc::coordinator {
+    namespace {
+        using dtx_map_type
+            = decltype(state_machine::coordinator_state::m_prepare_txs);
+
+        // The dtx data buffers have no length prefix in the state returned
+        // to the controller, so snapshots prefix each buffer with its size
+        auto write_dtxs(serializer& ser, const dtx_map_type& dtxs) -> bool {
+            if(!(ser << static_cast<uint64_t>(dtxs.size()))) {
+                return false;
+            }
+            for(const auto& [dtx_id, buf] : dtxs) {
+                if(!(ser << dtx_id << static_cast<uint64_t>(buf->size()))
+                   || !ser.write(buf->data_begin(), buf->size())) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        auto read_dtxs(serializer& deser, dtx_map_type& dtxs) -> bool {
+            uint64_t count{};
+            if(!(deser >> count)) {
+                return false;
+            }
+            dtxs.clear();
+            dtxs.reserve(count);
+            for(uint64_t i{0}; i < count; i++) {
+                auto dtx_id = hash_t();
+                uint64_t sz{};
+                if(!(deser >> dtx_id >> sz)) {
+                    return false;
+                }
+                auto buf = nuraft::buffer::alloc(sz);
+                if(!deser.read(buf->data_begin(), sz)) {
+                    return false;
+                }
+                dtxs.emplace(dtx_id, std::move(buf));
+            }
+            return true;
+        }
+    }
+
+    state_machine::state_machine(std::shared_ptr<logging::log> logger,
+                                 std::string snapshot_dir)
+        : m_logger(std::move(logger)),
+          m_snapshots(std::move(snapshot_dir), m_logger) {
+        const auto snp_idx = m_snapshots.latest_idx();
+        if(snp_idx.has_value()) {
+            auto snp = read_snapshot(*snp_idx, &m_state);
+            if(!snp) {
+                m_logger->fatal("Failed to read snapshot", *snp_idx);
+            }
+            m_last_committed_idx = snp->get_last_log_idx();
+            m_snapshot = std::move(snp);
+            m_logger->info("Restored snapshot",
+                           *snp_idx,
+                           "with",
+                           m_state.m_prepare_txs.size()
+                               + m_state.m_commit_txs.size()
+                               + m_state.m_discard_txs.size(),
+                           "dtxs");
+        }
+    }
+
+    state_machine::~state_machine() {
+        if(m_snapshot_thread.joinable()) {
+            m_snapshot_thread.join();
+        }
+    }
+
     auto state_machine::commit(uint64_t log_idx, nuraft::buffer& data)
         -> nuraft::ptr<nuraft::buffer> {
         assert(log_idx == m_last_committed_idx + 1);
@@ -98,13 +171,50 @@ namespace cbdc::coordinator {
         m_last_committed_idx = log_idx;
     }
 
-    auto state_machine::apply_snapshot(nuraft::snapshot& /* s */) -> bool {
-        // TODO: implement snapshots (cf. #768)
-        return false;
+    auto
+    state_machine::read_logical_snp_obj(nuraft::snapshot& s,
+                                        void*& /* user_snp_ctx */,
+                                        nuraft::ulong obj_id,
+                                        nuraft::ptr<nuraft::buffer>& data_out,
+                                        bool& is_last_obj) -> int {
+        return m_snapshots.read_obj(s.get_last_log_idx(),
+                                    obj_id,
+                                    std::numeric_limits<uint64_t>::max(),
+                                    data_out,
+                                    is_last_obj);
+    }
+
+    void state_machine::save_logical_snp_obj(nuraft::snapshot& s,
+                                             nuraft::ulong& obj_id,
+                                             nuraft::buffer& data,
+                                             bool is_first_obj,
+                                             bool is_last_obj) {
+        m_snapshots.save_obj(s.get_last_log_idx(),
+                             data,
+                             is_first_obj,
+                             is_last_obj);
+        obj_id++;
+    }
+
+    auto state_machine::apply_snapshot(nuraft::snapshot& s) -> bool {
+        auto state = coordinator_state();
+        auto snp = read_snapshot(s.get_last_log_idx(), &state);
+        if(!snp) {
+            return false;
+        }
+
+        m_state = std::move(state);
+        m_last_committed_idx = snp->get_last_log_idx();
+        {
+            std::unique_lock<std::shared_mutex> l(m_snapshots_mut);
+            m_snapshot = std::move(snp);
+        }
+        return true;
     }
 
     auto state_machine::last_snapshot() -> nuraft::ptr<nuraft::snapshot> {
-        return nullptr;
+        std::shared_lock<std::shared_mutex> l(m_snapshots_mut);
+        return m_snapshot;
     }
 
     auto state_machine::last_commit_index() -> uint64_t {
@@ -112,13 +222,62 @@ namespace cbdc::coordinator {
     }
 
     void state_machine::create_snapshot(
-        nuraft::snapshot& /* s */,
+        nuraft::snapshot& s,
         nuraft::async_result<bool>::handler_type& when_done) {
-        bool res{false};
-        auto snp = nuraft::ptr<std::exception>();
-        when_done(res, snp);
+        assert(s.get_last_log_idx() == last_commit_index());
+
+        // NuRaft does not start a new snapshot until the previous one calls
+        // when_done, so this only waits for the thread to exit
+        if(m_snapshot_thread.joinable()) {
+            m_snapshot_thread.join();
+        }
+
+        // Committed dtx data buffers are never modified so the copy can
+        // share them with the live state
+        auto state = m_state;
+        auto snp_buf = s.serialize();
+        auto snp = nuraft::snapshot::deserialize(*snp_buf);
+        m_snapshot_thread = std::thread(
+            [this,
+             snp = std::move(snp),
+             state = std::move(state),
+             when_done]() mutable {
+                write_snapshot(std::move(snp), std::move(state));
+                nuraft::ptr<std::exception> except(nullptr);
+                bool ret = true;
+                when_done(ret, except);
+            });
     }
 
-    state_machine::state_machine(std::shared_ptr<logging::log> logger)
-        : m_logger(std::move(logger)) {}
+    void state_machine::write_snapshot(nuraft::ptr<nuraft::snapshot> snp,
+                                       coordinator_state state) {
+        const auto idx = snp->get_last_log_idx();
+
+        m_snapshots.write(*snp, [&](serializer& ser) {
+            return write_dtxs(ser, state.m_prepare_txs)
+                && write_dtxs(ser, state.m_commit_txs)
+                && static_cast<bool>(ser << state.m_discard_txs);
+        });
+        {
+            std::unique_lock<std::shared_mutex> l(m_snapshots_mut);
+            m_snapshot = std::move(snp);
+        }
+
+        m_logger->info("Wrote snapshot",
+                       idx,
+                       "with",
+                       state.m_prepare_txs.size() + state.m_commit_txs.size()
+                           + state.m_discard_txs.size(),
+                       "dtxs");
+    }
+
+    auto state_machine::read_snapshot(uint64_t idx, coordinator_state* state)
+        -> nuraft::ptr<nuraft::snapshot> {
+        return m_snapshots.read(idx, [&](serializer& deser) {
+            return state == nullptr
+                || (read_dtxs(deser, state->m_prepare_txs)
+                    && read_dtxs(deser, state->m_commit_txs)
+                    && static_cast<bool>(deser >> state->m_discard_txs));
+        });
+    }
 }
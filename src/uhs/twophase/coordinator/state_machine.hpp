@@ -8,8 +8,11 @@
 
 #include "util/common/hashmap.hpp"
 #include "util/common/logging.hpp"
+#include "util/raft/snapshot_store.hpp"
 
 #include <libnuraft/nuraft.hxx>
+#include <shared_mutex>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -18,13 +21,29 @@ namespace cbdc::coordinator {
     ///
     /// Contains a \ref coordinator_state and the last-committed index.
     /// Accepts requests to manage and query distributed transactions.
+    ///
+    /// Snapshots hold only the dtxs in flight when they are taken, so they
+    /// stay small regardless of how many dtxs the coordinator has
+    /// processed. Restoring a snapshot and replaying the log entries after
+    /// it bounds recovery time by the number of in-flight dtxs rather than
+    /// the length of the log.
     class state_machine final : public nuraft::state_machine {
       public:
         /// Constructor.
-        /// Constructs a new coordinator state machine.
+        /// Constructs a new coordinator state machine, restoring the most
+        /// recent snapshot in the snapshot directory if there is one.
         ///
         /// \param logger pointer to logger instance.
-        explicit state_machine(std::shared_ptr<logging::log> logger);
+        /// \param snapshot_dir directory in which to store snapshots.
+        state_machine(std::shared_ptr<logging::log> logger,
+                      std::string snapshot_dir);
+
+        ~state_machine() override;
+
+        state_machine(const state_machine&) = delete;
+        auto operator=(const state_machine&) -> state_machine& = delete;
+        state_machine(state_machine&&) = delete;
+        auto operator=(state_machine&&) -> state_machine& = delete;
 
         /// Types of command the state machine can process.
         enum class command : uint8_t {
@@ -71,26 +90,78 @@ namespace cbdc::coordinator {
             nuraft::ulong log_idx,
             nuraft::ptr<nuraft::cluster_config>& /*new_conf*/) override;
 
-        /// Not implemented for coordinators.
-        /// \return false (unconditionally).
-        auto apply_snapshot(nuraft::snapshot& /* s */) -> bool override;
+        /// Reads the snapshot associated with the given metadata to send to
+        /// a follower. Coordinator snapshots are sent as a single object.
+        /// \param s metadata of the snapshot to read.
+        /// \param user_snp_ctx unused.
+        /// \param obj_id index of the object to read. Must be zero.
+        /// \param data_out buffer in which to write the snapshot.
+        /// \param is_last_obj set to true.
+        /// \return 0 if the snapshot was read successfully, or -1 if the
+        ///         snapshot no longer exists.
+        [[nodiscard]] auto
+        read_logical_snp_obj(nuraft::snapshot& s,
+                             void*& user_snp_ctx,
+                             nuraft::ulong obj_id,
+                             nuraft::ptr<nuraft::buffer>& data_out,
+                             bool& is_last_obj) -> int override;
+
+        /// Saves a snapshot received from the leader to persistent storage.
+        /// \param s metadata of the snapshot being received.
+        /// \param obj_id index of the object. Set to the index of the next
+        ///               expected object.
+        /// \param data snapshot data.
+        /// \param is_first_obj true if this is the first object.
+        /// \param is_last_obj true if this is the last object.
+        void save_logical_snp_obj(nuraft::snapshot& s,
+                                  nuraft::ulong& obj_id,
+                                  nuraft::buffer& data,
+                                  bool is_first_obj,
+                                  bool is_last_obj) override;
+
+        /// Replaces the coordinator state with the state stored in the
+        /// snapshot referenced by the given metadata.
+        /// \param s snapshot metadata.
+        /// \return true if the snapshot was applied successfully.
+        [[nodiscard]] auto apply_snapshot(nuraft::snapshot& s)
+            -> bool override;
 
-        /// Not implemented for coordinators.
-        /// \return nullptr (unconditionally).
-        auto last_snapshot() -> nuraft::ptr<nuraft::snapshot> override;
+        /// Returns the metadata of the most recent snapshot.
+        /// \return snapshot metadata, or nullptr if there is no snapshot.
+        [[nodiscard]] auto last_snapshot()
+            -> nuraft::ptr<nuraft::snapshot> override;
 
         /// Returns the index of the last-committed command.
         auto last_commit_index() -> uint64_t override;
 
-        /// Not implemented for coordinators.
+        /// Copies the in-flight dtxs and writes them to a snapshot file in a
+        /// background thread. The copy shares the dtx data buffers with the
+        /// live state so its cost is proportional to the number of dtxs in
+        /// flight. Calls when_done once the snapshot file is complete.
+        /// \param s snapshot metadata.
+        /// \param when_done function to call when snapshot creation is
+        ///                  complete.
         void create_snapshot(
-            nuraft::snapshot& /* s */,
+            nuraft::snapshot& s,
             nuraft::async_result<bool>::handler_type& when_done) override;
 
       private:
+        void write_snapshot(nuraft::ptr<nuraft::snapshot> snp,
+                            coordinator_state state);
+
+        [[nodiscard]] auto read_snapshot(uint64_t idx,
+                                         coordinator_state* state)
+            -> nuraft::ptr<nuraft::snapshot>;
+
         std::atomic<uint64_t> m_last_committed_idx{0};
         coordinator_state m_state{};
+
+        nuraft::ptr<nuraft::snapshot> m_snapshot{};
+        std::shared_mutex m_snapshots_mut{};
+        std::thread m_snapshot_thread;
+
         std::shared_ptr<logging::log> m_logger;
+        raft::snapshot_store m_snapshots;
     };
 }
 
@@ -11,11 +11,13 @@
 namespace cbdc::locking_shard::rpc {
     client::client(std::vector<network::endpoint_t> endpoints,
                    const std::pair<uint8_t, uint8_t>& output_range,
-                   logging::log& logger)
+                   logging::log& logger,
+                   std::chrono::microseconds coalesce_window)
         : interface(output_range),
           m_log(logger) {
         m_client = std::make_unique<decltype(m_client)::element_type>(
-            std::move(endpoints));
+            std::move(endpoints),
+            coalesce_window);
     }
 
     client::~client() {
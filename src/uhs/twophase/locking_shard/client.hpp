@@ -23,9 +23,14 @@ namespace cbdc::locking_shard::rpc {
         /// \param output_range inclusive range of UHS ID prefixes covered by
         ///                     the shard cluster
         /// \param logger log instance for writing status messages
+        /// \param coalesce_window time to wait for more requests to send in
+        ///                        one packet. Zero sends each request in its
+        ///                        own packet.
         client(std::vector<network::endpoint_t> endpoints,
                const std::pair<uint8_t, uint8_t>& output_range,
-               logging::log& logger);
+               logging::log& logger,
+               std::chrono::microseconds coalesce_window
+               = std::chrono::microseconds::zero());
 
         client() = delete;
         ~client() override;
@@ -44,7 +44,8 @@ namespace cbdc::locking_shard {
         params.election_timeout_upper_bound_
             = static_cast<int>(m_opts.m_election_timeout_upper);
         params.heart_beat_interval_ = static_cast<int>(m_opts.m_heartbeat);
-        params.snapshot_distance_ = 0; // TODO: implement snapshots
+        params.snapshot_distance_
+            = static_cast<int>(m_opts.m_snapshot_distance);
         params.max_append_size_ = static_cast<int>(m_opts.m_raft_max_batch);
 
         if(m_shard_id > (m_opts.m_shard_ranges.size() - 1)) {
@@ -58,7 +59,9 @@ namespace cbdc::locking_shard {
             m_logger,
             m_opts.m_shard_completed_txs_cache_size,
             m_preseed_dir,
-            m_opts);
+            m_opts,
+            "shard" + std::to_string(m_shard_id) + "_snps_"
+                + std::to_string(m_node_id));
 
         m_shard = m_state_machine->get_shard_instance();
 
@@ -88,7 +91,8 @@ namespace cbdc::locking_shard {
             [&](auto&& res, auto&& err) {
                 return raft_callback(std::forward<decltype(res)>(res),
                                      std::forward<decltype(err)>(err));
-            });
+            },
+            m_opts.m_raft_log_store);
 
         if(!m_raft_serv->init(params)) {
             m_logger->error("Failed to initialize raft server");
@@ -18,6 +18,32 @@ namespace cbdc {
         return packet >> tx.m_tx;
     }
 
+    auto operator<<(serializer& packet,
+                    const locking_shard::locking_shard::prepared_dtx& p)
+        -> serializer& {
+        return packet << p.m_txs << p.m_results;
+    }
+
+    auto operator>>(serializer& packet,
+                    locking_shard::locking_shard::prepared_dtx& p)
+        -> serializer& {
+        return packet >> p.m_txs >> p.m_results;
+    }
+
+    auto operator<<(serializer& packet,
+                    const locking_shard::locking_shard::state_snapshot& s)
+        -> serializer& {
+        return packet << s.m_uhs << s.m_locked << s.m_prepared_dtxs
+                      << s.m_applied_dtxs << s.m_completed_txs;
+    }
+
+    auto operator>>(serializer& packet,
+                    locking_shard::locking_shard::state_snapshot& s)
+        -> serializer& {
+        return packet >> s.m_uhs >> s.m_locked >> s.m_prepared_dtxs
+            >> s.m_applied_dtxs >> s.m_completed_txs;
+    }
+
     auto operator<<(serializer& packet, const locking_shard::rpc::request& p)
         -> serializer& {
         return packet << p.m_dtx_id << p.m_params;
@@ -14,6 +14,20 @@ namespace cbdc {
         -> serializer&;
     auto operator>>(serializer& packet, locking_shard::tx& tx) -> serializer&;
 
+    auto operator<<(serializer& packet,
+                    const locking_shard::locking_shard::prepared_dtx& p)
+        -> serializer&;
+    auto operator>>(serializer& packet,
+                    locking_shard::locking_shard::prepared_dtx& p)
+        -> serializer&;
+
+    auto operator<<(serializer& packet,
+                    const locking_shard::locking_shard::state_snapshot& s)
+        -> serializer&;
+    auto operator>>(serializer& packet,
+                    locking_shard::locking_shard::state_snapshot& s)
+        -> serializer&;
+
     auto operator<<(serializer& packet, const locking_shard::rpc::request& p)
         -> serializer&;
     auto operator>>(serializer& packet, locking_shard::rpc::request& p)
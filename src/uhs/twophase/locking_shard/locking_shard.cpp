@@ -186,4 +186,41 @@ namespace cbdc::locking_shard {
         -> std::optional<bool> {
         return m_completed_txs.contains(tx_id);
     }
+
+    auto locking_shard::snapshot() const -> state_snapshot {
+        auto ret = state_snapshot();
+        std::shared_lock<std::shared_mutex> l(m_mut);
+        ret.m_uhs.assign(m_uhs.begin(), m_uhs.end());
+        ret.m_locked.assign(m_locked.begin(), m_locked.end());
+        ret.m_prepared_dtxs.assign(m_prepared_dtxs.begin(),
+                                   m_prepared_dtxs.end());
+        ret.m_applied_dtxs.assign(m_applied_dtxs.begin(),
+                                  m_applied_dtxs.end());
+        ret.m_completed_txs = m_completed_txs.values();
+        return ret;
+    }
+
+    void locking_shard::restore(state_snapshot&& snp) {
+        std::unique_lock<std::shared_mutex> l(m_mut);
+        m_uhs.clear();
+        m_uhs.rehash(snp.m_uhs.size());
+        m_uhs.insert(snp.m_uhs.begin(), snp.m_uhs.end());
+
+        m_locked.clear();
+        m_locked.insert(snp.m_locked.begin(), snp.m_locked.end());
+
+        m_prepared_dtxs.clear();
+        for(auto& [dtx_id, dtx] : snp.m_prepared_dtxs) {
+            m_prepared_dtxs.emplace(dtx_id, std::move(dtx));
+        }
+
+        m_applied_dtxs.clear();
+        m_applied_dtxs.insert(snp.m_applied_dtxs.begin(),
+                              snp.m_applied_dtxs.end());
+
+        m_completed_txs.clear();
+        for(const auto& tx_id : snp.m_completed_txs) {
+            m_completed_txs.add(tx_id);
+        }
+    }
 }
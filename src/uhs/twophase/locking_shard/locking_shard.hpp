@@ -59,6 +59,29 @@ namespace cbdc::locking_shard {
                       config::options opts);
         locking_shard() = delete;
 
+        /// Locks and results for a distributed transaction between the lock
+        /// and apply operations.
+        struct prepared_dtx {
+            /// Transactions in the dtx relevant to this shard.
+            std::vector<tx> m_txs;
+            /// Result of the lock operation for each transaction.
+            std::vector<bool> m_results;
+        };
+
+        /// Point-in-time copy of the shard's state, used for raft snapshots.
+        struct state_snapshot {
+            /// Unspent UHS IDs.
+            std::vector<hash_t> m_uhs;
+            /// UHS IDs locked by prepared dtxs.
+            std::vector<hash_t> m_locked;
+            /// Dtxs which have been locked but not yet applied.
+            std::vector<std::pair<hash_t, prepared_dtx>> m_prepared_dtxs;
+            /// Dtxs which have been applied but not yet discarded.
+            std::vector<hash_t> m_applied_dtxs;
+            /// Recently completed TX IDs, oldest first.
+            std::vector<hash_t> m_completed_txs;
+        };
+
         /// \brief Attempts to lock the input hashes for the given batch of
         /// transactions.
         ///
@@ -124,14 +147,19 @@ namespace cbdc::locking_shard {
         [[nodiscard]] auto check_tx_id(const hash_t& tx_id)
             -> std::optional<bool> final;
 
+        /// Copies the state of the shard. Holds the shard's lock only for the
+        /// duration of the copy. The UHS, lock and dtx sets are returned in
+        /// no particular order.
+        /// \return copy of the shard state.
+        [[nodiscard]] auto snapshot() const -> state_snapshot;
+
+        /// Replaces the state of the shard with the given snapshot.
+        /// \param snp shard state to restore.
+        void restore(state_snapshot&& snp);
+
       private:
         auto read_preseed_file(const std::string& preseed_file) -> bool;
         auto check_and_lock_tx(const tx& t) -> bool;
-
-        struct prepared_dtx {
-            std::vector<tx> m_txs;
-            std::vector<bool> m_results;
-        };
         std::atomic_bool m_running{true};
 
         std::shared_ptr<logging::log> m_logger;
@@ -9,6 +9,7 @@
 #include "util/raft/serialization.hpp"
 #include "util/serialization/format.hpp"
 
+#include <algorithm>
 #include <unistd.h>
 
 namespace cbdc::locking_shard {
@@ -17,17 +18,42 @@ namespace cbdc::locking_shard {
         std::shared_ptr<logging::log> logger,
         size_t completed_txs_cache_size,
         const std::string& preseed_file,
-        config::options opts)
+        config::options opts,
+        std::string snapshot_dir)
         : m_output_range(output_range),
-          m_logger(std::move(logger)) {
+          m_logger(std::move(logger)),
+          m_snapshots(std::move(snapshot_dir), m_logger) {
         register_handler_callback([&](rpc::request req) {
             return process_request(std::move(req));
         });
-        m_shard = std::make_unique<locking_shard>(output_range,
-                                                  m_logger,
-                                                  completed_txs_cache_size,
-                                                  preseed_file,
-                                                  std::move(opts));
+
+        // Pre-seeding is redundant if there is a snapshot to restore
+        const auto snp_idx = m_snapshots.latest_idx();
+        m_shard = std::make_unique<locking_shard>(
+            output_range,
+            m_logger,
+            completed_txs_cache_size,
+            snp_idx.has_value() ? "" : preseed_file,
+            std::move(opts));
+
+        if(snp_idx.has_value()) {
+            m_logger->info("Restoring snapshot", *snp_idx);
+            auto state = locking_shard::state_snapshot();
+            auto snp = read_snapshot(*snp_idx, &state);
+            if(!snp) {
+                m_logger->fatal("Failed to read snapshot", *snp_idx);
+            }
+            m_shard->restore(std::move(state));
+            m_last_committed_idx = snp->get_last_log_idx();
+            m_snapshot = std::move(snp);
+            m_logger->info("Restored snapshot", *snp_idx);
+        }
+    }
+
+    state_machine::~state_machine() {
+        if(m_snapshot_thread.joinable()) {
+            m_snapshot_thread.join();
+        }
     }
 
     auto state_machine::commit(uint64_t log_idx, nuraft::buffer& data)
@@ -53,12 +79,50 @@ namespace cbdc::locking_shard {
         m_last_committed_idx = log_idx;
     }
 
-    auto state_machine::apply_snapshot(nuraft::snapshot& /* s */) -> bool {
-        return false;
+    auto
+    state_machine::read_logical_snp_obj(nuraft::snapshot& s,
+                                        void*& /* user_snp_ctx */,
+                                        nuraft::ulong obj_id,
+                                        nuraft::ptr<nuraft::buffer>& data_out,
+                                        bool& is_last_obj) -> int {
+        return m_snapshots.read_obj(s.get_last_log_idx(),
+                                    obj_id,
+                                    snapshot_chunk_size,
+                                    data_out,
+                                    is_last_obj);
+    }
+
+    void state_machine::save_logical_snp_obj(nuraft::snapshot& s,
+                                             nuraft::ulong& obj_id,
+                                             nuraft::buffer& data,
+                                             bool is_first_obj,
+                                             bool is_last_obj) {
+        m_snapshots.save_obj(s.get_last_log_idx(),
+                             data,
+                             is_first_obj,
+                             is_last_obj);
+        obj_id++;
+    }
+
+    auto state_machine::apply_snapshot(nuraft::snapshot& s) -> bool {
+        auto state = locking_shard::state_snapshot();
+        auto snp = read_snapshot(s.get_last_log_idx(), &state);
+        if(!snp) {
+            return false;
+        }
+
+        m_shard->restore(std::move(state));
+        m_last_committed_idx = snp->get_last_log_idx();
+        {
+            std::unique_lock<std::shared_mutex> l(m_snapshots_mut);
+            m_snapshot = std::move(snp);
+        }
+        return true;
     }
 
     auto state_machine::last_snapshot() -> nuraft::ptr<nuraft::snapshot> {
-        return nullptr;
+        std::shared_lock<std::shared_mutex> l(m_snapshots_mut);
+        return m_snapshot;
     }
 
     auto state_machine::last_commit_index() -> uint64_t {
@@ -66,11 +130,69 @@ namespace cbdc::locking_shard {
     }
 
     void state_machine::create_snapshot(
-        nuraft::snapshot& /* s */,
+        nuraft::snapshot& s,
         nuraft::async_result<bool>::handler_type& when_done) {
-        nuraft::ptr<std::exception> except(nullptr);
-        bool ret = false;
-        when_done(ret, except);
+        assert(s.get_last_log_idx() == last_commit_index());
+
+        // NuRaft does not start a new snapshot until the previous one calls
+        // when_done, so this only waits for the thread to exit
+        if(m_snapshot_thread.joinable()) {
+            m_snapshot_thread.join();
+        }
+
+        // Copy the state synchronously so it matches the log index in the
+        // snapshot metadata, then sort and write it in the background
+        auto state = m_shard->snapshot();
+        auto snp_buf = s.serialize();
+        auto snp = nuraft::snapshot::deserialize(*snp_buf);
+        m_snapshot_thread = std::thread(
+            [this,
+             snp = std::move(snp),
+             state = std::move(state),
+             when_done]() mutable {
+                write_snapshot(std::move(snp), std::move(state));
+                nuraft::ptr<std::exception> except(nullptr);
+                bool ret = true;
+                when_done(ret, except);
+            });
+    }
+
+    void
+    state_machine::write_snapshot(nuraft::ptr<nuraft::snapshot> snp,
+                                  locking_shard::state_snapshot state) {
+        const auto idx = snp->get_last_log_idx();
+        m_logger->info("Writing snapshot", idx);
+
+        std::sort(state.m_uhs.begin(), state.m_uhs.end());
+        std::sort(state.m_locked.begin(), state.m_locked.end());
+        std::sort(state.m_prepared_dtxs.begin(),
+                  state.m_prepared_dtxs.end(),
+                  [](const auto& a, const auto& b) {
+                      return a.first < b.first;
+                  });
+        std::sort(state.m_applied_dtxs.begin(), state.m_applied_dtxs.end());
+
+        m_snapshots.write(*snp, [&](serializer& ser) {
+            return static_cast<bool>(ser << state);
+        });
+        {
+            std::unique_lock<std::shared_mutex> l(m_snapshots_mut);
+            m_snapshot = std::move(snp);
+        }
+
+        m_logger->info("Wrote snapshot",
+                       idx,
+                       "with",
+                       state.m_uhs.size(),
+                       "UHS IDs");
+    }
+
+    auto state_machine::read_snapshot(uint64_t idx,
+                                      locking_shard::state_snapshot* state)
+        -> nuraft::ptr<nuraft::snapshot> {
+        return m_snapshots.read(idx, [&](serializer& deser) {
+            return state == nullptr || static_cast<bool>(deser >> *state);
+        });
     }
 
     auto state_machine::get_shard_instance()
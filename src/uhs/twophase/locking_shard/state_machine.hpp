@@ -8,10 +8,12 @@
 
 #include "locking_shard.hpp"
 #include "util/common/logging.hpp"
+#include "util/raft/snapshot_store.hpp"
 #include "util/rpc/blocking_server.hpp"
 
 #include <libnuraft/nuraft.hxx>
 #include <mutex>
+#include <thread>
 
 namespace cbdc::locking_shard {
     /// Raft state machine for handling locking shard RPC requests.
@@ -31,11 +33,22 @@ namespace cbdc::locking_shard {
         /// \param preseed_file path to file containing shard pre-seeding data
         ///                     or empty string to disable pre-seeding.
         /// \param opts configuration options.
+        /// \param snapshot_dir directory in which to store snapshots. The
+        ///                     most recent snapshot in the directory, if
+        ///                     any, is restored in place of pre-seeding.
         state_machine(const std::pair<uint8_t, uint8_t>& output_range,
                       std::shared_ptr<logging::log> logger,
                       size_t completed_txs_cache_size,
                       const std::string& preseed_file,
-                      config::options opts);
+                      config::options opts,
+                      std::string snapshot_dir);
+
+        ~state_machine() override;
+
+        state_machine(const state_machine&) = delete;
+        auto operator=(const state_machine&) -> state_machine& = delete;
+        state_machine(state_machine&&) = delete;
+        auto operator=(state_machine&&) -> state_machine& = delete;
 
         /// Commit the given raft log entry at the given log index, and return
         /// the result.
@@ -52,23 +65,62 @@ namespace cbdc::locking_shard {
             nuraft::ulong log_idx,
             nuraft::ptr<nuraft::cluster_config>& /*new_conf*/) override;
 
-        /// Not implemented for locking shard.
-        /// \return false.
-        auto apply_snapshot(nuraft::snapshot& /* s */) -> bool override;
-
-        /// Not implemented for locking shard.
-        /// \return nullptr.
-        auto last_snapshot() -> nuraft::ptr<nuraft::snapshot> override;
+        /// Reads a chunk of the snapshot associated with the given metadata
+        /// to send to a follower.
+        /// \param s metadata of the snapshot to read.
+        /// \param user_snp_ctx unused.
+        /// \param obj_id index of the chunk to read.
+        /// \param data_out buffer in which to write the chunk.
+        /// \param is_last_obj set to true if this is the last chunk.
+        /// \return 0 if the chunk was read successfully, or -1 if the
+        ///         snapshot no longer exists.
+        [[nodiscard]] auto
+        read_logical_snp_obj(nuraft::snapshot& s,
+                             void*& user_snp_ctx,
+                             nuraft::ulong obj_id,
+                             nuraft::ptr<nuraft::buffer>& data_out,
+                             bool& is_last_obj) -> int override;
+
+        /// Appends a chunk of a snapshot received from the leader to
+        /// persistent storage. The snapshot becomes available to
+        /// \ref apply_snapshot once the last chunk is saved.
+        /// \param s metadata of the snapshot being received.
+        /// \param obj_id index of the chunk. Set to the index of the next
+        ///               expected chunk.
+        /// \param data chunk data.
+        /// \param is_first_obj true if this is the first chunk.
+        /// \param is_last_obj true if this is the last chunk.
+        void save_logical_snp_obj(nuraft::snapshot& s,
+                                  nuraft::ulong& obj_id,
+                                  nuraft::buffer& data,
+                                  bool is_first_obj,
+                                  bool is_last_obj) override;
+
+        /// Replaces the state of the locking shard with the state stored in
+        /// the snapshot referenced by the given metadata.
+        /// \param s snapshot metadata.
+        /// \return true if the snapshot was applied successfully.
+        [[nodiscard]] auto apply_snapshot(nuraft::snapshot& s)
+            -> bool override;
+
+        /// Returns the metadata of the most recent snapshot.
+        /// \return snapshot metadata, or nullptr if there is no snapshot.
+        [[nodiscard]] auto last_snapshot()
+            -> nuraft::ptr<nuraft::snapshot> override;
 
         /// Returns the most recently committed log entry index.
         /// \return log entry index.
         auto last_commit_index() -> uint64_t override;
 
-        /// Not implemented for locking shard.
+        /// Copies the state of the locking shard and writes it to a snapshot
+        /// file in a background thread. The UHS and lock sets are written
+        /// sorted. Calls when_done once the snapshot file is complete.
+        /// \param s snapshot metadata.
+        /// \param when_done function to call when snapshot creation is
+        ///                  complete.
         void create_snapshot(
-            nuraft::snapshot& /* s */,
-            nuraft::async_result<bool>::handler_type& /* when_done */)
-            override;
+            nuraft::snapshot& s,
+            nuraft::async_result<bool>::handler_type& when_done) override;
 
         /// Returns a pointer to the locking shard instance managed by this
         /// state machine.
@@ -76,23 +128,30 @@ namespace cbdc::locking_shard {
         auto get_shard_instance()
             -> std::shared_ptr<cbdc::locking_shard::locking_shard>;
 
+        /// Size of the chunks in which snapshots are sent to followers.
+        static constexpr size_t snapshot_chunk_size{4UL * 1024 * 1024};
+
       private:
         auto process_request(cbdc::locking_shard::rpc::request req)
             -> cbdc::locking_shard::rpc::response;
 
+        void write_snapshot(nuraft::ptr<nuraft::snapshot> snp,
+                            locking_shard::state_snapshot state);
+
+        [[nodiscard]] auto read_snapshot(uint64_t idx,
+                                         locking_shard::state_snapshot* state)
+            -> nuraft::ptr<nuraft::snapshot>;
+
         std::atomic<uint64_t> m_last_committed_idx{0};
         nuraft::ptr<nuraft::snapshot> m_snapshot{};
         std::shared_mutex m_snapshots_mut{};
-
-        nuraft::ptr<nuraft::snapshot> m_tmp_snapshot{};
-        std::mutex m_tmp_mut{};
+        std::thread m_snapshot_thread;
 
         std::shared_ptr<cbdc::locking_shard::locking_shard> m_shard{};
         std::pair<uint8_t, uint8_t> m_output_range{};
-        std::string m_snapshot_dir{};
-        std::string m_db_dir{};
 
         std::shared_ptr<logging::log> m_logger;
+        raft::snapshot_store m_snapshots;
     };
 }
 
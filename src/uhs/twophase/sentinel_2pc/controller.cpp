@@ -67,7 +67,8 @@ namespace cbdc::sentinel_2pc {
             }
             auto client = std::make_unique<sentinel::rpc::client>(
                 std::vector<network::endpoint_t>{ep},
-                m_logger);
+                m_logger,
+                std::chrono::microseconds(m_opts.m_rpc_coalesce_window));
             if(!client->init(false)) {
                 m_logger->warn("Failed to start sentinel client");
             }
@@ -13,13 +13,20 @@
 
 namespace cbdc {
     /// Thread-safe producer-consumer FIFO queue supporting multiple
-    /// concurrent producers and consumers.
+    /// concurrent producers and consumers. Optionally bounded, in which case
+    /// producers block while the queue is full.
     /// \tparam type of object stored in the queue.
     template<typename T, typename Q>
     class blocking_queue_internal {
       public:
         blocking_queue_internal() = default;
 
+        /// Constructs a bounded queue.
+        /// \param capacity maximum number of elements in the queue, or zero
+        ///                 for an unbounded queue.
+        explicit blocking_queue_internal(size_t capacity)
+            : m_capacity(capacity) {}
+
         blocking_queue_internal(const blocking_queue_internal&) = delete;
         auto operator=(const blocking_queue_internal&)
             -> blocking_queue_internal& = delete;
@@ -36,12 +43,18 @@ namespace cbdc {
         }
 
         /// Pushes an element onto the queue and notifies at most one waiting
-        /// consumer.
+        /// consumer. If the queue is bounded and full, blocks until a consumer
+        /// pops an element or the queue is cleared.
         /// \param item object to push onto the queue.
-        auto push(const T& item) -> size_t {
+        auto push(T item) -> size_t {
             auto sz = [&]() {
                 std::unique_lock<std::mutex> lck(m_mut);
-                m_buffer.push(item);
+                if(m_capacity != 0) {
+                    m_space_cv.wait(lck, [&] {
+                        return m_buffer.size() < m_capacity || m_cleared;
+                    });
+                }
+                m_buffer.push(std::move(item));
                 m_wake = true;
                 return m_buffer.size();
             }();
@@ -57,6 +70,7 @@ namespace cbdc {
         /// \return true on success, false if interrupted by \ref clear() or
         ///         destruction.
         [[nodiscard]] auto pop(T& item) -> bool {
+            bool popped{false};
             {
                 std::unique_lock<std::mutex> lck(m_mut);
                 if(m_buffer.empty()) {
@@ -65,26 +79,30 @@ namespace cbdc {
                     });
                 }
 
-                bool popped{false};
                 if(!m_buffer.empty()) {
                     item = std::move(first_item<T, Q>());
                     m_buffer.pop();
                     popped = true;
                     m_wake = !m_buffer.empty();
                 }
-
-                return popped;
             }
+            if(popped && m_capacity != 0) {
+                m_space_cv.notify_one();
+            }
+            return popped;
         }
 
-        /// Clears the queue and unblocks waiting consumers.
+        /// Clears the queue and unblocks waiting consumers. A bounded queue
+        /// stops blocking producers until \ref reset() is called.
         void clear() {
             {
                 std::unique_lock<std::mutex> lck(m_mut);
                 m_buffer = decltype(m_buffer)();
                 m_wake = true;
+                m_cleared = true;
             }
             m_cv.notify_all();
+            m_space_cv.notify_all();
         }
 
         /// Removes the wakeup flag for consumers. Must be called after
@@ -93,6 +111,7 @@ namespace cbdc {
         void reset() {
             std::unique_lock l(m_mut);
             m_wake = false;
+            m_cleared = false;
         }
 
       private:
@@ -113,7 +132,10 @@ namespace cbdc {
         Q m_buffer;
         std::mutex m_mut;
         std::condition_variable m_cv;
+        std::condition_variable m_space_cv;
         bool m_wake{false};
+        bool m_cleared{false};
+        size_t m_capacity{0};
     };
 
     template<typename T>
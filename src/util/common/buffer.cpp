@@ -49,6 +49,10 @@ namespace cbdc {
         m_data.resize(m_data.size() + len);
     }
 
+    void buffer::reserve(size_t len) {
+        m_data.reserve(len);
+    }
+
     auto buffer::c_ptr() const -> const unsigned char* {
         // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
         return reinterpret_cast<const unsigned char*>(m_data.data());
@@ -53,6 +53,11 @@ namespace cbdc {
         /// \param len the number of bytes to add.
         void extend(size_t len);
 
+        /// Allocates enough space for the buffer to hold the given number of
+        /// bytes without reallocating.
+        /// \param len the number of bytes to allocate space for.
+        void reserve(size_t len);
+
         /// Returns a pointer to the data, cast to an unsigned char*.
         /// \return unsigned char pointer.
         [[nodiscard]] auto c_ptr() const -> const unsigned char*;
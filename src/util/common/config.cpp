@@ -29,6 +29,17 @@ namespace cbdc::config {
         return {host, static_cast<unsigned short>(port)};
     }
 
+    auto parse_raft_log_store(const std::string& in_str)
+        -> std::optional<raft_log_store_type> {
+        if(in_str == "leveldb") {
+            return raft_log_store_type::leveldb;
+        }
+        if(in_str == "segmented") {
+            return raft_log_store_type::segmented;
+        }
+        return std::nullopt;
+    }
+
     void get_shard_key_prefix(std::stringstream& ss, size_t shard_id) {
         ss << shard_prefix << shard_id << config_separator;
     }
@@ -418,6 +429,21 @@ namespace cbdc::config {
         opts.m_attestation_threshold
             = cfg.get_ulong(attestation_threshold_key)
                   .value_or(opts.m_attestation_threshold);
+        opts.m_sentinel_validation_threads
+            = cfg.get_ulong(sentinel_validation_threads_key)
+                  .value_or(opts.m_sentinel_validation_threads);
+        opts.m_sentinel_attestation_threads
+            = cfg.get_ulong(sentinel_attestation_threads_key)
+                  .value_or(opts.m_sentinel_attestation_threads);
+        opts.m_sentinel_routing_threads
+            = cfg.get_ulong(sentinel_routing_threads_key)
+                  .value_or(opts.m_sentinel_routing_threads);
+        opts.m_sentinel_queue_depth
+            = cfg.get_ulong(sentinel_queue_depth_key)
+                  .value_or(opts.m_sentinel_queue_depth);
+        opts.m_sentinel_batch_interval
+            = cfg.get_ulong(sentinel_batch_interval_key)
+                  .value_or(opts.m_sentinel_batch_interval);
 
         const auto sentinel_count
             = cfg.get_ulong(sentinel_count_key).value_or(0);
@@ -499,6 +525,22 @@ namespace cbdc::config {
         opts.m_stxo_cache_depth
             = cfg.get_ulong(stxo_cache_key).value_or(opts.m_stxo_cache_depth);
 
+        opts.m_atomizer_block_cache_size
+            = cfg.get_ulong(atomizer_block_cache_size_key)
+                  .value_or(opts.m_atomizer_block_cache_size);
+        if(opts.m_atomizer_block_cache_size == 0) {
+            return "Invalid atomizer block cache size ("
+                 + std::string(atomizer_block_cache_size_key) + ")";
+        }
+
+        opts.m_atomizer_prune_interval
+            = cfg.get_ulong(atomizer_prune_interval_key)
+                  .value_or(opts.m_atomizer_prune_interval);
+        if(opts.m_atomizer_prune_interval == 0) {
+            return "Invalid atomizer prune interval ("
+                 + std::string(atomizer_prune_interval_key) + ")";
+        }
+
         return std::nullopt;
     }
 
@@ -530,6 +572,16 @@ namespace cbdc::config {
             opts.m_archiver_db_dirs.push_back(*archiver_db);
         }
 
+        opts.m_archiver_compression
+            = cfg.get_ulong(archiver_compression_key).value_or(0) != 0;
+        opts.m_archiver_sync_interval
+            = cfg.get_ulong(archiver_sync_interval_key)
+                  .value_or(opts.m_archiver_sync_interval);
+        if(opts.m_archiver_sync_interval == 0) {
+            return "Invalid archiver sync interval ("
+                 + std::string(archiver_sync_interval_key) + ")";
+        }
+
         return std::nullopt;
     }
 
@@ -580,7 +632,8 @@ namespace cbdc::config {
         return std::nullopt;
     }
 
-    void read_raft_options(options& opts, const parser& cfg) {
+    auto read_raft_options(options& opts, const parser& cfg)
+        -> std::optional<std::string> {
         opts.m_election_timeout_upper = static_cast<int32_t>(
             cfg.get_ulong(election_timeout_upper_key)
                 .value_or(opts.m_election_timeout_upper));
@@ -598,6 +651,18 @@ namespace cbdc::config {
 
         opts.m_batch_size
             = cfg.get_ulong(batch_size_key).value_or(opts.m_batch_size);
+
+        const auto log_store = cfg.get_string(raft_log_store_key);
+        if(log_store.has_value()) {
+            const auto log_store_type = parse_raft_log_store(*log_store);
+            if(!log_store_type.has_value()) {
+                return "Unknown raft log store type " + *log_store + " ("
+                     + raft_log_store_key + ")";
+            }
+            opts.m_raft_log_store = *log_store_type;
+        }
+
+        return std::nullopt;
     }
 
     void read_loadgen_options(options& opts, const parser& cfg) {
@@ -613,6 +678,8 @@ namespace cbdc::config {
             = opts.m_input_count != 0 && opts.m_output_count != 0;
         opts.m_window_size
             = cfg.get_ulong(window_size_key).value_or(opts.m_window_size);
+        opts.m_send_timeout
+            = cfg.get_ulong(send_timeout_key).value_or(opts.m_send_timeout);
 
         opts.m_initial_mint_count = cfg.get_ulong(initial_mint_count_key)
                                         .value_or(opts.m_initial_mint_count);
@@ -631,6 +698,8 @@ namespace cbdc::config {
                   .value_or(opts.m_loadgen_tps_step_size);
         opts.m_loadgen_tps_initial = cfg.get_decimal(tps_initial_key)
                                          .value_or(opts.m_loadgen_tps_initial);
+        opts.m_loadgen_poisson_arrivals
+            = cfg.get_ulong(poisson_arrivals_key).value_or(0) != 0;
         for(size_t i{0}; i < opts.m_loadgen_count; ++i) {
             const auto loadgen_loglevel_key = get_loadgen_loglevel_key(i);
             const auto loadgen_loglevel
@@ -646,6 +715,8 @@ namespace cbdc::config {
         auto cfg = parser(config_file);
 
         opts.m_twophase_mode = cfg.get_ulong(two_phase_mode).value_or(0) != 0;
+        opts.m_rpc_coalesce_window = cfg.get_ulong(rpc_coalesce_window_key)
+                                         .value_or(opts.m_rpc_coalesce_window);
 
         auto err = read_sentinel_options(opts, cfg);
         if(err.has_value()) {
@@ -682,7 +753,10 @@ namespace cbdc::config {
             return err.value();
         }
 
-        read_raft_options(opts, cfg);
+        err = read_raft_options(opts, cfg);
+        if(err.has_value()) {
+            return err.value();
+        }
 
         read_loadgen_options(opts, cfg);
 
@@ -44,12 +44,23 @@ namespace cbdc::config {
     static constexpr uint64_t maximum_reservation
         = static_cast<uint64_t>(1024 * 1024); // 1MiB
 
+    /// Storage implementation backing the log of a raft node.
+    enum class raft_log_store_type {
+        /// Log entries stored in LevelDB.
+        leveldb,
+        /// Log entries appended to preallocated segment files.
+        segmented
+    };
+
     namespace defaults {
         static constexpr size_t stxo_cache_depth{1};
         static constexpr size_t window_size{10000};
+        static constexpr size_t send_timeout{30000};
         static constexpr size_t shard_completed_txs_cache_size{10000000};
         static constexpr size_t batch_size{2000};
         static constexpr size_t target_block_interval{250};
+        static constexpr size_t atomizer_block_cache_size{1024};
+        static constexpr size_t atomizer_prune_interval{8};
         static constexpr int32_t election_timeout_upper_bound{4000};
         static constexpr int32_t election_timeout_lower_bound{2000};
         static constexpr int32_t heartbeat{1000};
@@ -63,8 +74,12 @@ namespace cbdc::config {
         static constexpr size_t output_count{2};
         static constexpr double fixed_tx_rate{1.0};
         static constexpr size_t attestation_threshold{1};
+        static constexpr size_t sentinel_queue_depth{100000};
+        static constexpr size_t sentinel_batch_interval{1000};
+        static constexpr size_t archiver_sync_interval{16};
 
         static constexpr auto log_level = logging::log_level::warn;
+        static constexpr auto raft_log_store = raft_log_store_type::leveldb;
     }
 
     static constexpr auto endpoint_postfix = "endpoint";
@@ -88,7 +103,12 @@ namespace cbdc::config {
     static constexpr auto archiver_prefix = "archiver";
     static constexpr auto batch_size_key = "batch_size";
     static constexpr auto window_size_key = "window_size";
+    static constexpr auto send_timeout_key = "send_timeout";
     static constexpr auto target_block_interval_key = "target_block_interval";
+    static constexpr auto atomizer_block_cache_size_key
+        = "atomizer_block_cache_size";
+    static constexpr auto atomizer_prune_interval_key
+        = "atomizer_prune_interval";
     static constexpr auto election_timeout_upper_key
         = "election_timeout_upper";
     static constexpr auto election_timeout_lower_key
@@ -96,6 +116,7 @@ namespace cbdc::config {
     static constexpr auto heartbeat_key = "heartbeat";
     static constexpr auto snapshot_distance_key = "snapshot_distance";
     static constexpr auto raft_batch_size_key = "raft_max_batch";
+    static constexpr auto raft_log_store_key = "raft_log_store";
     static constexpr auto input_count_key = "loadgen_sendtx_input_count";
     static constexpr auto output_count_key = "loadgen_sendtx_output_count";
     static constexpr auto invalid_rate_key = "loadgen_invalid_tx_rate";
@@ -105,7 +126,11 @@ namespace cbdc::config {
     static constexpr auto tps_steptime_key = "loadgen_tps_step_time";
     static constexpr auto tps_stepsize_key = "loadgen_tps_step_percentage";
     static constexpr auto tps_initial_key = "loadgen_tps_step_start";
+    static constexpr auto poisson_arrivals_key = "loadgen_poisson_arrivals";
     static constexpr auto archiver_count_key = "archiver_count";
+    static constexpr auto archiver_compression_key = "archiver_compression";
+    static constexpr auto archiver_sync_interval_key
+        = "archiver_sync_interval";
     static constexpr auto watchtower_count_key = "watchtower_count";
     static constexpr auto watchtower_prefix = "watchtower";
     static constexpr auto watchtower_client_ep_postfix = "client_endpoint";
@@ -115,6 +140,7 @@ namespace cbdc::config {
     static constexpr auto watchtower_error_cache_size_key
         = "watchtower_error_cache_size";
     static constexpr auto two_phase_mode = "2pc";
+    static constexpr auto rpc_coalesce_window_key = "rpc_coalesce_window";
     static constexpr auto count_postfix = "count";
     static constexpr auto readonly = "readonly";
     static constexpr auto coordinator_prefix = "coordinator";
@@ -129,6 +155,15 @@ namespace cbdc::config {
     static constexpr auto private_key_postfix = "private_key";
     static constexpr auto public_key_postfix = "public_key";
     static constexpr auto attestation_threshold_key = "attestation_threshold";
+    static constexpr auto sentinel_validation_threads_key
+        = "sentinel_validation_threads";
+    static constexpr auto sentinel_attestation_threads_key
+        = "sentinel_attestation_threads";
+    static constexpr auto sentinel_routing_threads_key
+        = "sentinel_routing_threads";
+    static constexpr auto sentinel_queue_depth_key = "sentinel_queue_depth";
+    static constexpr auto sentinel_batch_interval_key
+        = "sentinel_batch_interval";
 
     /// [start, end] inclusive.
     using shard_range_t = std::pair<uint8_t, uint8_t>;
@@ -137,8 +172,12 @@ namespace cbdc::config {
     struct options {
         /// Depth of the spent transaction cache in the atomizer, in blocks.
         size_t m_stxo_cache_depth{defaults::stxo_cache_depth};
-        /// Maximum number of unconfirmed transactions in atomizer-cli.
+        /// Maximum number of unconfirmed transactions in atomizer-cli, and
+        /// of asynchronous sends awaiting a response in a client.
         size_t m_window_size{defaults::window_size};
+        /// Milliseconds a client waits for a sentinel to respond to an
+        /// asynchronous send before giving up on the response.
+        size_t m_send_timeout{defaults::send_timeout};
         /// Number of inputs in fixed-size transactions from atomizer-cli.
         size_t m_input_count{defaults::input_count};
         /// Number of outputs in fixed-size transactions from atomizer-cli.
@@ -172,6 +211,14 @@ namespace cbdc::config {
         size_t m_batch_size{defaults::batch_size};
         /// Target block creation interval in the atomizer in milliseconds.
         size_t m_target_block_interval{defaults::target_block_interval};
+        /// Initial capacity of the recent block cache in the atomizer, in
+        /// blocks.
+        size_t m_atomizer_block_cache_size{
+            defaults::atomizer_block_cache_size};
+        /// Number of blocks between prune commands replicated by the
+        /// atomizer leader. Prune requests received from archivers in
+        /// between are coalesced into a single command.
+        size_t m_atomizer_prune_interval{defaults::atomizer_prune_interval};
         /// List of atomizer log levels by atomizer ID.
         std::vector<logging::log_level> m_atomizer_loglevels;
         /// Raft election timeout upper bound in milliseconds.
@@ -186,6 +233,8 @@ namespace cbdc::config {
         int32_t m_snapshot_distance{0};
         /// Maximum number of raft log entries to batch into one RPC message.
         int32_t m_raft_max_batch{defaults::raft_max_batch};
+        /// Storage implementation for raft logs.
+        raft_log_store_type m_raft_log_store{defaults::raft_log_store};
         /// List of shard log levels by shard ID.
         std::vector<logging::log_level> m_shard_loglevels;
         /// List of shard DB paths by shard ID.
@@ -211,11 +260,20 @@ namespace cbdc::config {
         std::vector<logging::log_level> m_watchtower_loglevels;
         /// List of archiver DB paths by archiver ID.
         std::vector<std::string> m_archiver_db_dirs;
+        /// Flag set if archivers should compress stored blocks.
+        bool m_archiver_compression{false};
+        /// Number of blocks archivers write between syncs to disk. Atomizers
+        /// are only asked to prune blocks once they have been synced.
+        size_t m_archiver_sync_interval{defaults::archiver_sync_interval};
         /// Flag set if m_input_count or m_output_count are greater than zero.
         /// Causes the atomizer-cli to send fixed-size transactions.
         bool m_fixed_tx_mode{false};
         /// Flag set if the architecture is two-phase commit.
         bool m_twophase_mode{false};
+        /// Time in microseconds that sentinel and locking shard RPC clients
+        /// wait for more requests to send in one packet. Zero sends each
+        /// request in its own packet.
+        size_t m_rpc_coalesce_window{0};
         /// List of locking shard endpoints, ordered by shard ID then node ID.
         std::vector<std::vector<network::endpoint_t>>
             m_locking_shard_endpoints;
@@ -266,6 +324,9 @@ namespace cbdc::config {
         double m_loadgen_tps_step_size{0};
         /// Time (fractional seconds) to wait before the next step up
         double m_loadgen_tps_step_time{0};
+        /// Whether loadgens should space transactions with exponentially
+        /// distributed gaps rather than evenly.
+        bool m_loadgen_poisson_arrivals{false};
 
         /// Private keys for sentinels.
         std::unordered_map<size_t, privkey_t> m_sentinel_private_keys;
@@ -275,6 +336,29 @@ namespace cbdc::config {
 
         /// Number of sentinel attestations needed for a compact transaction.
         size_t m_attestation_threshold{defaults::attestation_threshold};
+
+        /// Number of threads validating transactions in each atomizer-mode
+        /// sentinel. Zero uses half the hardware threads.
+        size_t m_sentinel_validation_threads{0};
+
+        /// Number of threads compacting and signing transactions in each
+        /// atomizer-mode sentinel. Zero uses half the hardware threads.
+        size_t m_sentinel_attestation_threads{0};
+
+        /// Number of threads sending compact transactions to shards from
+        /// each atomizer-mode sentinel.
+        size_t m_sentinel_routing_threads{1};
+
+        /// Maximum number of transactions waiting at each stage of an
+        /// atomizer-mode sentinel before new requests block.
+        size_t m_sentinel_queue_depth{defaults::sentinel_queue_depth};
+
+        /// Interval in microseconds at which atomizer-mode sentinels send
+        /// the compact transactions batched for each shard, and check which
+        /// shards are connected. Zero sends each transaction as soon as it
+        /// is routed, and checks shard connectivity every 100ms or when a
+        /// send finds a shard disconnected.
+        size_t m_sentinel_batch_interval{defaults::sentinel_batch_interval};
     };
 
     /// Read options from the given config file without checking invariants.
@@ -411,6 +495,13 @@ namespace cbdc::config {
     };
 
     auto parse_ip_port(const std::string& in_str) -> network::endpoint_t;
+
+    /// Parses the name of a raft log store implementation.
+    /// \param in_str "leveldb" or "segmented".
+    /// \return log store type, or std::nullopt if the name is not
+    ///         recognized.
+    auto parse_raft_log_store(const std::string& in_str)
+        -> std::optional<raft_log_store_type>;
 }
 
 #endif // OPENCBDC_TX_SRC_COMMON_CONFIG_H_
@@ -0,0 +1,130 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "histogram.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+
+namespace cbdc {
+    namespace {
+        // Values below 2^sub_bucket_bits are counted exactly. Above that,
+        // each power of two is split into half_sub_buckets buckets.
+        constexpr size_t sub_bucket_bits{7};
+        constexpr uint64_t sub_buckets{uint64_t{1} << sub_bucket_bits};
+        constexpr uint64_t half_sub_buckets{sub_buckets / 2};
+        constexpr size_t value_bits{64};
+        constexpr size_t bucket_count{(value_bits - sub_bucket_bits + 2)
+                                      * half_sub_buckets};
+        constexpr auto max_percentile = 100.0;
+    }
+
+    histogram::histogram() : m_buckets(bucket_count) {}
+
+    void histogram::record(uint64_t value, uint64_t count) {
+        if(count == 0) {
+            return;
+        }
+        m_buckets[bucket_index(value)] += count;
+        if(m_count == 0) {
+            m_min = value;
+            m_max = value;
+        } else {
+            m_min = std::min(m_min, value);
+            m_max = std::max(m_max, value);
+        }
+        m_count += count;
+        m_sum += static_cast<long double>(value)
+               * static_cast<long double>(count);
+    }
+
+    void histogram::merge(const histogram& other) {
+        if(other.m_count == 0) {
+            return;
+        }
+        for(size_t i = 0; i < m_buckets.size(); i++) {
+            m_buckets[i] += other.m_buckets[i];
+        }
+        if(m_count == 0) {
+            m_min = other.m_min;
+            m_max = other.m_max;
+        } else {
+            m_min = std::min(m_min, other.m_min);
+            m_max = std::max(m_max, other.m_max);
+        }
+        m_count += other.m_count;
+        m_sum += other.m_sum;
+    }
+
+    void histogram::reset() {
+        std::fill(m_buckets.begin(), m_buckets.end(), 0);
+        m_count = 0;
+        m_min = 0;
+        m_max = 0;
+        m_sum = 0;
+    }
+
+    auto histogram::count() const -> uint64_t {
+        return m_count;
+    }
+
+    auto histogram::min() const -> uint64_t {
+        return m_min;
+    }
+
+    auto histogram::max() const -> uint64_t {
+        return m_max;
+    }
+
+    auto histogram::mean() const -> double {
+        if(m_count == 0) {
+            return 0.0;
+        }
+        return static_cast<double>(m_sum / static_cast<long double>(m_count));
+    }
+
+    auto histogram::percentile(double percentile) const -> uint64_t {
+        if(m_count == 0) {
+            return 0;
+        }
+        percentile = std::clamp(percentile, 0.0, max_percentile);
+        auto target = static_cast<uint64_t>(
+            std::ceil(percentile / max_percentile
+                      * static_cast<double>(m_count)));
+        target = std::clamp(target, uint64_t{1}, m_count);
+
+        uint64_t seen{0};
+        for(size_t i = 0; i < m_buckets.size(); i++) {
+            seen += m_buckets[i];
+            if(seen >= target) {
+                return std::clamp(bucket_upper_bound(i), m_min, m_max);
+            }
+        }
+        return m_max;
+    }
+
+    auto histogram::bucket_index(uint64_t value) -> size_t {
+        if(value < sub_buckets) {
+            return static_cast<size_t>(value);
+        }
+        const auto magnitude = static_cast<size_t>(std::bit_width(value)) - 1;
+        const auto shift = magnitude - sub_bucket_bits + 1;
+        return static_cast<size_t>(shift * half_sub_buckets
+                                   + (value >> shift));
+    }
+
+    auto histogram::bucket_upper_bound(size_t index) -> uint64_t {
+        if(index < sub_buckets) {
+            return index;
+        }
+        const auto shift = index / half_sub_buckets - 1;
+        const auto mantissa = index - shift * half_sub_buckets;
+        assert(shift < value_bits);
+        const auto lower = static_cast<uint64_t>(mantissa) << shift;
+        return lower + ((uint64_t{1} << shift) - 1);
+    }
+}
@@ -0,0 +1,76 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef OPENCBDC_TX_SRC_COMMON_HISTOGRAM_H_
+#define OPENCBDC_TX_SRC_COMMON_HISTOGRAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cbdc {
+    /// \brief Fixed-precision histogram of unsigned integer values, such as
+    ///        latencies in nanoseconds.
+    ///
+    /// Values are counted in log-linear buckets in the style of
+    /// HdrHistogram: each power of two is split into the same number of
+    /// equally sized buckets, so every recorded value, from zero up to
+    /// UINT64_MAX, is kept with a relative error below one part in 64.
+    /// Recording is constant time and memory use is fixed. Not
+    /// thread-safe.
+    class histogram {
+      public:
+        /// Constructor. Creates an empty histogram.
+        histogram();
+
+        /// Records occurrences of a value.
+        /// \param value value to record.
+        /// \param count number of occurrences to record.
+        void record(uint64_t value, uint64_t count = 1);
+
+        /// Adds the values recorded in another histogram to this one.
+        /// \param other histogram to merge.
+        void merge(const histogram& other);
+
+        /// Removes all recorded values.
+        void reset();
+
+        /// Returns the number of recorded values.
+        /// \return value count.
+        [[nodiscard]] auto count() const -> uint64_t;
+
+        /// Returns the smallest recorded value.
+        /// \return minimum value, or zero if no values were recorded.
+        [[nodiscard]] auto min() const -> uint64_t;
+
+        /// Returns the largest recorded value.
+        /// \return maximum value, or zero if no values were recorded.
+        [[nodiscard]] auto max() const -> uint64_t;
+
+        /// Returns the mean of the recorded values.
+        /// \return mean value, or zero if no values were recorded.
+        [[nodiscard]] auto mean() const -> double;
+
+        /// Returns the value at the given percentile. The result is the
+        /// largest value equivalent to the bucket containing the
+        /// percentile, capped at the maximum recorded value.
+        /// \param percentile percentile between 0 and 100.
+        /// \return value at the percentile, or zero if no values were
+        ///         recorded.
+        [[nodiscard]] auto percentile(double percentile) const -> uint64_t;
+
+      private:
+        std::vector<uint64_t> m_buckets;
+        uint64_t m_count{};
+        uint64_t m_min{};
+        uint64_t m_max{};
+        long double m_sum{};
+
+        static auto bucket_index(uint64_t value) -> size_t;
+        static auto bucket_upper_bound(size_t index) -> uint64_t;
+    };
+}
+
+#endif // OPENCBDC_TX_SRC_COMMON_HISTOGRAM_H_
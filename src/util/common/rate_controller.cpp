@@ -0,0 +1,72 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "rate_controller.hpp"
+
+#include <thread>
+
+namespace cbdc {
+    namespace {
+        // Waits shorter than this are spun out rather than slept, as
+        // sleeping may overshoot by about this much
+        constexpr auto spin_threshold = std::chrono::microseconds(100);
+    }
+
+    rate_controller::rate_controller(double rate,
+                                     arrival_distribution distribution,
+                                     std::mt19937_64::result_type seed)
+        : m_rate(rate),
+          m_distribution(distribution),
+          m_engine(seed),
+          m_next(clock_type::now()) {}
+
+    auto rate_controller::next() -> clock_type::time_point {
+        if(m_rate <= 0.0) {
+            return clock_type::now();
+        }
+        const auto ret = m_next;
+        m_next += gap();
+        return ret;
+    }
+
+    void rate_controller::set_rate(double rate) {
+        if(m_rate <= 0.0) {
+            // Restart the schedule when pacing is re-enabled
+            m_next = clock_type::now();
+        }
+        m_rate = rate;
+    }
+
+    auto rate_controller::rate() const -> double {
+        return m_rate;
+    }
+
+    auto rate_controller::lag(clock_type::time_point now) const
+        -> clock_type::duration {
+        if(m_rate <= 0.0 || now <= m_next) {
+            return clock_type::duration::zero();
+        }
+        return now - m_next;
+    }
+
+    void rate_controller::wait_until(clock_type::time_point deadline) {
+        auto now = clock_type::now();
+        if(deadline - now > spin_threshold) {
+            std::this_thread::sleep_until(deadline - spin_threshold);
+        }
+        while(clock_type::now() < deadline) {
+            std::this_thread::yield();
+        }
+    }
+
+    auto rate_controller::gap() -> clock_type::duration {
+        auto secs = 1.0 / m_rate;
+        if(m_distribution == arrival_distribution::poisson) {
+            secs *= m_exp_dist(m_engine);
+        }
+        return std::chrono::duration_cast<clock_type::duration>(
+            std::chrono::duration<double>(secs));
+    }
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef OPENCBDC_TX_SRC_COMMON_RATE_CONTROLLER_H_
+#define OPENCBDC_TX_SRC_COMMON_RATE_CONTROLLER_H_
+
+#include <chrono>
+#include <random>
+
+namespace cbdc {
+    /// \brief Open-loop schedule of event times at a target rate.
+    ///
+    /// Each call to next() returns the time at which the next event should
+    /// happen. The schedule only depends on the rate and the arrival
+    /// distribution, not on when the caller actually gets around to each
+    /// event, so a caller that falls behind catches up by issuing events
+    /// back to back rather than silently lowering the rate. Measuring
+    /// latency from the scheduled time instead of the actual time then
+    /// accounts for time spent queued behind a slow system.
+    class rate_controller {
+      public:
+        /// Clock used for the schedule.
+        using clock_type = std::chrono::steady_clock;
+
+        /// Distribution of the gaps between consecutive events.
+        enum class arrival_distribution {
+            /// Events are evenly spaced.
+            uniform,
+            /// Gaps are exponentially distributed, giving a Poisson
+            /// arrival process with the target mean rate.
+            poisson
+        };
+
+        /// Constructor. The schedule starts at the current time.
+        /// \param rate target events per second. Zero disables pacing.
+        /// \param distribution distribution of gaps between events.
+        /// \param seed seed for the gap distribution.
+        explicit rate_controller(double rate,
+                                 arrival_distribution distribution
+                                 = arrival_distribution::uniform,
+                                 std::mt19937_64::result_type seed
+                                 = std::mt19937_64::default_seed);
+
+        /// Returns the scheduled time of the next event and advances the
+        /// schedule. If pacing is disabled, returns the current time.
+        /// \return scheduled event time.
+        auto next() -> clock_type::time_point;
+
+        /// Changes the target rate. The gap after the most recently
+        /// scheduled event is computed from the new rate.
+        /// \param rate target events per second. Zero disables pacing.
+        void set_rate(double rate);
+
+        /// Returns the target rate.
+        /// \return events per second.
+        [[nodiscard]] auto rate() const -> double;
+
+        /// Returns how far behind the schedule the given time is.
+        /// \param now time to compare to the schedule.
+        /// \return time since the next scheduled event, or zero if the
+        ///         event is in the future.
+        [[nodiscard]] auto lag(clock_type::time_point now
+                               = clock_type::now()) const
+            -> clock_type::duration;
+
+        /// Blocks until the given time. Sleeps for most of the wait and
+        /// yields for the remainder, so short gaps are not rounded up to
+        /// the scheduler's sleep granularity.
+        /// \param deadline time to wait until.
+        static void wait_until(clock_type::time_point deadline);
+
+      private:
+        double m_rate;
+        arrival_distribution m_distribution;
+        std::mt19937_64 m_engine;
+        std::exponential_distribution<double> m_exp_dist{1.0};
+        clock_type::time_point m_next;
+
+        auto gap() -> clock_type::duration;
+    };
+}
+
+#endif // OPENCBDC_TX_SRC_COMMON_RATE_CONTROLLER_H_
@@ -46,6 +46,17 @@ namespace cbdc::network {
         }
     }
 
+    void connection_manager::broadcast_except(
+        const std::shared_ptr<buffer>& data,
+        const std::unordered_set<peer_id_t>& excluded) {
+        std::shared_lock<std::shared_mutex> l(m_peer_mutex);
+        for(const auto& peer : m_peers) {
+            if(excluded.find(peer.m_peer_id) == excluded.end()) {
+                peer.m_peer->send(data);
+            }
+        }
+    }
+
     auto connection_manager::handle_messages() -> std::vector<message_t> {
         std::vector<message_t> pkts;
 
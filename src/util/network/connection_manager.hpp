@@ -21,6 +21,7 @@
 #include <shared_mutex>
 #include <sys/socket.h>
 #include <thread>
+#include <unordered_set>
 
 namespace cbdc::network {
     /// Peer IDs within a \ref connection_manager.
@@ -89,6 +90,13 @@ namespace cbdc::network {
             return broadcast(pkt);
         }
 
+        /// Sends the provided data to all added peers except the given
+        /// ones.
+        /// \param data packet to send.
+        /// \param excluded IDs of the peers to skip.
+        void broadcast_except(const std::shared_ptr<buffer>& data,
+                              const std::unordered_set<peer_id_t>& excluded);
+
         /// Collects and return unhandled packets received from connected
         /// peers. \return vector of packets to handle.
         /// \note returned packets may be empty; check before dereferencing.
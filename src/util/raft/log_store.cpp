@@ -5,8 +5,11 @@
 
 #include "log_store.hpp"
 
+#include "segmented_log_store.hpp"
+
 #include <array>
 #include <cstring>
+#include <filesystem>
 #include <leveldb/write_batch.h>
 #include <libnuraft/buffer_serializer.hxx>
 
@@ -38,6 +41,10 @@ namespace cbdc::raft {
     }
 
     auto log_store::load(const std::string& db_dir) -> bool {
+        if(segmented_log_store::holds_log(db_dir)) {
+            return false;
+        }
+
         m_write_opt.sync = false;
 
         leveldb::Options opt;
@@ -63,6 +70,14 @@ namespace cbdc::raft {
         return true;
     }
 
+    auto log_store::holds_log(const std::string& db_dir) -> bool {
+        // LevelDB creates the CURRENT file in every database directory
+        std::error_code ec;
+        return std::filesystem::exists(
+            std::filesystem::path(db_dir) / "CURRENT",
+            ec);
+    }
+
     auto log_store::next_slot() const -> uint64_t {
         std::lock_guard<std::mutex> l(m_db_mut);
         return m_next_idx;
@@ -27,9 +27,16 @@ namespace cbdc::raft {
 
         /// Load the log store from the given LevelDB database directory.
         /// \param db_dir database directory.
-        /// \return true if loading the database succeeded.
+        /// \return true if loading the database succeeded, false if it
+        ///         failed or the directory holds a segmented log.
         [[nodiscard]] auto load(const std::string& db_dir) -> bool;
 
+        /// Checks whether the given directory holds a LevelDB database.
+        /// \param db_dir database directory.
+        /// \return true if the directory holds a LevelDB database.
+        [[nodiscard]] static auto holds_log(const std::string& db_dir)
+            -> bool;
+
         /// Return the log index of the next empty log entry.
         /// \return log index.
         [[nodiscard]] auto next_slot() const -> uint64_t override;
@@ -13,7 +13,8 @@ namespace cbdc::raft {
                nuraft::ptr<nuraft::state_machine> sm,
                size_t asio_thread_pool_size,
                std::shared_ptr<logging::log> logger,
-               nuraft::cb_func::func_type raft_cb)
+               nuraft::cb_func::func_type raft_cb,
+               config::raft_log_store_type log_store_type)
         : m_node_id(static_cast<uint32_t>(node_id)),
           m_blocking(blocking),
           m_port(raft_endpoints[m_node_id].second),
@@ -23,7 +24,8 @@ namespace cbdc::raft {
               node_type + "_raft_log_" + std::to_string(m_node_id),
               node_type + "_raft_config_" + std::to_string(m_node_id) + ".dat",
               node_type + "_raft_state_" + std::to_string(m_node_id) + ".dat",
-              std::move(raft_endpoints))),
+              std::move(raft_endpoints),
+              log_store_type)),
           m_sm(std::move(sm)),
           m_log(std::move(logger)) {
         m_asio_opt.thread_pool_size_ = asio_thread_pool_size;
@@ -43,6 +45,14 @@ namespace cbdc::raft {
         }
         params.auto_forwarding_ = false;
 
+        if(!m_smgr->log_format_matches()) {
+            // Switching raft_log_store on an existing node would otherwise
+            // start it from an empty log
+            m_log->error("Raft log directory holds a log written by a "
+                         "different raft_log_store type");
+            return false;
+        }
+
         m_raft_instance = m_launcher.init(m_sm,
                                           m_smgr,
                                           m_raft_logger,
@@ -51,6 +51,7 @@ namespace cbdc::raft {
         ///                              of cores on the system.
         /// \param logger log instance NuRaft should use.
         /// \param raft_cb NuRaft callback to report raft events.
+        /// \param log_store_type storage implementation for the raft log.
         node(int node_id,
              std::vector<network::endpoint_t> raft_endpoints,
              const std::string& node_type,
@@ -58,7 +59,9 @@ namespace cbdc::raft {
              nuraft::ptr<nuraft::state_machine> sm,
              size_t asio_thread_pool_size,
              std::shared_ptr<logging::log> logger,
-             nuraft::cb_func::func_type raft_cb);
+             nuraft::cb_func::func_type raft_cb,
+             config::raft_log_store_type log_store_type
+             = config::defaults::raft_log_store);
 
         ~node();
 
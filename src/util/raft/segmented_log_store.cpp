@@ -0,0 +1,995 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "segmented_log_store.hpp"
+
+#include "crypto/siphash.h"
+#include "log_store.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <libnuraft/buffer_serializer.hxx>
+#include <span>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <utility>
+
+namespace cbdc::raft {
+    namespace {
+        constexpr auto data_ext = ".seg";
+        constexpr auto index_ext = ".idx";
+        constexpr auto start_index_file = "start_index";
+
+        /// Each record in a data file is the log term, the length of the
+        /// serialized log entry and a checksum of both and the entry,
+        /// followed by the serialized log entry.
+        constexpr size_t record_header_size = 3 * sizeof(uint64_t);
+
+        auto record_checksum(uint64_t term,
+                             const unsigned char* data,
+                             size_t len) -> uint64_t {
+            static constexpr std::array<uint64_t, 2> checksum_key{0x1337,
+                                                                  0x7331};
+            CSipHasher hasher(checksum_key[0], checksum_key[1]);
+            hasher.Write(term);
+            hasher.Write(len);
+            hasher.Write(data, len);
+            return hasher.Finalize();
+        }
+
+        /// Aborts the process after a write to the log failed. The log
+        /// cannot report failed writes to NuRaft, which would otherwise
+        /// assume the entry was stored and reuse its index.
+        [[noreturn]] void fail(const char* what) {
+            std::fprintf(stderr,
+                         "segmented_log_store: %s: %s\n",
+                         what,
+                         std::strerror(errno));
+            std::abort();
+        }
+
+        auto null_entry() -> nuraft::ptr<nuraft::log_entry> {
+            return nuraft::cs_new<nuraft::log_entry>(0, nullptr);
+        }
+
+        /// Deserializes a log entry from a copy of the given bytes.
+        /// log_entry::deserialize moves the read position of the buffer it
+        /// is given, so cached buffers shared between readers must never be
+        /// passed to it directly.
+        auto entry_from_bytes(const unsigned char* data, size_t len)
+            -> nuraft::ptr<nuraft::log_entry> {
+            auto buf = nuraft::buffer::alloc(len);
+            std::memcpy(buf->data_begin(), data, len);
+            auto entry = nuraft::log_entry::deserialize(*buf);
+            assert(entry);
+            return entry;
+        }
+
+        auto read_fully(int fd,
+                        std::span<unsigned char> buf,
+                        uint64_t offset) -> bool {
+            size_t done{0};
+            while(done < buf.size()) {
+                const auto res
+                    = ::pread(fd,
+                              buf.subspan(done).data(),
+                              buf.size() - done,
+                              static_cast<off_t>(offset + done));
+                if(res < 0 && errno == EINTR) {
+                    continue;
+                }
+                if(res <= 0) {
+                    return false;
+                }
+                done += static_cast<size_t>(res);
+            }
+            return true;
+        }
+
+        auto sync_data(int fd) -> bool {
+#ifdef __APPLE__
+            return ::fsync(fd) == 0;
+#else
+            // Data files are preallocated, so appends only need the data
+            // and file size synced, not the rest of the inode
+            return ::fdatasync(fd) == 0;
+#endif
+        }
+
+        auto sync_dir(const std::string& dir) -> bool {
+            const auto fd = ::open(dir.c_str(), O_RDONLY | O_CLOEXEC);
+            if(fd < 0) {
+                return false;
+            }
+            const auto res = ::fsync(fd);
+            ::close(fd);
+            return res == 0;
+        }
+    }
+
+    /// Open data and index files for a range of log entries.
+    struct segmented_log_store::segment {
+        segment() = default;
+
+        ~segment() {
+            if(!m_offsets.empty()) {
+                ::munmap(m_offsets.data(), m_offsets.size_bytes());
+            }
+            if(m_data_fd >= 0) {
+                ::close(m_data_fd);
+            }
+            if(m_index_fd >= 0) {
+                ::close(m_index_fd);
+            }
+        }
+
+        segment(const segment&) = delete;
+        auto operator=(const segment&) -> segment& = delete;
+        segment(segment&&) = delete;
+        auto operator=(segment&&) -> segment& = delete;
+
+        /// Return the offset in the data file of the record at the given
+        /// position in the segment.
+        [[nodiscard]] auto record_begin(uint64_t pos) const -> uint64_t {
+            return pos == 0 ? 0 : m_offsets[pos - 1];
+        }
+
+        /// Return the log index following the last entry in the segment.
+        [[nodiscard]] auto end_idx() const -> uint64_t {
+            return m_first_idx + m_count;
+        }
+
+        uint64_t m_first_idx{};
+        std::string m_data_file;
+        std::string m_index_file;
+        int m_data_fd{-1};
+        int m_index_fd{-1};
+        /// Memory-mapped index file holding the end offset of each record.
+        std::span<uint64_t> m_offsets;
+        uint64_t m_count{};
+        uint64_t m_data_capacity{};
+        bool m_dirty{false};
+    };
+
+    segmented_log_store::segmented_log_store(uint64_t segment_entries,
+                                             uint64_t segment_bytes,
+                                             size_t cache_entries)
+        : m_segment_entries(std::max<uint64_t>(segment_entries, 1)),
+          m_segment_bytes(segment_bytes),
+          m_cache(cache_entries),
+          m_cache_idx(cache_entries) {}
+
+    segmented_log_store::~segmented_log_store() = default;
+
+    auto segmented_log_store::load(const std::string& dir) -> bool {
+        std::unique_lock l(m_mut);
+        m_dir = dir;
+        m_segments.clear();
+        m_terms.clear();
+        m_dirty.clear();
+        std::fill(m_cache.begin(), m_cache.end(), nullptr);
+        std::fill(m_cache_idx.begin(), m_cache_idx.end(), 0);
+
+        std::error_code ec;
+        std::filesystem::create_directories(m_dir, ec);
+        if(ec) {
+            return false;
+        }
+        if(raft::log_store::holds_log(m_dir)) {
+            return false;
+        }
+
+        uint64_t start_idx{1};
+        {
+            std::ifstream file(std::filesystem::path(m_dir)
+                               / start_index_file);
+            if(file.good()) {
+                file >> start_idx;
+                if(file.fail()) {
+                    start_idx = 1;
+                }
+            }
+        }
+
+        std::vector<uint64_t> firsts;
+        auto it = std::filesystem::directory_iterator(m_dir, ec);
+        for(; !ec && it != std::filesystem::directory_iterator();
+            it.increment(ec)) {
+            const auto& path = it->path();
+            if(path.extension() != data_ext) {
+                continue;
+            }
+            const auto stem = path.stem().string();
+            uint64_t first{};
+            const auto* stem_end = stem.data() + stem.size();
+            const auto res = std::from_chars(stem.data(), stem_end, first);
+            if(res.ec != std::errc() || res.ptr != stem_end) {
+                continue;
+            }
+            firsts.push_back(first);
+        }
+        if(ec) {
+            return false;
+        }
+        std::sort(firsts.begin(), firsts.end());
+
+        if(!firsts.empty()) {
+            start_idx = std::max(start_idx, firsts.front());
+        }
+        m_start_idx = start_idx;
+        m_next_idx = start_idx;
+
+        for(const auto first : firsts) {
+            if(!m_segments.empty() && first != m_next_idx) {
+                // Anything after a gap was written before the log was
+                // truncated and is no longer part of the log
+                std::filesystem::remove(segment_path(first, data_ext), ec);
+                std::filesystem::remove(segment_path(first, index_ext), ec);
+                continue;
+            }
+
+            auto seg = open_segment(first, false);
+            if(!seg || !recover_segment(*seg)) {
+                return false;
+            }
+
+            if(seg->end_idx() <= m_start_idx) {
+                // Every entry in the segment has been compacted
+                remove_segment(seg);
+                continue;
+            }
+
+            if(m_segments.empty() && first > m_start_idx) {
+                m_start_idx = first;
+            }
+            m_next_idx = seg->end_idx();
+            m_segments.emplace(first, std::move(seg));
+        }
+
+        m_next_idx = std::max(m_next_idx, m_start_idx);
+        m_write_seq = 0;
+        m_synced_seq = 0;
+        if(m_dir_dirty) {
+            m_dir_dirty = false;
+            return sync_dir(m_dir);
+        }
+        return true;
+    }
+
+    auto segmented_log_store::holds_log(const std::string& dir) -> bool {
+        std::error_code ec;
+        if(std::filesystem::exists(std::filesystem::path(dir)
+                                       / start_index_file,
+                                   ec)) {
+            return true;
+        }
+        auto it = std::filesystem::directory_iterator(dir, ec);
+        for(; !ec && it != std::filesystem::directory_iterator();
+            it.increment(ec)) {
+            if(it->path().extension() == data_ext) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auto segmented_log_store::segment_path(uint64_t first_idx,
+                                           const std::string& ext) const
+        -> std::string {
+        std::stringstream ss;
+        ss << std::setw(std::numeric_limits<uint64_t>::digits10 + 1)
+           << std::setfill('0') << first_idx << ext;
+        return (std::filesystem::path(m_dir) / ss.str()).string();
+    }
+
+    auto segmented_log_store::open_segment(uint64_t first_idx, bool create)
+        -> std::shared_ptr<segment> {
+        auto seg = std::make_shared<segment>();
+        seg->m_first_idx = first_idx;
+        seg->m_data_file = segment_path(first_idx, data_ext);
+        seg->m_index_file = segment_path(first_idx, index_ext);
+
+        auto flags = O_RDWR | O_CLOEXEC;
+        if(create) {
+            flags |= O_CREAT | O_TRUNC;
+        }
+        static constexpr auto file_mode = 0644;
+        seg->m_data_fd = ::open(seg->m_data_file.c_str(), flags, file_mode);
+        if(seg->m_data_fd < 0) {
+            return nullptr;
+        }
+        seg->m_index_fd = ::open(seg->m_index_file.c_str(), flags, file_mode);
+        if(seg->m_index_fd < 0) {
+            return nullptr;
+        }
+
+        if(create) {
+            const auto data_size = static_cast<off_t>(m_segment_bytes);
+            if(::ftruncate(seg->m_data_fd, data_size) != 0) {
+                return nullptr;
+            }
+#ifdef __linux__
+            // Reserve the blocks up front so appends never have to allocate
+            if(data_size > 0
+               && ::posix_fallocate(seg->m_data_fd, 0, data_size) != 0) {
+                return nullptr;
+            }
+#endif
+            const auto index_size
+                = static_cast<off_t>(m_segment_entries * sizeof(uint64_t));
+            if(::ftruncate(seg->m_index_fd, index_size) != 0) {
+                return nullptr;
+            }
+            m_dir_dirty = true;
+        }
+
+        struct stat st {};
+        if(::fstat(seg->m_data_fd, &st) != 0) {
+            return nullptr;
+        }
+        seg->m_data_capacity = static_cast<uint64_t>(st.st_size);
+
+        if(::fstat(seg->m_index_fd, &st) != 0) {
+            return nullptr;
+        }
+        const auto capacity
+            = static_cast<size_t>(st.st_size) / sizeof(uint64_t);
+        if(capacity == 0) {
+            return nullptr;
+        }
+
+        auto* map = ::mmap(nullptr,
+                           capacity * sizeof(uint64_t),
+                           PROT_READ | PROT_WRITE,
+                           MAP_SHARED,
+                           seg->m_index_fd,
+                           0);
+        if(map == MAP_FAILED) {
+            return nullptr;
+        }
+        seg->m_offsets = std::span(static_cast<uint64_t*>(map), capacity);
+
+        return seg;
+    }
+
+    auto segmented_log_store::recover_segment(segment& seg) -> bool {
+        std::vector<unsigned char> record;
+        uint64_t begin{0};
+        uint64_t count{0};
+        for(; count < seg.m_offsets.size(); count++) {
+            const auto end = seg.m_offsets[count];
+            if(end <= begin || end > seg.m_data_capacity
+               || end - begin <= record_header_size) {
+                break;
+            }
+            record.resize(end - begin);
+            if(!read_fully(seg.m_data_fd, record, begin)) {
+                return false;
+            }
+
+            uint64_t term{};
+            uint64_t len{};
+            uint64_t checksum{};
+            std::memcpy(&term, record.data(), sizeof(term));
+            std::memcpy(&len, &record[sizeof(term)], sizeof(len));
+            std::memcpy(&checksum,
+                        &record[sizeof(term) + sizeof(len)],
+                        sizeof(checksum));
+            // The index file may reach the disk before the record it
+            // points to, so stop at the first record not fully written
+            if(len != end - begin - record_header_size
+               || checksum
+                      != record_checksum(term,
+                                         &record[record_header_size],
+                                         len)) {
+                break;
+            }
+
+            const auto idx = seg.m_first_idx + count;
+            if(idx >= m_start_idx) {
+                m_terms.push_back(term);
+            }
+
+            begin = end;
+        }
+        seg.m_count = count;
+
+        // Clear the index after the last complete record so later appends
+        // to this segment are not mistaken for stale offsets on recovery
+        const auto tail = seg.m_offsets.subspan(count);
+        if(std::any_of(tail.begin(), tail.end(), [](uint64_t off) {
+               return off != 0;
+           })) {
+            std::fill(tail.begin(), tail.end(), 0);
+        }
+
+        return true;
+    }
+
+    void
+    segmented_log_store::remove_segment(const std::shared_ptr<segment>& seg) {
+        std::error_code ec;
+        std::filesystem::remove(seg->m_data_file, ec);
+        std::filesystem::remove(seg->m_index_file, ec);
+        if(seg->m_dirty) {
+            seg->m_dirty = false;
+            std::erase(m_dirty, seg);
+        }
+        m_dir_dirty = true;
+    }
+
+    auto segmented_log_store::next_slot() const -> uint64_t {
+        std::shared_lock l(m_mut);
+        return m_next_idx;
+    }
+
+    auto segmented_log_store::start_index() const -> uint64_t {
+        std::shared_lock l(m_mut);
+        return m_start_idx;
+    }
+
+    auto segmented_log_store::last_entry() const
+        -> nuraft::ptr<nuraft::log_entry> {
+        std::shared_lock l(m_mut);
+        if(m_next_idx == m_start_idx) {
+            return null_entry();
+        }
+        return read_entry(m_next_idx - 1);
+    }
+
+    auto segmented_log_store::append(nuraft::ptr<nuraft::log_entry>& entry)
+        -> uint64_t {
+        auto buf = entry->serialize();
+
+        std::unique_lock l(m_mut);
+        const auto idx = m_next_idx;
+        if(!append_locked(entry->get_term(), std::move(buf))) {
+            fail("Failed to append log entry");
+        }
+        return idx;
+    }
+
+    void segmented_log_store::write_at(uint64_t index,
+                                       nuraft::ptr<nuraft::log_entry>& entry) {
+        auto buf = entry->serialize();
+
+        std::unique_lock l(m_mut);
+        if(index < m_start_idx || index > m_next_idx) {
+            if(!reset_locked(index)) {
+                fail("Failed to reset log");
+            }
+        } else {
+            truncate_locked(index);
+        }
+        if(!append_locked(entry->get_term(), std::move(buf))) {
+            fail("Failed to write log entry");
+        }
+    }
+
+    auto segmented_log_store::log_entries(uint64_t start, uint64_t end)
+        -> log_entries_t {
+        auto ret = nuraft::cs_new<log_entries_t::element_type>(end - start);
+
+        std::shared_lock l(m_mut);
+        auto missing_start = end;
+        auto missing_end = start;
+        for(auto idx = start; idx < end; idx++) {
+            auto& entry = (*ret)[idx - start];
+            if(idx < m_start_idx || idx >= m_next_idx) {
+                entry = null_entry();
+                continue;
+            }
+            auto buf = cached(idx);
+            if(buf) {
+                entry = entry_from_bytes(buf->data_begin(), buf->size());
+                continue;
+            }
+            missing_start = std::min(missing_start, idx);
+            missing_end = idx + 1;
+        }
+
+        if(missing_start < missing_end) {
+            // Entries behind the cached tail of the log are read from disk
+            // with one read per segment
+            const auto res = read_records(
+                missing_start,
+                missing_end,
+                [&](uint64_t idx,
+                    uint64_t /* term */,
+                    const unsigned char* data,
+                    size_t len) {
+                    auto& entry = (*ret)[idx - start];
+                    if(!entry) {
+                        entry = entry_from_bytes(data, len);
+                    }
+                });
+            if(!res) {
+                for(auto& entry : *ret) {
+                    if(!entry) {
+                        entry = null_entry();
+                    }
+                }
+            }
+        }
+
+        return ret;
+    }
+
+    auto segmented_log_store::entry_at(uint64_t index)
+        -> nuraft::ptr<nuraft::log_entry> {
+        std::shared_lock l(m_mut);
+        return read_entry(index);
+    }
+
+    auto segmented_log_store::term_at(uint64_t index) -> uint64_t {
+        std::shared_lock l(m_mut);
+        if(index < m_start_idx || index >= m_next_idx) {
+            return 0;
+        }
+        return m_terms[index - m_start_idx];
+    }
+
+    auto segmented_log_store::pack(uint64_t index, int32_t cnt)
+        -> nuraft::ptr<nuraft::buffer> {
+        assert(cnt >= 0);
+        const auto n = static_cast<uint64_t>(cnt);
+        const auto end = index + n;
+
+        std::shared_lock l(m_mut);
+        assert(index >= m_start_idx && end <= m_next_idx);
+
+        // The pack format is the entry count followed by the length and
+        // serialized form of each entry, which is how records are stored
+        // less the term
+        const auto len = sizeof(uint64_t) + stored_bytes(index, end)
+                       - n * (record_header_size - sizeof(uint64_t));
+        auto ret = nuraft::buffer::alloc(len);
+        nuraft::buffer_serializer bs(ret);
+        bs.put_u64(n);
+
+        const auto res = read_records(index,
+                                      end,
+                                      [&](uint64_t /* idx */,
+                                          uint64_t /* term */,
+                                          const unsigned char* data,
+                                          size_t entry_len) {
+                                          bs.put_u64(entry_len);
+                                          bs.put_raw(data, entry_len);
+                                      });
+        if(!res) {
+            fail("Failed to read log entries");
+        }
+
+        return ret;
+    }
+
+    void segmented_log_store::apply_pack(uint64_t index,
+                                         nuraft::buffer& pack) {
+        nuraft::buffer_serializer bs(pack);
+
+        const auto cnt = bs.get_u64();
+
+        std::vector<std::pair<uint64_t, nuraft::ptr<nuraft::buffer>>> entries(
+            cnt);
+
+        for(auto& [term, buf] : entries) {
+            const auto len = bs.get_u64();
+            buf = nuraft::buffer::alloc(len);
+            bs.get_buffer(buf);
+            const auto entry = nuraft::log_entry::deserialize(*buf);
+            assert(entry);
+            term = entry->get_term();
+        }
+
+        std::unique_lock l(m_mut);
+        if(index < m_start_idx || index > m_next_idx) {
+            if(!reset_locked(index)) {
+                fail("Failed to reset log");
+            }
+        } else {
+            truncate_locked(index);
+        }
+
+        for(auto& [term, buf] : entries) {
+            if(!append_locked(term, std::move(buf))) {
+                fail("Failed to write log entry");
+            }
+        }
+    }
+
+    auto segmented_log_store::compact(uint64_t last_log_index) -> bool {
+        std::unique_lock l(m_mut);
+        if(last_log_index < m_start_idx) {
+            return true;
+        }
+
+        const auto new_start = last_log_index + 1;
+        if(new_start >= m_next_idx) {
+            return reset_locked(new_start);
+        }
+
+        cache_erase(m_start_idx, new_start);
+        m_terms.erase(m_terms.begin(),
+                      m_terms.begin()
+                          + static_cast<std::ptrdiff_t>(new_start
+                                                        - m_start_idx));
+        m_start_idx = new_start;
+
+        // Record the new start before deleting anything so a crash in
+        // between leaves the log readable
+        if(!persist_start_index()) {
+            return false;
+        }
+
+        while(!m_segments.empty()) {
+            auto it = m_segments.begin();
+            if(it->second->end_idx() > m_start_idx) {
+                break;
+            }
+            remove_segment(it->second);
+            m_segments.erase(it);
+        }
+        m_write_seq++;
+
+        return true;
+    }
+
+    auto segmented_log_store::flush() -> bool {
+        uint64_t requested{};
+        {
+            std::shared_lock l(m_mut);
+            requested = m_write_seq;
+        }
+
+        std::lock_guard fl(m_flush_mut);
+        if(m_synced_seq >= requested) {
+            // A flush that started after our writes already synced them
+            return true;
+        }
+
+        uint64_t seq{};
+        std::vector<std::shared_ptr<segment>> dirty;
+        bool dir_dirty{};
+        {
+            std::unique_lock l(m_mut);
+            seq = m_write_seq;
+            dirty.swap(m_dirty);
+            for(auto& seg : dirty) {
+                seg->m_dirty = false;
+            }
+            dir_dirty = std::exchange(m_dir_dirty, false);
+        }
+
+        auto success = true;
+        for(auto& seg : dirty) {
+            success = sync_data(seg->m_data_fd) && success;
+            success = ::msync(seg->m_offsets.data(),
+                              seg->m_offsets.size_bytes(),
+                              MS_SYNC)
+                          == 0
+                   && success;
+        }
+        if(dir_dirty) {
+            success = sync_dir(m_dir) && success;
+        }
+
+        if(!success) {
+            std::unique_lock l(m_mut);
+            for(auto& seg : dirty) {
+                mark_dirty(seg);
+            }
+            m_dir_dirty = m_dir_dirty || dir_dirty;
+            return false;
+        }
+
+        m_synced_seq = seq;
+        return true;
+    }
+
+    auto segmented_log_store::writable_segment(uint64_t size)
+        -> std::shared_ptr<segment> {
+        std::shared_ptr<segment> seg;
+        if(!m_segments.empty()) {
+            seg = m_segments.rbegin()->second;
+            assert(seg->end_idx() == m_next_idx);
+            const auto used = seg->record_begin(seg->m_count);
+            if(seg->m_count == seg->m_offsets.size()
+               || (seg->m_count > 0 && used + size > seg->m_data_capacity)) {
+                seg.reset();
+            }
+        }
+
+        if(!seg) {
+            seg = open_segment(m_next_idx, true);
+            if(!seg) {
+                return nullptr;
+            }
+            m_segments.emplace(m_next_idx, seg);
+        }
+
+        const auto used = seg->record_begin(seg->m_count);
+        if(used + size > seg->m_data_capacity) {
+            // A record larger than the preallocated size gets a segment to
+            // itself, grown to fit
+            if(::ftruncate(seg->m_data_fd, static_cast<off_t>(used + size))
+               != 0) {
+                return nullptr;
+            }
+            seg->m_data_capacity = used + size;
+        }
+
+        return seg;
+    }
+
+    auto segmented_log_store::append_locked(uint64_t term,
+                                            nuraft::ptr<nuraft::buffer> buf)
+        -> bool {
+        const auto size = record_header_size + buf->size();
+        auto seg = writable_segment(size);
+        if(!seg) {
+            return false;
+        }
+
+        std::array<uint64_t, 3> header{
+            term,
+            buf->size(),
+            record_checksum(term, buf->data_begin(), buf->size())};
+        std::array<iovec, 2> iov{};
+        iov[0].iov_base = header.data();
+        iov[0].iov_len = sizeof(header);
+        iov[1].iov_base = buf->data_begin();
+        iov[1].iov_len = buf->size();
+
+        const auto offset = seg->record_begin(seg->m_count);
+        const auto written = ::pwritev(seg->m_data_fd,
+                                       iov.data(),
+                                       static_cast<int>(iov.size()),
+                                       static_cast<off_t>(offset));
+        if(written != static_cast<ssize_t>(size)) {
+            if(written >= 0) {
+                // A short write to a regular file means the disk is full
+                errno = ENOSPC;
+            }
+            return false;
+        }
+
+        seg->m_offsets[seg->m_count] = offset + size;
+        seg->m_count++;
+        m_terms.push_back(term);
+        cache_put(m_next_idx, std::move(buf));
+        m_next_idx++;
+        mark_dirty(seg);
+
+        return true;
+    }
+
+    void segmented_log_store::truncate_locked(uint64_t index) {
+        assert(index >= m_start_idx);
+        if(index >= m_next_idx) {
+            return;
+        }
+
+        cache_erase(index, m_next_idx);
+
+        while(!m_segments.empty()) {
+            auto it = std::prev(m_segments.end());
+            auto seg = it->second;
+            if(seg->m_first_idx >= index) {
+                remove_segment(seg);
+                m_segments.erase(it);
+                continue;
+            }
+
+            const auto keep = index - seg->m_first_idx;
+            if(keep < seg->m_count) {
+                const auto tail = seg->m_offsets.subspan(keep,
+                                                         seg->m_count - keep);
+                std::fill(tail.begin(), tail.end(), 0);
+                seg->m_count = keep;
+                mark_dirty(seg);
+            }
+            break;
+        }
+
+        m_terms.resize(index - m_start_idx);
+        m_next_idx = index;
+        m_write_seq++;
+    }
+
+    auto segmented_log_store::reset_locked(uint64_t index) -> bool {
+        std::fill(m_cache.begin(), m_cache.end(), nullptr);
+        std::fill(m_cache_idx.begin(), m_cache_idx.end(), 0);
+        m_terms.clear();
+        m_start_idx = index;
+        m_next_idx = index;
+        m_write_seq++;
+
+        const auto res = persist_start_index();
+
+        for(auto& [first, seg] : m_segments) {
+            remove_segment(seg);
+        }
+        m_segments.clear();
+
+        return res;
+    }
+
+    auto segmented_log_store::persist_start_index() -> bool {
+        const auto path = std::filesystem::path(m_dir) / start_index_file;
+        auto tmp_path = path;
+        tmp_path += ".tmp";
+        {
+            std::ofstream file(tmp_path, std::ios::trunc);
+            file << m_start_idx;
+            file.flush();
+            if(!file.good()) {
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tmp_path, path, ec);
+        if(ec) {
+            return false;
+        }
+        m_dir_dirty = true;
+        return true;
+    }
+
+    void segmented_log_store::mark_dirty(const std::shared_ptr<segment>& seg) {
+        if(!seg->m_dirty) {
+            seg->m_dirty = true;
+            m_dirty.push_back(seg);
+        }
+        m_write_seq++;
+    }
+
+    auto segmented_log_store::read_entry(uint64_t index) const
+        -> nuraft::ptr<nuraft::log_entry> {
+        if(index < m_start_idx || index >= m_next_idx) {
+            return null_entry();
+        }
+
+        auto buf = cached(index);
+        if(buf) {
+            return entry_from_bytes(buf->data_begin(), buf->size());
+        }
+
+        nuraft::ptr<nuraft::log_entry> ret;
+        const auto res = read_records(index,
+                                      index + 1,
+                                      [&](uint64_t /* idx */,
+                                          uint64_t /* term */,
+                                          const unsigned char* data,
+                                          size_t len) {
+                                          ret = entry_from_bytes(data, len);
+                                      });
+        if(!res || !ret) {
+            return null_entry();
+        }
+        return ret;
+    }
+
+    auto segmented_log_store::stored_bytes(uint64_t start,
+                                           uint64_t end) const -> uint64_t {
+        uint64_t total{0};
+        auto it = m_segments.upper_bound(start);
+        if(it != m_segments.begin()) {
+            it--;
+        }
+        for(; it != m_segments.end() && it->first < end; it++) {
+            const auto& seg = *it->second;
+            const auto from = std::max(start, seg.m_first_idx);
+            const auto to = std::min(end, seg.end_idx());
+            if(to > from) {
+                total += seg.record_begin(to - seg.m_first_idx)
+                       - seg.record_begin(from - seg.m_first_idx);
+            }
+        }
+        return total;
+    }
+
+    auto segmented_log_store::read_records(uint64_t start,
+                                           uint64_t end,
+                                           const record_callback_type& cb)
+        const -> bool {
+        auto it = m_segments.upper_bound(start);
+        if(it == m_segments.begin()) {
+            return false;
+        }
+        it--;
+
+        std::vector<unsigned char> buf;
+        auto idx = start;
+        while(idx < end) {
+            if(it == m_segments.end()) {
+                return false;
+            }
+            const auto& seg = *it->second;
+            const auto pos = idx - seg.m_first_idx;
+            if(pos >= seg.m_count) {
+                return false;
+            }
+            const auto last = std::min(end, seg.end_idx());
+            const auto begin_offset = seg.record_begin(pos);
+            const auto end_offset = seg.record_begin(last - seg.m_first_idx);
+            buf.resize(end_offset - begin_offset);
+            if(!read_fully(seg.m_data_fd, buf, begin_offset)) {
+                return false;
+            }
+
+            size_t offset{0};
+            for(; idx < last; idx++) {
+                uint64_t term{};
+                uint64_t len{};
+                std::memcpy(&term, &buf[offset], sizeof(term));
+                std::memcpy(&len, &buf[offset + sizeof(term)], sizeof(len));
+                offset += record_header_size;
+                if(offset + len > buf.size()) {
+                    return false;
+                }
+                cb(idx, term, &buf[offset], len);
+                offset += len;
+            }
+            it++;
+        }
+
+        return true;
+    }
+
+    auto segmented_log_store::cached(uint64_t index) const
+        -> nuraft::ptr<nuraft::buffer> {
+        if(m_cache.empty()) {
+            return nullptr;
+        }
+        const auto slot = index % m_cache.size();
+        if(m_cache_idx[slot] != index) {
+            return nullptr;
+        }
+        return m_cache[slot];
+    }
+
+    void segmented_log_store::cache_put(uint64_t index,
+                                        nuraft::ptr<nuraft::buffer> buf) {
+        if(m_cache.empty()) {
+            return;
+        }
+        const auto slot = index % m_cache.size();
+        m_cache[slot] = std::move(buf);
+        m_cache_idx[slot] = index;
+    }
+
+    void segmented_log_store::cache_erase(uint64_t start, uint64_t end) {
+        if(m_cache.empty()) {
+            return;
+        }
+        if(end - start >= m_cache.size()) {
+            std::fill(m_cache.begin(), m_cache.end(), nullptr);
+            std::fill(m_cache_idx.begin(), m_cache_idx.end(), 0);
+            return;
+        }
+        for(auto idx = start; idx < end; idx++) {
+            const auto slot = idx % m_cache.size();
+            if(m_cache_idx[slot] == idx) {
+                m_cache[slot] = nullptr;
+                m_cache_idx[slot] = 0;
+            }
+        }
+    }
+}
@@ -0,0 +1,218 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef OPENCBDC_TX_SRC_RAFT_SEGMENTED_LOG_STORE_H_
+#define OPENCBDC_TX_SRC_RAFT_SEGMENTED_LOG_STORE_H_
+
+#include <deque>
+#include <functional>
+#include <libnuraft/log_store.hxx>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace cbdc::raft {
+    /// \brief NuRaft log_store implementation using append-only segment
+    ///        files.
+    ///
+    /// Log entries are appended to preallocated data files, each holding a
+    /// contiguous range of log indices. Every data file has a companion
+    /// index file, memory-mapped and holding the end offset of each record
+    /// in the data file, so entries can be located without scanning.
+    /// Compaction deletes whole segments and the first retained index is
+    /// recorded in a separate file. Each record carries a checksum, and
+    /// loading the log stops at the first record that fails it. Write
+    /// failures abort the process, as NuRaft assumes appends succeed.
+    ///
+    /// The terms of all retained entries are kept in memory so term_at
+    /// never touches the disk, and the most recently appended entries are
+    /// kept in a ring cache to serve followers catching up on the tail of
+    /// the log. Reads share a latch and only mutations are exclusive.
+    /// Concurrent calls to flush are coalesced so a single sync covers
+    /// every write made before it started.
+    class segmented_log_store : public nuraft::log_store {
+      public:
+        /// Default maximum number of log entries per segment.
+        static constexpr uint64_t default_segment_entries{65536};
+        /// Default size in bytes to preallocate for each segment data file.
+        static constexpr uint64_t default_segment_bytes{64UL * 1024 * 1024};
+        /// Default number of recent log entries to cache in memory.
+        static constexpr size_t default_cache_entries{16384};
+
+        /// Constructor.
+        /// \param segment_entries maximum number of entries per segment.
+        /// \param segment_bytes size in bytes to preallocate for each
+        ///                      segment data file. Segments holding a
+        ///                      single larger entry grow to fit it.
+        /// \param cache_entries number of recent entries to cache in
+        ///                      memory. Zero disables the cache.
+        explicit segmented_log_store(
+            uint64_t segment_entries = default_segment_entries,
+            uint64_t segment_bytes = default_segment_bytes,
+            size_t cache_entries = default_cache_entries);
+        ~segmented_log_store() override;
+
+        segmented_log_store(const segmented_log_store& other) = delete;
+        auto operator=(const segmented_log_store& other)
+            -> segmented_log_store& = delete;
+
+        segmented_log_store(segmented_log_store&& other) = delete;
+        auto operator=(segmented_log_store&& other)
+            -> segmented_log_store& = delete;
+
+        /// Load the log store from the given directory, creating the
+        /// directory if it does not exist. Discards any partially written
+        /// records at the end of the log.
+        /// \param dir log directory.
+        /// \return true if loading the log succeeded, false if it failed
+        ///         or the directory holds a LevelDB log.
+        [[nodiscard]] auto load(const std::string& dir) -> bool;
+
+        /// Checks whether the given directory holds a segmented log.
+        /// \param dir log directory.
+        /// \return true if the directory holds segment files or a
+        ///         persisted start index.
+        [[nodiscard]] static auto holds_log(const std::string& dir) -> bool;
+
+        /// Return the log index of the next empty log entry.
+        /// \return log index.
+        [[nodiscard]] auto next_slot() const -> uint64_t override;
+
+        /// Return the first log index stored by the log store.
+        /// \return log index.
+        [[nodiscard]] auto start_index() const -> uint64_t override;
+
+        /// Return the last log entry in the log store. Returns an empty log
+        /// entry at index zero if the log store is empty.
+        /// \return log entry.
+        [[nodiscard]] auto last_entry() const
+            -> nuraft::ptr<nuraft::log_entry> override;
+
+        /// Append the given log entry to the end of the log.
+        /// \param entry log entry to append.
+        /// \return index of the appended log entry.
+        auto append(nuraft::ptr<nuraft::log_entry>& entry)
+            -> uint64_t override;
+
+        /// Write a log entry at the given index, discarding any entries
+        /// after it.
+        /// \param index log index at which to write the entry.
+        /// \param entry log entry to write.
+        void write_at(uint64_t index,
+                      nuraft::ptr<nuraft::log_entry>& entry) override;
+
+        /// List of log entries.
+        using log_entries_t
+            = nuraft::ptr<std::vector<nuraft::ptr<nuraft::log_entry>>>;
+
+        /// Return the log entries in the given range of indices.
+        /// \param start first log entry to retrieve.
+        /// \param end last log entry to retrieve (exclusive).
+        /// \return list of log entries.
+        [[nodiscard]] auto log_entries(uint64_t start, uint64_t end)
+            -> log_entries_t override;
+
+        /// Return the log entry at the given index. Returns a null log entry
+        /// if there is no log entry at the given index.
+        /// \param index log index.
+        /// \return log entry.
+        [[nodiscard]] auto entry_at(uint64_t index)
+            -> nuraft::ptr<nuraft::log_entry> override;
+
+        /// Return the log term associated with the log entry at the given
+        /// index, or zero if there is no such entry.
+        /// \param index log index.
+        /// \return log term.
+        [[nodiscard]] auto term_at(uint64_t index) -> uint64_t override;
+
+        /// Serialize the given number of log entries from the given index.
+        /// Copies the stored records without deserializing them.
+        /// \param index starting log index.
+        /// \param cnt number of log entries to serialize. Must be positive.
+        /// \return buffer containing serialized log entries.
+        [[nodiscard]] auto pack(uint64_t index, int32_t cnt)
+            -> nuraft::ptr<nuraft::buffer> override;
+
+        /// Deserialize the given log entries and write them starting at the
+        /// given log index. Discards the existing log if the index is not
+        /// adjacent to it.
+        /// \param index log index at which to write the first log entry.
+        /// \param pack serialized log entries.
+        void apply_pack(uint64_t index, nuraft::buffer& pack) override;
+
+        /// Delete log entries from the start of the log up to the given log
+        /// index. Segments are deleted once all their entries are compacted.
+        /// \param last_log_index last log index to delete (inclusive).
+        /// \return true if the new start index was persisted.
+        auto compact(uint64_t last_log_index) -> bool override;
+
+        /// Sync all writes made before the call to disk.
+        /// \return true if the flush was successful.
+        auto flush() -> bool override;
+
+      private:
+        struct segment;
+
+        using record_callback_type = std::function<
+            void(uint64_t, uint64_t, const unsigned char*, size_t)>;
+
+        uint64_t m_segment_entries;
+        uint64_t m_segment_bytes;
+
+        std::string m_dir;
+
+        mutable std::shared_mutex m_mut;
+        std::map<uint64_t, std::shared_ptr<segment>> m_segments;
+        uint64_t m_start_idx{1};
+        uint64_t m_next_idx{1};
+        std::deque<uint64_t> m_terms;
+
+        std::vector<nuraft::ptr<nuraft::buffer>> m_cache;
+        std::vector<uint64_t> m_cache_idx;
+
+        uint64_t m_write_seq{};
+        std::vector<std::shared_ptr<segment>> m_dirty;
+        bool m_dir_dirty{false};
+
+        std::mutex m_flush_mut;
+        uint64_t m_synced_seq{};
+
+        [[nodiscard]] auto segment_path(uint64_t first_idx,
+                                        const std::string& ext) const
+            -> std::string;
+        [[nodiscard]] auto open_segment(uint64_t first_idx, bool create)
+            -> std::shared_ptr<segment>;
+        [[nodiscard]] auto recover_segment(segment& seg) -> bool;
+        void remove_segment(const std::shared_ptr<segment>& seg);
+
+        [[nodiscard]] auto writable_segment(uint64_t size)
+            -> std::shared_ptr<segment>;
+        [[nodiscard]] auto append_locked(uint64_t term,
+                                         nuraft::ptr<nuraft::buffer> buf)
+            -> bool;
+        void truncate_locked(uint64_t index);
+        [[nodiscard]] auto reset_locked(uint64_t index) -> bool;
+        [[nodiscard]] auto persist_start_index() -> bool;
+        void mark_dirty(const std::shared_ptr<segment>& seg);
+
+        [[nodiscard]] auto read_entry(uint64_t index) const
+            -> nuraft::ptr<nuraft::log_entry>;
+        [[nodiscard]] auto stored_bytes(uint64_t start, uint64_t end) const
+            -> uint64_t;
+        [[nodiscard]] auto read_records(uint64_t start,
+                                        uint64_t end,
+                                        const record_callback_type& cb) const
+            -> bool;
+        [[nodiscard]] auto cached(uint64_t index) const
+            -> nuraft::ptr<nuraft::buffer>;
+        void cache_put(uint64_t index, nuraft::ptr<nuraft::buffer> buf);
+        void cache_erase(uint64_t start, uint64_t end);
+    };
+}
+
+#endif // OPENCBDC_TX_SRC_RAFT_SEGMENTED_LOG_STORE_H_
@@ -0,0 +1,205 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "snapshot_store.hpp"
+
+#include "util/serialization/format.hpp"
+#include "util/serialization/istream_serializer.hpp"
+#include "util/serialization/ostream_serializer.hpp"
+
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace cbdc::raft {
+    snapshot_store::snapshot_store(std::string dir,
+                                   std::shared_ptr<logging::log> logger)
+        : m_dir(std::move(dir)),
+          m_logger(std::move(logger)) {
+        auto err = std::error_code();
+        std::filesystem::create_directories(m_dir, err);
+        if(err) {
+            m_logger->fatal("Failed to create snapshot directory", m_dir);
+        }
+    }
+
+    auto snapshot_store::latest_idx() -> std::optional<uint64_t> {
+        std::shared_lock<std::shared_mutex> l(m_mut);
+        auto ret = std::optional<uint64_t>();
+        auto err = std::error_code();
+        for(const auto& p : std::filesystem::directory_iterator(m_dir, err)) {
+            auto f_idx = parse_idx(p.path().filename().generic_string());
+            if(f_idx.has_value() && (!ret.has_value() || *f_idx > *ret)) {
+                ret = f_idx;
+            }
+        }
+        return ret;
+    }
+
+    void snapshot_store::write(
+        nuraft::snapshot& snp,
+        const std::function<bool(serializer&)>& write_state) {
+        const auto idx = snp.get_last_log_idx();
+
+        // Snapshots are created one at a time, so only one thread writes the
+        // creation temporary file
+        auto tmp_path = get_tmp_path(m_create_tmp_file);
+        auto ss = std::ofstream(tmp_path,
+                                std::ios::out | std::ios::trunc
+                                    | std::ios::binary);
+        if(!ss.good()) {
+            m_logger->fatal("Failed to open", tmp_path);
+        }
+
+        auto ser = cbdc::ostream_serializer(ss);
+        auto snp_buf = snp.serialize();
+        if(!(ser << static_cast<uint64_t>(snp_buf->size()))
+           || !ser.write(snp_buf->data_begin(), snp_buf->size())
+           || !write_state(ser)) {
+            m_logger->fatal("Failed to write snapshot", idx);
+        }
+        ss.flush();
+        ss.close();
+
+        std::unique_lock<std::shared_mutex> l(m_mut);
+        install(tmp_path, idx);
+    }
+
+    auto
+    snapshot_store::read(uint64_t idx,
+                         const std::function<bool(serializer&)>& read_state)
+        -> nuraft::ptr<nuraft::snapshot> {
+        auto path = get_path(idx);
+        std::shared_lock<std::shared_mutex> l(m_mut);
+        auto ss = std::ifstream(path, std::ios::in | std::ios::binary);
+        if(!ss.good()) {
+            return nullptr;
+        }
+
+        auto deser = cbdc::istream_serializer(ss);
+        uint64_t snp_sz{};
+        if(!(deser >> snp_sz)) {
+            return nullptr;
+        }
+        auto snp_buf = nuraft::buffer::alloc(snp_sz);
+        if(!deser.read(snp_buf->data_begin(), snp_buf->size())) {
+            return nullptr;
+        }
+        auto snp = nuraft::snapshot::deserialize(*snp_buf);
+
+        if(read_state && !read_state(deser)) {
+            return nullptr;
+        }
+
+        return snp;
+    }
+
+    auto snapshot_store::read_obj(uint64_t idx,
+                                  uint64_t obj_id,
+                                  uint64_t obj_size,
+                                  nuraft::ptr<nuraft::buffer>& data_out,
+                                  bool& is_last_obj) -> int {
+        auto path = get_path(idx);
+        std::shared_lock<std::shared_mutex> l(m_mut);
+        auto ss = std::ifstream(path, std::ios::in | std::ios::binary);
+        if(!ss.good()) {
+            // Requested snapshot was replaced by a newer one, not fatal
+            return -1;
+        }
+
+        auto err = std::error_code();
+        const auto sz = std::filesystem::file_size(path, err);
+        if(err) {
+            m_logger->fatal("Failed to read size of snapshot", path);
+        }
+
+        const auto n_objs = sz == 0 ? 1 : (sz - 1) / obj_size + 1;
+        if(obj_id >= n_objs) {
+            return -1;
+        }
+        const auto offset = obj_id * obj_size;
+        const auto len = std::min<uint64_t>(obj_size, sz - offset);
+
+        auto read_vec = std::vector<char>(len);
+        ss.seekg(static_cast<std::streamoff>(offset));
+        ss.read(read_vec.data(), static_cast<std::streamsize>(len));
+        if(!ss.good()) {
+            m_logger->fatal("Failed to read snapshot", path);
+        }
+
+        auto buf = nuraft::buffer::alloc(len);
+        std::memcpy(buf->data_begin(), read_vec.data(), len);
+        data_out = std::move(buf);
+        is_last_obj = obj_id + 1 == n_objs;
+
+        return 0;
+    }
+
+    void snapshot_store::save_obj(uint64_t idx,
+                                  nuraft::buffer& data,
+                                  bool is_first_obj,
+                                  bool is_last_obj) {
+        auto tmp_path = get_tmp_path(m_receive_tmp_file);
+        std::unique_lock<std::shared_mutex> l(m_mut);
+        auto mode = std::ios::out | std::ios::binary;
+        mode |= is_first_obj ? std::ios::trunc : std::ios::app;
+        auto ss = std::ofstream(tmp_path, mode);
+        if(!ss.good()) {
+            m_logger->fatal("Failed to open", tmp_path);
+        }
+
+        auto write_vec = std::vector<char>(data.size());
+        std::memcpy(write_vec.data(), data.data_begin(), data.size());
+        ss.write(write_vec.data(), static_cast<std::streamsize>(data.size()));
+        ss.flush();
+        if(!ss.good()) {
+            m_logger->fatal("Failed to write", tmp_path);
+        }
+        ss.close();
+
+        if(is_last_obj) {
+            install(tmp_path, idx);
+        }
+    }
+
+    void snapshot_store::install(const std::string& tmp_path, uint64_t idx) {
+        auto path = get_path(idx);
+        auto err = std::error_code();
+        std::filesystem::rename(tmp_path, path, err);
+        if(err) {
+            m_logger->fatal("Failed to move snapshot to", path);
+        }
+
+        // Raft compacts the log up to the newest snapshot, so older ones are
+        // never needed again
+        for(const auto& p : std::filesystem::directory_iterator(m_dir, err)) {
+            auto f_idx = parse_idx(p.path().filename().generic_string());
+            if(f_idx.has_value() && *f_idx < idx) {
+                std::filesystem::remove(p, err);
+            }
+        }
+    }
+
+    auto snapshot_store::get_path(uint64_t idx) const -> std::string {
+        return m_dir + "/" + std::to_string(idx);
+    }
+
+    auto snapshot_store::get_tmp_path(const std::string& name) const
+        -> std::string {
+        return m_dir + "/" + name;
+    }
+
+    auto snapshot_store::parse_idx(const std::string& name)
+        -> std::optional<uint64_t> {
+        uint64_t idx{};
+        const auto* name_end = name.data() + name.size();
+        auto res = std::from_chars(name.data(), name_end, idx);
+        if(res.ec != std::errc() || res.ptr != name_end) {
+            return std::nullopt;
+        }
+        return idx;
+    }
+}
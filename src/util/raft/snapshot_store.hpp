@@ -0,0 +1,101 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef OPENCBDC_TX_SRC_RAFT_SNAPSHOT_STORE_H_
+#define OPENCBDC_TX_SRC_RAFT_SNAPSHOT_STORE_H_
+
+#include "util/common/logging.hpp"
+#include "util/serialization/serializer.hpp"
+
+#include <functional>
+#include <libnuraft/nuraft.hxx>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+
+namespace cbdc::raft {
+    /// \brief Directory of snapshot files for a raft state machine.
+    ///
+    /// Each snapshot is a file named after its last log index, holding the
+    /// serialized snapshot metadata followed by the state machine's state.
+    /// Snapshots are written to a temporary file first, then renamed into
+    /// place, and only the newest snapshot is kept. Failures that leave the
+    /// directory in an unknown state are fatal.
+    class snapshot_store {
+      public:
+        /// Constructor. Creates the snapshot directory if needed.
+        /// \param dir directory in which to store snapshots.
+        /// \param logger log instance.
+        snapshot_store(std::string dir, std::shared_ptr<logging::log> logger);
+
+        /// Returns the log index of the newest snapshot in the directory.
+        /// \return log index, or std::nullopt if there is no snapshot.
+        [[nodiscard]] auto latest_idx() -> std::optional<uint64_t>;
+
+        /// Writes a snapshot and removes any older ones.
+        /// \param snp snapshot metadata.
+        /// \param write_state function that serializes the state.
+        void write(nuraft::snapshot& snp,
+                   const std::function<bool(serializer&)>& write_state);
+
+        /// Reads a snapshot.
+        /// \param idx log index of the snapshot.
+        /// \param read_state function that deserializes the state, or an
+        ///                   empty function to only read the metadata.
+        /// \return snapshot metadata, or nullptr if the snapshot does not
+        ///         exist or could not be read.
+        [[nodiscard]] auto
+        read(uint64_t idx, const std::function<bool(serializer&)>& read_state)
+            -> nuraft::ptr<nuraft::snapshot>;
+
+        /// Reads part of a snapshot file to send to a follower.
+        /// \param idx log index of the snapshot.
+        /// \param obj_id index of the part to read.
+        /// \param obj_size size of each part.
+        /// \param data_out buffer in which to return the part.
+        /// \param is_last_obj set to true if this is the last part.
+        /// \return 0 if the part was read, or -1 if the snapshot no longer
+        ///         exists or has no such part.
+        [[nodiscard]] auto read_obj(uint64_t idx,
+                                    uint64_t obj_id,
+                                    uint64_t obj_size,
+                                    nuraft::ptr<nuraft::buffer>& data_out,
+                                    bool& is_last_obj) -> int;
+
+        /// Saves part of a snapshot received from the leader. The snapshot
+        /// replaces any older ones once its last part is saved.
+        /// \param idx log index of the snapshot.
+        /// \param data snapshot data.
+        /// \param is_first_obj true if this is the first part.
+        /// \param is_last_obj true if this is the last part.
+        void save_obj(uint64_t idx,
+                      nuraft::buffer& data,
+                      bool is_first_obj,
+                      bool is_last_obj);
+
+      private:
+        static constexpr auto m_create_tmp_file = "tmp";
+        static constexpr auto m_receive_tmp_file = "recv";
+
+        std::string m_dir;
+        std::shared_ptr<logging::log> m_logger;
+        std::shared_mutex m_mut;
+
+        [[nodiscard]] auto get_path(uint64_t idx) const -> std::string;
+        [[nodiscard]] auto get_tmp_path(const std::string& name) const
+            -> std::string;
+
+        /// Moves a complete snapshot file into place and removes older
+        /// snapshots. Requires an exclusive lock on m_mut.
+        void install(const std::string& tmp_path, uint64_t idx);
+
+        /// Parses a snapshot file name.
+        /// \return log index, or std::nullopt for temporary files.
+        static auto parse_idx(const std::string& name)
+            -> std::optional<uint64_t>;
+    };
+}
+
+#endif // OPENCBDC_TX_SRC_RAFT_SNAPSHOT_STORE_H_
@@ -6,6 +6,7 @@
 #include "state_manager.hpp"
 
 #include "log_store.hpp"
+#include "segmented_log_store.hpp"
 
 #include <cstring>
 #include <filesystem>
@@ -18,12 +19,14 @@ namespace cbdc::raft {
         std::string log_dir,
         std::string config_file,
         std::string state_file,
-        std::vector<network::endpoint_t> raft_endpoints)
+        std::vector<network::endpoint_t> raft_endpoints,
+        config::raft_log_store_type log_store_type)
         : m_id(srv_id),
           m_config_file(std::move(config_file)),
           m_state_file(std::move(state_file)),
           m_log_dir(std::move(log_dir)),
-          m_raft_endpoints(std::move(raft_endpoints)) {}
+          m_raft_endpoints(std::move(raft_endpoints)),
+          m_log_store_type(log_store_type) {}
 
     template<typename T>
     void save_object(const T& obj, const std::string& filename) {
@@ -99,6 +102,14 @@ namespace cbdc::raft {
     }
 
     auto state_manager::load_log_store() -> nuraft::ptr<nuraft::log_store> {
+        if(m_log_store_type == config::raft_log_store_type::segmented) {
+            auto log = nuraft::cs_new<segmented_log_store>();
+            if(!log->load(m_log_dir)) {
+                return nullptr;
+            }
+            return log;
+        }
+
         auto log = nuraft::cs_new<log_store>();
         if(!log->load(m_log_dir)) {
             return nullptr;
@@ -107,6 +118,13 @@ namespace cbdc::raft {
         return log;
     }
 
+    auto state_manager::log_format_matches() const -> bool {
+        if(m_log_store_type == config::raft_log_store_type::segmented) {
+            return !log_store::holds_log(m_log_dir);
+        }
+        return !segmented_log_store::holds_log(m_log_dir);
+    }
+
     auto state_manager::server_id() -> int32_t {
         return m_id;
     }
@@ -7,6 +7,7 @@
 #define OPENCBDC_TX_SRC_RAFT_STATE_MANAGER_H_
 
 #include "log_store.hpp"
+#include "util/common/config.hpp"
 #include "util/network/socket.hpp"
 
 #include <libnuraft/nuraft.hxx>
@@ -21,11 +22,14 @@ namespace cbdc::raft {
         /// \param config_file file for the cluster configuration.
         /// \param state_file file for the server state.
         /// \param raft_endpoints list of initial node endpoints in the cluster.
+        /// \param log_store_type storage implementation for the raft log.
         state_manager(int32_t srv_id,
                       std::string log_dir,
                       std::string config_file,
                       std::string state_file,
-                      std::vector<network::endpoint_t> raft_endpoints);
+                      std::vector<network::endpoint_t> raft_endpoints,
+                      config::raft_log_store_type log_store_type
+                      = config::defaults::raft_log_store);
         ~state_manager() override = default;
 
         state_manager(const state_manager& other) = delete;
@@ -54,6 +58,12 @@ namespace cbdc::raft {
         /// \return log store instance, or nullptr if loading failed.
         auto load_log_store() -> nuraft::ptr<nuraft::log_store> override;
 
+        /// Checks that the log directory does not hold a log written by a
+        /// different log store implementation than the configured one.
+        /// \return false if the log directory holds a log in another
+        ///         format.
+        [[nodiscard]] auto log_format_matches() const -> bool;
+
         /// Return the server ID.
         /// \return server ID.
         auto server_id() -> int32_t override;
@@ -68,6 +78,7 @@ namespace cbdc::raft {
         std::string m_state_file;
         std::string m_log_dir;
         std::vector<network::endpoint_t> m_raft_endpoints;
+        config::raft_log_store_type m_log_store_type;
     };
 }
 
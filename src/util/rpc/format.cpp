@@ -5,7 +5,9 @@
 
 #include "format.hpp"
 
+#include "util/serialization/buffer_serializer.hpp"
 #include "util/serialization/format.hpp"
+#include "util/serialization/util.hpp"
 
 namespace cbdc {
     auto operator<<(serializer& ser, const rpc::header& header)
@@ -17,3 +19,27 @@ namespace cbdc {
         return deser >> header.m_request_id;
     }
 }
+
+namespace cbdc::rpc {
+    auto make_batch(const std::vector<buffer>& msgs) -> buffer {
+        const auto hdr = header{batch_request_id};
+        auto pkt = buffer();
+        pkt.extend(serialized_size(hdr) + serialized_size(msgs));
+        auto ser = buffer_serializer(pkt);
+        ser << hdr << msgs;
+        return pkt;
+    }
+
+    auto split_batch(buffer& pkt) -> std::optional<std::vector<buffer>> {
+        auto deser = buffer_serializer(pkt);
+        auto hdr = header{};
+        if(!(deser >> hdr) || hdr.m_request_id != batch_request_id) {
+            return std::nullopt;
+        }
+        auto msgs = std::vector<buffer>();
+        if(!(deser >> msgs)) {
+            return std::nullopt;
+        }
+        return msgs;
+    }
+}
@@ -7,8 +7,12 @@
 #define OPENCBDC_TX_SRC_RPC_FORMAT_H_
 
 #include "messages.hpp"
+#include "util/common/buffer.hpp"
 #include "util/serialization/serializer.hpp"
 
+#include <optional>
+#include <vector>
+
 namespace cbdc {
     auto operator<<(serializer& ser, const rpc::header& header) -> serializer&;
     auto operator>>(serializer& deser, rpc::header& header) -> serializer&;
@@ -36,4 +40,17 @@ namespace cbdc {
     }
 }
 
+namespace cbdc::rpc {
+    /// Packs serialized requests or responses into one batch packet.
+    /// \param msgs serialized requests or responses.
+    /// \return batch packet.
+    auto make_batch(const std::vector<buffer>& msgs) -> buffer;
+
+    /// Unpacks the serialized requests or responses in a batch packet.
+    /// \param pkt packet to unpack.
+    /// \return serialized requests or responses, or std::nullopt if the
+    ///         packet is not a batch.
+    auto split_batch(buffer& pkt) -> std::optional<std::vector<buffer>>;
+}
+
 #endif
@@ -7,10 +7,17 @@
 #define OPENCBDC_TX_SRC_RPC_HEADER_H_
 
 #include <cstdint>
+#include <limits>
 
 namespace cbdc::rpc {
     using request_id_type = uint64_t;
 
+    /// Request ID of a batch packet. Never used by a single request. A batch
+    /// packet holds several serialized requests or responses after its
+    /// header, each with its own request ID.
+    static constexpr request_id_type batch_request_id
+        = std::numeric_limits<request_id_type>::max();
+
     /// RPC request and response header.
     struct header {
         /// Identifier for matching requests with responses.
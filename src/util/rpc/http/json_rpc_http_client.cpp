@@ -13,7 +13,9 @@
 #include "epoll_event_handler.hpp"
 #endif
 
+#include <algorithm>
 #include <cassert>
+#include <utility>
 
 namespace cbdc::rpc {
     curl_initializer::curl_initializer() {
@@ -27,10 +29,14 @@ namespace cbdc::rpc {
     json_rpc_http_client::json_rpc_http_client(
         std::vector<std::string> endpoints,
         long timeout,
-        std::shared_ptr<logging::log> log)
-        : m_endpoints(std::move(endpoints)),
-          m_timeout(timeout),
+        std::shared_ptr<logging::log> log,
+        size_t max_batch_size)
+        : m_timeout(timeout),
+          m_max_batch_size(std::max(max_batch_size, size_t{1})),
           m_log(std::move(log)) {
+        for(auto& url : endpoints) {
+            m_endpoints.push_back(endpoint{std::move(url), {}, 0});
+        }
 // TODO: find a way to do this without the preprocessor
 #ifdef __APPLE__
         m_ev_handler = std::make_unique<kqueue_event_handler>();
@@ -50,11 +56,14 @@ namespace cbdc::rpc {
                           CURLMOPT_SOCKETFUNCTION,
                           socket_callback);
         curl_multi_setopt(m_multi_handle, CURLMOPT_SOCKETDATA, this);
+        // Multiplex requests over one connection when the server supports
+        // HTTP/2, otherwise use one keep-alive connection per transfer
+        curl_multi_setopt(m_multi_handle,
+                          CURLMOPT_PIPELINING,
+                          CURLPIPE_MULTIPLEX);
         m_headers
             = curl_slist_append(m_headers, "Content-Type: application/json");
         m_headers = curl_slist_append(m_headers, "charsets: utf-8");
-        m_payload["id"] = 1;
-        m_payload["jsonrpc"] = "2.0";
     }
 
     json_rpc_http_client::~json_rpc_http_client() {
@@ -63,15 +72,18 @@ namespace cbdc::rpc {
                 m_log->fatal("Error removing handle");
             }
             curl_easy_cleanup(handle);
-            t->m_cb(std::nullopt);
+            complete(*t, std::nullopt);
+        }
+        for(auto& [req, cb] : m_queued) {
+            cb(std::nullopt);
         }
         if(curl_multi_cleanup(m_multi_handle) != CURLM_OK) {
             m_log->fatal("Error cleaning up multi_handle");
         }
-        while(!m_handles.empty()) {
-            auto* handle = m_handles.front();
-            curl_easy_cleanup(handle);
-            m_handles.pop();
+        for(auto& ep : m_endpoints) {
+            for(auto* handle : ep.m_idle_handles) {
+                curl_easy_cleanup(handle);
+            }
         }
         curl_slist_free_all(m_headers);
     }
@@ -79,42 +91,125 @@ namespace cbdc::rpc {
     void json_rpc_http_client::call(const std::string& method,
                                     Json::Value params,
                                     callback_type result_fn) {
-        CURL* handle{};
-        if(m_handles.empty()) {
-            handle = curl_easy_init();
-            curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1);
-            curl_easy_setopt(handle,
-                             CURLOPT_URL,
-                             m_endpoints[m_lb_idx].c_str());
-            m_lb_idx = (m_lb_idx + 1) % m_endpoints.size();
-            curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, write_data);
-            curl_easy_setopt(handle, CURLOPT_HTTPHEADER, m_headers);
-            curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, m_timeout);
-            curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT, 3);
-            // curl_easy_setopt(handle, CURLOPT_TIMEOUT, 5);
-        } else {
-            handle = m_handles.front();
-            m_handles.pop();
+        auto req = Json::Value();
+        req["jsonrpc"] = "2.0";
+        req["method"] = method;
+        req["params"] = std::move(params);
+
+        if(m_max_batch_size == 1) {
+            req["id"] = 1;
+            auto tf = std::make_unique<transfer>();
+            tf->m_cbs.emplace_back(std::move(result_fn));
+            tf->m_payload = Json::writeString(m_builder, req);
+            send(std::move(tf));
+            return;
+        }
+
+        m_queued.emplace_back(std::move(req), std::move(result_fn));
+        if(m_queued.size() >= m_max_batch_size) {
+            send_queued();
         }
+    }
 
-        auto it = m_transfers.emplace(handle, std::make_unique<transfer>());
-        auto& tf = it.first->second;
-        tf->m_cb = std::move(result_fn);
+    auto json_rpc_http_client::get_handle(size_t ep) -> CURL* {
+        auto& idle = m_endpoints[ep].m_idle_handles;
+        if(!idle.empty()) {
+            auto* handle = idle.back();
+            idle.pop_back();
+            return handle;
+        }
 
-        curl_easy_setopt(handle, CURLOPT_WRITEDATA, tf.get());
+        auto* handle = curl_easy_init();
+        curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1);
+        curl_easy_setopt(handle, CURLOPT_URL, m_endpoints[ep].m_url.c_str());
+        curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, write_data);
+        curl_easy_setopt(handle, CURLOPT_HTTPHEADER, m_headers);
+        curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, m_timeout);
+        curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT, 3);
+        curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(handle, CURLOPT_TCP_NODELAY, 1L);
+        return handle;
+    }
 
-        m_payload["method"] = method;
-        m_payload["params"] = std::move(params);
+    void json_rpc_http_client::send(std::unique_ptr<transfer> tf) {
+        // Least outstanding calls, starting the search after the endpoint
+        // picked last time so ties rotate between endpoints
+        auto ep = m_lb_idx % m_endpoints.size();
+        for(size_t i = 1; i < m_endpoints.size(); i++) {
+            const auto idx = (m_lb_idx + i) % m_endpoints.size();
+            if(m_endpoints[idx].m_outstanding
+               < m_endpoints[ep].m_outstanding) {
+                ep = idx;
+            }
+        }
+        m_lb_idx = ep + 1;
+        m_endpoints[ep].m_outstanding += tf->m_cbs.size();
+        tf->m_endpoint = ep;
 
-        tf->m_payload = Json::writeString(m_builder, m_payload);
+        auto* handle = get_handle(ep);
+        curl_easy_setopt(handle, CURLOPT_WRITEDATA, tf.get());
+        curl_easy_setopt(handle,
+                         CURLOPT_POSTFIELDSIZE,
+                         static_cast<long>(tf->m_payload.size()));
         curl_easy_setopt(handle, CURLOPT_POSTFIELDS, tf->m_payload.c_str());
 
+        m_transfers.emplace(handle, std::move(tf));
+
         if(curl_multi_add_handle(m_multi_handle, handle) != CURLM_OK) {
             m_log->fatal("Error adding handle");
         }
+    }
 
-        // m_requests_started++;
-        // m_log->trace("requests started:", m_requests_started);
+    void json_rpc_http_client::send_queued() {
+        auto queued = std::exchange(m_queued, {});
+        for(size_t i = 0; i < queued.size(); i += m_max_batch_size) {
+            const auto n = std::min(m_max_batch_size, queued.size() - i);
+            auto tf = std::make_unique<transfer>();
+            tf->m_cbs.reserve(n);
+            if(n == 1) {
+                auto& [req, cb] = queued[i];
+                req["id"] = 1;
+                tf->m_cbs.emplace_back(std::move(cb));
+                tf->m_payload = Json::writeString(m_builder, req);
+            } else {
+                tf->m_batch = true;
+                auto batch = Json::Value(Json::arrayValue);
+                for(size_t j = 0; j < n; j++) {
+                    auto& [req, cb] = queued[i + j];
+                    req["id"] = static_cast<Json::UInt64>(j);
+                    batch.append(std::move(req));
+                    tf->m_cbs.emplace_back(std::move(cb));
+                }
+                tf->m_payload = Json::writeString(m_builder, batch);
+            }
+            send(std::move(tf));
+        }
+    }
+
+    void json_rpc_http_client::complete(transfer& tf,
+                                        std::optional<Json::Value> res) {
+        if(!tf.m_batch) {
+            tf.m_cbs.front()(std::move(res));
+            return;
+        }
+
+        // Responses to a batch may come back in any order, and calls which
+        // the server could not parse may have no response
+        auto resps = std::vector<std::optional<Json::Value>>(tf.m_cbs.size());
+        if(res.has_value() && res->isArray()) {
+            for(auto& resp : res.value()) {
+                if(!resp.isObject() || !resp["id"].isUInt64()) {
+                    continue;
+                }
+                const auto id = resp["id"].asUInt64();
+                if(id < resps.size()) {
+                    resps[id] = std::move(resp);
+                }
+            }
+        }
+        for(size_t i = 0; i < tf.m_cbs.size(); i++) {
+            tf.m_cbs[i](std::move(resps[i]));
+        }
     }
 
     auto json_rpc_http_client::write_data(void* ptr,
@@ -128,6 +223,10 @@ namespace cbdc::rpc {
     }
 
     auto json_rpc_http_client::pump() -> bool {
+        if(!m_queued.empty()) {
+            send_queued();
+        }
+
         auto maybe_events = m_ev_handler->poll();
         if(!maybe_events.has_value()) {
             m_log->error("Polling error");
@@ -166,7 +265,7 @@ namespace cbdc::rpc {
             auto& tf = it.mapped();
 
             if(m->msg != CURLMSG_DONE) {
-                tf->m_cb(std::nullopt);
+                complete(*tf, std::nullopt);
             } else {
                 if(m->data.result != CURLE_OK) {
                     m_log->warn("CURL error:",
@@ -193,14 +292,14 @@ namespace cbdc::rpc {
 
                 if(http_code / 100 != 2) {
                     m_log->warn("Bad return code:", http_code);
-                    tf->m_cb(std::nullopt);
+                    complete(*tf, std::nullopt);
                 } else {
                     auto res = Json::Value();
                     auto r = Json::Reader();
                     auto success = r.parse(tf->m_result.str(), res, false);
                     if(success) {
                         // TODO: sanity check the value of res
-                        tf->m_cb(std::move(res));
+                        complete(*tf, std::move(res));
                     } else {
                         m_log->warn(r.getFormattedErrorMessages(),
                                     "res:",
@@ -208,12 +307,14 @@ namespace cbdc::rpc {
                                     "(",
                                     tf->m_result.str().size(),
                                     ")");
-                        tf->m_cb(std::nullopt);
+                        complete(*tf, std::nullopt);
                     }
                 }
             }
 
-            m_handles.push(m->easy_handle);
+            auto& ep = m_endpoints[tf->m_endpoint];
+            ep.m_outstanding -= tf->m_cbs.size();
+            ep.m_idle_handles.push_back(m->easy_handle);
             if(curl_multi_remove_handle(m_multi_handle, m->easy_handle)
                != CURLM_OK) {
                 m_log->error("Error removing multi handle");
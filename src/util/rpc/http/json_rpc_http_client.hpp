@@ -13,9 +13,10 @@
 #include <functional>
 #include <json/json.h>
 #include <optional>
-#include <queue>
 #include <set>
+#include <sstream>
 #include <unordered_map>
+#include <vector>
 
 namespace cbdc::rpc {
     /// Class for performing libcurl global initialization.
@@ -31,17 +32,26 @@ namespace cbdc::rpc {
     /// application.
     static curl_initializer curl_init = curl_initializer();
 
-    /// Asynchronous HTTP JSON-RPC client implemented using libcurl. Supports
-    /// randomized load balancing across multiple RPC endpoints.
+    /// Asynchronous HTTP JSON-RPC client implemented using libcurl. Keeps a
+    /// pool of configured easy handles for each RPC endpoint so requests
+    /// reuse persistent keep-alive connections, and sends each request to the
+    /// endpoint with the fewest outstanding calls. Can optionally send calls
+    /// in JSON-RPC batch requests.
     class json_rpc_http_client {
       public:
         /// Construct a new client.
         /// \param endpoints list of RPC endpoints to load balance between.
         /// \param timeout response timeout in milliseconds. 0 for no timeout.
         /// \param log log instance.
+        /// \param max_batch_size maximum number of calls to send in one
+        ///                       JSON-RPC batch request. Calls are queued
+        ///                       until the next pump() or until a batch is
+        ///                       full. 1 sends each call in its own request
+        ///                       right away.
         json_rpc_http_client(std::vector<std::string> endpoints,
                              long timeout,
-                             std::shared_ptr<logging::log> log);
+                             std::shared_ptr<logging::log> log,
+                             size_t max_batch_size = 1);
         /// Cancels any existing requests and stops the client.
         ~json_rpc_http_client();
 
@@ -64,36 +74,64 @@ namespace cbdc::rpc {
                   Json::Value params,
                   callback_type result_fn);
 
-        /// Process events raised by the underlying libcurl implementation.
+        /// Sends any queued calls, then processes events raised by the
+        /// underlying libcurl implementation.
         /// \return true if the last pump was successful and should be
         ///         continued.
         [[nodiscard]] auto pump() -> bool;
 
       private:
-        std::vector<std::string> m_endpoints;
+        /// An RPC endpoint and its pool of idle easy handles.
+        struct endpoint {
+            std::string m_url;
+            std::vector<CURL*> m_idle_handles;
+            /// Calls sent to the endpoint which have not completed.
+            size_t m_outstanding{};
+        };
+
+        std::vector<endpoint> m_endpoints;
         long m_timeout;
+        size_t m_max_batch_size;
         std::unique_ptr<event_handler> m_ev_handler;
 
         Json::StreamWriterBuilder m_builder;
 
         CURLM* m_multi_handle{};
 
-        std::queue<CURL*> m_handles;
-
         struct transfer {
             std::stringstream m_result;
-            callback_type m_cb;
+            /// Callbacks for the calls in the request. The ID of each call
+            /// in a batch request is its index.
+            std::vector<callback_type> m_cbs;
+            bool m_batch{false};
             std::string m_payload;
+            size_t m_endpoint{};
         };
 
         std::unordered_map<CURL*, std::unique_ptr<transfer>> m_transfers;
 
+        /// Calls waiting to be sent in a batch request.
+        std::vector<std::pair<Json::Value, callback_type>> m_queued;
+
         curl_slist* m_headers{};
-        Json::Value m_payload;
 
+        /// Endpoint to prefer when several have the fewest outstanding
+        /// calls.
         size_t m_lb_idx{};
 
-        // size_t m_requests_started{};
+        /// Returns an easy handle for the given endpoint, reusing an idle
+        /// one if there is one.
+        auto get_handle(size_t ep) -> CURL*;
+
+        /// Sends the calls in the given transfer to the endpoint with the
+        /// fewest outstanding calls.
+        void send(std::unique_ptr<transfer> tf);
+
+        /// Sends the queued calls in batches of up to m_max_batch_size.
+        void send_queued();
+
+        /// Passes the response to a transfer to the callbacks of its calls.
+        static void complete(transfer& tf, std::optional<Json::Value> res);
 
         static auto
         write_data(void* ptr, size_t size, size_t nmemb, struct transfer* t)
@@ -121,9 +121,7 @@ namespace cbdc::rpc {
         }
 
         if(*upload_data_size != 0) {
-            req->m_request.write(
-                upload_data,
-                static_cast<std::streamsize>(*upload_data_size));
+            req->m_request.append(upload_data, *upload_data_size);
             *upload_data_size = 0;
             return MHD_YES;
         }
@@ -215,45 +213,360 @@ namespace cbdc::rpc {
         return ret == MHD_YES;
     }
 
-    auto json_rpc_http_server::handle_request(request* request_info) -> bool {
-        auto req = Json::Value();
-        auto r = Json::Reader();
-        auto success = r.parse(request_info->m_request.str(), req, false);
-        if(!success) {
+    auto json_rpc_http_server::parse_flat_call(std::string_view payload)
+        -> std::optional<call> {
+        size_t pos{0};
+        auto skip_ws = [&]() {
+            while(pos < payload.size()
+                  && (payload[pos] == ' ' || payload[pos] == '\t'
+                      || payload[pos] == '\n' || payload[pos] == '\r')) {
+                pos++;
+            }
+        };
+        auto consume = [&](char c) {
+            skip_ws();
+            if(pos < payload.size() && payload[pos] == c) {
+                pos++;
+                return true;
+            }
             return false;
+        };
+        // Strings with escapes are left to the full parser
+        auto read_string = [&]() -> std::optional<std::string_view> {
+            if(!consume('"')) {
+                return std::nullopt;
+            }
+            const auto begin = pos;
+            while(pos < payload.size() && payload[pos] != '"') {
+                if(payload[pos] == '\\'
+                   || static_cast<unsigned char>(payload[pos]) < ' ') {
+                    return std::nullopt;
+                }
+                pos++;
+            }
+            if(pos == payload.size()) {
+                return std::nullopt;
+            }
+            return payload.substr(begin, pos++ - begin);
+        };
+        auto read_literal = [&](std::string_view lit) {
+            skip_ws();
+            if(payload.substr(pos, lit.size()) != lit) {
+                return false;
+            }
+            pos += lit.size();
+            return true;
+        };
+        auto read_param = [&]() -> std::optional<Json::Value> {
+            skip_ws();
+            if(pos == payload.size()) {
+                return std::nullopt;
+            }
+            if(payload[pos] == '"') {
+                auto str = read_string();
+                if(!str.has_value()) {
+                    return std::nullopt;
+                }
+                return Json::Value(str->data(), str->data() + str->size());
+            }
+            if(read_literal("true")) {
+                return Json::Value(true);
+            }
+            if(read_literal("false")) {
+                return Json::Value(false);
+            }
+            if(!consume('{')) {
+                return std::nullopt;
+            }
+            auto obj = Json::Value(Json::objectValue);
+            if(consume('}')) {
+                return obj;
+            }
+            do {
+                auto key = read_string();
+                if(!key.has_value() || !consume(':')) {
+                    return std::nullopt;
+                }
+                auto val = read_string();
+                if(!val.has_value()) {
+                    return std::nullopt;
+                }
+                obj[std::string(key.value())]
+                    = Json::Value(val->data(), val->data() + val->size());
+            } while(consume(','));
+            if(!consume('}')) {
+                return std::nullopt;
+            }
+            return obj;
+        };
+
+        auto ret = call{};
+        auto has_method = false;
+        if(!consume('{')) {
+            return std::nullopt;
+        }
+        do {
+            auto key = read_string();
+            if(!key.has_value() || !consume(':')) {
+                return std::nullopt;
+            }
+            if(key.value() == "jsonrpc") {
+                if(!read_string().has_value()) {
+                    return std::nullopt;
+                }
+            } else if(key.value() == "method") {
+                auto method = read_string();
+                if(!method.has_value()) {
+                    return std::nullopt;
+                }
+                ret.m_method = method.value();
+                has_method = true;
+            } else if(key.value() == "id") {
+                skip_ws();
+                const auto begin = pos;
+                uint64_t id{0};
+                while(pos < payload.size() && payload[pos] >= '0'
+                      && payload[pos] <= '9' && pos - begin < 19) {
+                    static constexpr uint64_t base{10};
+                    id = id * base + static_cast<uint64_t>(payload[pos] - '0');
+                    pos++;
+                }
+                if(pos == begin || (pos < payload.size() && payload[pos] >= '0'
+                                    && payload[pos] <= '9')) {
+                    return std::nullopt;
+                }
+                ret.m_id = id;
+                ret.m_notification = false;
+            } else if(key.value() == "params") {
+                if(!consume('[')) {
+                    return std::nullopt;
+                }
+                ret.m_params = Json::Value(Json::arrayValue);
+                if(!consume(']')) {
+                    do {
+                        auto param = read_param();
+                        if(!param.has_value()) {
+                            return std::nullopt;
+                        }
+                        ret.m_params.append(std::move(param.value()));
+                    } while(consume(','));
+                    if(!consume(']')) {
+                        return std::nullopt;
+                    }
+                }
+            } else {
+                return std::nullopt;
+            }
+        } while(consume(','));
+        if(!consume('}')) {
+            return std::nullopt;
+        }
+        skip_ws();
+        if(pos != payload.size() || !has_method) {
+            return std::nullopt;
+        }
+        return ret;
+    }
+
+    auto json_rpc_http_server::parse_call(Json::Value& req)
+        -> std::optional<call> {
+        if(!req.isObject()) {
+            return std::nullopt;
         }
 
         if(!req.isMember("method")) {
-            return false;
+            return std::nullopt;
         }
 
         if(!req["method"].isString()) {
-            return false;
+            return std::nullopt;
         }
 
-        auto method = req["method"].asString();
-        auto params = Json::Value();
+        auto ret = call{};
+        ret.m_method = req["method"].asString();
 
         if(req.isMember("params")) {
-            params = req["params"];
+            ret.m_params = std::move(req["params"]);
         }
 
-        uint64_t id = 0;
-        if(req["id"].isUInt64()) {
-            id = req["id"].asUInt64();
+        if(req.isMember("id")) {
+            ret.m_notification = false;
+            if(req["id"].isUInt64()) {
+                ret.m_id = req["id"].asUInt64();
+            }
+        }
+
+        return ret;
+    }
+
+    auto json_rpc_http_server::handle_request(request* request_info) -> bool {
+        const auto& payload = request_info->m_request;
+        auto maybe_call = parse_flat_call(payload);
+        if(!maybe_call.has_value()) {
+            auto req = Json::Value();
+            auto r = Json::Reader();
+            auto success = r.parse(payload.data(),
+                                   payload.data() + payload.size(),
+                                   req,
+                                   false);
+            if(!success) {
+                return false;
+            }
+
+            if(req.isArray()) {
+                return handle_batch(request_info, req);
+            }
+
+            maybe_call = parse_call(req);
+            if(!maybe_call.has_value()) {
+                return false;
+            }
         }
 
+        auto& c = maybe_call.value();
         MHD_suspend_connection(request_info->m_connection);
 
         auto maybe_sent
-            = m_cb(method,
-                   params,
-                   [this, request_info, id](std::optional<Json::Value> resp) {
+            = m_cb(std::move(c.m_method),
+                   std::move(c.m_params),
+                   [this, request_info, id = c.m_id](
+                       std::optional<Json::Value> resp) {
                        handle_response(id, request_info, std::move(resp));
                    });
         return maybe_sent;
     }
 
+    auto json_rpc_http_server::handle_batch(request* request_info,
+                                            Json::Value& reqs) -> bool {
+        if(reqs.empty()) {
+            // An empty batch is a single invalid request, not a batch
+            auto err = Json::Value();
+            err["jsonrpc"] = "2.0";
+            err["error"]["code"] = invalid_request_code;
+            err["error"]["message"] = "Invalid request";
+            err["id"] = Json::Value();
+            request_info->m_code = MHD_HTTP_OK;
+            send_response(Json::writeString(m_builder, err), request_info);
+            return true;
+        }
+
+        auto b = std::make_shared<batch>();
+        b->m_results.resize(reqs.size());
+        b->m_pending = reqs.size() + 1;
+
+        MHD_suspend_connection(request_info->m_connection);
+
+        for(Json::ArrayIndex i = 0; i < reqs.size(); i++) {
+            auto id = reqs[i].isObject() ? reqs[i].get("id", Json::Value())
+                                         : Json::Value();
+            auto c = parse_call(reqs[i]);
+            if(!c.has_value()) {
+                auto err = Json::Value();
+                err["error"]["code"] = invalid_request_code;
+                err["error"]["message"] = "Invalid request";
+                err["id"] = Json::Value();
+                complete_batch_call(request_info, b, i, std::move(err));
+                continue;
+            }
+
+            if(c->m_notification) {
+                // Nothing waits for the outcome, and the batch may be
+                // answered before the handler finishes
+                m_cb(std::move(c->m_method),
+                     std::move(c->m_params),
+                     [](const std::optional<Json::Value>& /* resp */) {});
+                release_batch(request_info, b);
+                continue;
+            }
+
+            // The handler may fail after it has already responded, so only
+            // the first outcome counts
+            auto done = std::make_shared<std::atomic<bool>>(false);
+            auto sent = m_cb(
+                std::move(c->m_method),
+                std::move(c->m_params),
+                [this, request_info, b, i, id, done](
+                    std::optional<Json::Value> resp) {
+                    if(!done->exchange(true)) {
+                        complete_batch_call(request_info,
+                                            b,
+                                            i,
+                                            make_result(id, std::move(resp)));
+                    }
+                });
+            if(!sent && !done->exchange(true)) {
+                auto err = Json::Value();
+                err["error"]["code"] = invalid_params_code;
+                err["error"]["message"] = "Invalid request payload";
+                complete_batch_call(request_info,
+                                    b,
+                                    i,
+                                    make_result(id, std::move(err)));
+            }
+        }
+
+        release_batch(request_info, b);
+        return true;
+    }
+
+    void json_rpc_http_server::complete_batch_call(
+        request* request_info,
+        const std::shared_ptr<batch>& b,
+        size_t idx,
+        Json::Value result) {
+        {
+            std::unique_lock l(b->m_mut);
+            b->m_results[idx] = std::move(result);
+        }
+        release_batch(request_info, b);
+    }
+
+    void
+    json_rpc_http_server::release_batch(request* request_info,
+                                        const std::shared_ptr<batch>& b) {
+        {
+            std::unique_lock l(b->m_mut);
+            if(--b->m_pending != 0) {
+                return;
+            }
+        }
+
+        auto resp = Json::Value(Json::arrayValue);
+        for(auto& result : b->m_results) {
+            if(result.isNull()) {
+                continue;
+            }
+            if(!result.isMember("jsonrpc")) {
+                result["jsonrpc"] = "2.0";
+            }
+            resp.append(std::move(result));
+        }
+        if(resp.empty()) {
+            // A batch of only notifications gets no response at all
+            request_info->m_code = MHD_HTTP_NO_CONTENT;
+            send_response("", request_info);
+            return;
+        }
+        request_info->m_code = MHD_HTTP_OK;
+        auto resp_str = Json::writeString(m_builder, resp);
+        send_response(std::move(resp_str), request_info);
+    }
+
+    auto json_rpc_http_server::make_result(Json::Value id,
+                                           std::optional<Json::Value> resp)
+        -> Json::Value {
+        auto ret = Json::Value();
+        if(resp.has_value()) {
+            ret = std::move(resp.value());
+        } else {
+            ret["error"]["code"] = internal_error_code;
+            ret["error"]["message"] = "Error processing request";
+        }
+        ret["jsonrpc"] = "2.0";
+        ret["id"] = std::move(id);
+        return ret;
+    }
+
     void
     json_rpc_http_server::handle_response(uint64_t id,
                                           request* request_info,
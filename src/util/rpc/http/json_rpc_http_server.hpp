@@ -14,11 +14,15 @@
 #include <microhttpd.h>
 #include <mutex>
 #include <optional>
-#include <sstream>
+#include <string_view>
+#include <vector>
 
 namespace cbdc::rpc {
     /// Asynchrounous HTTP JSON-RPC server implemented using libmicrohttpd and
-    /// libjsoncpp.
+    /// libjsoncpp. Accepts JSON-RPC 2.0 batch requests, whose calls are
+    /// dispatched to the handler concurrently. Notifications within a batch
+    /// get no response, as in the specification. A single notification
+    /// outside of a batch is still answered, with an ID of zero.
     class json_rpc_http_server {
       public:
         /// Type alias for the callback function for returning response values
@@ -53,10 +57,39 @@ namespace cbdc::rpc {
         /// \return true if listening was successful.
         auto init() -> bool;
 
+        /// A single call parsed from a request payload.
+        struct call {
+            /// Name of the method to call.
+            std::string m_method;
+            /// Call parameters, or null if the request has none.
+            Json::Value m_params;
+            /// Request ID, or zero if it is not an unsigned integer.
+            uint64_t m_id{};
+            /// True if the request has no ID and expects no response.
+            bool m_notification{true};
+        };
+
+        /// Parses requests whose parameters are strings, booleans or
+        /// objects with string values without building a Json::Value tree
+        /// for the whole payload, which covers the frequent transaction
+        /// calls. Any call it returns is the same as \ref parse_call would
+        /// return for the parsed payload.
+        /// \param payload request payload.
+        /// \return the call, or std::nullopt if the payload has any other
+        ///         form and must be parsed in full.
+        static auto parse_flat_call(std::string_view payload)
+            -> std::optional<call>;
+
+        /// Extracts a call from a parsed request.
+        /// \param req request object. Its parameters are moved out.
+        /// \return the call, or std::nullopt if the request is not an
+        ///         object with a string method.
+        static auto parse_call(Json::Value& req) -> std::optional<call>;
+
       private:
         struct request {
             MHD_Connection* m_connection{};
-            std::stringstream m_request;
+            std::string m_request;
             json_rpc_http_server* m_server{};
             const char* m_origin{};
             unsigned int m_code{};
@@ -88,8 +121,40 @@ namespace cbdc::rpc {
         static auto send_response(std::string response, request* request_info)
             -> bool;
 
+        static constexpr int invalid_request_code = -32600;
+        static constexpr int invalid_params_code = -32602;
+        static constexpr int internal_error_code = -32603;
+
+        /// Responses to the calls in a batch request.
+        struct batch {
+            std::mutex m_mut;
+            /// Response to each call, or null for notifications.
+            std::vector<Json::Value> m_results;
+            /// Calls still waiting for a response, plus one until every
+            /// call has been dispatched.
+            size_t m_pending{};
+        };
+
         auto handle_request(request* request_info) -> bool;
 
+        auto handle_batch(request* request_info, Json::Value& reqs) -> bool;
+
+        void complete_batch_call(request* request_info,
+                                 const std::shared_ptr<batch>& b,
+                                 size_t idx,
+                                 Json::Value result);
+
+        /// Drops one pending reference to the batch, and sends the
+        /// responses once there are none left.
+        void release_batch(request* request_info,
+                           const std::shared_ptr<batch>& b);
+
+        /// Returns the response to a call in a batch, which echoes the ID
+        /// of the request as it was sent.
+        static auto make_result(Json::Value id,
+                                std::optional<Json::Value> resp)
+            -> Json::Value;
+
         void handle_response(uint64_t id,
                              request* request_info,
                              std::optional<Json::Value> resp);
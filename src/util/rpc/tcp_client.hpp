@@ -10,12 +10,18 @@
 #include "util/common/variant_overloaded.hpp"
 #include "util/network/connection_manager.hpp"
 
-#include <future>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 
 namespace cbdc::rpc {
     /// Implements an RPC client over TCP sockets. Accepts multiple server
-    /// endpoints for failover purposes.
+    /// endpoints for failover purposes. Can optionally coalesce requests
+    /// issued within a short window into one batch packet.
     /// \see cbdc::rpc::tcp_server
     /// \tparam Request type for requests.
     /// \tparam Response type for responses.
@@ -24,8 +30,15 @@ namespace cbdc::rpc {
       public:
         /// Constructor.
         /// \param server_endpoints RPC server endpoints to which to connect.
-        explicit tcp_client(std::vector<network::endpoint_t> server_endpoints)
-            : m_server_endpoints(std::move(server_endpoints)) {}
+        /// \param coalesce_window time to wait for more requests to send in
+        ///                        the same packet as the first. Zero sends
+        ///                        each request in its own packet.
+        explicit tcp_client(std::vector<network::endpoint_t> server_endpoints,
+                            std::chrono::microseconds coalesce_window
+                            = std::chrono::microseconds::zero())
+            : m_server_endpoints(std::move(server_endpoints)),
+              m_coalesce_window(coalesce_window),
+              m_slots(slot_count) {}
 
         tcp_client(tcp_client&&) = delete;
         auto operator=(tcp_client&&) -> tcp_client& = delete;
@@ -36,18 +49,32 @@ namespace cbdc::rpc {
             typename client<Request, Response>::response_type;
 
         /// Destructor. Disconnects from the RPC servers and stops the response
-        /// handler thread.
+        /// handler thread. Fails any requests still waiting for a response.
         ~tcp_client() override {
+            {
+                std::unique_lock<std::mutex> l(m_batch_mut);
+                m_running = false;
+            }
+            m_batch_cv.notify_one();
+            if(m_coalesce_thread.joinable()) {
+                m_coalesce_thread.join();
+            }
             m_net.close();
             if(m_handler_thread.joinable()) {
                 m_handler_thread.join();
             }
-            {
-                std::unique_lock<std::mutex> l(m_responses_mut);
-                for(auto& [request_id, action] : m_responses) {
-                    set_response_value(action, std::nullopt);
+            for(size_t i = 0; i < slot_count; i++) {
+                auto action = take_slot(m_slots[i], std::nullopt);
+                if(action.has_value()) {
+                    set_response_value(action.value(), std::nullopt);
                 }
-                m_responses.clear();
+            }
+            auto overflow = [&]() {
+                std::unique_lock<std::mutex> l(m_overflow_mut);
+                return std::exchange(m_overflow, {});
+            }();
+            for(auto& [request_id, action] : overflow) {
+                set_response_value(action, std::nullopt);
             }
         }
 
@@ -83,40 +110,224 @@ namespace cbdc::rpc {
                     return response_handler(std::move(msg));
                 });
 
+            if(m_coalesce_window != std::chrono::microseconds::zero()) {
+                m_coalesce_thread = std::thread([&]() {
+                    coalesce_loop();
+                });
+            }
+
             return true;
         }
 
       private:
+        using raw_callback_type =
+            typename client<Request, Response>::raw_callback_type;
+
+        /// Response slot of a caller blocked in the timed call_raw().
+        struct waiter {
+            std::mutex m_mut;
+            std::condition_variable m_cv;
+            std::optional<response_type> m_value;
+            bool m_done{false};
+        };
+
+        using response_action_type
+            = std::variant<waiter*, raw_callback_type>;
+
+        static constexpr uint8_t slot_free{0};
+        static constexpr uint8_t slot_busy{1};
+        static constexpr uint8_t slot_full{2};
+
+        /// \brief Entry in the table of requests waiting for a response.
+        ///
+        /// The thread that moves the state from free or full to busy owns
+        /// the ID and action until it stores the state again.
+        struct slot {
+            std::atomic<uint8_t> m_state{slot_free};
+            request_id_type m_id{};
+            response_action_type m_action;
+        };
+
+        /// Number of slots in the table, indexed by the low bits of the
+        /// request ID. Must be a power of two.
+        static constexpr size_t slot_count{1024};
+
+        /// Maximum number of requests sent in one batch packet.
+        static constexpr size_t max_batch_requests{256};
+
         network::connection_manager m_net;
         std::vector<network::endpoint_t> m_server_endpoints;
         std::thread m_handler_thread;
 
-        using raw_callback_type =
-            typename client<Request, Response>::raw_callback_type;
+        std::chrono::microseconds m_coalesce_window;
+        std::mutex m_batch_mut;
+        std::condition_variable m_batch_cv;
+        std::vector<std::pair<request_id_type, buffer>> m_batch;
+        bool m_running{true};
+        std::thread m_coalesce_thread;
 
-        using promise_type = std::promise<std::optional<response_type>>;
-        using response_action_type
-            = std::variant<promise_type, raw_callback_type>;
+        std::vector<slot> m_slots;
 
-        std::mutex m_responses_mut;
-        std::unordered_map<request_id_type, response_action_type> m_responses;
+        /// Requests whose slot was taken by an earlier request which is
+        /// still waiting for its response.
+        std::mutex m_overflow_mut;
+        std::unordered_map<request_id_type, response_action_type> m_overflow;
+
+        void add_action(request_id_type request_id,
+                        response_action_type response_action) {
+            auto& s = m_slots[request_id & (slot_count - 1)];
+            auto state = s.m_state.load(std::memory_order_relaxed);
+            while(true) {
+                if(state == slot_busy) {
+                    std::this_thread::yield();
+                    state = s.m_state.load(std::memory_order_relaxed);
+                    continue;
+                }
+                if(state == slot_full) {
+                    std::unique_lock<std::mutex> l(m_overflow_mut);
+                    m_overflow.emplace(request_id, std::move(response_action));
+                    return;
+                }
+                if(s.m_state.compare_exchange_weak(
+                       state,
+                       slot_busy,
+                       std::memory_order_acquire,
+                       std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            s.m_id = request_id;
+            s.m_action = std::move(response_action);
+            s.m_state.store(slot_full, std::memory_order_release);
+        }
+
+        /// Takes the action out of a slot if it holds the given request ID,
+        /// or any request ID if std::nullopt.
+        auto take_slot(slot& s, std::optional<request_id_type> request_id)
+            -> std::optional<response_action_type> {
+            auto state = s.m_state.load(std::memory_order_relaxed);
+            while(true) {
+                if(state == slot_free) {
+                    return std::nullopt;
+                }
+                if(state == slot_busy) {
+                    std::this_thread::yield();
+                    state = s.m_state.load(std::memory_order_relaxed);
+                    continue;
+                }
+                if(s.m_state.compare_exchange_weak(
+                       state,
+                       slot_busy,
+                       std::memory_order_acquire,
+                       std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            if(request_id.has_value() && s.m_id != request_id.value()) {
+                s.m_state.store(slot_full, std::memory_order_release);
+                return std::nullopt;
+            }
+            auto action = std::move(s.m_action);
+            s.m_action = response_action_type();
+            s.m_state.store(slot_free, std::memory_order_release);
+            return action;
+        }
+
+        auto take_action(request_id_type request_id)
+            -> std::optional<response_action_type> {
+            auto& s = m_slots[request_id & (slot_count - 1)];
+            auto action = take_slot(s, request_id);
+            if(action.has_value()) {
+                return action;
+            }
+            std::unique_lock<std::mutex> l(m_overflow_mut);
+            auto node = m_overflow.extract(request_id);
+            if(node.empty()) {
+                return std::nullopt;
+            }
+            return std::move(node.mapped());
+        }
 
         auto send_request(cbdc::buffer request_buf,
                           request_id_type request_id,
                           response_action_type response_action) -> bool {
+            add_action(request_id, std::move(response_action));
+            if(m_coalesce_window == std::chrono::microseconds::zero()) {
+                auto pkt = std::make_shared<buffer>(std::move(request_buf));
+                return m_net.send_to_one(pkt);
+            }
             {
-                std::unique_lock<std::mutex> l(m_responses_mut);
-                assert(m_responses.find(request_id) == m_responses.end());
-                m_responses[request_id] = std::move(response_action);
+                std::unique_lock<std::mutex> l(m_batch_mut);
+                if(!m_running) {
+                    return false;
+                }
+                m_batch.emplace_back(request_id, std::move(request_buf));
+            }
+            m_batch_cv.notify_one();
+            return true;
+        }
+
+        /// Waits for a request to send, then for the coalescing window to
+        /// pass or the batch to fill, and sends the batch.
+        void coalesce_loop() {
+            auto batch = std::vector<std::pair<request_id_type, buffer>>();
+            while(true) {
+                {
+                    std::unique_lock<std::mutex> l(m_batch_mut);
+                    m_batch_cv.wait(l, [&]() {
+                        return !m_batch.empty() || !m_running;
+                    });
+                    m_batch_cv.wait_for(l, m_coalesce_window, [&]() {
+                        return m_batch.size() >= max_batch_requests
+                            || !m_running;
+                    });
+                    std::swap(batch, m_batch);
+                }
+                send_batch(batch);
+                batch.clear();
+                std::unique_lock<std::mutex> l(m_batch_mut);
+                if(!m_running) {
+                    for(auto& [request_id, buf] : m_batch) {
+                        set_response(request_id, std::nullopt);
+                    }
+                    m_batch.clear();
+                    return;
+                }
+            }
+        }
+
+        void
+        send_batch(std::vector<std::pair<request_id_type, buffer>>& batch) {
+            if(batch.empty()) {
+                return;
+            }
+            auto pkt = std::make_shared<buffer>();
+            if(batch.size() == 1) {
+                *pkt = std::move(batch.front().second);
+            } else {
+                auto msgs = std::vector<buffer>();
+                msgs.reserve(batch.size());
+                for(auto& [request_id, buf] : batch) {
+                    msgs.emplace_back(std::move(buf));
+                }
+                *pkt = make_batch(msgs);
+            }
+            if(!m_net.send_to_one(pkt)) {
+                for(auto& [request_id, buf] : batch) {
+                    set_response(request_id, std::nullopt);
+                }
             }
-            auto pkt = std::make_shared<buffer>(std::move(request_buf));
-            return m_net.send_to_one(pkt);
         }
 
         void set_response_value(response_action_type& response_action,
                                 std::optional<response_type> value) {
-            std::visit(overloaded{[&](promise_type& p) {
-                                      p.set_value(std::move(value));
+            std::visit(overloaded{[&](waiter* w) {
+                                      // Notify while holding the lock so the
+                                      // waiter is not destroyed before then
+                                      std::unique_lock<std::mutex> l(w->m_mut);
+                                      w->m_value = std::move(value);
+                                      w->m_done = true;
+                                      w->m_cv.notify_one();
                                   },
                                   [&](raw_callback_type& cb) {
                                       cb(std::move(value));
@@ -128,47 +339,58 @@ namespace cbdc::rpc {
                       request_id_type request_id,
                       std::chrono::milliseconds timeout)
             -> std::optional<response_type> override {
-            auto response_promise = promise_type();
-            auto response_future = response_promise.get_future();
-
-            if(!send_request(std::move(request_buf),
-                             request_id,
-                             std::move(response_promise))) {
+            auto w = waiter();
+            if(!send_request(std::move(request_buf), request_id, &w)) {
                 set_response(request_id, std::nullopt);
-                return std::nullopt;
             }
 
-            if(timeout != std::chrono::milliseconds::zero()) {
-                auto res = response_future.wait_for(timeout);
-                if(res == std::future_status::timeout) {
-                    set_response(request_id, std::nullopt);
+            std::unique_lock<std::mutex> l(w.m_mut);
+            auto done = [&]() {
+                return w.m_done;
+            };
+            if(timeout == std::chrono::milliseconds::zero()) {
+                w.m_cv.wait(l, done);
+            } else if(!w.m_cv.wait_for(l, timeout, done)) {
+                l.unlock();
+                if(take_action(request_id).has_value()) {
                     return std::nullopt;
                 }
+                // The response handler took the action first, so wait for
+                // it to finish with the waiter
+                l.lock();
+                w.m_cv.wait(l, done);
             }
 
-            return response_future.get();
+            return std::move(w.m_value);
         }
 
         auto response_handler(network::message_t&& msg)
             -> std::optional<buffer> {
+            auto batch = split_batch(*msg.m_pkt);
+            if(!batch.has_value()) {
+                handle_response(*msg.m_pkt);
+                return std::nullopt;
+            }
+            for(auto& resp_buf : batch.value()) {
+                handle_response(resp_buf);
+            }
+            return std::nullopt;
+        }
+
+        void handle_response(buffer& resp_buf) {
             auto resp
-                = client<Request, Response>::deserialize_response(*msg.m_pkt);
+                = client<Request, Response>::deserialize_response(resp_buf);
             if(resp.has_value()) {
                 set_response(resp.value().m_header.m_request_id,
                              std::move(resp.value()));
             }
-            return std::nullopt;
         }
 
         void set_response(request_id_type request_id,
                           std::optional<response_type> value) {
-            auto response_node = [&]() {
-                std::unique_lock<std::mutex> l(m_responses_mut);
-                return m_responses.extract(request_id);
-            }();
-
-            if(!response_node.empty()) {
-                set_response_value(response_node.mapped(), std::move(value));
+            auto action = take_action(request_id);
+            if(action.has_value()) {
+                set_response_value(action.value(), std::move(value));
             }
         }
 
@@ -178,10 +400,7 @@ namespace cbdc::rpc {
             if(!send_request(std::move(request_buf),
                              request_id,
                              std::move(response_callback))) {
-                {
-                    std::unique_lock<std::mutex> l(m_responses_mut);
-                    m_responses.erase(request_id);
-                }
+                take_action(request_id);
                 return false;
             }
 
@@ -47,21 +47,8 @@ namespace cbdc::rpc {
             auto handler_thread = m_net->start_server(
                 m_listen_endpoint,
                 [&](network::message_t&& msg) -> std::optional<cbdc::buffer> {
-                    auto ret = std::optional<cbdc::buffer>();
-                    if constexpr(Server::handler == handler_type::async) {
-                        ret = Server::async_call(
-                            std::move(*msg.m_pkt),
-                            [&, peer_id = msg.m_peer_id, net = m_net](
-                                cbdc::buffer resp) {
-                                auto resp_ptr = std::make_shared<cbdc::buffer>(
-                                    std::move(resp));
-                                net->send(resp_ptr, peer_id);
-                            });
-                    } else {
-                        ret = Server::blocking_call(std::move(*msg.m_pkt));
-                    }
-
-                    return ret;
+                    return handle_packet(std::move(*msg.m_pkt),
+                                         msg.m_peer_id);
                 });
 
             if(!handler_thread.has_value()) {
@@ -77,6 +64,49 @@ namespace cbdc::rpc {
         std::shared_ptr<network::connection_manager> m_net;
         network::endpoint_t m_listen_endpoint;
         std::thread m_handler_thread;
+
+        /// Handles a packet holding one request, or a batch of requests from
+        /// a client which coalesces its requests. Responses a blocking
+        /// server returns for a batch are sent back as one batch.
+        auto handle_packet(cbdc::buffer pkt, network::peer_id_t peer_id)
+            -> std::optional<cbdc::buffer> {
+            auto batch = split_batch(pkt);
+            if(!batch.has_value()) {
+                return handle_request(std::move(pkt), peer_id);
+            }
+
+            auto resps = std::vector<cbdc::buffer>();
+            resps.reserve(batch->size());
+            for(auto& req : batch.value()) {
+                auto resp = handle_request(std::move(req), peer_id);
+                if(resp.has_value()) {
+                    resps.emplace_back(std::move(resp.value()));
+                }
+            }
+
+            if(resps.empty()) {
+                return std::nullopt;
+            }
+            if(resps.size() == 1) {
+                return std::move(resps.front());
+            }
+            return make_batch(resps);
+        }
+
+        auto handle_request(cbdc::buffer req, network::peer_id_t peer_id)
+            -> std::optional<cbdc::buffer> {
+            if constexpr(Server::handler == handler_type::async) {
+                return Server::async_call(
+                    std::move(req),
+                    [peer_id, net = m_net](cbdc::buffer resp) {
+                        auto resp_ptr
+                            = std::make_shared<cbdc::buffer>(std::move(resp));
+                        net->send(resp_ptr, peer_id);
+                    });
+            } else {
+                return Server::blocking_call(std::move(req));
+            }
+        }
     };
 
     /// TCP RPC server which implements blocking request handling logic.
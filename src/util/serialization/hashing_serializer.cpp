@@ -0,0 +1,49 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "hashing_serializer.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace cbdc {
+    hashing_serializer::operator bool() const {
+        return true;
+    }
+
+    void hashing_serializer::advance_cursor(size_t len) {
+        static constexpr std::array<unsigned char, 64> zeros{};
+        while(len > 0) {
+            const auto n = std::min(len, zeros.size());
+            m_sha.Write(zeros.data(), n);
+            len -= n;
+        }
+    }
+
+    void hashing_serializer::reset() {
+        m_sha.Reset();
+    }
+
+    auto hashing_serializer::end_of_buffer() const -> bool {
+        return false;
+    }
+
+    auto hashing_serializer::write(const void* data, size_t len) -> bool {
+        m_sha.Write(static_cast<const unsigned char*>(data), len);
+        return true;
+    }
+
+    auto hashing_serializer::read(void* /* data */, size_t /* len */)
+        -> bool {
+        return false;
+    }
+
+    auto hashing_serializer::finalize() -> hash_t {
+        auto ret = hash_t();
+        m_sha.Finalize(ret.data());
+        m_sha.Reset();
+        return ret;
+    }
+}
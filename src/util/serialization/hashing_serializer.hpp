@@ -0,0 +1,75 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef OPENCBDC_TX_SRC_SERIALIZATION_HASHING_SERIALIZER_H_
+#define OPENCBDC_TX_SRC_SERIALIZATION_HASHING_SERIALIZER_H_
+
+#include "crypto/sha256.h"
+#include "serializer.hpp"
+#include "util/common/hash.hpp"
+
+namespace cbdc {
+    /// \brief Implementation of \ref serializer which feeds the serialized
+    ///        bytes directly into a SHA256 hasher.
+    ///
+    /// Produces the same hash as serializing into a buffer with
+    /// \ref make_buffer and hashing the buffer, without allocating the
+    /// intermediate buffer. Deserialization is not supported and always
+    /// fails to read any data.
+    class hashing_serializer final : public serializer {
+      public:
+        hashing_serializer() = default;
+
+        /// Indicates whether the last serialization operation succeeded.
+        /// Serialization always succeeds for hashing serializer.
+        /// \return true.
+        explicit operator bool() const final;
+
+        /// Hashes the given number of zero bytes, matching the contents of
+        /// a freshly extended buffer.
+        /// \param len number of bytes.
+        void advance_cursor(size_t len) final;
+
+        /// Discards the bytes hashed so far.
+        void reset() final;
+
+        /// Hashing serializer has no underlying buffer so this method always
+        /// returns false.
+        /// \return false.
+        [[nodiscard]] auto end_of_buffer() const -> bool final;
+
+        /// Adds the given bytes to the hash.
+        /// \param data pointer to the start of the data to hash.
+        /// \param len number of bytes to hash.
+        /// \return true.
+        auto write(const void* data, size_t len) -> bool final;
+
+        /// Read is not implemented for hashing serializer.
+        /// \return false.
+        auto read(void* data, size_t len) -> bool final;
+
+        /// Returns the SHA256 hash of the bytes serialized since
+        /// construction or the last reset, and resets the serializer.
+        /// \return hash of the serialized bytes.
+        auto finalize() -> hash_t;
+
+      private:
+        CSHA256 m_sha;
+    };
+
+    /// Calculates the SHA256 hash of the given object's serialized
+    /// representation without serializing it into a buffer.
+    /// \tparam T type of object to hash.
+    /// \param obj object to hash.
+    /// \return hash of the serialized object.
+    template<typename T>
+    auto hash_serialized(const T& obj) -> hash_t {
+        auto ser = hashing_serializer();
+        ser << obj;
+        return ser.finalize();
+    }
+}
+
+#endif // OPENCBDC_TX_SRC_SERIALIZATION_HASHING_SERIALIZER_H_
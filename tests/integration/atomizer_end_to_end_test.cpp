@@ -84,8 +84,10 @@ class atomizer_end_to_end_test : public ::testing::Test {
         std::filesystem::remove_all("atomizer_snps_0");
         std::filesystem::remove_all("shard0_db");
         std::filesystem::remove(m_sender_wallet_store_file);
+        std::filesystem::remove(m_sender_wallet_journal_file);
         std::filesystem::remove(m_sender_client_store_file);
         std::filesystem::remove(m_receiver_wallet_store_file);
+        std::filesystem::remove(m_receiver_wallet_journal_file);
         std::filesystem::remove(m_receiver_client_store_file);
         std::filesystem::remove("tp_samples.txt");
     }
@@ -113,8 +115,12 @@ class atomizer_end_to_end_test : public ::testing::Test {
     static constexpr auto m_end_to_end_cfg_path = "integration_tests.cfg";
 
     static constexpr auto m_sender_wallet_store_file = "s_wallet_store.dat";
+    static constexpr auto m_sender_wallet_journal_file
+        = "s_wallet_store.dat.journal";
     static constexpr auto m_sender_client_store_file = "s_client_store.dat";
     static constexpr auto m_receiver_wallet_store_file = "r_wallet_store.dat";
+    static constexpr auto m_receiver_wallet_journal_file
+        = "r_wallet_store.dat.journal";
     static constexpr auto m_receiver_client_store_file = "r_client_store.dat";
 
     std::chrono::milliseconds m_block_wait_interval;
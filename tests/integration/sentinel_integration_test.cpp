@@ -65,4 +65,18 @@ TEST_F(sentinel_integration_test, valid_signed_tx) {
     ASSERT_TRUE(got.has_value());
     cbdc::test::print_sentinel_error(got->m_tx_error);
     ASSERT_EQ(got.value(), want);
+
+    // The sentinel batches compact transactions for each shard
+    ASSERT_EQ(err.wait_for(std::chrono::seconds(2)),
+              std::future_status::ready);
+    ASSERT_EQ(err.get().m_id, ctx.m_id);
+}
+
+TEST_F(sentinel_integration_test, invalid_tx) {
+    auto tx = cbdc::transaction::full_tx{};
+
+    auto got = m_client->execute_transaction(tx);
+    ASSERT_TRUE(got.has_value());
+    ASSERT_EQ(got->m_tx_status, cbdc::sentinel::tx_status::static_invalid);
+    ASSERT_TRUE(got->m_tx_error.has_value());
 }
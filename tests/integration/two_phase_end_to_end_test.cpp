@@ -8,6 +8,7 @@
 #include "uhs/twophase/locking_shard/controller.hpp"
 #include "uhs/twophase/sentinel_2pc/controller.hpp"
 #include "util.hpp"
+#include "util/network/connection_manager.hpp"
 #include "util/network/socket.hpp"
 
 #include <filesystem>
@@ -63,13 +64,17 @@ class two_phase_end_to_end_test : public ::testing::Test {
         m_receiver.reset();
 
         std::filesystem::remove(m_sender_wallet_store_file);
+        std::filesystem::remove(m_sender_wallet_journal_file);
         std::filesystem::remove(m_sender_client_store_file);
         std::filesystem::remove(m_receiver_wallet_store_file);
+        std::filesystem::remove(m_receiver_wallet_journal_file);
         std::filesystem::remove(m_receiver_client_store_file);
         std::filesystem::remove_all("coordinator0_raft_log_0");
         std::filesystem::remove("coordinator0_raft_config_0.dat");
         std::filesystem::remove("coordinator0_raft_state_0.dat");
+        std::filesystem::remove_all("coordinator0_snps_0");
         std::filesystem::remove_all("shard0_raft_log_0");
+        std::filesystem::remove_all("shard0_snps_0");
         std::filesystem::remove("shard0_raft_config_0.dat");
         std::filesystem::remove("shard0_raft_state_0.dat");
         std::filesystem::remove("tp_samples.txt");
@@ -98,8 +103,12 @@ class two_phase_end_to_end_test : public ::testing::Test {
     static constexpr auto m_end_to_end_cfg_path = "integration_tests_2pc.cfg";
 
     static constexpr auto m_sender_wallet_store_file = "s_wallet_store.dat";
+    static constexpr auto m_sender_wallet_journal_file
+        = "s_wallet_store.dat.journal";
     static constexpr auto m_sender_client_store_file = "s_client_store.dat";
     static constexpr auto m_receiver_wallet_store_file = "r_wallet_store.dat";
+    static constexpr auto m_receiver_wallet_journal_file
+        = "r_wallet_store.dat.journal";
     static constexpr auto m_receiver_client_store_file = "r_client_store.dat";
 
     std::chrono::milliseconds m_wait_interval;
@@ -142,6 +151,82 @@ TEST_F(two_phase_end_to_end_test, complete_transaction) {
     ASSERT_EQ(m_receiver->pending_input_count(), 0UL);
 }
 
+TEST_F(two_phase_end_to_end_test, pipelined_transactions) {
+    auto addr = m_receiver->new_address();
+
+    static constexpr auto n_txs = 5;
+    auto n_confirmed = std::atomic<size_t>();
+    for(size_t i = 0; i < n_txs; i++) {
+        ASSERT_TRUE(m_sender->send_async(
+            10,
+            addr,
+            [&](const cbdc::transaction::full_tx& /* tx */,
+                std::optional<cbdc::sentinel::execute_response> res) {
+                if(res.has_value()
+                   && res->m_tx_status
+                          == cbdc::sentinel::tx_status::confirmed) {
+                    n_confirmed++;
+                }
+            }));
+    }
+    m_sender->flush();
+
+    ASSERT_EQ(n_confirmed, n_txs);
+    ASSERT_EQ(m_sender->balance(), 50UL);
+    ASSERT_EQ(m_sender->pending_tx_count(), 0UL);
+}
+
+TEST_F(two_phase_end_to_end_test, pipelined_transactions_sentinel_lost) {
+    // Stand in for a sentinel that accepts transactions but goes away
+    // before responding to them.
+    static const auto fake_sentinel_ep
+        = cbdc::network::endpoint_t{"127.0.0.1", 29858};
+    auto fake_sentinel = cbdc::network::connection_manager();
+    auto n_received = std::atomic<size_t>();
+    auto fake_thread = fake_sentinel.start_server(
+        fake_sentinel_ep,
+        [&](cbdc::network::message_t&& /* pkt */)
+            -> std::optional<cbdc::buffer> {
+            n_received++;
+            return std::nullopt;
+        });
+    ASSERT_TRUE(fake_thread.has_value());
+
+    m_opts.m_sentinel_endpoints = {fake_sentinel_ep};
+    m_opts.m_window_size = 2;
+    m_opts.m_send_timeout = 500;
+    reload_sender();
+
+    auto addr = m_receiver->new_address();
+
+    static constexpr auto n_txs = 2;
+    auto n_failed = std::atomic<size_t>();
+    for(size_t i = 0; i < n_txs; i++) {
+        ASSERT_TRUE(m_sender->send_async(
+            10,
+            addr,
+            [&](const cbdc::transaction::full_tx& /* tx */,
+                std::optional<cbdc::sentinel::execute_response> res) {
+                if(!res.has_value()) {
+                    n_failed++;
+                }
+            }));
+    }
+
+    for(size_t i = 0; i < 100 && n_received < n_txs; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_EQ(n_received, n_txs);
+    fake_sentinel.close();
+    fake_thread->join();
+
+    // The lost sends must time out and release the window rather than
+    // blocking flush forever.
+    m_sender->flush();
+    ASSERT_EQ(n_failed, n_txs);
+    ASSERT_EQ(m_sender->pending_tx_count(), static_cast<size_t>(n_txs));
+}
+
 TEST_F(two_phase_end_to_end_test, duplicate_transaction) {
     auto addr = m_receiver->new_address();
 
@@ -4,12 +4,15 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "uhs/atomizer/archiver/controller.hpp"
+#include "uhs/atomizer/archiver/format.hpp"
 #include "uhs/atomizer/atomizer/format.hpp"
 #include "util/common/logging.hpp"
+#include "util/network/tcp_listener.hpp"
 #include "util/serialization/format.hpp"
 
 #include <filesystem>
 #include <gtest/gtest.h>
+#include <thread>
 
 class ArchiverTest : public ::testing::Test {
   protected:
@@ -234,7 +237,7 @@ TEST_F(ArchiverTest, server_handler) {
     m_archiver->digest_block(m_dummy_blocks[2]);
     auto pkt = std::make_shared<cbdc::buffer>();
     auto ser = cbdc::buffer_serializer(*pkt);
-    ser << static_cast<uint64_t>(1);
+    ser << cbdc::archiver::request{cbdc::archiver::block_request{1}};
     auto msg = cbdc::network::message_t{pkt, 0};
     auto buf = m_archiver->server_handler(std::move(msg));
     ASSERT_TRUE(buf.has_value());
@@ -293,3 +296,235 @@ TEST_F(ArchiverTest, init) {
     ASSERT_TRUE(blk.has_value());
     ASSERT_EQ(m_archiver->best_block_height(), 1UL);
 }
+
+// Test fetching a range of blocks with a single scan
+TEST_F(ArchiverTest, get_blocks) {
+    m_archiver->init_leveldb();
+    m_archiver->init_best_block();
+    for(const auto& blk : m_dummy_blocks) {
+        m_archiver->digest_block(blk);
+    }
+    auto blks = m_archiver->get_blocks(3, 4);
+    ASSERT_EQ(blks.size(), 4UL);
+    for(size_t i{0}; i < blks.size(); i++) {
+        ASSERT_EQ(blks[i].m_height, i + 3);
+        ASSERT_EQ(blks[i].m_transactions,
+                  m_dummy_blocks[i + 2].m_transactions);
+    }
+
+    // The range stops at the last archived block
+    blks = m_archiver->get_blocks(9, 5);
+    ASSERT_EQ(blks.size(), 2UL);
+    ASSERT_EQ(blks[1].m_height, 10UL);
+
+    blks = m_archiver->get_blocks(11, 5);
+    ASSERT_TRUE(blks.empty());
+}
+
+// Test looking up where transactions and UHS IDs were archived
+TEST_F(ArchiverTest, tx_location) {
+    m_archiver->init_leveldb();
+    m_archiver->init_best_block();
+    m_archiver->digest_block(m_dummy_blocks[0]);
+    m_archiver->digest_block(m_dummy_blocks[1]);
+
+    const auto& tx = m_dummy_blocks[1].m_transactions[5];
+    auto expected = cbdc::archiver::tx_location{2, 5};
+    auto loc = m_archiver->get_tx_location(tx.m_id);
+    ASSERT_TRUE(loc.has_value());
+    ASSERT_EQ(loc.value(), expected);
+
+    loc = m_archiver->get_uhs_location(tx.m_uhs_outputs[0]);
+    ASSERT_TRUE(loc.has_value());
+    ASSERT_EQ(loc.value(), expected);
+
+    loc = m_archiver->get_tx_location(cbdc::hash_t{});
+    ASSERT_FALSE(loc.has_value());
+}
+
+// Test that blocks and the index survive a restart with unsynced writes
+TEST_F(ArchiverTest, unsynced_blocks_reopen) {
+    m_config_opts.m_archiver_sync_interval = 4;
+    {
+        auto archiver0
+            = std::make_unique<cbdc::archiver::controller>(0,
+                                                           m_config_opts,
+                                                           m_log,
+                                                           0);
+        ASSERT_TRUE(archiver0->init_leveldb());
+        ASSERT_TRUE(archiver0->init_best_block());
+        for(size_t i{0}; i < 6; i++) {
+            archiver0->digest_block(m_dummy_blocks[i]);
+        }
+    }
+    auto archiver1
+        = std::make_unique<cbdc::archiver::controller>(0,
+                                                       m_config_opts,
+                                                       m_log,
+                                                       0);
+    ASSERT_TRUE(archiver1->init_leveldb());
+    ASSERT_TRUE(archiver1->init_best_block());
+    ASSERT_EQ(archiver1->best_block_height(), 6UL);
+    ASSERT_EQ(archiver1->get_blocks(1, 10).size(), 6UL);
+    auto loc = archiver1->get_tx_location(
+        m_dummy_blocks[5].m_transactions[0].m_id);
+    ASSERT_TRUE(loc.has_value());
+    ASSERT_EQ(loc.value().m_height, 6UL);
+}
+
+// Test the range and location queries through the client
+TEST_F(ArchiverTest, client_queries) {
+    m_archiver->init_leveldb();
+    m_archiver->init_best_block();
+    ASSERT_TRUE(m_archiver->init_archiver_server());
+    m_archiver->digest_block(m_dummy_blocks[0]);
+    m_archiver->digest_block(m_dummy_blocks[1]);
+    m_archiver->digest_block(m_dummy_blocks[2]);
+
+    auto client
+        = cbdc::archiver::client(m_config_opts.m_archiver_endpoints[0], m_log);
+    ASSERT_TRUE(client.init());
+    auto blks = client.get_blocks(2, 5);
+    ASSERT_TRUE(blks.has_value());
+    ASSERT_EQ(blks.value().size(), 2UL);
+    ASSERT_EQ(blks.value()[0].m_height, 2UL);
+
+    const auto& tx = m_dummy_blocks[2].m_transactions[7];
+    auto loc = client.get_tx_location(tx.m_id);
+    ASSERT_TRUE(loc.has_value());
+    ASSERT_EQ(loc.value(), (cbdc::archiver::tx_location{3, 7}));
+    loc = client.get_uhs_location(tx.m_uhs_outputs[0]);
+    ASSERT_TRUE(loc.has_value());
+    ASSERT_EQ(loc.value(), (cbdc::archiver::tx_location{3, 7}));
+    ASSERT_FALSE(client.get_tx_location(cbdc::hash_t{}).has_value());
+}
+
+// Test streaming blocks in chunks terminated by a short chunk
+TEST_F(ArchiverTest, stream_blocks) {
+    m_archiver->init_leveldb();
+    m_archiver->init_best_block();
+    static constexpr auto n_blocks = cbdc::archiver::max_range_blocks * 2;
+    for(uint64_t h = 1; h <= n_blocks + 3; h++) {
+        auto blk = cbdc::atomizer::block();
+        blk.m_height = h;
+        m_archiver->digest_block(blk);
+    }
+
+    auto chunks = std::vector<cbdc::archiver::block_range_response>();
+    auto cb = [&](cbdc::archiver::block_range_response&& chunk) {
+        chunks.emplace_back(std::move(chunk));
+    };
+    ASSERT_EQ(m_archiver->stream_blocks(2, n_blocks, cb), n_blocks);
+    ASSERT_EQ(chunks.size(), 3UL);
+    ASSERT_EQ(chunks[0].size(), cbdc::archiver::max_range_blocks);
+    ASSERT_EQ(chunks[1].size(), cbdc::archiver::max_range_blocks);
+    ASSERT_TRUE(chunks[2].empty());
+    ASSERT_EQ(chunks[0].front().m_height, 2UL);
+    ASSERT_EQ(chunks[1].back().m_height, n_blocks + 1);
+
+    chunks.clear();
+    ASSERT_EQ(m_archiver->stream_blocks(n_blocks, 100, cb), 4UL);
+    ASSERT_EQ(chunks.size(), 1UL);
+    ASSERT_EQ(chunks[0].back().m_height, n_blocks + 3);
+}
+
+// Test streaming blocks across several pipelined windows through the client
+TEST_F(ArchiverTest, client_stream_blocks) {
+    m_archiver->init_leveldb();
+    m_archiver->init_best_block();
+    ASSERT_TRUE(m_archiver->init_archiver_server());
+    static constexpr auto n_blocks = cbdc::archiver::max_stream_blocks * 3;
+    for(uint64_t h = 1; h <= n_blocks; h++) {
+        auto blk = cbdc::atomizer::block();
+        blk.m_height = h;
+        m_archiver->digest_block(blk);
+    }
+
+    auto client
+        = cbdc::archiver::client(m_config_opts.m_archiver_endpoints[0], m_log);
+    ASSERT_TRUE(client.init());
+    auto expected = uint64_t{1};
+    auto streamed = client.stream_blocks(
+        1,
+        n_blocks * 2,
+        [&](cbdc::atomizer::block&& blk) {
+            ASSERT_EQ(blk.m_height, expected);
+            expected++;
+        });
+    ASSERT_TRUE(streamed.has_value());
+    ASSERT_EQ(streamed.value(), n_blocks);
+    ASSERT_EQ(expected, n_blocks + 1);
+
+    // The discarded windows were drained so the connection is still usable
+    auto blk = client.get_block(5);
+    ASSERT_TRUE(blk.has_value());
+    ASSERT_EQ(blk.value().m_height, 5UL);
+}
+
+// Test that a failed stream does not leave blocks on the connection for the
+// next request to read
+TEST_F(ArchiverTest, client_stream_blocks_failure) {
+    static constexpr auto fake_endpoint
+        = cbdc::network::endpoint_t{"127.0.0.1", 29803};
+    auto listener = cbdc::network::tcp_listener();
+    ASSERT_TRUE(listener.listen(fake_endpoint.first, fake_endpoint.second));
+
+    auto make_chunk = [](uint64_t start) {
+        auto chunk = cbdc::archiver::block_range_response();
+        for(uint64_t i = 0; i < cbdc::archiver::max_range_blocks; i++) {
+            auto blk = cbdc::atomizer::block();
+            blk.m_height = start + i;
+            chunk.push_back(blk);
+        }
+        return chunk;
+    };
+
+    // Fake archiver which sends a malformed packet in the middle of a
+    // stream, followed by more blocks, then serves a block request on the
+    // next connection
+    auto server = std::thread([&]() {
+        auto stream_sock = cbdc::network::tcp_socket();
+        if(!listener.accept(stream_sock)) {
+            return;
+        }
+        auto pkt = cbdc::buffer();
+        if(!stream_sock.receive(pkt)) {
+            return;
+        }
+        auto malformed = cbdc::buffer();
+        malformed.append("x", 1);
+        [[maybe_unused]] auto res
+            = stream_sock.send(make_chunk(1)) && stream_sock.send(malformed)
+           && stream_sock.send(make_chunk(cbdc::archiver::max_range_blocks));
+
+        auto sock = cbdc::network::tcp_socket();
+        if(!listener.accept(sock) || !sock.receive(pkt)) {
+            return;
+        }
+        auto req = cbdc::from_buffer<cbdc::archiver::request>(pkt);
+        if(!req.has_value()
+           || !std::holds_alternative<cbdc::archiver::block_request>(
+               req.value())) {
+            return;
+        }
+        auto blk = cbdc::atomizer::block();
+        blk.m_height = std::get<cbdc::archiver::block_request>(req.value());
+        res = sock.send(cbdc::archiver::response{blk});
+    });
+
+    auto client = cbdc::archiver::client(fake_endpoint, m_log);
+    ASSERT_TRUE(client.init());
+    auto n_received = uint64_t{};
+    auto streamed
+        = client.stream_blocks(1, 100, [&](cbdc::atomizer::block&& /* blk */) {
+              n_received++;
+          });
+    ASSERT_FALSE(streamed.has_value());
+    ASSERT_EQ(n_received, cbdc::archiver::max_range_blocks);
+
+    auto blk = client.get_block(5);
+    listener.close();
+    server.join();
+    ASSERT_TRUE(blk.has_value());
+    ASSERT_EQ(blk.value().m_height, 5UL);
+}
@@ -0,0 +1,102 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "uhs/atomizer/atomizer/block_ring.hpp"
+
+#include <gtest/gtest.h>
+
+class block_ring_test : public ::testing::Test {
+  protected:
+    static constexpr size_t m_capacity{4};
+
+    static auto make_block(uint64_t height) -> cbdc::atomizer::block {
+        auto blk = cbdc::atomizer::block();
+        blk.m_height = height;
+        blk.m_transactions.emplace_back();
+        blk.m_transactions.back().m_id[0] = static_cast<unsigned char>(height);
+        return blk;
+    }
+
+    cbdc::atomizer::block_ring m_ring{m_capacity};
+};
+
+TEST_F(block_ring_test, empty) {
+    ASSERT_TRUE(m_ring.empty());
+    ASSERT_EQ(m_ring.size(), 0UL);
+    ASSERT_FALSE(m_ring.first_height().has_value());
+    ASSERT_EQ(m_ring.find(0), nullptr);
+    ASSERT_EQ(m_ring.prune(10), 0UL);
+}
+
+TEST_F(block_ring_test, push_find) {
+    for(uint64_t h = 1; h <= 3; h++) {
+        m_ring.push(make_block(h));
+    }
+    ASSERT_EQ(m_ring.size(), 3UL);
+    ASSERT_EQ(m_ring.first_height(), 1UL);
+    ASSERT_EQ(m_ring.find(0), nullptr);
+    ASSERT_EQ(m_ring.find(4), nullptr);
+    for(uint64_t h = 1; h <= 3; h++) {
+        const auto* blk = m_ring.find(h);
+        ASSERT_NE(blk, nullptr);
+        ASSERT_EQ(*blk, make_block(h));
+    }
+}
+
+TEST_F(block_ring_test, prune_wraps) {
+    for(uint64_t h = 1; h <= m_capacity; h++) {
+        m_ring.push(make_block(h));
+    }
+    ASSERT_EQ(m_ring.prune(3), 2UL);
+    ASSERT_EQ(m_ring.first_height(), 3UL);
+    ASSERT_EQ(m_ring.find(2), nullptr);
+
+    // Heights 5 and 6 reuse the slots freed by pruning.
+    m_ring.push(make_block(5));
+    m_ring.push(make_block(6));
+    ASSERT_EQ(m_ring.capacity(), m_capacity);
+    for(uint64_t h = 3; h <= 6; h++) {
+        ASSERT_EQ(*m_ring.find(h), make_block(h));
+    }
+
+    ASSERT_EQ(m_ring.prune(3), 0UL);
+    ASSERT_EQ(m_ring.prune(100), m_capacity);
+    ASSERT_TRUE(m_ring.empty());
+}
+
+TEST_F(block_ring_test, grows_when_full) {
+    m_ring.push(make_block(1));
+    m_ring.push(make_block(2));
+    ASSERT_EQ(m_ring.prune(2), 1UL);
+    for(uint64_t h = 3; h <= m_capacity * 2; h++) {
+        m_ring.push(make_block(h));
+    }
+    ASSERT_EQ(m_ring.capacity(), m_capacity * 2);
+    ASSERT_EQ(m_ring.size(), m_capacity * 2 - 1);
+    for(uint64_t h = 2; h <= m_capacity * 2; h++) {
+        ASSERT_EQ(*m_ring.find(h), make_block(h));
+    }
+}
+
+TEST_F(block_ring_test, push_gap_resets) {
+    m_ring.push(make_block(1));
+    m_ring.push(make_block(2));
+    m_ring.push(make_block(10));
+    ASSERT_EQ(m_ring.size(), 1UL);
+    ASSERT_EQ(m_ring.first_height(), 10UL);
+    ASSERT_EQ(m_ring.find(1), nullptr);
+    ASSERT_EQ(*m_ring.find(10), make_block(10));
+}
+
+TEST_F(block_ring_test, equality_ignores_capacity) {
+    auto other = cbdc::atomizer::block_ring(1);
+    for(uint64_t h = 7; h <= 9; h++) {
+        m_ring.push(make_block(h));
+        other.push(make_block(h));
+    }
+    ASSERT_EQ(m_ring, other);
+    other.prune(8);
+    ASSERT_FALSE(m_ring == other);
+}
@@ -4,6 +4,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "uhs/atomizer/atomizer/format.hpp"
+#include "util/serialization/format.hpp"
 
 #include <gtest/gtest.h>
 
@@ -23,7 +24,11 @@ TEST_F(atomizer_messages_test, snapshot) {
     auto blocks
         = std::make_shared<decltype(cbdc::atomizer::state_machine::snapshot::
                                         m_blocks)::element_type>();
-    blocks->emplace(5, cbdc::atomizer::block());
+    auto blk = cbdc::atomizer::block();
+    blk.m_height = 5;
+    blocks->push(blk);
+    blk.m_height = 6;
+    blocks->push(blk);
     auto snp = cbdc::atomizer::state_machine::snapshot{std::move(atm),
                                                        std::move(nuraft_snp),
                                                        std::move(blocks)};
@@ -47,3 +52,35 @@ TEST_F(atomizer_messages_test, snapshot) {
     ASSERT_EQ(snp.m_snp->get_last_log_idx(),
               deser_snp.m_snp->get_last_log_idx());
 }
+
+TEST_F(atomizer_messages_test, legacy_snapshot) {
+    // Older versions serialized the block cache as an unordered map from
+    // height to block, without a format tag
+    auto atm = cbdc::atomizer::atomizer(0, 2);
+    auto nuraft_snp
+        = nuraft::snapshot(7, 3, nuraft::cs_new<nuraft::cluster_config>());
+    auto legacy_blocks = std::unordered_map<uint64_t, cbdc::atomizer::block>();
+    auto expected = cbdc::atomizer::block_ring();
+    for(uint64_t h = 4; h < 8; h++) {
+        auto blk = cbdc::atomizer::block();
+        blk.m_height = h;
+        legacy_blocks.emplace(h, blk);
+        expected.push(blk);
+    }
+
+    auto snp_buf = nuraft_snp.serialize();
+    auto atm_buf = atm.serialize();
+    ASSERT_TRUE(m_ser << static_cast<uint64_t>(snp_buf->size()));
+    ASSERT_TRUE(m_ser.write(snp_buf->data_begin(), snp_buf->size()));
+    ASSERT_TRUE(m_ser.write(atm_buf.data(), atm_buf.size()));
+    ASSERT_TRUE(m_ser << legacy_blocks);
+
+    auto deser_snp = cbdc::atomizer::state_machine::snapshot{
+        std::make_shared<cbdc::atomizer::atomizer>(3, 2),
+        nullptr,
+        std::make_shared<cbdc::atomizer::block_ring>()};
+    ASSERT_TRUE(m_deser >> deser_snp);
+    ASSERT_EQ(atm, *deser_snp.m_atomizer);
+    ASSERT_EQ(expected, *deser_snp.m_blocks);
+    ASSERT_EQ(deser_snp.m_snp->get_last_log_idx(), 7UL);
+}
@@ -0,0 +1,106 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "util/common/blocking_queue.hpp"
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace {
+    /// Long enough for a blocked thread to have run if it was not blocked.
+    constexpr auto block_wait = std::chrono::milliseconds(100);
+}
+
+TEST(blocking_queue_test, fifo) {
+    auto q = cbdc::blocking_queue<int>();
+    ASSERT_EQ(q.push(1), 1UL);
+    ASSERT_EQ(q.push(2), 2UL);
+    int item{};
+    ASSERT_TRUE(q.pop(item));
+    ASSERT_EQ(item, 1);
+    ASSERT_TRUE(q.pop(item));
+    ASSERT_EQ(item, 2);
+}
+
+TEST(blocking_queue_test, push_blocks_at_capacity) {
+    auto q = cbdc::blocking_queue<int>(2);
+    q.push(1);
+    q.push(2);
+
+    auto pushed = std::atomic<bool>();
+    auto producer = std::thread([&]() {
+        q.push(3);
+        pushed = true;
+    });
+    std::this_thread::sleep_for(block_wait);
+    ASSERT_FALSE(pushed);
+
+    // Popping makes room for the blocked producer
+    int item{};
+    ASSERT_TRUE(q.pop(item));
+    ASSERT_EQ(item, 1);
+    producer.join();
+    ASSERT_TRUE(pushed);
+
+    ASSERT_TRUE(q.pop(item));
+    ASSERT_EQ(item, 2);
+    ASSERT_TRUE(q.pop(item));
+    ASSERT_EQ(item, 3);
+}
+
+TEST(blocking_queue_test, pop_wakes_blocked_producers) {
+    static constexpr int n_producers = 4;
+    auto q = cbdc::blocking_queue<int>(1);
+    q.push(0);
+
+    auto n_pushed = std::atomic<int>();
+    auto producers = std::vector<std::thread>();
+    for(int i = 1; i <= n_producers; i++) {
+        producers.emplace_back([&, i]() {
+            q.push(i);
+            n_pushed++;
+        });
+    }
+    std::this_thread::sleep_for(block_wait);
+    ASSERT_EQ(n_pushed, 0);
+
+    // Each pop lets exactly one more producer through
+    auto sum = 0;
+    for(int i = 0; i <= n_producers; i++) {
+        int item{};
+        ASSERT_TRUE(q.pop(item));
+        sum += item;
+    }
+    for(auto& t : producers) {
+        t.join();
+    }
+    ASSERT_EQ(n_pushed, n_producers);
+    ASSERT_EQ(sum, n_producers * (n_producers + 1) / 2);
+}
+
+TEST(blocking_queue_test, clear_releases_producers) {
+    static constexpr int n_producers = 4;
+    auto q = cbdc::blocking_queue<int>(1);
+    q.push(0);
+
+    auto n_pushed = std::atomic<int>();
+    auto producers = std::vector<std::thread>();
+    for(int i = 0; i < n_producers; i++) {
+        producers.emplace_back([&]() {
+            q.push(1);
+            n_pushed++;
+        });
+    }
+    std::this_thread::sleep_for(block_wait);
+    ASSERT_EQ(n_pushed, 0);
+
+    q.clear();
+    for(auto& t : producers) {
+        t.join();
+    }
+    ASSERT_EQ(n_pushed, n_producers);
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "util/common/histogram.hpp"
+
+#include <gtest/gtest.h>
+#include <limits>
+
+TEST(histogram_test, empty) {
+    auto hist = cbdc::histogram();
+    EXPECT_EQ(hist.count(), 0UL);
+    EXPECT_EQ(hist.min(), 0UL);
+    EXPECT_EQ(hist.max(), 0UL);
+    EXPECT_EQ(hist.mean(), 0.0);
+    EXPECT_EQ(hist.percentile(50.0), 0UL);
+}
+
+TEST(histogram_test, small_values_exact) {
+    auto hist = cbdc::histogram();
+    for(uint64_t i = 1; i <= 100; i++) {
+        hist.record(i);
+    }
+    EXPECT_EQ(hist.count(), 100UL);
+    EXPECT_EQ(hist.min(), 1UL);
+    EXPECT_EQ(hist.max(), 100UL);
+    EXPECT_DOUBLE_EQ(hist.mean(), 50.5);
+    EXPECT_EQ(hist.percentile(0.0), 1UL);
+    EXPECT_EQ(hist.percentile(50.0), 50UL);
+    EXPECT_EQ(hist.percentile(99.0), 99UL);
+    EXPECT_EQ(hist.percentile(100.0), 100UL);
+}
+
+TEST(histogram_test, large_values_precision) {
+    auto hist = cbdc::histogram();
+    static constexpr uint64_t n = 100000;
+    static constexpr uint64_t scale = 1000;
+    for(uint64_t i = 1; i <= n; i++) {
+        hist.record(i * scale);
+    }
+    for(const auto p : {50.0, 90.0, 99.0, 99.9}) {
+        const auto want = static_cast<double>(n * scale) * p / 100.0;
+        const auto got = static_cast<double>(hist.percentile(p));
+        EXPECT_GE(got, want);
+        EXPECT_LE(got, want * (1.0 + 1.0 / 64));
+    }
+    EXPECT_EQ(hist.percentile(100.0), n * scale);
+}
+
+TEST(histogram_test, extreme_values) {
+    auto hist = cbdc::histogram();
+    hist.record(0);
+    hist.record(std::numeric_limits<uint64_t>::max());
+    EXPECT_EQ(hist.percentile(50.0), 0UL);
+    EXPECT_EQ(hist.percentile(100.0), std::numeric_limits<uint64_t>::max());
+}
+
+TEST(histogram_test, merge_and_reset) {
+    auto a = cbdc::histogram();
+    auto b = cbdc::histogram();
+    a.record(10, 3);
+    b.record(1000);
+    b.record(5);
+    a.merge(b);
+    EXPECT_EQ(a.count(), 5UL);
+    EXPECT_EQ(a.min(), 5UL);
+    EXPECT_EQ(a.max(), 1000UL);
+    EXPECT_EQ(a.percentile(20.0), 5UL);
+    EXPECT_EQ(a.percentile(80.0), 10UL);
+
+    a.reset();
+    EXPECT_EQ(a.count(), 0UL);
+    EXPECT_EQ(a.percentile(100.0), 0UL);
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "util/common/rate_controller.hpp"
+
+#include <gtest/gtest.h>
+#include <thread>
+
+using cbdc::rate_controller;
+
+TEST(rate_controller_test, uniform_schedule) {
+    auto rate = rate_controller(1000.0);
+    auto prev = rate.next();
+    for(int i = 0; i < 100; i++) {
+        auto next = rate.next();
+        EXPECT_EQ(next - prev, std::chrono::milliseconds(1));
+        prev = next;
+    }
+}
+
+TEST(rate_controller_test, poisson_mean_gap) {
+    static constexpr auto n = 100000;
+    auto rate = rate_controller(
+        1000.0,
+        rate_controller::arrival_distribution::poisson);
+    const auto first = rate.next();
+    auto last = first;
+    for(int i = 0; i < n; i++) {
+        last = rate.next();
+    }
+    const auto mean_gap
+        = std::chrono::duration<double, std::milli>(last - first) / n;
+    EXPECT_NEAR(mean_gap.count(), 1.0, 0.02);
+}
+
+TEST(rate_controller_test, set_rate) {
+    auto rate = rate_controller(1000.0);
+    rate.next();
+    auto prev = rate.next();
+    rate.set_rate(100.0);
+    EXPECT_EQ(rate.rate(), 100.0);
+    // The gap after the last scheduled event was set at the old rate
+    auto next = rate.next();
+    EXPECT_EQ(next - prev, std::chrono::milliseconds(1));
+    EXPECT_EQ(rate.next() - next, std::chrono::milliseconds(10));
+}
+
+TEST(rate_controller_test, unpaced) {
+    auto rate = rate_controller(0.0);
+    const auto before = rate_controller::clock_type::now();
+    EXPECT_GE(rate.next(), before);
+    EXPECT_EQ(rate.lag(), rate_controller::clock_type::duration::zero());
+}
+
+TEST(rate_controller_test, lag_and_wait) {
+    auto rate = rate_controller(100.0);
+    const auto first = rate.next();
+    rate_controller::wait_until(first + std::chrono::milliseconds(25));
+    EXPECT_GE(rate_controller::clock_type::now(),
+              first + std::chrono::milliseconds(25));
+    // The next event was due after 10ms, so we're 15ms behind
+    EXPECT_GE(rate.lag(), std::chrono::milliseconds(15));
+    // Events keep their schedule rather than starting from now
+    EXPECT_EQ(rate.next(), first + std::chrono::milliseconds(10));
+}
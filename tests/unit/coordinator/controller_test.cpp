@@ -22,6 +22,7 @@ class coordinator_controller_test : public ::testing::Test {
         std::filesystem::remove_all("coordinator0_raft_log_0");
         std::filesystem::remove("coordinator0_raft_config_0.dat");
         std::filesystem::remove("coordinator0_raft_state_0.dat");
+        std::filesystem::remove_all("coordinator0_snps_0");
     }
 
     static constexpr auto cfg_path = "coordinator.cfg";
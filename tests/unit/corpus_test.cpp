@@ -0,0 +1,85 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "uhs/transaction/corpus.hpp"
+#include "uhs/transaction/validation.hpp"
+#include "uhs/transaction/wallet.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+
+class corpus_test : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        static constexpr auto seed_value = 100;
+        ASSERT_TRUE(m_wallet.seed(m_privkey, seed_value, 0, 10));
+        m_seed.m_seed_from = 0;
+        m_seed.m_seed_to = 10;
+        m_seed.m_seed_value = seed_value;
+
+        const auto payee = m_wallet.generate_key();
+        for(auto tx = m_wallet.send_to(5, payee, true); tx.has_value();
+            tx = m_wallet.send_to(5, payee, true)) {
+            m_txs.push_back(tx.value());
+        }
+        ASSERT_EQ(m_txs.size(), 10UL);
+
+        auto writer = cbdc::transaction::corpus_writer(m_corpus_file, m_seed);
+        for(const auto& tx : m_txs) {
+            ASSERT_TRUE(writer.add(tx));
+        }
+        ASSERT_TRUE(writer.finish());
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(m_corpus_file);
+    }
+
+    static constexpr auto m_corpus_file = "test_corpus.dat";
+    cbdc::privkey_t m_privkey{1};
+    cbdc::transaction::wallet m_wallet;
+    cbdc::transaction::corpus_seed m_seed;
+    std::vector<cbdc::transaction::full_tx> m_txs;
+};
+
+TEST_F(corpus_test, round_trip) {
+    auto corpus = cbdc::transaction::corpus();
+    ASSERT_TRUE(corpus.init(m_corpus_file));
+    ASSERT_EQ(corpus.seed(), m_seed);
+    ASSERT_EQ(corpus.size(), m_txs.size());
+    for(size_t i = 0; i < corpus.size(); i++) {
+        auto tx = corpus.get(i);
+        ASSERT_TRUE(tx.has_value());
+        ASSERT_EQ(tx.value(), m_txs[i]);
+        ASSERT_FALSE(cbdc::transaction::validation::check_tx(tx.value())
+                         .has_value());
+    }
+
+    // Re-opening an initialized corpus fails
+    ASSERT_FALSE(corpus.init(m_corpus_file));
+}
+
+TEST_F(corpus_test, empty) {
+    {
+        auto writer = cbdc::transaction::corpus_writer(m_corpus_file, m_seed);
+        ASSERT_TRUE(writer.finish());
+    }
+    auto corpus = cbdc::transaction::corpus();
+    ASSERT_TRUE(corpus.init(m_corpus_file));
+    ASSERT_EQ(corpus.size(), 0UL);
+}
+
+TEST_F(corpus_test, malformed) {
+    auto corpus = cbdc::transaction::corpus();
+    ASSERT_FALSE(corpus.init("does_not_exist.dat"));
+
+    // Dropping the last byte corrupts the transaction count
+    const auto size = std::filesystem::file_size(m_corpus_file);
+    std::filesystem::resize_file(m_corpus_file, size - 1);
+    auto truncated = cbdc::transaction::corpus();
+    ASSERT_FALSE(truncated.init(m_corpus_file));
+    ASSERT_EQ(truncated.size(), 0UL);
+}
@@ -1832,3 +1832,45 @@ TEST_F(evm_test, test_failing_tx) {
                   "0xb695A631806BCcA49e9106Cb6Dcc2E7Fd544A592")
                   .value());
 }
+
+TEST_F(evm_test, log_block_index_test) {
+    using cbdc::parsec::agent::runner::log_block_index_bucket_size;
+    auto addr = cbdc::parsec::agent::runner::from_hex<evmc::address>(
+                    "8d1ec7694e13bf51041920b5cf4e1668b0e267a9")
+                    .value();
+
+    // A single ticket only needs a single key
+    auto keys = cbdc::parsec::agent::runner::log_block_index_keys(addr, 5, 5);
+    ASSERT_EQ(keys.size(), 1);
+    ASSERT_EQ(keys[0],
+              cbdc::parsec::agent::runner::log_block_index_key(addr, 5));
+
+    // Ranges need one key for every bucket they overlap
+    keys = cbdc::parsec::agent::runner::log_block_index_keys(
+        addr,
+        log_block_index_bucket_size - 1,
+        log_block_index_bucket_size * 2);
+    ASSERT_EQ(keys.size(), 3);
+    ASSERT_EQ(keys[1],
+              cbdc::parsec::agent::runner::log_block_index_key(
+                  addr,
+                  log_block_index_bucket_size));
+
+    keys = cbdc::parsec::agent::runner::log_block_index_keys(addr, 10, 9);
+    ASSERT_TRUE(keys.empty());
+
+    // Only tickets within the range in flagged buckets are returned
+    const auto from = log_block_index_bucket_size - 2;
+    const auto to = log_block_index_bucket_size * 2 + 1;
+    auto flags = std::vector<cbdc::buffer>{cbdc::make_buffer(true),
+                                           cbdc::buffer(),
+                                           cbdc::make_buffer(true)};
+    auto addrs = std::vector<evmc::address>{addr};
+    auto res
+        = cbdc::parsec::agent::runner::log_index_keys(addrs, flags, from, to);
+    auto exp = std::vector<cbdc::buffer>();
+    for(auto tn : {from, from + 1, to - 1, to}) {
+        exp.push_back(cbdc::parsec::agent::runner::log_index_key(addr, tn));
+    }
+    ASSERT_EQ(res, exp);
+}
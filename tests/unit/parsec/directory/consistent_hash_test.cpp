@@ -0,0 +1,129 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "parsec/directory/consistent_hash.hpp"
+#include "util/serialization/format.hpp"
+#include "util/serialization/util.hpp"
+
+#include <gtest/gtest.h>
+
+class consistent_hash_test : public ::testing::Test {
+  protected:
+    using key_type = cbdc::parsec::runtime_locking_shard::key_type;
+
+    void SetUp() override {
+        for(uint64_t i = 0; i < m_n_keys; i++) {
+            m_keys.emplace_back(cbdc::make_buffer(i));
+        }
+    }
+
+    static auto locate(cbdc::parsec::directory::consistent_hash& directory,
+                       const key_type& key)
+        -> uint64_t {
+        auto ret = std::optional<uint64_t>();
+        auto success = directory.key_location(key, [&](uint64_t shard) {
+            ret = shard;
+        });
+        EXPECT_TRUE(success);
+        EXPECT_TRUE(ret.has_value());
+        return ret.value_or(0);
+    }
+
+    static constexpr size_t m_n_shards = 4;
+    static constexpr size_t m_n_keys = 10000;
+    std::vector<key_type> m_keys;
+};
+
+TEST_F(consistent_hash_test, distribution_test) {
+    auto directory = cbdc::parsec::directory::consistent_hash(m_n_shards);
+    auto counts = std::vector<size_t>(m_n_shards);
+    for(const auto& key : m_keys) {
+        auto shard = locate(directory, key);
+        ASSERT_LT(shard, m_n_shards);
+        counts[shard]++;
+    }
+    for(auto count : counts) {
+        // Each shard should hold roughly a quarter of the keys
+        ASSERT_GT(count, m_n_keys / m_n_shards / 2);
+        ASSERT_LT(count, m_n_keys / m_n_shards * 2);
+    }
+}
+
+TEST_F(consistent_hash_test, add_remove_shard_test) {
+    auto directory = cbdc::parsec::directory::consistent_hash(m_n_shards);
+    auto before = std::vector<uint64_t>();
+    for(const auto& key : m_keys) {
+        before.push_back(locate(directory, key));
+    }
+
+    auto new_shard = directory.add_shard();
+    ASSERT_EQ(new_shard, m_n_shards);
+    size_t moved{0};
+    for(size_t i = 0; i < m_keys.size(); i++) {
+        auto shard = locate(directory, m_keys[i]);
+        if(shard != before[i]) {
+            // Keys only move to the new shard
+            ASSERT_EQ(shard, new_shard);
+            moved++;
+        }
+    }
+    ASSERT_GT(moved, 0);
+    ASSERT_LT(moved, m_n_keys / 2);
+
+    ASSERT_TRUE(directory.remove_shard(new_shard));
+    ASSERT_FALSE(directory.remove_shard(new_shard));
+    for(size_t i = 0; i < m_keys.size(); i++) {
+        ASSERT_EQ(locate(directory, m_keys[i]), before[i]);
+    }
+}
+
+TEST_F(consistent_hash_test, hot_keys_test) {
+    auto directory = cbdc::parsec::directory::consistent_hash(
+        m_n_shards,
+        cbdc::parsec::directory::consistent_hash::default_vnodes,
+        cbdc::parsec::directory::consistent_hash::default_max_tracked_keys,
+        1);
+    for(size_t i = 0; i < 10; i++) {
+        for(size_t j = 0; j <= i; j++) {
+            locate(directory, m_keys[i]);
+        }
+    }
+    ASSERT_EQ(directory.access_count(m_keys[9]), 10);
+    ASSERT_EQ(directory.access_count(m_keys[10]), 0);
+
+    auto hot = directory.hot_keys(3);
+    ASSERT_EQ(hot.size(), 3);
+    ASSERT_EQ(hot[0].first, m_keys[9]);
+    ASSERT_EQ(hot[0].second, 10);
+    ASSERT_EQ(hot[1].first, m_keys[8]);
+    ASSERT_EQ(hot[2].first, m_keys[7]);
+
+    directory.reset_access_counts();
+    ASSERT_EQ(directory.access_count(m_keys[9]), 0);
+    ASSERT_TRUE(directory.hot_keys(3).empty());
+}
+
+TEST_F(consistent_hash_test, sampled_access_test) {
+    static constexpr size_t sample_interval = 4;
+    auto directory = cbdc::parsec::directory::consistent_hash(
+        m_n_shards,
+        cbdc::parsec::directory::consistent_hash::default_vnodes,
+        cbdc::parsec::directory::consistent_hash::default_max_tracked_keys,
+        sample_interval);
+    for(size_t i = 0; i < sample_interval * 100; i++) {
+        locate(directory, m_keys[0]);
+    }
+    ASSERT_EQ(directory.access_count(m_keys[0]), sample_interval * 100);
+
+    // Keys looked up less often than the sample interval may be missed
+    locate(directory, m_keys[1]);
+    auto count = directory.access_count(m_keys[1]);
+    ASSERT_TRUE(count == 0 || count == sample_interval);
+
+    auto hot = directory.hot_keys(1);
+    ASSERT_EQ(hot.size(), 1);
+    ASSERT_EQ(hot[0].first, m_keys[0]);
+    ASSERT_EQ(hot[0].second, sample_interval * 100);
+}
@@ -7,6 +7,7 @@
 
 #include <future>
 #include <gtest/gtest.h>
+#include <thread>
 
 TEST(runtime_locking_shard_test, basic_test) {
     auto log = std::make_shared<cbdc::logging::log>(
@@ -723,3 +724,201 @@ TEST(runtime_locking_shard_test, upgrade_lock_test) {
         });
     ASSERT_TRUE(maybe_success);
 }
+
+TEST(runtime_locking_shard_test, read_test) {
+    auto log = std::make_shared<cbdc::logging::log>(
+        cbdc::logging::log_level::trace);
+    auto shard = cbdc::parsec::runtime_locking_shard::impl(log, 2);
+
+    auto key = cbdc::buffer::from_hex("aa").value();
+
+    auto write_value = [&](uint64_t ticket_number,
+                           const cbdc::buffer& value) {
+        auto maybe_success = shard.try_lock(
+            ticket_number,
+            0,
+            key,
+            cbdc::parsec::runtime_locking_shard::lock_type::write,
+            true,
+            [&](const cbdc::parsec::runtime_locking_shard::interface::
+                    try_lock_return_type& ret) {
+                ASSERT_TRUE(std::holds_alternative<
+                            cbdc::parsec::runtime_locking_shard::value_type>(
+                    ret));
+            });
+        ASSERT_TRUE(maybe_success);
+        maybe_success = shard.prepare(
+            ticket_number,
+            0,
+            {{key, value}},
+            [](const std::optional<
+                cbdc::parsec::runtime_locking_shard::shard_error>& ret) {
+                ASSERT_FALSE(ret.has_value());
+            });
+        ASSERT_TRUE(maybe_success);
+        maybe_success = shard.commit(
+            ticket_number,
+            [](const std::optional<
+                cbdc::parsec::runtime_locking_shard::shard_error>& ret) {
+                ASSERT_FALSE(ret.has_value());
+            });
+        ASSERT_TRUE(maybe_success);
+    };
+
+    auto expect_read
+        = [&](std::optional<uint64_t> as_of,
+              const cbdc::parsec::runtime_locking_shard::interface::
+                  read_return_type& exp) {
+              auto maybe_success = shard.read(
+                  key,
+                  as_of,
+                  [&](const cbdc::parsec::runtime_locking_shard::interface::
+                          read_return_type& ret) {
+                      ASSERT_EQ(ret.index(), exp.index());
+                      if(std::holds_alternative<
+                             cbdc::parsec::runtime_locking_shard::value_type>(
+                             ret)) {
+                          ASSERT_EQ(
+                              std::get<cbdc::parsec::runtime_locking_shard::
+                                           value_type>(ret),
+                              std::get<cbdc::parsec::runtime_locking_shard::
+                                           value_type>(exp));
+                      } else {
+                          ASSERT_EQ(
+                              std::get<cbdc::parsec::runtime_locking_shard::
+                                           shard_error>(ret)
+                                  .m_error_code,
+                              std::get<cbdc::parsec::runtime_locking_shard::
+                                           shard_error>(exp)
+                                  .m_error_code);
+                      }
+                  });
+              ASSERT_TRUE(maybe_success);
+          };
+
+    expect_read(std::nullopt, cbdc::buffer());
+
+    auto val1 = cbdc::buffer::from_hex("bb").value();
+    write_value(1, val1);
+    expect_read(std::nullopt, val1);
+    expect_read(0, cbdc::buffer());
+    expect_read(1, val1);
+
+    auto val2 = cbdc::buffer::from_hex("cc").value();
+    write_value(2, val2);
+    expect_read(std::nullopt, val2);
+    expect_read(1, val1);
+
+    // Reads are served while another ticket holds the write lock
+    auto maybe_success = shard.try_lock(
+        3,
+        0,
+        key,
+        cbdc::parsec::runtime_locking_shard::lock_type::write,
+        true,
+        [&](const cbdc::parsec::runtime_locking_shard::interface::
+                try_lock_return_type& ret) {
+            ASSERT_TRUE(std::holds_alternative<
+                        cbdc::parsec::runtime_locking_shard::value_type>(ret));
+        });
+    ASSERT_TRUE(maybe_success);
+    expect_read(std::nullopt, val2);
+    maybe_success = shard.rollback(
+        3,
+        [](const std::optional<
+            cbdc::parsec::runtime_locking_shard::shard_error>& ret) {
+            ASSERT_FALSE(ret.has_value());
+        });
+    ASSERT_TRUE(maybe_success);
+
+    // Only two versions are retained so the first version is discarded
+    auto val4 = cbdc::buffer::from_hex("dd").value();
+    write_value(4, val4);
+    expect_read(std::nullopt, val4);
+    expect_read(2, val2);
+    expect_read(1,
+                cbdc::parsec::runtime_locking_shard::shard_error{
+                    cbdc::parsec::runtime_locking_shard::error_code::
+                        version_unavailable,
+                    std::nullopt});
+}
+
+TEST(runtime_locking_shard_test, concurrent_disjoint_test) {
+    using namespace cbdc::parsec::runtime_locking_shard;
+    auto log = std::make_shared<cbdc::logging::log>(
+        cbdc::logging::log_level::warn);
+    static constexpr auto n_threads = 4;
+    static constexpr auto n_tickets = 200;
+    auto shard = impl(log, impl::default_max_versions, 2);
+
+    auto threads = std::vector<std::thread>();
+    for(size_t t = 0; t < n_threads; t++) {
+        threads.emplace_back([&, t]() {
+            auto key = cbdc::buffer();
+            key.append(&t, sizeof(t));
+            for(size_t i = 0; i < n_tickets; i++) {
+                auto ticket_number = i * n_threads + t;
+                auto val = cbdc::buffer();
+                val.append(&i, sizeof(i));
+                auto success = shard.try_lock(
+                    ticket_number,
+                    0,
+                    key,
+                    lock_type::write,
+                    true,
+                    [&](const interface::try_lock_return_type& ret) {
+                        ASSERT_TRUE(std::holds_alternative<value_type>(ret));
+                    });
+                ASSERT_TRUE(success);
+                success = shard.prepare(
+                    ticket_number,
+                    0,
+                    {{key, val}},
+                    [](const interface::prepare_return_type& ret) {
+                        ASSERT_FALSE(ret.has_value());
+                    });
+                ASSERT_TRUE(success);
+                success = shard.commit(
+                    ticket_number,
+                    [](const interface::commit_return_type& ret) {
+                        ASSERT_FALSE(ret.has_value());
+                    });
+                ASSERT_TRUE(success);
+                success = shard.finish(
+                    ticket_number,
+                    [](const interface::finish_return_type& ret) {
+                        ASSERT_FALSE(ret.has_value());
+                    });
+                ASSERT_TRUE(success);
+            }
+        });
+    }
+    for(auto& th : threads) {
+        th.join();
+    }
+
+    for(size_t t = 0; t < n_threads; t++) {
+        auto key = cbdc::buffer();
+        key.append(&t, sizeof(t));
+        auto exp = cbdc::buffer();
+        auto last = size_t{n_tickets - 1};
+        exp.append(&last, sizeof(last));
+        auto success = shard.read(
+            key,
+            std::nullopt,
+            [&](const interface::read_return_type& ret) {
+                ASSERT_TRUE(std::holds_alternative<value_type>(ret));
+                ASSERT_EQ(std::get<value_type>(ret), exp);
+            });
+        ASSERT_TRUE(success);
+    }
+
+    auto success = shard.get_tickets(
+        0,
+        [](const interface::get_tickets_return_type& ret) {
+            using success_type = interface::get_tickets_success_type;
+            ASSERT_TRUE(std::holds_alternative<success_type>(ret));
+            ASSERT_TRUE(std::get<success_type>(ret).empty());
+        });
+    ASSERT_TRUE(success);
+}
@@ -0,0 +1,212 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "parsec/ticket_machine/client.hpp"
+#include "util/rpc/tcp_server.hpp"
+#include "util/serialization/format.hpp"
+
+#include <condition_variable>
+#include <future>
+#include <gtest/gtest.h>
+#include <queue>
+#include <thread>
+
+class ticket_machine_client_test : public ::testing::Test {
+  protected:
+    using ticket_machine = cbdc::parsec::ticket_machine::interface;
+    using return_type = ticket_machine::get_ticket_number_return_type;
+    using range_type = ticket_machine::ticket_number_range_type;
+    using server_type = cbdc::rpc::async_tcp_server<
+        cbdc::parsec::ticket_machine::rpc::request,
+        cbdc::parsec::ticket_machine::rpc::response>;
+    using response_callback_type
+        = std::function<void(std::optional<return_type>)>;
+
+    void SetUp() override {
+        // Fake ticket machine which holds requests until the test responds
+        m_server.register_handler_callback(
+            [&](cbdc::parsec::ticket_machine::rpc::request /* req */,
+                response_callback_type cb) {
+                {
+                    std::unique_lock l(m_mut);
+                    m_requests.push(std::move(cb));
+                }
+                m_cv.notify_all();
+                return true;
+            });
+        ASSERT_TRUE(m_server.init());
+        ASSERT_TRUE(m_client.init());
+    }
+
+    /// Waits for the client to request a range of ticket numbers.
+    /// \return callback to respond to the request, or std::nullopt if
+    ///         no request arrived.
+    auto next_request() -> std::optional<response_callback_type> {
+        std::unique_lock l(m_mut);
+        if(!m_cv.wait_for(l, m_request_timeout, [&]() {
+               return !m_requests.empty();
+           })) {
+            return std::nullopt;
+        }
+        auto cb = std::move(m_requests.front());
+        m_requests.pop();
+        return cb;
+    }
+
+    /// Responds to the next request from the client.
+    /// \return false if no request arrived.
+    auto respond(return_type res) -> bool {
+        auto cb = next_request();
+        if(!cb.has_value()) {
+            return false;
+        }
+        (*cb)(res);
+        return true;
+    }
+
+    /// Returns the number of requests awaiting a response.
+    auto pending_requests() -> size_t {
+        std::unique_lock l(m_mut);
+        return m_requests.size();
+    }
+
+    /// Requests a ticket number from the client.
+    /// \param called_back set to whether the callback was called before
+    ///                    get_ticket_number returned.
+    /// \return future for the ticket number.
+    auto get_ticket(bool& called_back) -> std::future<return_type> {
+        auto res = std::make_shared<std::promise<return_type>>();
+        auto fut = res->get_future();
+        auto success = m_client.get_ticket_number([res](return_type ret) {
+            res->set_value(ret);
+        });
+        EXPECT_TRUE(success);
+        called_back = fut.wait_for(std::chrono::seconds(0))
+                   == std::future_status::ready;
+        return fut;
+    }
+
+    /// Requests a ticket number which the client should have in its
+    /// current lease.
+    /// \return ticket number, or std::nullopt if the client had to wait.
+    auto get_leased_ticket()
+        -> std::optional<cbdc::parsec::ticket_machine::ticket_number_type> {
+        bool called_back{};
+        auto fut = get_ticket(called_back);
+        if(!called_back) {
+            return std::nullopt;
+        }
+        auto ret = fut.get();
+        if(!std::holds_alternative<range_type>(ret)) {
+            return std::nullopt;
+        }
+        auto range = std::get<range_type>(ret);
+        EXPECT_EQ(range.first, range.second);
+        return range.first;
+    }
+
+    static constexpr auto m_threshold = 2;
+    static constexpr auto m_request_timeout = std::chrono::seconds(2);
+    /// Long enough for a request to have arrived if one was sent.
+    static constexpr auto m_no_request_wait = std::chrono::milliseconds(100);
+
+    // Declared before the server so requests arriving during shutdown
+    // still have a queue
+    std::mutex m_mut;
+    std::condition_variable m_cv;
+    std::queue<response_callback_type> m_requests;
+
+    cbdc::network::endpoint_t m_endpoint{cbdc::network::localhost, 29870};
+    server_type m_server{m_endpoint};
+    cbdc::parsec::ticket_machine::rpc::client m_client{{m_endpoint},
+                                                       m_threshold};
+};
+
+TEST_F(ticket_machine_client_test, acquire_test) {
+    // Without a lease the first caller waits for one
+    bool called_back{};
+    auto first = get_ticket(called_back);
+    ASSERT_FALSE(called_back);
+    ASSERT_TRUE(respond(range_type{10, 20}));
+    ASSERT_EQ(first.wait_for(m_request_timeout), std::future_status::ready);
+    ASSERT_EQ(std::get<range_type>(first.get()), (range_type{10, 10}));
+
+    // The rest of the lease is handed out in order without waiting
+    for(uint64_t i = 11; i < 18; i++) {
+        ASSERT_EQ(get_leased_ticket(), i);
+    }
+}
+
+TEST_F(ticket_machine_client_test, renew_test) {
+    bool called_back{};
+    auto first = get_ticket(called_back);
+    ASSERT_TRUE(respond(range_type{10, 20}));
+    ASSERT_EQ(std::get<range_type>(first.get()), (range_type{10, 10}));
+
+    // Installing a lease for waiting callers fetches the one after it
+    ASSERT_TRUE(respond(range_type{20, 30}));
+    std::this_thread::sleep_for(m_no_request_wait);
+    ASSERT_EQ(pending_requests(), 0UL);
+
+    // Moving to the queued lease does not wait on the ticket machine
+    for(uint64_t i = 11; i < 28; i++) {
+        ASSERT_EQ(get_leased_ticket(), i);
+    }
+    std::this_thread::sleep_for(m_no_request_wait);
+    ASSERT_EQ(pending_requests(), 0UL);
+
+    // Reaching the threshold in the current lease requests the next one
+    // while tickets remain
+    ASSERT_EQ(get_leased_ticket(), 28UL);
+    ASSERT_TRUE(respond(range_type{50, 60}));
+    std::this_thread::sleep_for(m_no_request_wait);
+    ASSERT_EQ(get_leased_ticket(), 29UL);
+    ASSERT_EQ(get_leased_ticket(), 50UL);
+}
+
+TEST_F(ticket_machine_client_test, expire_test) {
+    bool called_back{};
+    auto first = get_ticket(called_back);
+    ASSERT_TRUE(respond(range_type{10, 13}));
+    ASSERT_EQ(std::get<range_type>(first.get()), (range_type{10, 10}));
+    ASSERT_EQ(get_leased_ticket(), 11UL);
+    ASSERT_EQ(get_leased_ticket(), 12UL);
+
+    // Once the lease is used up, callers wait for the next range and are
+    // served in order when it arrives
+    auto waiting = std::vector<std::future<return_type>>();
+    for(size_t i = 0; i < 3; i++) {
+        waiting.emplace_back(get_ticket(called_back));
+        ASSERT_FALSE(called_back);
+    }
+    ASSERT_TRUE(respond(range_type{20, 30}));
+    for(uint64_t i = 0; i < waiting.size(); i++) {
+        ASSERT_EQ(waiting[i].wait_for(m_request_timeout),
+                  std::future_status::ready);
+        ASSERT_EQ(std::get<range_type>(waiting[i].get()),
+                  (range_type{20 + i, 20 + i}));
+    }
+}
+
+TEST_F(ticket_machine_client_test, expire_error_test) {
+    bool called_back{};
+    auto first = get_ticket(called_back);
+    ASSERT_TRUE(respond(range_type{10, 11}));
+    ASSERT_EQ(std::get<range_type>(first.get()), (range_type{10, 10}));
+
+    // The lease is exhausted and the ticket machine fails to renew it
+    auto waiting = get_ticket(called_back);
+    ASSERT_FALSE(called_back);
+    ASSERT_TRUE(respond(ticket_machine::error_code{}));
+    ASSERT_EQ(waiting.wait_for(m_request_timeout), std::future_status::ready);
+    ASSERT_TRUE(
+        std::holds_alternative<ticket_machine::error_code>(waiting.get()));
+
+    // The next caller retries the fetch
+    auto retry = get_ticket(called_back);
+    ASSERT_FALSE(called_back);
+    ASSERT_TRUE(respond(range_type{20, 30}));
+    ASSERT_EQ(std::get<range_type>(retry.get()), (range_type{20, 20}));
+}
@@ -9,12 +9,14 @@
 #include "util/raft/log_store.hpp"
 #include "util/raft/messages.hpp"
 #include "util/raft/node.hpp"
+#include "util/raft/segmented_log_store.hpp"
 #include "util/raft/serialization.hpp"
 #include "util/raft/state_manager.hpp"
 #include "util/raft/util.hpp"
 #include "util/serialization/format.hpp"
 #include "util/serialization/util.hpp"
 
+#include <atomic>
 #include <filesystem>
 #include <gtest/gtest.h>
 
@@ -625,6 +627,288 @@ TEST_F(raft_test, log_store_term_at) {
     }
 }
 
+TEST_F(raft_test, segmented_log_store_init) {
+    auto log_store = cbdc::raft::segmented_log_store();
+    ASSERT_TRUE(log_store.load(m_db_dir));
+    ASSERT_EQ(log_store.next_slot(), 1U);
+    ASSERT_EQ(log_store.start_index(), 1U);
+    auto last_entry = log_store.last_entry();
+    ASSERT_TRUE(last_entry);
+    ASSERT_EQ(last_entry->get_term(), 0U);
+    ASSERT_TRUE(last_entry->is_buf_null());
+}
+
+TEST_F(raft_test, segmented_log_store_load_filled) {
+    {
+        // Small segments so the log spans several files
+        auto log_store = cbdc::raft::segmented_log_store(3, 256, 4);
+        ASSERT_TRUE(log_store.load(m_db_dir));
+        for(auto& entry : m_dummy_log_entries) {
+            log_store.append(entry);
+        }
+        ASSERT_TRUE(log_store.flush());
+    }
+    {
+        auto log_store = cbdc::raft::segmented_log_store(3, 256, 4);
+        ASSERT_TRUE(log_store.load(m_db_dir));
+        ASSERT_EQ(log_store.next_slot(), m_dummy_log_entries.size() + 1);
+        ASSERT_EQ(log_store.start_index(), 1UL);
+
+        auto entry = log_store.last_entry();
+        ASSERT_EQ(entry->get_term(), m_dummy_log_entries.back()->get_term());
+        ASSERT_EQ(
+            std::memcmp(entry->serialize()->data_begin(),
+                        m_dummy_log_entries.back()->serialize()->data_begin(),
+                        entry->serialize()->size()),
+            0);
+
+        auto log_range = log_store.log_entries(1, 21);
+        ASSERT_EQ(log_range->size(), m_dummy_log_entries.size());
+        for(size_t i{0}; i < log_range->size(); i++) {
+            ASSERT_EQ((*log_range)[i]->get_term(),
+                      m_dummy_log_entries[i]->get_term());
+            ASSERT_EQ(log_store.term_at(i + 1),
+                      m_dummy_log_entries[i]->get_term());
+        }
+    }
+}
+
+TEST_F(raft_test, segmented_log_store_write_at) {
+    auto log_store = cbdc::raft::segmented_log_store(3, 256, 4);
+    ASSERT_TRUE(log_store.load(m_db_dir));
+
+    for(auto& entry : m_dummy_log_entries) {
+        log_store.append(entry);
+    }
+
+    log_store.write_at(3, m_dummy_log_entries[5]);
+    ASSERT_EQ(log_store.next_slot(), 4UL);
+    ASSERT_EQ(log_store.term_at(3), m_dummy_log_entries[5]->get_term());
+    ASSERT_EQ(log_store.term_at(4), 0UL);
+
+    auto entry = log_store.entry_at(4);
+    ASSERT_EQ(entry->get_term(), 0U);
+    ASSERT_TRUE(entry->is_buf_null());
+
+    log_store.append(m_dummy_log_entries[6]);
+
+    auto log_store2 = cbdc::raft::segmented_log_store(3, 256, 4);
+    ASSERT_TRUE(log_store2.load(m_db_dir));
+    ASSERT_EQ(log_store2.next_slot(), 5UL);
+    ASSERT_EQ(log_store2.term_at(3), m_dummy_log_entries[5]->get_term());
+    ASSERT_EQ(log_store2.term_at(4), m_dummy_log_entries[6]->get_term());
+}
+
+TEST_F(raft_test, segmented_log_store_pack_apply) {
+    auto log_store = cbdc::raft::segmented_log_store(3, 256, 4);
+    ASSERT_TRUE(log_store.load(m_db_dir));
+
+    for(auto& entry : m_dummy_log_entries) {
+        log_store.append(entry);
+    }
+
+    auto pack = log_store.pack(4, 17);
+    log_store.write_at(3, m_dummy_log_entries[2]);
+    ASSERT_EQ(log_store.next_slot(), 4UL);
+
+    log_store.apply_pack(4, *pack);
+    ASSERT_EQ(log_store.next_slot(), m_dummy_log_entries.size() + 1);
+
+    auto entry = log_store.entry_at(m_dummy_log_entries.size());
+    ASSERT_EQ(entry->get_term(), m_dummy_log_entries.back()->get_term());
+    ASSERT_EQ(
+        std::memcmp(entry->serialize()->data_begin(),
+                    m_dummy_log_entries.back()->serialize()->data_begin(),
+                    entry->serialize()->size()),
+        0);
+
+    // The packed format is shared with the LevelDB log store
+    auto leveldb_store = cbdc::raft::log_store();
+    ASSERT_TRUE(leveldb_store.load(m_db_dir + std::string("_leveldb")));
+    for(auto& e : m_dummy_log_entries) {
+        leveldb_store.append(e);
+    }
+    auto leveldb_pack = leveldb_store.pack(4, 17);
+    ASSERT_EQ(leveldb_pack->size(), pack->size());
+    ASSERT_EQ(std::memcmp(leveldb_pack->data_begin(),
+                          pack->data_begin(),
+                          pack->size()),
+              0);
+    std::filesystem::remove_all(m_db_dir + std::string("_leveldb"));
+}
+
+TEST_F(raft_test, segmented_log_store_compact) {
+    {
+        auto log_store = cbdc::raft::segmented_log_store(3, 256, 4);
+        ASSERT_TRUE(log_store.load(m_db_dir));
+
+        for(auto& entry : m_dummy_log_entries) {
+            log_store.append(entry);
+        }
+        ASSERT_TRUE(log_store.compact(16));
+        ASSERT_EQ(log_store.start_index(), 17UL);
+        ASSERT_EQ(log_store.term_at(16), 0UL);
+        ASSERT_EQ(log_store.term_at(17), m_dummy_log_entries[16]->get_term());
+    }
+    {
+        auto log_store2 = cbdc::raft::segmented_log_store(3, 256, 4);
+        ASSERT_TRUE(log_store2.load(m_db_dir));
+        ASSERT_EQ(log_store2.next_slot(), m_dummy_log_entries.size() + 1);
+        ASSERT_EQ(log_store2.start_index(), 17UL);
+        ASSERT_EQ(log_store2.entry_at(17)->get_term(),
+                  m_dummy_log_entries[16]->get_term());
+
+        // Compacting past the end of the log leaves it empty
+        ASSERT_TRUE(log_store2.compact(30));
+        ASSERT_EQ(log_store2.start_index(), 31UL);
+        ASSERT_EQ(log_store2.next_slot(), 31UL);
+        ASSERT_EQ(log_store2.append(m_dummy_log_entries[0]), 31UL);
+    }
+    {
+        auto log_store3 = cbdc::raft::segmented_log_store(3, 256, 4);
+        ASSERT_TRUE(log_store3.load(m_db_dir));
+        ASSERT_EQ(log_store3.start_index(), 31UL);
+        ASSERT_EQ(log_store3.next_slot(), 32UL);
+    }
+}
+
+TEST_F(raft_test, segmented_log_store_torn_record) {
+    {
+        auto log_store = cbdc::raft::segmented_log_store(3, 256, 4);
+        ASSERT_TRUE(log_store.load(m_db_dir));
+        for(auto& entry : m_dummy_log_entries) {
+            log_store.append(entry);
+        }
+        ASSERT_TRUE(log_store.flush());
+    }
+
+    // Flip the last byte of entry 14, the second record in the segment
+    // starting at entry 13, as if its payload never reached the disk
+    const auto seg_path
+        = std::filesystem::path(m_db_dir) / "00000000000000000013";
+    uint64_t record_end{};
+    {
+        auto idx_file = std::ifstream(seg_path.string() + ".idx",
+                                      std::ios::binary);
+        idx_file.seekg(sizeof(uint64_t));
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        idx_file.read(reinterpret_cast<char*>(&record_end),
+                      sizeof(record_end));
+        ASSERT_TRUE(idx_file.good());
+    }
+    {
+        auto data_file = std::fstream(seg_path.string() + ".seg",
+                                      std::ios::binary | std::ios::in
+                                          | std::ios::out);
+        data_file.seekg(static_cast<std::streamoff>(record_end - 1));
+        char byte{};
+        data_file.read(&byte, 1);
+        byte = static_cast<char>(~byte);
+        data_file.seekp(static_cast<std::streamoff>(record_end - 1));
+        data_file.write(&byte, 1);
+        ASSERT_TRUE(data_file.good());
+    }
+
+    // Recovery stops before the damaged record and drops everything after
+    auto log_store = cbdc::raft::segmented_log_store(3, 256, 4);
+    ASSERT_TRUE(log_store.load(m_db_dir));
+    ASSERT_EQ(log_store.next_slot(), 14UL);
+    ASSERT_EQ(log_store.term_at(13), m_dummy_log_entries[12]->get_term());
+    ASSERT_EQ(log_store.append(m_dummy_log_entries[13]), 14UL);
+    ASSERT_EQ(log_store.entry_at(14)->get_term(),
+              m_dummy_log_entries[13]->get_term());
+}
+
+TEST_F(raft_test, log_store_format_mismatch) {
+    auto segmented_sm
+        = cbdc::raft::state_manager(0,
+                                    m_db_dir,
+                                    m_config_file,
+                                    m_state_file,
+                                    m_raft_endpoints,
+                                    cbdc::config::raft_log_store_type::
+                                        segmented);
+    auto leveldb_sm
+        = cbdc::raft::state_manager(0,
+                                    m_db_dir,
+                                    m_config_file,
+                                    m_state_file,
+                                    m_raft_endpoints,
+                                    cbdc::config::raft_log_store_type::
+                                        leveldb);
+    ASSERT_TRUE(segmented_sm.log_format_matches());
+    ASSERT_TRUE(leveldb_sm.log_format_matches());
+
+    {
+        auto log_store = cbdc::raft::log_store();
+        ASSERT_TRUE(log_store.load(m_db_dir));
+        log_store.append(m_dummy_log_entries[0]);
+    }
+    ASSERT_FALSE(segmented_sm.log_format_matches());
+    ASSERT_TRUE(leveldb_sm.log_format_matches());
+    ASSERT_FALSE(cbdc::raft::segmented_log_store().load(m_db_dir));
+
+    std::filesystem::remove_all(m_db_dir);
+    {
+        auto log_store = cbdc::raft::segmented_log_store();
+        ASSERT_TRUE(log_store.load(m_db_dir));
+        log_store.append(m_dummy_log_entries[0]);
+    }
+    ASSERT_TRUE(segmented_sm.log_format_matches());
+    ASSERT_FALSE(leveldb_sm.log_format_matches());
+    ASSERT_FALSE(cbdc::raft::log_store().load(m_db_dir));
+}
+
+TEST_F(raft_test, segmented_log_store_cached_reads) {
+    auto log_store = cbdc::raft::segmented_log_store(3, 256, 4);
+    ASSERT_TRUE(log_store.load(m_db_dir));
+    for(auto& entry : m_dummy_log_entries) {
+        log_store.append(entry);
+    }
+
+    // The last four entries are in the cache. Reading one must not disturb
+    // later reads of the same entry.
+    const auto last = m_dummy_log_entries.size();
+    auto matches = [&](uint64_t idx,
+                       const nuraft::ptr<nuraft::log_entry>& entry) {
+        const auto& want = m_dummy_log_entries[idx - 1];
+        const auto got_buf = entry->serialize();
+        const auto want_buf = want->serialize();
+        return entry->get_term() == want->get_term()
+            && got_buf->size() == want_buf->size()
+            && std::memcmp(got_buf->data_begin(),
+                           want_buf->data_begin(),
+                           got_buf->size())
+                   == 0;
+    };
+    for(size_t i{0}; i < 2; i++) {
+        ASSERT_TRUE(matches(last, log_store.entry_at(last)));
+        auto log_range = log_store.log_entries(last - 3, last + 1);
+        for(size_t j{0}; j < log_range->size(); j++) {
+            ASSERT_TRUE(matches(last - 3 + j, (*log_range)[j]));
+        }
+    }
+
+    static constexpr size_t n_threads{2};
+    static constexpr size_t n_reads{1000};
+    std::atomic<size_t> mismatches{0};
+    auto threads = std::vector<std::thread>();
+    for(size_t i{0}; i < n_threads; i++) {
+        threads.emplace_back([&]() {
+            for(size_t j{0}; j < n_reads; j++) {
+                const auto idx = last - j % 4;
+                if(!matches(idx, log_store.entry_at(idx))) {
+                    mismatches++;
+                }
+            }
+        });
+    }
+    for(auto& t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(mismatches, 0UL);
+}
+
 TEST_F(raft_test, console_logger_loglevel) {
     // TODO: split these tests into separate fixtures.
     {
@@ -0,0 +1,315 @@
+// Copyright (c) 2022 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "util/rpc/http/json_rpc_http_client.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <future>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+    /// Minimal HTTP/1.1 server which passes the JSON body of each request
+    /// to a handler and replies with the value it returns. Serves each
+    /// keep-alive connection on its own thread.
+    class fake_server {
+      public:
+        using handler_type = std::function<Json::Value(const Json::Value&)>;
+
+        fake_server(uint16_t port, handler_type handler)
+            : m_handler(std::move(handler)),
+              m_url("http://127.0.0.1:" + std::to_string(port)) {
+            m_listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+            int one = 1;
+            setsockopt(m_listen_fd,
+                       SOL_SOCKET,
+                       SO_REUSEADDR,
+                       &one,
+                       sizeof(one));
+            auto addr = sockaddr_in();
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            auto* sa = reinterpret_cast<sockaddr*>(&addr);
+            m_listening = bind(m_listen_fd, sa, sizeof(addr)) == 0
+                       && listen(m_listen_fd, SOMAXCONN) == 0;
+            m_accept_thread = std::thread([&]() {
+                accept_loop();
+            });
+        }
+
+        ~fake_server() {
+            shutdown(m_listen_fd, SHUT_RDWR);
+            m_accept_thread.join();
+            close(m_listen_fd);
+            {
+                std::unique_lock l(m_mut);
+                for(auto fd : m_conns) {
+                    shutdown(fd, SHUT_RDWR);
+                }
+            }
+            for(auto& t : m_conn_threads) {
+                t.join();
+            }
+        }
+
+        fake_server(const fake_server&) = delete;
+        auto operator=(const fake_server&) -> fake_server& = delete;
+        fake_server(fake_server&&) = delete;
+        auto operator=(fake_server&&) -> fake_server& = delete;
+
+        [[nodiscard]] auto listening() const -> bool {
+            return m_listening;
+        }
+
+        [[nodiscard]] auto url() const -> std::string {
+            return m_url;
+        }
+
+        /// Returns the number of requests received so far.
+        [[nodiscard]] auto requests() -> size_t {
+            std::unique_lock l(m_mut);
+            return m_requests;
+        }
+
+      private:
+        handler_type m_handler;
+        std::string m_url;
+        int m_listen_fd{-1};
+        bool m_listening{};
+        std::thread m_accept_thread;
+
+        std::mutex m_mut;
+        std::vector<int> m_conns;
+        std::vector<std::thread> m_conn_threads;
+        size_t m_requests{};
+
+        void accept_loop() {
+            while(true) {
+                auto fd = accept(m_listen_fd, nullptr, nullptr);
+                if(fd == -1) {
+                    return;
+                }
+                std::unique_lock l(m_mut);
+                m_conns.push_back(fd);
+                m_conn_threads.emplace_back([&, fd]() {
+                    serve(fd);
+                    close(fd);
+                });
+            }
+        }
+
+        void serve(int fd) {
+            auto buf = std::string();
+            while(true) {
+                auto hdr_end = buf.find("\r\n\r\n");
+                while(hdr_end == std::string::npos) {
+                    if(!read_more(fd, buf)) {
+                        return;
+                    }
+                    hdr_end = buf.find("\r\n\r\n");
+                }
+                auto hdr = buf.substr(0, hdr_end);
+                std::transform(hdr.begin(),
+                               hdr.end(),
+                               hdr.begin(),
+                               [](unsigned char c) {
+                                   return std::tolower(c);
+                               });
+                static constexpr auto len_hdr
+                    = std::string_view("content-length:");
+                auto len_pos = hdr.find(len_hdr);
+                if(len_pos == std::string::npos) {
+                    return;
+                }
+                const auto body_len = std::stoul(
+                    hdr.substr(len_pos + len_hdr.size()));
+                const auto body_start = hdr_end + 4;
+                while(buf.size() < body_start + body_len) {
+                    if(!read_more(fd, buf)) {
+                        return;
+                    }
+                }
+                auto body = buf.substr(body_start, body_len);
+                buf.erase(0, body_start + body_len);
+
+                auto req = Json::Value();
+                auto r = Json::Reader();
+                if(!r.parse(body, req, false)) {
+                    return;
+                }
+                {
+                    std::unique_lock l(m_mut);
+                    m_requests++;
+                }
+
+                auto resp_body
+                    = Json::writeString(Json::StreamWriterBuilder(),
+                                        m_handler(req));
+                auto resp = "HTTP/1.1 200 OK\r\n"
+                            "Content-Type: application/json\r\n"
+                            "Content-Length: "
+                          + std::to_string(resp_body.size()) + "\r\n\r\n"
+                          + resp_body;
+                if(::send(fd, resp.data(), resp.size(), MSG_NOSIGNAL)
+                   != static_cast<ssize_t>(resp.size())) {
+                    return;
+                }
+            }
+        }
+
+        static auto read_more(int fd, std::string& buf) -> bool {
+            auto chunk = std::array<char, 4096>();
+            auto n = ::recv(fd, chunk.data(), chunk.size(), 0);
+            if(n <= 0) {
+                return false;
+            }
+            buf.append(chunk.data(), static_cast<size_t>(n));
+            return true;
+        }
+    };
+
+    /// Responds to a single call with its first parameter as the result.
+    auto echo(const Json::Value& call) -> Json::Value {
+        auto resp = Json::Value();
+        resp["jsonrpc"] = "2.0";
+        resp["id"] = call["id"];
+        resp["result"] = call["params"][0];
+        return resp;
+    }
+}
+
+class json_rpc_http_client_test : public ::testing::Test {
+  protected:
+    /// Pumps the client until the given number of calls have completed.
+    template<typename T>
+    void pump_until(T& client, const size_t& done, size_t target) {
+        for(size_t i = 0; i < m_max_pumps && done < target; i++) {
+            ASSERT_TRUE(client.pump());
+        }
+        ASSERT_EQ(done, target);
+    }
+
+    static constexpr size_t m_max_pumps = 200;
+
+    std::shared_ptr<cbdc::logging::log> m_log{
+        std::make_shared<cbdc::logging::log>(cbdc::logging::log_level::warn)};
+};
+
+TEST_F(json_rpc_http_client_test, batch_out_of_order_test) {
+    static constexpr size_t batch_size = 4;
+    static constexpr size_t n_calls = 6;
+    static constexpr Json::UInt64 missing = 2;
+
+    // Answers batches in reverse order, drops the call with the missing
+    // parameter and adds a response for an id that was never sent
+    std::mutex batch_mut;
+    auto batch_sizes = std::vector<Json::ArrayIndex>();
+    auto server = fake_server(29880, [&](const Json::Value& req) {
+        if(!req.isArray()) {
+            return echo(req);
+        }
+        {
+            std::unique_lock l(batch_mut);
+            batch_sizes.push_back(req.size());
+        }
+        auto resp = Json::Value(Json::arrayValue);
+        for(auto i = req.size(); i > 0; i--) {
+            const auto& call = req[i - 1];
+            if(call["params"][0].asUInt64() != missing) {
+                resp.append(echo(call));
+            }
+        }
+        auto stray = Json::Value();
+        stray["jsonrpc"] = "2.0";
+        stray["id"] = static_cast<Json::UInt64>(req.size());
+        stray["result"] = "stray";
+        resp.append(stray);
+        return resp;
+    });
+    ASSERT_TRUE(server.listening());
+
+    auto client = cbdc::rpc::json_rpc_http_client({server.url()},
+                                                  0,
+                                                  m_log,
+                                                  batch_size);
+    auto results = std::vector<std::optional<Json::Value>>(n_calls);
+    size_t done{};
+    for(size_t i = 0; i < n_calls; i++) {
+        auto params = Json::Value(Json::arrayValue);
+        params.append(static_cast<Json::UInt64>(i));
+        client.call("echo",
+                    std::move(params),
+                    [&, i](std::optional<Json::Value> res) {
+                        results[i] = std::move(res);
+                        done++;
+                    });
+    }
+    pump_until(client, done, n_calls);
+
+    // A full batch is sent right away, the rest on the next pump
+    {
+        std::unique_lock l(batch_mut);
+        ASSERT_EQ(batch_sizes, (std::vector<Json::ArrayIndex>{4, 2}));
+    }
+
+    for(size_t i = 0; i < n_calls; i++) {
+        if(i == missing) {
+            ASSERT_FALSE(results[i].has_value());
+            continue;
+        }
+        ASSERT_TRUE(results[i].has_value());
+        ASSERT_EQ((*results[i])["result"].asUInt64(), i);
+    }
+}
+
+TEST_F(json_rpc_http_client_test, fewest_outstanding_test) {
+    // The slow endpoint holds its responses until the test releases them,
+    // or the promise is destroyed if the test fails first
+    auto fast = fake_server(29881, echo);
+    auto release = std::promise<void>();
+    auto slow = fake_server(
+        29882,
+        [released = release.get_future().share()](const Json::Value& req) {
+            released.wait();
+            return echo(req);
+        });
+    ASSERT_TRUE(fast.listening());
+    ASSERT_TRUE(slow.listening());
+
+    auto client
+        = cbdc::rpc::json_rpc_http_client({slow.url(), fast.url()}, 0, m_log);
+    size_t done{};
+    auto call = [&]() {
+        auto params = Json::Value(Json::arrayValue);
+        params.append(static_cast<Json::UInt64>(done));
+        client.call("echo",
+                    std::move(params),
+                    [&](std::optional<Json::Value> res) {
+                        ASSERT_TRUE(res.has_value());
+                        done++;
+                    });
+    };
+
+    // The first call goes to the slow endpoint. While it is outstanding
+    // every other call goes to the fast one, rather than alternating.
+    static constexpr size_t n_fast = 5;
+    call();
+    for(size_t i = 0; i < n_fast; i++) {
+        call();
+        pump_until(client, done, i + 1);
+    }
+    ASSERT_EQ(slow.requests(), 1UL);
+    ASSERT_EQ(fast.requests(), n_fast);
+
+    release.set_value();
+    pump_until(client, done, n_fast + 1);
+}
@@ -0,0 +1,408 @@
+// Copyright (c) 2022 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "util/rpc/http/json_rpc_http_server.hpp"
+
+#include <arpa/inet.h>
+#include <condition_variable>
+#include <future>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    using server = cbdc::rpc::json_rpc_http_server;
+
+    /// Parses the payload the way the server does when the flat parser
+    /// declines it.
+    auto full_parse(std::string_view payload) -> std::optional<server::call> {
+        auto req = Json::Value();
+        auto r = Json::Reader();
+        if(!r.parse(payload.data(),
+                    payload.data() + payload.size(),
+                    req,
+                    false)) {
+            return std::nullopt;
+        }
+        return server::parse_call(req);
+    }
+
+    /// Checks that the flat parser either declines the payload or agrees
+    /// with the full parser, and returns the call the server would make.
+    auto parse(std::string_view payload) -> std::optional<server::call> {
+        auto full = full_parse(payload);
+        auto flat = server::parse_flat_call(payload);
+        if(flat.has_value()) {
+            EXPECT_TRUE(full.has_value());
+            if(full.has_value()) {
+                EXPECT_EQ(flat->m_method, full->m_method);
+                EXPECT_EQ(flat->m_params, full->m_params);
+                EXPECT_EQ(flat->m_id, full->m_id);
+                EXPECT_EQ(flat->m_notification, full->m_notification);
+            }
+        }
+        return full;
+    }
+
+    /// Sends a single POST request with the given body to a server on the
+    /// local host and waits for the connection to close.
+    /// \return the HTTP status code and the response body, or a zero status
+    ///         if the request failed.
+    auto post(uint16_t port, const std::string& body)
+        -> std::pair<unsigned int, std::string> {
+        auto fd = socket(AF_INET, SOCK_STREAM, 0);
+        auto addr = sockaddr_in();
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        auto* sa = reinterpret_cast<sockaddr*>(&addr);
+        auto req = "POST / HTTP/1.1\r\n"
+                   "Host: 127.0.0.1\r\n"
+                   "Content-Type: application/json\r\n"
+                   "Connection: close\r\n"
+                   "Content-Length: "
+                 + std::to_string(body.size()) + "\r\n\r\n" + body;
+        if(connect(fd, sa, sizeof(addr)) != 0
+           || ::send(fd, req.data(), req.size(), MSG_NOSIGNAL)
+                  != static_cast<ssize_t>(req.size())) {
+            close(fd);
+            return {0, ""};
+        }
+        auto resp = std::string();
+        auto chunk = std::array<char, 4096>();
+        for(auto n = ::recv(fd, chunk.data(), chunk.size(), 0); n > 0;
+            n = ::recv(fd, chunk.data(), chunk.size(), 0)) {
+            resp.append(chunk.data(), static_cast<size_t>(n));
+        }
+        close(fd);
+
+        static constexpr auto status_pos
+            = std::string_view("HTTP/1.1 ").size();
+        auto hdr_end = resp.find("\r\n\r\n");
+        if(resp.size() < status_pos || hdr_end == std::string::npos) {
+            return {0, ""};
+        }
+        auto code = std::stoul(resp.substr(status_pos));
+        return {static_cast<unsigned int>(code), resp.substr(hdr_end + 4)};
+    }
+
+    /// Parses a response body as JSON.
+    auto parse_json(const std::string& body) -> Json::Value {
+        auto ret = Json::Value();
+        auto r = Json::Reader();
+        EXPECT_TRUE(r.parse(body, ret, false)) << body;
+        return ret;
+    }
+}
+
+/// Runs a server whose handler responds to "echo" calls with their first
+/// parameter, and holds "defer" calls until the test answers them.
+class json_rpc_http_server_batch_test : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        m_server.register_handler_callback(
+            [&](const std::string& method,
+                Json::Value params,
+                const server::result_callback_type& callback) {
+                return handle(method, std::move(params), callback);
+            });
+        ASSERT_TRUE(m_server.init());
+    }
+
+    auto handle(const std::string& method,
+                Json::Value params,
+                const server::result_callback_type& callback) -> bool {
+        auto res = Json::Value();
+        res["result"] = params[0];
+        if(method == "echo") {
+            callback(res);
+            return true;
+        }
+        if(method == "fail_after") {
+            // Responds, then reports that the call could not be sent
+            callback(res);
+            return false;
+        }
+        if(method == "defer") {
+            std::unique_lock l(m_mut);
+            m_deferred.emplace_back(callback, std::move(res));
+            m_cv.notify_one();
+            return true;
+        }
+        return false;
+    }
+
+    /// Waits until the given number of calls are deferred, then answers
+    /// them in the reverse order.
+    void answer_deferred_reversed(size_t n) {
+        auto deferred = decltype(m_deferred)();
+        {
+            std::unique_lock l(m_mut);
+            ASSERT_TRUE(m_cv.wait_for(l, m_timeout, [&]() {
+                return m_deferred.size() == n;
+            }));
+            std::swap(deferred, m_deferred);
+        }
+        for(auto it = deferred.rbegin(); it != deferred.rend(); it++) {
+            it->first(it->second);
+        }
+    }
+
+    static constexpr uint16_t m_port = 29890;
+    static constexpr auto m_timeout = std::chrono::seconds(5);
+
+    std::mutex m_mut;
+    std::condition_variable m_cv;
+    std::vector<std::pair<server::result_callback_type, Json::Value>>
+        m_deferred;
+
+    server m_server{{"127.0.0.1", m_port}};
+};
+
+TEST(json_rpc_http_server_test, flat_call) {
+    static constexpr auto payload
+        = R"({"jsonrpc":"2.0","method":"eth_sendRawTransaction",)"
+          R"("params":["0xabcd",true,{"from":"0x01","to":"0x02"}],)"
+          R"("id":42})";
+    auto c = server::parse_flat_call(payload);
+    ASSERT_TRUE(c.has_value());
+    ASSERT_EQ(c->m_method, "eth_sendRawTransaction");
+    ASSERT_EQ(c->m_id, 42UL);
+    ASSERT_TRUE(c->m_params.isArray());
+    ASSERT_EQ(c->m_params.size(), 3U);
+    ASSERT_EQ(c->m_params[0].asString(), "0xabcd");
+    ASSERT_TRUE(c->m_params[1].asBool());
+    ASSERT_EQ(c->m_params[2]["from"].asString(), "0x01");
+    ASSERT_EQ(c->m_params[2]["to"].asString(), "0x02");
+    ASSERT_TRUE(parse(payload).has_value());
+}
+
+TEST(json_rpc_http_server_test, whitespace) {
+    static constexpr auto payload
+        = " {\n\t\"method\" : \"m\" ,\r\n \"params\" : [ \"a\" , "
+          "{ \"k\" : \"v\" } , false ] ,\"id\" : 7 } \n";
+    auto c = server::parse_flat_call(payload);
+    ASSERT_TRUE(c.has_value());
+    ASSERT_EQ(c->m_method, "m");
+    ASSERT_EQ(c->m_id, 7UL);
+    ASSERT_EQ(c->m_params.size(), 3U);
+    ASSERT_TRUE(parse(payload).has_value());
+}
+
+TEST(json_rpc_http_server_test, escapes) {
+    // Escaped strings are left to the full parser, which decodes them
+    static constexpr auto method = R"({"method":"a\u0062c","id":1})";
+    ASSERT_FALSE(server::parse_flat_call(method).has_value());
+    auto c = parse(method);
+    ASSERT_TRUE(c.has_value());
+    ASSERT_EQ(c->m_method, "abc");
+
+    static constexpr auto param = R"({"method":"m","params":["\"q\""]})";
+    ASSERT_FALSE(server::parse_flat_call(param).has_value());
+    c = parse(param);
+    ASSERT_TRUE(c.has_value());
+    ASSERT_EQ(c->m_params[0].asString(), "\"q\"");
+
+    static constexpr auto key = R"({"method":"m","params":[{"k\n":"v"}]})";
+    ASSERT_FALSE(server::parse_flat_call(key).has_value());
+    c = parse(key);
+    ASSERT_TRUE(c.has_value());
+    ASSERT_EQ(c->m_params[0]["k\n"].asString(), "v");
+}
+
+TEST(json_rpc_http_server_test, ids) {
+    static constexpr auto max_id
+        = R"({"method":"m","id":1234567890123456789})";
+    auto c = parse(max_id);
+    ASSERT_TRUE(server::parse_flat_call(max_id).has_value());
+    ASSERT_EQ(c->m_id, 1234567890123456789UL);
+
+    ASSERT_FALSE(c->m_notification);
+    ASSERT_TRUE(parse(R"({"method":"m"})")->m_notification);
+    ASSERT_FALSE(parse(R"({"method":"m","id":null})")->m_notification);
+
+    // Any id that is not an unsigned integer becomes zero
+    for(const auto* payload : {R"({"method":"m","id":"7"})",
+                               R"({"method":"m","id":null})",
+                               R"({"method":"m","id":-1})",
+                               R"({"method":"m","id":1.5})",
+                               R"({"method":"m","id":-0.5})",
+                               R"({"method":"m","id":[1]})",
+                               R"({"method":"m"})"}) {
+        c = parse(payload);
+        ASSERT_TRUE(c.has_value()) << payload;
+        ASSERT_EQ(c->m_id, 0UL) << payload;
+    }
+
+    // Ids the flat parser cannot hold are left to the full parser
+    static constexpr auto big_id
+        = R"({"method":"m","id":18446744073709551615})";
+    ASSERT_FALSE(server::parse_flat_call(big_id).has_value());
+    c = parse(big_id);
+    ASSERT_TRUE(c.has_value());
+    ASSERT_EQ(c->m_id, 18446744073709551615UL);
+
+    static constexpr auto exp_id = R"({"method":"m","id":1e3})";
+    ASSERT_FALSE(server::parse_flat_call(exp_id).has_value());
+    c = parse(exp_id);
+    ASSERT_TRUE(c.has_value());
+    ASSERT_EQ(c->m_id, 1000UL);
+}
+
+TEST(json_rpc_http_server_test, nested_params) {
+    for(const auto* payload :
+        {R"({"method":"m","params":[{"k":{"n":"v"}}],"id":1})",
+         R"({"method":"m","params":[["a"]],"id":1})",
+         R"({"method":"m","params":[{"k":["v"]}],"id":1})",
+         R"({"method":"m","params":[1,null],"id":1})",
+         R"({"method":"m","params":{"k":"v"},"id":1})"}) {
+        ASSERT_FALSE(server::parse_flat_call(payload).has_value())
+            << payload;
+        auto c = parse(payload);
+        ASSERT_TRUE(c.has_value()) << payload;
+        ASSERT_EQ(c->m_id, 1UL) << payload;
+    }
+
+    auto c = parse(R"({"method":"m","params":[{"k":{"n":"v"}}]})");
+    ASSERT_EQ(c->m_params[0]["k"]["n"].asString(), "v");
+}
+
+TEST(json_rpc_http_server_test, missing_params) {
+    static constexpr auto payload = R"({"jsonrpc":"2.0","method":"m"})";
+    auto flat = server::parse_flat_call(payload);
+    ASSERT_TRUE(flat.has_value());
+    ASSERT_TRUE(flat->m_params.isNull());
+    auto c = parse(payload);
+    ASSERT_TRUE(c.has_value());
+    ASSERT_TRUE(c->m_params.isNull());
+
+    static constexpr auto empty = R"({"method":"m","params":[]})";
+    flat = server::parse_flat_call(empty);
+    ASSERT_TRUE(flat.has_value());
+    ASSERT_TRUE(flat->m_params.isArray());
+    ASSERT_TRUE(flat->m_params.empty());
+    ASSERT_TRUE(parse(empty).has_value());
+}
+
+TEST(json_rpc_http_server_test, invalid) {
+    for(const auto* payload : {"",
+                               "[]",
+                               R"({"params":[]})",
+                               R"({"method":1})",
+                               R"({"method":"m")",
+                               R"({"method":"m"} x)",
+                               R"({"method":"m","params":["a",]})"}) {
+        ASSERT_FALSE(server::parse_flat_call(payload).has_value())
+            << payload;
+    }
+}
+
+TEST_F(json_rpc_http_server_batch_test, mixed_valid_and_invalid) {
+    auto [code, body] = post(
+        m_port,
+        R"([{"jsonrpc":"2.0","method":"echo","params":[1],"id":1},)"
+        R"(5,{"jsonrpc":"2.0","params":[2],"id":2},)"
+        R"({"jsonrpc":"2.0","method":"unknown","params":[3],"id":3},)"
+        R"({"jsonrpc":"2.0","method":"echo","params":[4],"id":4}])");
+    ASSERT_EQ(code, 200U);
+    auto resp = parse_json(body);
+    ASSERT_TRUE(resp.isArray());
+    ASSERT_EQ(resp.size(), 5U);
+
+    ASSERT_EQ(resp[0]["id"].asUInt64(), 1UL);
+    ASSERT_EQ(resp[0]["result"].asUInt64(), 1UL);
+
+    // Entries which are not calls get an error with a null ID
+    for(Json::ArrayIndex i : {1, 2}) {
+        ASSERT_EQ(resp[i]["jsonrpc"].asString(), "2.0");
+        ASSERT_EQ(resp[i]["error"]["code"].asInt(), -32600);
+        ASSERT_TRUE(resp[i]["id"].isNull());
+    }
+
+    ASSERT_EQ(resp[3]["id"].asUInt64(), 3UL);
+    ASSERT_EQ(resp[3]["error"]["code"].asInt(), -32602);
+
+    ASSERT_EQ(resp[4]["id"].asUInt64(), 4UL);
+    ASSERT_EQ(resp[4]["result"].asUInt64(), 4UL);
+}
+
+TEST_F(json_rpc_http_server_batch_test, fail_after_respond) {
+    // Only the response counts when the handler fails afterwards
+    auto [code, body] = post(
+        m_port,
+        R"([{"jsonrpc":"2.0","method":"fail_after","params":[1],"id":1},)"
+        R"({"jsonrpc":"2.0","method":"echo","params":[2],"id":2}])");
+    ASSERT_EQ(code, 200U);
+    auto resp = parse_json(body);
+    ASSERT_EQ(resp.size(), 2U);
+    for(Json::ArrayIndex i = 0; i < resp.size(); i++) {
+        ASSERT_FALSE(resp[i].isMember("error"));
+        ASSERT_EQ(resp[i]["id"].asUInt64(), i + 1);
+        ASSERT_EQ(resp[i]["result"].asUInt64(), i + 1);
+    }
+}
+
+TEST_F(json_rpc_http_server_batch_test, out_of_order) {
+    static constexpr size_t n_calls = 3;
+    auto req = Json::Value(Json::arrayValue);
+    for(size_t i = 0; i < n_calls; i++) {
+        auto call = Json::Value();
+        call["jsonrpc"] = "2.0";
+        call["method"] = "defer";
+        call["params"].append(static_cast<Json::UInt64>(i * 2));
+        call["id"] = static_cast<Json::UInt64>(i);
+        req.append(std::move(call));
+    }
+    auto res = std::async(std::launch::async, [&]() {
+        auto builder = Json::StreamWriterBuilder();
+        return post(m_port, Json::writeString(builder, req));
+    });
+    answer_deferred_reversed(n_calls);
+
+    auto [code, body] = res.get();
+    ASSERT_EQ(code, 200U);
+    auto resp = parse_json(body);
+    ASSERT_EQ(resp.size(), n_calls);
+    for(Json::ArrayIndex i = 0; i < n_calls; i++) {
+        ASSERT_EQ(resp[i]["id"].asUInt64(), i);
+        ASSERT_EQ(resp[i]["result"].asUInt64(), i * 2);
+    }
+}
+
+TEST_F(json_rpc_http_server_batch_test, empty) {
+    // An empty batch gets a single error rather than an array
+    auto [code, body] = post(m_port, "[]");
+    ASSERT_EQ(code, 200U);
+    auto resp = parse_json(body);
+    ASSERT_TRUE(resp.isObject());
+    ASSERT_EQ(resp["jsonrpc"].asString(), "2.0");
+    ASSERT_EQ(resp["error"]["code"].asInt(), -32600);
+    ASSERT_TRUE(resp["id"].isNull());
+}
+
+TEST_F(json_rpc_http_server_batch_test, notifications) {
+    auto [code, body] = post(
+        m_port,
+        R"([{"jsonrpc":"2.0","method":"echo","params":[1]},)"
+        R"({"jsonrpc":"2.0","method":"echo","params":[2],"id":null},)"
+        R"({"jsonrpc":"2.0","method":"echo","params":[3],"id":3}])");
+    ASSERT_EQ(code, 200U);
+    auto resp = parse_json(body);
+    ASSERT_EQ(resp.size(), 2U);
+    ASSERT_TRUE(resp[0]["id"].isNull());
+    ASSERT_EQ(resp[0]["result"].asUInt64(), 2UL);
+    ASSERT_EQ(resp[1]["id"].asUInt64(), 3UL);
+    ASSERT_EQ(resp[1]["result"].asUInt64(), 3UL);
+
+    // A batch of only notifications gets no response
+    std::tie(code, body) = post(
+        m_port,
+        R"([{"jsonrpc":"2.0","method":"echo","params":[1]},)"
+        R"({"jsonrpc":"2.0","method":"unknown","params":[2]}])");
+    ASSERT_EQ(code, 204U);
+    ASSERT_TRUE(body.empty());
+}
@@ -9,6 +9,8 @@
 #include "util/rpc/tcp_server.hpp"
 #include "util/serialization/format.hpp"
 
+#include <condition_variable>
+#include <future>
 #include <gtest/gtest.h>
 #include <variant>
 
@@ -263,3 +265,140 @@ TEST(tcp_rpc_test, async_error_test) {
     status = done_fut.wait_for(std::chrono::milliseconds(100));
     ASSERT_EQ(status, std::future_status::ready);
 }
+
+TEST(tcp_rpc_test, coalesce_blocking_test) {
+    using request = int64_t;
+    using response = int64_t;
+
+    auto ep = cbdc::network::endpoint_t{cbdc::network::localhost, 55555};
+    auto server = cbdc::rpc::blocking_tcp_server<request, response>(ep);
+    server.register_handler_callback(
+        [](request req) -> std::optional<response> {
+            return req * 2;
+        });
+
+    ASSERT_TRUE(server.init());
+
+    auto client = cbdc::rpc::tcp_client<request, response>(
+        {ep},
+        std::chrono::milliseconds(1));
+    ASSERT_TRUE(client.init());
+
+    static constexpr auto n_threads = 16;
+    static constexpr auto n_calls = 5;
+    auto failures = std::atomic<int>();
+    auto threads = std::vector<std::thread>();
+    for(int i = 0; i < n_threads; i++) {
+        threads.emplace_back([&, i]() {
+            for(int j = 0; j < n_calls; j++) {
+                auto req = request{i * n_calls + j};
+                auto resp = client.call(req);
+                if(!resp.has_value() || resp.value() != req * 2) {
+                    failures++;
+                }
+            }
+        });
+    }
+    for(auto& t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(failures, 0);
+}
+
+TEST(tcp_rpc_test, coalesce_async_test) {
+    using request = int64_t;
+    using response = int64_t;
+
+    auto ep = cbdc::network::endpoint_t{cbdc::network::localhost, 55555};
+    auto server = cbdc::rpc::async_tcp_server<request, response>(ep);
+    server.register_handler_callback(
+        [](request req,
+           std::function<void(std::optional<response>)> cb) -> bool {
+            // Odd requests fail immediately, so their responses come back
+            // in a batch
+            if(req % 2 != 0) {
+                return false;
+            }
+            std::thread([cb = std::move(cb), req]() {
+                cb(req);
+            }).detach();
+            return true;
+        });
+
+    ASSERT_TRUE(server.init());
+
+    auto client = cbdc::rpc::tcp_client<request, response>(
+        {ep},
+        std::chrono::milliseconds(1));
+    ASSERT_TRUE(client.init());
+
+    static constexpr auto n_calls = 100;
+    auto mut = std::mutex();
+    auto cv = std::condition_variable();
+    auto n_ok = 0;
+    auto n_failed = 0;
+    for(int i = 0; i < n_calls; i++) {
+        auto success = client.call(i, [&, i](std::optional<response> resp) {
+            std::unique_lock l(mut);
+            if(resp.has_value() && resp.value() == i) {
+                n_ok++;
+            } else if(!resp.has_value() && i % 2 != 0) {
+                n_failed++;
+            }
+            cv.notify_one();
+        });
+        ASSERT_TRUE(success);
+    }
+
+    std::unique_lock l(mut);
+    ASSERT_TRUE(cv.wait_for(l, std::chrono::seconds(1), [&]() {
+        return n_ok == n_calls / 2 && n_failed == n_calls / 2;
+    }));
+}
+
+TEST(tcp_rpc_test, many_outstanding_test) {
+    using request = int64_t;
+    using response = int64_t;
+
+    // More requests than the client's response slots, answered in reverse
+    static constexpr auto n_calls = 3000;
+
+    auto ep = cbdc::network::endpoint_t{cbdc::network::localhost, 55555};
+    auto server = cbdc::rpc::async_tcp_server<request, response>(ep);
+    using callback_type = std::function<void(std::optional<response>)>;
+    auto pending = std::vector<std::pair<request, callback_type>>();
+    server.register_handler_callback(
+        [&](request req, callback_type cb) -> bool {
+            pending.emplace_back(req, std::move(cb));
+            if(pending.size() == n_calls) {
+                for(auto it = pending.rbegin(); it != pending.rend(); it++) {
+                    it->second(it->first);
+                }
+            }
+            return true;
+        });
+
+    ASSERT_TRUE(server.init());
+
+    auto client = cbdc::rpc::tcp_client<request, response>({ep});
+    ASSERT_TRUE(client.init());
+
+    auto mut = std::mutex();
+    auto cv = std::condition_variable();
+    auto n_ok = 0;
+    for(int i = 0; i < n_calls; i++) {
+        auto success = client.call(i, [&, i](std::optional<response> resp) {
+            std::unique_lock l(mut);
+            if(resp.has_value() && resp.value() == i) {
+                n_ok++;
+            }
+            cv.notify_one();
+        });
+        ASSERT_TRUE(success);
+    }
+
+    std::unique_lock l(mut);
+    ASSERT_TRUE(cv.wait_for(l, std::chrono::seconds(5), [&]() {
+        return n_ok == n_calls;
+    }));
+}
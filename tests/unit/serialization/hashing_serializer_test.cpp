@@ -0,0 +1,84 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "crypto/sha256.h"
+#include "uhs/transaction/messages.hpp"
+#include "util/serialization/format.hpp"
+#include "util/serialization/hashing_serializer.hpp"
+#include "util/serialization/util.hpp"
+
+#include <gtest/gtest.h>
+
+namespace {
+    auto buffered_hash(const cbdc::buffer& buf) -> cbdc::hash_t {
+        auto sha = CSHA256();
+        sha.Write(buf.c_ptr(), buf.size());
+        auto ret = cbdc::hash_t();
+        sha.Finalize(ret.data());
+        return ret;
+    }
+}
+
+class hashing_serializer_test : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        for(unsigned char i = 0; i < 3; i++) {
+            auto inp = cbdc::transaction::input();
+            inp.m_prevout.m_tx_id = {i, 'a'};
+            inp.m_prevout.m_index = i;
+            inp.m_prevout_data.m_value = 10U + i;
+            inp.m_prevout_data.m_witness_program_commitment = {'w', i};
+            m_tx.m_inputs.push_back(inp);
+            m_tx.m_witness.emplace_back(64, std::byte(i));
+        }
+        m_tx.m_outputs.emplace_back(cbdc::hash_t{'o'}, 33);
+    }
+
+    cbdc::transaction::full_tx m_tx{};
+};
+
+TEST_F(hashing_serializer_test, matches_buffer) {
+    ASSERT_EQ(cbdc::hash_serialized(m_tx),
+              buffered_hash(cbdc::make_buffer(m_tx)));
+}
+
+TEST_F(hashing_serializer_test, multiple_objects) {
+    auto buf = cbdc::buffer();
+    auto buf_ser = cbdc::buffer_serializer(buf);
+    buf.extend(cbdc::serialized_size(m_tx.m_inputs)
+               + cbdc::serialized_size(m_tx.m_outputs) + sizeof(uint64_t));
+    buf_ser << m_tx.m_inputs << m_tx.m_outputs << uint64_t{7};
+
+    auto ser = cbdc::hashing_serializer();
+    ASSERT_TRUE(ser << m_tx.m_inputs << m_tx.m_outputs << uint64_t{7});
+    ASSERT_EQ(ser.finalize(), buffered_hash(buf));
+}
+
+TEST_F(hashing_serializer_test, advance_cursor) {
+    static constexpr auto len = 150;
+    auto buf = cbdc::buffer();
+    buf.extend(len);
+    std::memset(buf.data(), 0, len);
+
+    auto ser = cbdc::hashing_serializer();
+    ser.advance_cursor(len);
+    ASSERT_EQ(ser.finalize(), buffered_hash(buf));
+}
+
+TEST_F(hashing_serializer_test, reset) {
+    auto ser = cbdc::hashing_serializer();
+    ser << m_tx.m_outputs;
+    ser.reset();
+    ser << m_tx;
+    ASSERT_EQ(ser.finalize(), cbdc::hash_serialized(m_tx));
+
+    // Finalizing also resets the serializer
+    ser << m_tx;
+    ASSERT_EQ(ser.finalize(), cbdc::hash_serialized(m_tx));
+
+    uint64_t data{};
+    ASSERT_FALSE(ser.read(&data, sizeof(data)));
+    ASSERT_FALSE(ser.end_of_buffer());
+}
@@ -8,6 +8,8 @@
 #include "util.hpp"
 
 #include <filesystem>
+#include <fstream>
+#include <sstream>
 #include <gtest/gtest.h>
 
 static constexpr auto g_shard_test_dir = "test_shard_db";
@@ -149,3 +151,129 @@ TEST_F(shard_test, digest_block_valid) {
 
     ASSERT_EQ(invalid_got, invalid_want);
 }
+
+TEST_F(shard_test, digest_block_projection) {
+    cbdc::atomizer::block b2;
+    b2.m_height = 2;
+    b2.m_transactions.push_back(
+        cbdc::test::simple_tx({'c'}, {{1}, {3}, {11}}, {{7}, {9}}));
+    b2.m_transactions.push_back(
+        cbdc::test::simple_tx({'d'}, {{2}, {12}}, {{10}}));
+    b2.m_transactions.front().m_attestations.emplace(cbdc::pubkey_t{},
+                                                     cbdc::signature_t{});
+
+    auto proj = cbdc::atomizer::project_block(b2, {3, 8});
+    ASSERT_EQ(proj.m_height, 2UL);
+    ASSERT_EQ(proj.m_transactions.size(), 1UL);
+    const auto& ptx = proj.m_transactions[0];
+    ASSERT_EQ(ptx.m_id, b2.m_transactions[0].m_id);
+    ASSERT_EQ(ptx.m_inputs, (std::vector<cbdc::hash_t>{{3}}));
+    ASSERT_EQ(ptx.m_uhs_outputs, (std::vector<cbdc::hash_t>{{7}}));
+    ASSERT_TRUE(ptx.m_attestations.empty());
+
+    ASSERT_TRUE(m_shard.digest_block(proj));
+
+    cbdc::transaction::compact_tx ctx{};
+    ctx.m_id = {'e'};
+    ctx.m_inputs = {{3}, {4}, {7}};
+    auto res = m_shard.digest_transaction(ctx);
+    ASSERT_TRUE(std::holds_alternative<cbdc::watchtower::tx_error>(res));
+    auto want = cbdc::watchtower::tx_error{
+        {'e'},
+        cbdc::watchtower::tx_error_inputs_dne{{{3}}}};
+    ASSERT_EQ(std::get<cbdc::watchtower::tx_error>(res), want);
+}
+
+TEST_F(shard_test, snapshot_round_trip) {
+    static constexpr auto import_dir = "test_shard_import_db";
+    static constexpr auto snapshot_file = "test_shard_snapshot";
+
+    // Fill the shard with enough UHS IDs to span several chunks, including
+    // IDs outside its range which should not be exported
+    cbdc::atomizer::block b2;
+    b2.m_height = 2;
+    for(unsigned char i = 0; i < 50; i++) {
+        b2.m_transactions.push_back(cbdc::test::simple_tx(
+            {'e', i},
+            {},
+            {{static_cast<unsigned char>(i % 10), i},
+             {static_cast<unsigned char>(i % 10), i, 1}}));
+    }
+    ASSERT_TRUE(m_shard.digest_block(b2));
+
+    {
+        auto out = std::ofstream(snapshot_file, std::ios::binary);
+        auto info = m_shard.export_snapshot(out, 16);
+        ASSERT_TRUE(info.has_value());
+        ASSERT_EQ(info->m_height, 2UL);
+        // 4 IDs from block 1 and 60 in range from block 2
+        ASSERT_EQ(info->m_count, 64UL);
+        ASSERT_EQ(info->m_chunks.size(), 4UL);
+    }
+
+    auto imported = cbdc::shard::shard({3, 8});
+    ASSERT_FALSE(imported.open_db(import_dir).has_value());
+    ASSERT_FALSE(imported.import_snapshot(snapshot_file, 3).has_value());
+    ASSERT_EQ(imported.best_block_height(), 2UL);
+
+    // Re-exporting the imported shard gives the same root
+    auto orig_ss = std::stringstream();
+    auto imported_ss = std::stringstream();
+    auto orig_info = m_shard.export_snapshot(orig_ss);
+    auto imported_info = imported.export_snapshot(imported_ss);
+    ASSERT_TRUE(orig_info.has_value());
+    ASSERT_TRUE(imported_info.has_value());
+    ASSERT_EQ(orig_info->m_root, imported_info->m_root);
+    ASSERT_EQ(orig_ss.str(), imported_ss.str());
+
+    cbdc::transaction::compact_tx ctx{};
+    ctx.m_id = {'a'};
+    ctx.m_inputs = {{3}, {5, 5}, {9, 9}};
+    auto res = imported.digest_transaction(ctx);
+    ASSERT_TRUE(
+        std::holds_alternative<cbdc::atomizer::tx_notify_request>(res));
+    auto want = cbdc::atomizer::tx_notify_request();
+    want.m_tx = ctx;
+    want.m_attestations = {0, 1};
+    want.m_block_height = 2;
+    ASSERT_EQ(std::get<cbdc::atomizer::tx_notify_request>(res), want);
+
+    // The shard is no longer empty
+    ASSERT_TRUE(imported.import_snapshot(snapshot_file, 1).has_value());
+
+    std::filesystem::remove_all(import_dir);
+    std::filesystem::remove(snapshot_file);
+}
+
+TEST_F(shard_test, snapshot_corrupt_chunk) {
+    auto ss = std::stringstream();
+    auto info = m_shard.export_snapshot(ss, 2);
+    ASSERT_TRUE(info.has_value());
+    ASSERT_EQ(info->m_chunks.size(), 2UL);
+
+    auto in = std::stringstream(ss.str());
+    auto read_info = cbdc::shard::read_uhs_snapshot_info(in);
+    ASSERT_TRUE(read_info.has_value());
+    ASSERT_EQ(read_info->m_root, info->m_root);
+    auto ids = cbdc::shard::read_uhs_snapshot_chunk(in, info->m_chunks[1]);
+    ASSERT_TRUE(ids.has_value());
+    auto want = std::vector<cbdc::hash_t>{{5}, {6}};
+    ASSERT_EQ(ids.value(), want);
+
+    // Flip the last byte of the second chunk
+    auto buf = ss.str();
+    const auto& chunk = info->m_chunks[1];
+    buf[chunk.m_offset + chunk.m_size - 1] ^= 1;
+    auto corrupt = std::stringstream(buf);
+    ASSERT_TRUE(cbdc::shard::read_uhs_snapshot_info(corrupt).has_value());
+    ASSERT_TRUE(
+        cbdc::shard::read_uhs_snapshot_chunk(corrupt, info->m_chunks[0])
+            .has_value());
+    ASSERT_FALSE(
+        cbdc::shard::read_uhs_snapshot_chunk(corrupt, info->m_chunks[1])
+            .has_value());
+
+    // Truncated snapshots are rejected outright
+    auto truncated = std::stringstream(buf.substr(0, buf.size() - 1));
+    ASSERT_FALSE(cbdc::shard::read_uhs_snapshot_info(truncated).has_value());
+}
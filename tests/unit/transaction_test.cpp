@@ -3,8 +3,13 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include "crypto/sha256.h"
+#include "uhs/transaction/messages.hpp"
 #include "uhs/transaction/transaction.hpp"
+#include "util/serialization/format.hpp"
+#include "util/serialization/util.hpp"
 
+#include <cstring>
 #include <gtest/gtest.h>
 
 TEST(CTransaction, input_from_output_basic) {
@@ -39,3 +44,126 @@ TEST(CTransaction, input_from_output_out_of_bounds) {
     auto result = cbdc::transaction::input_from_output(tx, 1);
     ASSERT_FALSE(result);
 }
+
+TEST(CTransaction, hashes_match_serialized_buffers) {
+    cbdc::transaction::full_tx tx;
+    for(unsigned char i = 0; i < 2; i++) {
+        cbdc::transaction::input inp;
+        inp.m_prevout.m_tx_id = {'p', i};
+        inp.m_prevout.m_index = i;
+        inp.m_prevout_data.m_value = 50;
+        inp.m_prevout_data.m_witness_program_commitment = {'c', i};
+        tx.m_inputs.push_back(inp);
+    }
+    for(unsigned char i = 0; i < 3; i++) {
+        tx.m_outputs.emplace_back(cbdc::hash_t{'o', i}, 30 + i);
+    }
+
+    auto sha = CSHA256();
+    auto expected = cbdc::hash_t();
+
+    auto inp_buf = cbdc::make_buffer(tx.m_inputs);
+    auto out_buf = cbdc::make_buffer(tx.m_outputs);
+    sha.Write(inp_buf.c_ptr(), inp_buf.size());
+    sha.Write(out_buf.c_ptr(), out_buf.size());
+    sha.Finalize(expected.data());
+    const auto id = cbdc::transaction::tx_id(tx);
+    ASSERT_EQ(id, expected);
+
+    for(const auto& inp : tx.m_inputs) {
+        auto buf = cbdc::make_buffer(inp);
+        sha.Reset().Write(buf.c_ptr(), buf.size());
+        sha.Finalize(expected.data());
+        ASSERT_EQ(inp.hash(), expected);
+    }
+
+    for(uint64_t i = 0; i < tx.m_outputs.size(); i++) {
+        std::array<unsigned char, sizeof(i)> index_arr{};
+        std::memcpy(index_arr.data(), &i, sizeof(i));
+        auto buf = cbdc::make_buffer(tx.m_outputs[i]);
+        sha.Reset().Write(id.data(), id.size());
+        sha.Write(index_arr.data(), index_arr.size());
+        sha.Write(buf.c_ptr(), buf.size());
+        sha.Finalize(expected.data());
+        auto uhs_id
+            = cbdc::transaction::uhs_id_from_output(id, i, tx.m_outputs[i]);
+        ASSERT_EQ(uhs_id, expected);
+    }
+
+    auto ctx = cbdc::transaction::compact_tx(tx);
+    auto unattested = cbdc::make_buffer(ctx);
+    sha.Reset().Write(unattested.c_ptr(), unattested.size());
+    sha.Finalize(expected.data());
+    ctx.m_attestations.insert({cbdc::pubkey_t{'k'}, cbdc::signature_t{'s'}});
+    ASSERT_EQ(ctx.hash(), expected);
+}
+
+namespace {
+    auto make_tx(unsigned char seed, size_t n_inputs, size_t n_outputs)
+        -> cbdc::transaction::full_tx {
+        cbdc::transaction::full_tx tx;
+        for(unsigned char i = 0; i < n_inputs; i++) {
+            cbdc::transaction::input inp;
+            inp.m_prevout.m_tx_id = {seed, 'p', i};
+            inp.m_prevout.m_index = i;
+            inp.m_prevout_data.m_value = 50U + i;
+            inp.m_prevout_data.m_witness_program_commitment = {seed, 'c', i};
+            tx.m_inputs.push_back(inp);
+        }
+        for(unsigned char i = 0; i < n_outputs; i++) {
+            tx.m_outputs.emplace_back(cbdc::hash_t{seed, 'o', i}, 30U + i);
+        }
+        return tx;
+    }
+}
+
+TEST(CTransaction, batch_hashes_match) {
+    for(size_t n = 0; n < 20; n++) {
+        auto tx = make_tx(static_cast<unsigned char>(n), n, n + 1);
+        const auto id = cbdc::transaction::tx_id(tx);
+
+        auto inp_hashes = cbdc::transaction::input_hashes(tx.m_inputs);
+        ASSERT_EQ(inp_hashes.size(), tx.m_inputs.size());
+        for(size_t i = 0; i < tx.m_inputs.size(); i++) {
+            ASSERT_EQ(inp_hashes[i], tx.m_inputs[i].hash());
+        }
+
+        auto uhs_ids
+            = cbdc::transaction::uhs_ids_from_outputs(id, tx.m_outputs);
+        ASSERT_EQ(uhs_ids.size(), tx.m_outputs.size());
+        for(size_t i = 0; i < tx.m_outputs.size(); i++) {
+            ASSERT_EQ(uhs_ids[i],
+                      cbdc::transaction::uhs_id_from_output(id,
+                                                            i,
+                                                            tx.m_outputs[i]));
+        }
+    }
+}
+
+TEST(CTransaction, compact_txs_match) {
+    // Runs of transactions with the same shape, broken up by other shapes
+    auto txs = std::vector<cbdc::transaction::full_tx>();
+    for(unsigned char i = 0; i < 9; i++) {
+        txs.push_back(make_tx(i, 1, 2));
+    }
+    txs.push_back(make_tx('a', 5, 1));
+    for(unsigned char i = 0; i < 4; i++) {
+        txs.push_back(make_tx('b' + i, 2, 2));
+    }
+    txs.push_back(make_tx('z', 0, 3));
+
+    auto ids = cbdc::transaction::tx_ids(txs);
+    auto ctxs = cbdc::transaction::compact_txs(txs);
+    ASSERT_EQ(ids.size(), txs.size());
+    ASSERT_EQ(ctxs.size(), txs.size());
+    for(size_t i = 0; i < txs.size(); i++) {
+        auto expected = cbdc::transaction::compact_tx(txs[i]);
+        ASSERT_EQ(ids[i], expected.m_id);
+        ASSERT_EQ(ctxs[i].m_id, expected.m_id);
+        ASSERT_EQ(ctxs[i].m_inputs, expected.m_inputs);
+        ASSERT_EQ(ctxs[i].m_uhs_outputs, expected.m_uhs_outputs);
+    }
+
+    ASSERT_TRUE(cbdc::transaction::tx_ids({}).empty());
+    ASSERT_TRUE(cbdc::transaction::compact_txs({}).empty());
+}
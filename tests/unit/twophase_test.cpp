@@ -4,7 +4,9 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "uhs/twophase/coordinator/distributed_tx.hpp"
+#include "uhs/twophase/locking_shard/format.hpp"
 #include "uhs/twophase/locking_shard/locking_shard.hpp"
+#include "util/serialization/buffer_serializer.hpp"
 
 #include <gtest/gtest.h>
 #include <queue>
@@ -379,3 +381,76 @@ TEST_F(TwoPhaseTest, test_two_shards_conflicting) {
         ASSERT_FALSE((*res)[i]);
     }
 }
+
+TEST_F(TwoPhaseTest, test_snapshot_restore) {
+    auto logger = std::make_shared<cbdc::logging::log>(
+        cbdc::logging::log_level::debug);
+    auto shard = cbdc::locking_shard::locking_shard(std::make_pair(0, 255),
+                                                    logger,
+                                                    10000000,
+                                                    "",
+                                                    m_opts);
+
+    auto outputs = std::vector<cbdc::hash_t>();
+    auto txs = std::vector<cbdc::locking_shard::tx>();
+    for(size_t i{0}; i < 100; i++) {
+        auto tx = cbdc::locking_shard::tx();
+        std::memcpy(tx.m_tx.m_id.data(), &i, sizeof(i));
+        auto uhs_id = cbdc::hash_t();
+        uhs_id[sizeof(i)] = 1;
+        std::memcpy(uhs_id.data(), &i, sizeof(i));
+        tx.m_tx.m_uhs_outputs.push_back(uhs_id);
+        outputs.push_back(uhs_id);
+        txs.push_back(tx);
+    }
+    auto mint_id = cbdc::hash_t{1};
+    auto lock_res = shard.lock_outputs(std::move(txs), mint_id);
+    ASSERT_TRUE(lock_res.has_value());
+    ASSERT_TRUE(shard.apply_outputs(std::move(*lock_res), mint_id));
+
+    // Leave a dtx spending half the outputs prepared but not applied
+    auto spend_txs = std::vector<cbdc::locking_shard::tx>();
+    for(size_t i{0}; i < outputs.size() / 2; i++) {
+        auto tx = cbdc::locking_shard::tx();
+        tx.m_tx.m_id = outputs[i];
+        tx.m_tx.m_inputs.push_back(outputs[i]);
+        spend_txs.push_back(tx);
+    }
+    auto spend_id = cbdc::hash_t{2};
+    auto spend_res = shard.lock_outputs(std::move(spend_txs), spend_id);
+    ASSERT_TRUE(spend_res.has_value());
+
+    auto buf = cbdc::buffer();
+    auto ser = cbdc::buffer_serializer(buf);
+    ASSERT_TRUE(ser << shard.snapshot());
+
+    auto snp = cbdc::locking_shard::locking_shard::state_snapshot();
+    auto deser = cbdc::buffer_serializer(buf);
+    ASSERT_TRUE(deser >> snp);
+    ASSERT_EQ(snp.m_uhs.size(), outputs.size() / 2);
+    ASSERT_EQ(snp.m_locked.size(), outputs.size() / 2);
+    ASSERT_EQ(snp.m_prepared_dtxs.size(), 1UL);
+    ASSERT_EQ(snp.m_applied_dtxs.size(), 1UL);
+    ASSERT_EQ(snp.m_completed_txs.size(), outputs.size());
+
+    auto restored = cbdc::locking_shard::locking_shard(std::make_pair(0, 255),
+                                                       logger,
+                                                       10000000,
+                                                       "",
+                                                       m_opts);
+    restored.restore(std::move(snp));
+    for(size_t i{0}; i < outputs.size(); i++) {
+        ASSERT_TRUE(*restored.check_unspent(outputs[i]));
+        auto tx_id = cbdc::hash_t();
+        std::memcpy(tx_id.data(), &i, sizeof(i));
+        ASSERT_TRUE(*restored.check_tx_id(tx_id));
+    }
+
+    // The prepared dtx can be completed on the restored shard
+    auto complete = std::vector<bool>(outputs.size() / 2, true);
+    ASSERT_TRUE(restored.apply_outputs(std::move(complete), spend_id));
+    for(size_t i{0}; i < outputs.size(); i++) {
+        ASSERT_EQ(*restored.check_unspent(outputs[i]),
+                  i >= outputs.size() / 2);
+    }
+}
@@ -0,0 +1,253 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "uhs/transaction/utxo_store.hpp"
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace {
+    auto make_utxo(uint32_t n, uint64_t value) -> cbdc::transaction::input {
+        auto ret = cbdc::transaction::input();
+        ret.m_prevout.m_tx_id = {static_cast<unsigned char>(n & 0xff),
+                                 static_cast<unsigned char>(n >> 8)};
+        ret.m_prevout.m_index = n;
+        ret.m_prevout_data.m_value = value;
+        ret.m_prevout_data.m_witness_program_commitment = {'w'};
+        return ret;
+    }
+}
+
+class UtxoStoreTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        for(uint32_t i = 0; i < m_values.size(); i++) {
+            ASSERT_TRUE(m_store.add(make_utxo(i, m_values[i])));
+        }
+    }
+
+    static constexpr std::array<uint64_t, 5> m_values{40, 10, 30, 50, 20};
+    cbdc::transaction::utxo_store m_store;
+};
+
+TEST_F(UtxoStoreTest, add_spend) {
+    ASSERT_EQ(m_store.size(), 5UL);
+    ASSERT_EQ(m_store.balance(), 150UL);
+    ASSERT_FALSE(m_store.add(make_utxo(0, 40)));
+
+    ASSERT_TRUE(m_store.spend(make_utxo(2, 30).m_prevout));
+    ASSERT_FALSE(m_store.spend(make_utxo(2, 30).m_prevout));
+    ASSERT_FALSE(m_store.spend(make_utxo(9, 30).m_prevout));
+    ASSERT_EQ(m_store.size(), 4UL);
+    ASSERT_EQ(m_store.balance(), 120UL);
+
+    // A spent UTXO can be added again
+    ASSERT_TRUE(m_store.add(make_utxo(2, 30)));
+    ASSERT_EQ(m_store.balance(), 150UL);
+}
+
+TEST_F(UtxoStoreTest, reserve_oldest) {
+    auto res = m_store.reserve_oldest(2);
+    ASSERT_TRUE(res.has_value());
+    ASSERT_EQ(res.value(),
+              (std::vector{make_utxo(0, 40), make_utxo(1, 10)}));
+    ASSERT_EQ(m_store.balance(), 100UL);
+
+    res = m_store.reserve_oldest(1);
+    ASSERT_TRUE(res.has_value());
+    ASSERT_EQ(res.value(), std::vector{make_utxo(2, 30)});
+
+    // Not enough UTXOs reserves nothing
+    ASSERT_FALSE(m_store.reserve_oldest(3).has_value());
+    ASSERT_EQ(m_store.size(), 2UL);
+
+    m_store.release({make_utxo(0, 40)});
+    res = m_store.reserve_oldest(1);
+    ASSERT_TRUE(res.has_value());
+    ASSERT_EQ(res.value(), std::vector{make_utxo(0, 40)});
+}
+
+TEST_F(UtxoStoreTest, reserve_amount_best_fit) {
+    auto res = m_store.reserve_amount(25);
+    ASSERT_TRUE(res.has_value());
+    ASSERT_EQ(res.value(), std::vector{make_utxo(2, 30)});
+
+    res = m_store.reserve_amount(30);
+    ASSERT_TRUE(res.has_value());
+    ASSERT_EQ(res.value(), std::vector{make_utxo(0, 40)});
+}
+
+TEST_F(UtxoStoreTest, reserve_amount_largest_first) {
+    auto res = m_store.reserve_amount(85);
+    ASSERT_TRUE(res.has_value());
+    ASSERT_EQ(res.value(),
+              (std::vector{make_utxo(3, 50),
+                           make_utxo(0, 40)}));
+    ASSERT_EQ(m_store.balance(), 60UL);
+
+    // Not enough value reserves nothing
+    ASSERT_FALSE(m_store.reserve_amount(61).has_value());
+    ASSERT_EQ(m_store.balance(), 60UL);
+    ASSERT_EQ(m_store.size(), 3UL);
+}
+
+TEST_F(UtxoStoreTest, utxos_oldest_first) {
+    ASSERT_TRUE(m_store.spend(make_utxo(1, 10).m_prevout));
+    ASSERT_TRUE(m_store.add(make_utxo(7, 70)));
+    ASSERT_EQ(m_store.utxos(),
+              (std::vector{make_utxo(0, 40),
+                           make_utxo(2, 30),
+                           make_utxo(3, 50),
+                           make_utxo(4, 20),
+                           make_utxo(7, 70)}));
+
+    m_store.clear();
+    ASSERT_EQ(m_store.size(), 0UL);
+    ASSERT_EQ(m_store.balance(), 0UL);
+    ASSERT_TRUE(m_store.utxos().empty());
+}
+
+TEST(UtxoStoreCompactTest, compaction) {
+    static constexpr uint32_t n_utxos = 5000;
+    auto store = cbdc::transaction::utxo_store();
+    for(uint32_t i = 0; i < n_utxos; i++) {
+        ASSERT_TRUE(store.add(make_utxo(i, i + 1)));
+    }
+
+    // Spend enough to compact the slab, then check the indexes still agree
+    for(uint32_t i = 0; i < n_utxos - 10; i++) {
+        ASSERT_TRUE(store.spend(make_utxo(i, i + 1).m_prevout));
+    }
+    ASSERT_EQ(store.size(), 10UL);
+    ASSERT_FALSE(store.spend(make_utxo(0, 1).m_prevout));
+    ASSERT_TRUE(store.spend(make_utxo(n_utxos - 1, n_utxos).m_prevout));
+
+    auto res = store.reserve_amount(n_utxos - 1);
+    ASSERT_TRUE(res.has_value());
+    ASSERT_EQ(res.value(), std::vector{make_utxo(n_utxos - 2, n_utxos - 1)});
+
+    res = store.reserve_oldest(1);
+    ASSERT_TRUE(res.has_value());
+    ASSERT_EQ(res.value(),
+              std::vector{make_utxo(n_utxos - 10, n_utxos - 9)});
+    ASSERT_EQ(store.size(), 7UL);
+}
+
+TEST(UtxoStoreCompactTest, release_after_compaction) {
+    static constexpr uint32_t n_utxos = 5000;
+    auto store = cbdc::transaction::utxo_store();
+    for(uint32_t i = 0; i < n_utxos; i++) {
+        ASSERT_TRUE(store.add(make_utxo(i, 1)));
+    }
+
+    // Compaction drops the reserved slots along with the spent ones
+    auto res = store.reserve_oldest(10);
+    ASSERT_TRUE(res.has_value());
+    for(uint32_t i = 10; i < n_utxos - 10; i++) {
+        ASSERT_TRUE(store.spend(make_utxo(i, 1).m_prevout));
+    }
+    ASSERT_EQ(store.size(), 10UL);
+
+    store.release(res.value());
+    ASSERT_EQ(store.size(), 20UL);
+    ASSERT_EQ(store.balance(), 20UL);
+    for(uint32_t i = 0; i < 10; i++) {
+        ASSERT_TRUE(store.spend(make_utxo(i, 1).m_prevout));
+    }
+}
+
+TEST(UtxoStoreConcurrentTest, reserve_each_once) {
+    static constexpr uint32_t n_utxos = 20000;
+    static constexpr size_t n_threads = 8;
+    auto store = cbdc::transaction::utxo_store();
+    for(uint32_t i = 0; i < n_utxos; i++) {
+        ASSERT_TRUE(store.add(make_utxo(i, 1)));
+    }
+
+    auto reserved = std::vector<std::vector<cbdc::transaction::input>>(
+        n_threads);
+    auto threads = std::vector<std::thread>();
+    for(size_t t = 0; t < n_threads; t++) {
+        threads.emplace_back([&, t]() {
+            while(true) {
+                auto res = t % 2 == 0 ? store.reserve_oldest(3)
+                                      : store.reserve_amount(3);
+                if(!res.has_value()) {
+                    break;
+                }
+                reserved[t].insert(reserved[t].end(),
+                                   res->begin(),
+                                   res->end());
+            }
+        });
+    }
+    for(auto& thread : threads) {
+        thread.join();
+    }
+
+    auto seen = std::vector<bool>(n_utxos);
+    size_t total{0};
+    for(const auto& res : reserved) {
+        for(const auto& utxo : res) {
+            ASSERT_FALSE(seen[utxo.m_prevout.m_index]);
+            seen[utxo.m_prevout.m_index] = true;
+            total++;
+        }
+    }
+    ASSERT_EQ(total + store.size(), n_utxos);
+    ASSERT_EQ(store.balance(), store.size());
+}
+
+TEST(UtxoStoreConcurrentTest, release_during_compaction) {
+    static constexpr uint32_t n_utxos = 20000;
+    static constexpr uint32_t n_kept = 5000;
+    auto store = cbdc::transaction::utxo_store();
+    for(uint32_t i = 0; i < n_utxos; i++) {
+        ASSERT_TRUE(store.add(make_utxo(i, 1)));
+    }
+
+    // Spending most of the UTXOs compacts the slab while the other threads
+    // hold reservations they later give back
+    auto spent_all = std::atomic<bool>();
+    auto missed = std::vector<uint32_t>();
+    auto spender = std::thread([&]() {
+        for(uint32_t i = n_kept; i < n_utxos; i++) {
+            if(!store.spend(make_utxo(i, 1).m_prevout)) {
+                missed.push_back(i);
+            }
+        }
+        spent_all = true;
+    });
+    auto failed_reserver = std::thread([&]() {
+        while(!spent_all) {
+            ASSERT_FALSE(store.reserve_oldest(n_utxos + 1).has_value());
+        }
+    });
+    auto releaser = std::thread([&]() {
+        while(!spent_all) {
+            auto res = store.reserve_amount(3);
+            if(res.has_value()) {
+                store.release(res.value());
+            }
+        }
+    });
+    spender.join();
+    failed_reserver.join();
+    releaser.join();
+
+    // UTXOs that were reserved when the spender reached them must be back
+    for(auto i : missed) {
+        ASSERT_TRUE(store.spend(make_utxo(i, 1).m_prevout));
+    }
+    ASSERT_EQ(store.size(), n_kept);
+    ASSERT_EQ(store.balance(), n_kept);
+    auto seen = std::vector<bool>(n_kept);
+    for(const auto& utxo : store.utxos()) {
+        ASSERT_LT(utxo.m_prevout.m_index, n_kept);
+        ASSERT_FALSE(seen[utxo.m_prevout.m_index]);
+        seen[utxo.m_prevout.m_index] = true;
+    }
+}
@@ -201,3 +201,158 @@ TEST_F(WalletTest, load_save) {
     ASSERT_EQ(m_wallet.balance(), new_wal.balance());
     ASSERT_EQ(m_wallet.count(), new_wal.count());
 }
+
+class WalletJournalTest : public ::testing::Test {
+  protected:
+    void TearDown() override {
+        std::filesystem::remove(m_wallet_file);
+        std::filesystem::remove(m_journal_file);
+    }
+
+    static constexpr auto m_wallet_file = "test_journal_wallet.dat";
+    static constexpr auto m_journal_file = "test_journal_wallet.dat.journal";
+};
+
+TEST_F(WalletJournalTest, replay) {
+    auto pubkey = cbdc::pubkey_t();
+    {
+        auto wallet = cbdc::transaction::wallet();
+        ASSERT_TRUE(wallet.open(m_wallet_file));
+        auto mint_tx = wallet.mint_new_coins(10, 10);
+        wallet.confirm_transaction(mint_tx);
+        pubkey = wallet.generate_key();
+        auto tx = wallet.send_to(15, pubkey, true);
+        ASSERT_TRUE(tx.has_value());
+        ASSERT_EQ(wallet.balance(), 80UL);
+        wallet.confirm_transaction(tx.value());
+        ASSERT_EQ(wallet.balance(), 100UL);
+        ASSERT_EQ(wallet.count(), 10UL);
+    }
+    ASSERT_FALSE(std::filesystem::exists(m_wallet_file));
+
+    auto wallet = cbdc::transaction::wallet();
+    ASSERT_TRUE(wallet.open(m_wallet_file));
+    ASSERT_EQ(wallet.balance(), 100UL);
+    ASSERT_EQ(wallet.count(), 10UL);
+
+    // The replayed keys can still sign for the replayed UTXOs
+    auto tx = wallet.send_to(10, 1, pubkey, true);
+    ASSERT_TRUE(tx.has_value());
+    ASSERT_FALSE(cbdc::transaction::validation::check_tx(tx.value())
+                     .has_value());
+
+    ASSERT_TRUE(wallet.compact());
+    ASSERT_EQ(std::filesystem::file_size(m_journal_file), 0UL);
+    auto reloaded = cbdc::transaction::wallet();
+    ASSERT_TRUE(reloaded.open(m_wallet_file));
+    ASSERT_EQ(reloaded.balance(), 0UL);
+    ASSERT_EQ(reloaded.count(), 0UL);
+}
+
+TEST_F(WalletJournalTest, torn_tail) {
+    {
+        auto wallet = cbdc::transaction::wallet();
+        ASSERT_TRUE(wallet.open(m_wallet_file));
+        auto mint_tx = wallet.mint_new_coins(3, 10);
+        wallet.confirm_transaction(mint_tx);
+    }
+
+    // Cut the last record short, as if the process stopped part way
+    // through writing it
+    const auto size = std::filesystem::file_size(m_journal_file);
+    std::filesystem::resize_file(m_journal_file, size - 1);
+
+    {
+        auto wallet = cbdc::transaction::wallet();
+        ASSERT_TRUE(wallet.open(m_wallet_file));
+        ASSERT_EQ(wallet.count(), 2UL);
+        auto mint_tx = wallet.mint_new_coins(1, 5);
+        wallet.confirm_transaction(mint_tx);
+    }
+
+    auto wallet = cbdc::transaction::wallet();
+    ASSERT_TRUE(wallet.open(m_wallet_file));
+    ASSERT_EQ(wallet.count(), 3UL);
+    ASSERT_EQ(wallet.balance(), 25UL);
+}
+
+TEST_F(WalletJournalTest, compacts_large_journal) {
+    auto wallet = cbdc::transaction::wallet();
+    ASSERT_TRUE(wallet.open(m_wallet_file));
+    auto mint_tx = wallet.mint_new_coins(1, 100);
+    wallet.confirm_transaction(mint_tx);
+    auto payee = wallet.generate_key();
+    for(size_t i = 0; i < 5000; i++) {
+        auto tx = wallet.send_to(1, 1, payee, false);
+        ASSERT_TRUE(tx.has_value());
+        wallet.confirm_transaction(tx.value());
+    }
+    ASSERT_TRUE(std::filesystem::exists(m_wallet_file));
+
+    auto reloaded = cbdc::transaction::wallet();
+    ASSERT_TRUE(reloaded.open(m_wallet_file));
+    ASSERT_EQ(reloaded.balance(), 100UL);
+    ASSERT_EQ(reloaded.count(), 1UL);
+}
+
+TEST(WalletSignTest, sign_many_inputs) {
+    // Enough inputs to be signed on multiple threads, locked to both a
+    // seeded key and a generated key
+    static constexpr auto n_seeded = 300;
+    auto wallet = cbdc::transaction::wallet();
+    ASSERT_TRUE(wallet.seed({1}, 2, 0, n_seeded));
+    auto mint_tx = wallet.mint_new_coins(10, 2);
+    wallet.confirm_transaction(mint_tx);
+
+    auto tx = wallet.send_to(n_seeded + 10, 1, wallet.generate_key(), true);
+    ASSERT_TRUE(tx.has_value());
+    ASSERT_EQ(tx->m_witness.size(), tx->m_inputs.size());
+    ASSERT_FALSE(cbdc::transaction::validation::check_tx(tx.value())
+                     .has_value());
+
+    // Re-signing after a change must produce a matching signature
+    tx->m_outputs[0].m_value--;
+    tx->m_outputs.push_back(tx->m_outputs[0]);
+    tx->m_outputs.back().m_value = 1;
+    ASSERT_TRUE(cbdc::transaction::validation::check_tx(tx.value())
+                    .has_value());
+    wallet.sign(tx.value());
+    ASSERT_FALSE(cbdc::transaction::validation::check_tx(tx.value())
+                     .has_value());
+}
+
+TEST(WalletSignTest, sign_batch) {
+    static constexpr auto n_txs = 100;
+    auto wallet = cbdc::transaction::wallet();
+    ASSERT_TRUE(wallet.seed({1}, 2, 0, n_txs));
+    auto payee = wallet.generate_key();
+    auto txs = std::vector<cbdc::transaction::full_tx>();
+    for(int i = 0; i < n_txs; i++) {
+        auto tx = wallet.send_to(1, 1, payee, false);
+        ASSERT_TRUE(tx.has_value());
+        ASSERT_TRUE(cbdc::transaction::validation::check_tx(tx.value())
+                        .has_value());
+        txs.push_back(tx.value());
+    }
+
+    wallet.sign(txs);
+    for(const auto& tx : txs) {
+        ASSERT_FALSE(cbdc::transaction::validation::check_tx(tx).has_value());
+    }
+}
+
+TEST(WalletSignTest, foreign_inputs_unsigned) {
+    auto wallet = cbdc::transaction::wallet();
+    auto other = cbdc::transaction::wallet();
+    auto mint_tx = other.mint_new_coins(1, 10);
+    other.confirm_transaction(mint_tx);
+    auto tx = other.send_to(5, wallet.generate_key(), false);
+    ASSERT_TRUE(tx.has_value());
+
+    auto unsigned_witness = tx->m_witness;
+    wallet.sign(tx.value());
+    ASSERT_EQ(tx->m_witness, unsigned_witness);
+    other.sign(tx.value());
+    ASSERT_FALSE(cbdc::transaction::validation::check_tx(tx.value())
+                     .has_value());
+}
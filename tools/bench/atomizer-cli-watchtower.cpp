@@ -9,6 +9,7 @@
 #include "uhs/atomizer/watchtower/client.hpp"
 #include "uhs/atomizer/watchtower/watchtower.hpp"
 #include "uhs/sentinel/client.hpp"
+#include "uhs/transaction/corpus.hpp"
 #include "uhs/transaction/messages.hpp"
 #include "uhs/transaction/wallet.hpp"
 #include "util/common/config.hpp"
@@ -40,7 +41,7 @@ auto main(int argc, char** argv) -> int {
     if(args.size() < 4) {
         std::cerr << "Usage: " << args[0]
                   << " <config file> <atomizer-cli id> <sign txs> "
-                     "[<trace(default: 1)>]"
+                     "[<trace(default: 1)> [<corpus file>]]"
                   << std::endl;
         return 0;
     }
@@ -124,8 +125,21 @@ auto main(int argc, char** argv) -> int {
 
     cbdc::transaction::wallet wal;
 
+    // In replay mode, send pre-generated transactions from a corpus file
+    // rather than generating them from the wallet
+    auto corpus = cbdc::transaction::corpus();
+    const auto replay = args.size() > 5;
+    size_t corpus_idx{0};
+    if(replay) {
+        if(!corpus.init(args[5])) {
+            log->error("Failed to load corpus file", args[5]);
+            return -1;
+        }
+        log->info("Replaying", corpus.size(), "transactions from", args[5]);
+    }
+
     // Optionally Pre-seed wallet with deterministic UTXOs
-    if(cfg.m_seed_from != cfg.m_seed_to) {
+    if(!replay && cfg.m_seed_from != cfg.m_seed_to) {
         auto [range_start, range_end]
             = cbdc::config::loadgen_seed_range(cfg, cli_id);
 
@@ -299,8 +313,8 @@ auto main(int argc, char** argv) -> int {
             block_cv.notify_all();
         });
 
-    // Only mint when not using pre-seeded wallets
-    if(cfg.m_seed_from == cfg.m_seed_to) {
+    // Only mint when not using pre-seeded wallets or replaying a corpus
+    if(!replay && cfg.m_seed_from == cfg.m_seed_to) {
         const auto& mint_tx = wal.mint_new_coins(cfg.m_initial_mint_count,
                                                  cfg.m_initial_mint_value);
 
@@ -382,11 +396,19 @@ auto main(int argc, char** argv) -> int {
             return pending_txs.size();
         };
 
+        auto wallet_empty = [&]() {
+            if(replay) {
+                return false;
+            }
+            if(cfg.m_fixed_tx_mode) {
+                return wal.count() < cfg.m_input_count
+                    || wal.balance() / cfg.m_output_count == 0;
+            }
+            return wal.balance() < send_amount;
+        };
+
         while(running
-              && ((wal.balance() < send_amount && !cfg.m_fixed_tx_mode)
-                  || (cfg.m_fixed_tx_mode
-                      && (wal.count() < cfg.m_input_count
-                          || wal.balance() / cfg.m_output_count == 0))
+              && (wallet_empty()
                   || (count_in_flight() >= cfg.m_window_size
                       && cfg.m_window_size > 0))) {
             // Wait for previous txs to confirm
@@ -443,6 +465,18 @@ auto main(int argc, char** argv) -> int {
             }
             pay_tx = std::move(confirmed_txs.front());
             confirmed_txs.pop();
+        } else if(replay) {
+            if(corpus_idx == corpus.size()) {
+                log->info("Corpus exhausted");
+                break;
+            }
+            auto tx = corpus.get(corpus_idx++);
+            if(!tx.has_value()) {
+                log->warn("Skipping malformed corpus transaction",
+                          corpus_idx - 1);
+                continue;
+            }
+            pay_tx = std::move(tx.value());
         } else {
             auto gen_s = std::chrono::high_resolution_clock::now();
             if(send_fixed) {
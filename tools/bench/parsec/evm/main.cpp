@@ -22,7 +22,10 @@ auto main(int argc, char** argv) -> int {
         endpoints.push_back(url);
     }
 
-    auto c = std::make_shared<geth_client>(endpoints, 0, log);
+    auto c = std::make_shared<geth_client>(endpoints,
+                                           0,
+                                           log,
+                                           cfg->m_rpc_batch_size);
 
     // Determine mint depth from loadgen_accounts
     size_t mint_tree_depth = 1;
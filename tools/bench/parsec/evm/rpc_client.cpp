@@ -7,10 +7,12 @@
 
 geth_client::geth_client(std::vector<std::string> endpoints,
                          long timeout,
-                         std::shared_ptr<cbdc::logging::log> log)
+                         std::shared_ptr<cbdc::logging::log> log,
+                         size_t max_batch_size)
     : cbdc::rpc::json_rpc_http_client(std::move(endpoints),
                                       timeout,
-                                      std::move(log)) {}
+                                      std::move(log),
+                                      max_batch_size) {}
 
 void geth_client::send_transaction(
     const std::string& tx,
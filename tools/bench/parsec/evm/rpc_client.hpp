@@ -11,9 +11,16 @@
 
 class geth_client : public cbdc::rpc::json_rpc_http_client {
   public:
+    /// Constructor.
+    /// \param endpoints agent or geth JSON-RPC endpoints.
+    /// \param timeout response timeout in milliseconds. 0 for no timeout.
+    /// \param log log instance.
+    /// \param max_batch_size maximum number of calls in one JSON-RPC batch
+    ///                       request.
     geth_client(std::vector<std::string> endpoints,
                 long timeout,
-                std::shared_ptr<cbdc::logging::log> log);
+                std::shared_ptr<cbdc::logging::log> log,
+                size_t max_batch_size = 1);
 
     static constexpr auto error_key = "error";
     static constexpr auto result_key = "result";
@@ -6,6 +6,7 @@
 #include "crypto/sha256.h"
 #include "parsec/agent/client.hpp"
 #include "parsec/broker/impl.hpp"
+#include "parsec/directory/consistent_hash.hpp"
 #include "parsec/directory/impl.hpp"
 #include "parsec/runtime_locking_shard/client.hpp"
 #include "parsec/ticket_machine/client.hpp"
@@ -67,8 +68,16 @@ auto main(int argc, char** argv) -> int {
     }
     log->trace("Connected to ticket machine");
 
-    auto directory
-        = std::make_shared<cbdc::parsec::directory::impl>(shards.size());
+    auto directory = std::shared_ptr<cbdc::parsec::directory::interface>();
+    if(cfg->m_directory_vnodes > 0) {
+        directory
+            = std::make_shared<cbdc::parsec::directory::consistent_hash>(
+                shards.size(),
+                cfg->m_directory_vnodes);
+    } else {
+        directory
+            = std::make_shared<cbdc::parsec::directory::impl>(shards.size());
+    }
     auto broker = std::make_shared<cbdc::parsec::broker::impl>(
         std::numeric_limits<size_t>::max(),
         shards,
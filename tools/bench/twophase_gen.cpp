@@ -5,23 +5,28 @@
 
 #include "uhs/sentinel/client.hpp"
 #include "uhs/sentinel/format.hpp"
+#include "uhs/transaction/corpus.hpp"
 #include "uhs/transaction/messages.hpp"
 #include "uhs/transaction/wallet.hpp"
 #include "uhs/twophase/coordinator/client.hpp"
 #include "uhs/twophase/locking_shard/status_client.hpp"
 #include "util/common/config.hpp"
+#include "util/common/histogram.hpp"
 #include "util/common/logging.hpp"
+#include "util/common/rate_controller.hpp"
 #include "util/network/connection_manager.hpp"
 #include "util/serialization/format.hpp"
 
+#include <condition_variable>
 #include <csignal>
+#include <future>
 #include <iostream>
 
 auto main(int argc, char** argv) -> int {
     auto args = cbdc::config::get_args(argc, argv);
     if(args.size() < 3) {
-        std::cerr << "Usage: " << args[0] << " <config file> <gen ID>"
-                  << std::endl;
+        std::cerr << "Usage: " << args[0]
+                  << " <config file> <gen ID> [<corpus file>]" << std::endl;
         return -1;
     }
 
@@ -52,8 +57,29 @@ auto main(int argc, char** argv) -> int {
 
     auto wallet = cbdc::transaction::wallet();
 
+    // In replay mode, send pre-generated transactions from a corpus file
+    // rather than generating and signing them from the wallet
+    auto corpus = cbdc::transaction::corpus();
+    const auto replay = args.size() > 3;
+    if(replay) {
+        if(!corpus.init(args[3])) {
+            logger->error("Failed to load corpus file", args[3]);
+            return -1;
+        }
+        const auto& seed = corpus.seed();
+        if(seed.m_seed_from < cfg.m_seed_from
+           || seed.m_seed_to > cfg.m_seed_to) {
+            logger->warn("Corpus spends seeds",
+                         seed.m_seed_from,
+                         "-",
+                         seed.m_seed_to,
+                         "outside the configured pre-seed range");
+        }
+        logger->info("Replaying", corpus.size(), "transactions from", args[3]);
+    }
+
     // Optionally Pre-seed wallet with deterministic UTXOs
-    if(cfg.m_seed_from != cfg.m_seed_to) {
+    if(!replay && cfg.m_seed_from != cfg.m_seed_to) {
         auto [range_start, range_end]
             = cbdc::config::loadgen_seed_range(cfg, gen_id);
 
@@ -71,8 +97,8 @@ auto main(int argc, char** argv) -> int {
                      range_end);
     }
 
-    // Only mint when not pre-seeding
-    if(cfg.m_seed_from == cfg.m_seed_to) {
+    // Only mint when not pre-seeding or replaying a corpus
+    if(!replay && cfg.m_seed_from == cfg.m_seed_to) {
         auto coordinator_client
             = cbdc::coordinator::rpc::client(cfg.m_coordinator_endpoints[0]);
         if(!coordinator_client.init()) {
@@ -187,175 +213,197 @@ auto main(int argc, char** argv) -> int {
 
     constexpr auto send_amt = 5;
 
-    uint64_t send_gap{};
-    uint64_t gen_avg{};
-    auto ramp_secs = std::chrono::duration<double, std::ratio<1, 1>>(
-        cfg.m_loadgen_tps_step_time);
-    auto ramp_timer_full
-        = std::chrono::duration_cast<std::chrono::nanoseconds>(ramp_secs);
+    // Generate a transaction to send, or return std::nullopt if the wallet
+    // has no spendable outputs or the corpus is exhausted
+    size_t corpus_idx{0};
+    auto make_tx = [&]() -> std::optional<cbdc::transaction::full_tx> {
+        // Determine if we should attempt to send a double-spending
+        // transaction
+        bool send_invalid{false};
+        if(cfg.m_invalid_rate > 0.0) {
+            send_invalid = invalid_dist(engine);
+        }
 
-    auto ramp_timer = ramp_timer_full;
-    auto ramping = ramp_timer.count() != 0
-                && per_gen_send_limit != cfg.m_loadgen_tps_target;
-    auto gen_thread = std::thread([&]() {
-        while(running) {
-            // Determine if we should attempt to send a double-spending
-            // transaction
-            bool send_invalid{false};
-            if(cfg.m_invalid_rate > 0.0) {
-                send_invalid = invalid_dist(engine);
-            }
+        // Determine if we should attempt to send a fixed-size transaction
+        bool send_fixed{false};
+        if(cfg.m_fixed_tx_mode && cfg.m_fixed_tx_rate > 0.0) {
+            send_fixed = fixed_dist(engine);
+        }
 
-            // Determine if we should attempt to send a fixed-size transaction
-            bool send_fixed{false};
-            if(cfg.m_fixed_tx_mode && cfg.m_fixed_tx_rate > 0.0) {
-                send_fixed = fixed_dist(engine);
+        // Try to send a double-spending transaction
+        if(send_invalid) {
+            std::lock_guard<std::mutex> l(confirmed_txs_mut);
+            // Attempt to pop a previously confirmed transaction to re-send
+            // (will now be a double-spend)
+            if(!confirmed_txs.empty()) {
+                auto tx = std::move(confirmed_txs.front());
+                confirmed_txs.pop();
+                return tx;
             }
+        }
 
-            auto tx = std::optional<cbdc::transaction::full_tx>();
-            // Try to send a double-spending transaction
-            if(send_invalid) {
-                std::lock_guard<std::mutex> l(confirmed_txs_mut);
-                // Attempt to pop a previously confirmed transaction to re-send
-                // (will now be a double-spend)
-                if(!confirmed_txs.empty()) {
-                    tx = std::move(confirmed_txs.front());
-                    confirmed_txs.pop();
+        // There wasn't a double-spend available for us to send. Try to
+        // send a new (valid) transaction instead.
+        if(replay) {
+            while(corpus_idx < corpus.size()) {
+                auto tx = corpus.get(corpus_idx++);
+                if(tx.has_value()) {
+                    return tx;
                 }
+                logger->warn("Skipping malformed corpus transaction",
+                             corpus_idx - 1);
             }
+            return std::nullopt;
+        }
 
-            // tx is empty so there wasn't a double-spend available for us to
-            // send. Try to send a new (valid) transaction instead.
-            if(!tx) {
-                // If we're sending fixed-size transactions, attempt to
-                // generate a fixed-size transaction.
-                auto gen_s = std::chrono::high_resolution_clock::now();
-                if(send_fixed) {
-                    tx = wallet.send_to(cfg.m_input_count,
-                                        cfg.m_output_count,
-                                        wallet.generate_key(),
-                                        true);
-                } else {
-                    // If using fixed TX mode, the fallback in/out count
-                    // should be 2/2
-                    if(cfg.m_fixed_tx_mode && cfg.m_fixed_tx_rate > 0.0) {
-                        tx = wallet.send_to(2, 2, wallet.generate_key(), true);
-                    } else {
-                        // Otherwise send a regular transaction and let the
-                        // wallet determine the input/output count.
-                        tx = wallet.send_to(send_amt,
-                                            wallet.generate_key(),
-                                            true);
-                    }
-                }
-                auto gen_e = std::chrono::high_resolution_clock::now();
-                auto gen_t = gen_e - gen_s;
-                static constexpr auto average_factor = 0.1;
-                gen_avg = static_cast<uint64_t>(
-                    (static_cast<double>(gen_t.count()) * average_factor)
-                    + (static_cast<double>(gen_avg) * (1.0 - average_factor)));
-                if(ramping) {
-                    if(gen_t >= ramp_timer) {
-                        logger->debug(
-                            "Ramp Timer Exhausted (gen_t). Resetting");
-                        ramp_timer = ramp_timer_full;
-                        per_gen_send_limit
-                            = std::min(cfg.m_loadgen_tps_target,
-                                       per_gen_send_limit + per_gen_step_size);
-                        logger->debug("New Send Limit:", per_gen_send_limit);
-                        if(per_gen_send_limit == cfg.m_loadgen_tps_target) {
-                            ramping = false;
-                            logger->info("Reached Target Throughput");
-                        }
-                    } else {
-                        ramp_timer -= gen_t;
-                    }
-                }
-                auto total_send_time
-                    = std::chrono::nanoseconds(gen_avg * per_gen_send_limit);
-                if(total_send_time < std::chrono::seconds(1)) {
-                    send_gap
-                        = (std::chrono::seconds(1) - total_send_time).count()
-                        / per_gen_send_limit;
-                    logger->trace("New send-gap:", send_gap);
-                }
-            } else {
-                std::this_thread::sleep_for(std::chrono::nanoseconds(gen_avg));
-                if(ramping) {
-                    auto avg = std::chrono::nanoseconds(gen_avg);
-                    if(avg >= ramp_timer) {
-                        logger->debug("Ramp Timer Exhausted (dbl-spend "
-                                      "gen_avg). Resetting");
-                        ramp_timer = ramp_timer_full;
-                        per_gen_send_limit
-                            = std::min(cfg.m_loadgen_tps_target,
-                                       per_gen_send_limit + per_gen_step_size);
-                        logger->debug("New Send Limit:", per_gen_send_limit);
-                        if(per_gen_send_limit == cfg.m_loadgen_tps_target) {
-                            ramping = false;
-                            logger->info("Reached Target Throughput");
-                        }
-                    } else {
-                        ramp_timer -= avg;
-                    }
+        // If we're sending
+        // fixed-size transactions, attempt to generate a fixed-size
+        // transaction.
+        if(send_fixed) {
+            return wallet.send_to(cfg.m_input_count,
+                                  cfg.m_output_count,
+                                  wallet.generate_key(),
+                                  true);
+        }
+        // If using fixed TX mode, the fallback in/out count should be 2/2
+        if(cfg.m_fixed_tx_mode && cfg.m_fixed_tx_rate > 0.0) {
+            return wallet.send_to(2, 2, wallet.generate_key(), true);
+        }
+        // Otherwise send a regular transaction and let the wallet
+        // determine the input/output count.
+        return wallet.send_to(send_amt, wallet.generate_key(), true);
+    };
+
+    // Signalled whenever a response returns outputs to the wallet
+    auto outputs_mut = std::mutex();
+    auto outputs_cv = std::condition_variable();
+    uint64_t responses{0};
+    auto notify_outputs = [&]() {
+        {
+            std::lock_guard<std::mutex> l(outputs_mut);
+            responses++;
+        }
+        outputs_cv.notify_one();
+    };
+
+    // Latency from the scheduled send time, which includes any time the
+    // transaction spent waiting behind earlier ones, and latency from the
+    // actual send time
+    auto latency_mut = std::mutex();
+    auto scheduled_latency = cbdc::histogram();
+    auto send_latency = cbdc::histogram();
+
+    using clock_type = cbdc::rate_controller::clock_type;
+    auto rate = cbdc::rate_controller(
+        static_cast<double>(per_gen_send_limit),
+        cfg.m_loadgen_poisson_arrivals
+            ? cbdc::rate_controller::arrival_distribution::poisson
+            : cbdc::rate_controller::arrival_distribution::uniform,
+        gen_id);
+    auto ramp_secs = std::chrono::duration<double, std::ratio<1, 1>>(
+        cfg.m_loadgen_tps_step_time);
+    auto ramp_step
+        = std::chrono::duration_cast<clock_type::duration>(ramp_secs);
+    auto ramping = ramp_step.count() != 0
+                && per_gen_send_limit != cfg.m_loadgen_tps_target;
+    auto next_ramp = clock_type::now() + ramp_step;
+    auto sent_count = std::atomic<uint64_t>();
+    auto gen_thread = std::thread([&]() {
+        while(running) {
+            auto scheduled = rate.next();
+            cbdc::rate_controller::wait_until(scheduled);
+
+            if(ramping && clock_type::now() >= next_ramp) {
+                next_ramp += ramp_step;
+                per_gen_send_limit
+                    = std::min(cfg.m_loadgen_tps_target,
+                               per_gen_send_limit + per_gen_step_size);
+                rate.set_rate(static_cast<double>(per_gen_send_limit));
+                logger->debug("New Send Limit:", per_gen_send_limit);
+                if(per_gen_send_limit == cfg.m_loadgen_tps_target) {
+                    ramping = false;
+                    logger->info("Reached Target Throughput");
                 }
             }
 
-            // We couldn't send a double-spend or a newly generated valid
-            // transaction, emit a warning and wait for confirmations.
-            if(!tx) {
+            // If we're out of spendable outputs, wait for responses to
+            // return some. The transaction keeps its scheduled send time so
+            // the wait counts towards its latency.
+            auto tx = make_tx();
+            if(!tx && replay) {
+                // Give in-flight transactions a chance to complete so
+                // their latencies are included in the results
+                logger->info("Corpus exhausted, waiting for responses");
+                static constexpr auto drain_timeout = std::chrono::seconds(30);
+                {
+                    std::unique_lock<std::mutex> l(outputs_mut);
+                    outputs_cv.wait_for(l, drain_timeout, [&]() {
+                        return responses >= sent_count || !running;
+                    });
+                }
+                running = false;
+                break;
+            }
+            while(!tx && running) {
                 logger->warn("Wallet out of outputs");
-                // If we couldn't send any txs this loop because we're out of
-                // spendable outputs, sleep the send thread for some time in
-                // the hope of receiving confirmations. Note, this could also
-                // be a condition variable signalled by the confirmation thread
-                // instead.
                 static constexpr auto send_delay = std::chrono::seconds(1);
-                std::this_thread::sleep_for(send_delay);
-                if(ramping) {
-                    if(send_delay >= ramp_timer) {
-                        logger->debug(
-                            "Ramp Timer Exhausted (send_delay). Resetting");
-                        ramp_timer = ramp_timer_full;
-                        per_gen_send_limit
-                            = std::min(cfg.m_loadgen_tps_target,
-                                       per_gen_send_limit + per_gen_step_size);
-                        logger->debug("New Send Limit:", per_gen_send_limit);
-                        if(per_gen_send_limit == cfg.m_loadgen_tps_target) {
-                            ramping = false;
-                            logger->info("Reached Target Throughput");
-                        }
-                    } else {
-                        ramp_timer -= send_delay;
-                    }
+                {
+                    std::unique_lock<std::mutex> l(outputs_mut);
+                    const auto seen = responses;
+                    outputs_cv.wait_for(l, send_delay, [&]() {
+                        return responses != seen || !running;
+                    });
                 }
+                tx = make_tx();
+            }
+            if(!tx) {
                 continue;
             }
 
-            auto send_time = std::chrono::high_resolution_clock::now()
-                                 .time_since_epoch()
-                                 .count();
-
+            const auto send_time = clock_type::now();
             auto res_cb
-                = [&, txn = tx.value(), send_time = send_time](
+                = [&, txn = tx.value(), scheduled, send_time](
                       cbdc::sentinel::rpc::client::execute_result_type res) {
                       auto tx_id = cbdc::transaction::tx_id(txn);
                       if(!res.has_value()) {
                           logger->warn("Failure response from sentinel for",
                                        cbdc::to_string(tx_id));
-                          wallet.confirm_inputs(txn.m_inputs);
+                          if(!replay) {
+                              wallet.confirm_inputs(txn.m_inputs);
+                          }
+                          notify_outputs();
                           return;
                       }
                       auto& sent_resp = res.value();
                       if(sent_resp.m_tx_status
                          == cbdc::sentinel::tx_status::confirmed) {
-                          wallet.confirm_transaction(txn);
+                          if(!replay) {
+                              wallet.confirm_transaction(txn);
+                          }
+                          notify_outputs();
                           second_conf_queue.push(tx_id);
-                          auto now = std::chrono::high_resolution_clock::now()
-                                         .time_since_epoch()
-                                         .count();
-                          const auto tx_delay = now - send_time;
-                          latency_log << now << " " << tx_delay << "\n";
+                          const auto now = clock_type::now();
+                          const auto scheduled_delay
+                              = std::chrono::duration_cast<
+                                    std::chrono::nanoseconds>(now - scheduled)
+                                    .count();
+                          const auto send_delay
+                              = std::chrono::duration_cast<
+                                    std::chrono::nanoseconds>(now - send_time)
+                                    .count();
+                          {
+                              std::lock_guard<std::mutex> l(latency_mut);
+                              scheduled_latency.record(
+                                  static_cast<uint64_t>(scheduled_delay));
+                              send_latency.record(
+                                  static_cast<uint64_t>(send_delay));
+                              latency_log << std::chrono::duration_cast<
+                                                 std::chrono::nanoseconds>(
+                                                 now.time_since_epoch())
+                                                 .count()
+                                          << " " << scheduled_delay << " "
+                                          << send_delay << "\n";
+                          }
                           constexpr auto max_invalid = 100000;
                           if(cfg.m_invalid_rate > 0.0) {
                               std::lock_guard<std::mutex> l(confirmed_txs_mut);
@@ -365,7 +413,10 @@ auto main(int argc, char** argv) -> int {
                           }
                       } else {
                           logger->warn(cbdc::to_string(tx_id), "had error");
-                          wallet.confirm_inputs(txn.m_inputs);
+                          if(!replay) {
+                              wallet.confirm_inputs(txn.m_inputs);
+                          }
+                          notify_outputs();
                           // TODO: in some cases we should retry the TX here
                       }
                   };
@@ -373,29 +424,12 @@ auto main(int argc, char** argv) -> int {
             if(!sentinel_client.execute_transaction(tx.value(),
                                                     std::move(res_cb))) {
                 logger->error("Failure sending transaction to sentinel");
-                wallet.confirm_inputs(tx.value().m_inputs);
-            }
-
-            auto gap = std::chrono::nanoseconds(send_gap);
-            if(gap < std::chrono::seconds(1)) {
-                std::this_thread::sleep_for(gap);
-                if(ramping) {
-                    if(gap >= ramp_timer) {
-                        logger->debug("Ramp Timer Exhausted (gap). Resetting");
-                        ramp_timer = ramp_timer_full;
-                        per_gen_send_limit
-                            = std::min(cfg.m_loadgen_tps_target,
-                                       per_gen_send_limit + per_gen_step_size);
-                        logger->debug("New Send Limit:", per_gen_send_limit);
-                        if(per_gen_send_limit == cfg.m_loadgen_tps_target) {
-                            ramping = false;
-                            logger->info("Reached Target Throughput");
-                        }
-                    } else {
-                        ramp_timer -= gap;
-                    }
+                if(!replay) {
+                    wallet.confirm_inputs(tx.value().m_inputs);
                 }
+                continue;
             }
+            sent_count++;
         }
     });
 
@@ -403,15 +437,60 @@ auto main(int argc, char** argv) -> int {
         running = false;
     });
 
+    // Report the achieved send rate, which falls short of the target when
+    // the generator can't keep up with its schedule
+    uint64_t last_sent{0};
     while(running) {
         std::this_thread::sleep_for(std::chrono::seconds(1));
+        const auto sent = sent_count.load();
+        logger->debug("Sent", sent - last_sent, "TX/s");
+        last_sent = sent;
     }
 
+    {
+        std::lock_guard<std::mutex> l(outputs_mut);
+    }
+    outputs_cv.notify_all();
     gen_thread.join();
     second_conf_queue.clear();
     for(auto& thr : second_conf_thrs) {
         thr.join();
     }
 
+    {
+        std::lock_guard<std::mutex> l(latency_mut);
+        latency_log.flush();
+        std::ofstream percentile_log("tx_latency_" + std::to_string(gen_id)
+                                     + ".txt");
+        static constexpr auto percentiles
+            = std::array{50.0, 90.0, 99.0, 99.9, 99.99, 100.0};
+        for(const auto p : percentiles) {
+            percentile_log << p << " " << scheduled_latency.percentile(p)
+                           << " " << send_latency.percentile(p) << "\n";
+        }
+        static constexpr auto ns_per_ms = 1e6;
+        auto to_ms = [](uint64_t ns) {
+            return static_cast<double>(ns) / ns_per_ms;
+        };
+        logger->info("Confirmed",
+                     scheduled_latency.count(),
+                     "TXs. Latency from scheduled send (ms): p50",
+                     to_ms(scheduled_latency.percentile(50.0)),
+                     "p99",
+                     to_ms(scheduled_latency.percentile(99.0)),
+                     "p999",
+                     to_ms(scheduled_latency.percentile(99.9)),
+                     "max",
+                     to_ms(scheduled_latency.max()));
+        logger->info("Latency from actual send (ms): p50",
+                     to_ms(send_latency.percentile(50.0)),
+                     "p99",
+                     to_ms(send_latency.percentile(99.0)),
+                     "p999",
+                     to_ms(send_latency.percentile(99.9)),
+                     "max",
+                     to_ms(send_latency.max()));
+    }
+
     return 0;
 }
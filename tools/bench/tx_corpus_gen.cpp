@@ -0,0 +1,181 @@
+// Copyright (c) 2021 MIT Digital Currency Initiative,
+//                    Federal Reserve Bank of Boston
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "uhs/transaction/corpus.hpp"
+#include "uhs/transaction/messages.hpp"
+#include "uhs/transaction/validation.hpp"
+#include "uhs/transaction/wallet.hpp"
+#include "util/common/config.hpp"
+#include "util/common/logging.hpp"
+#include "util/serialization/format.hpp"
+#include "util/serialization/util.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+// Pre-generates signed transactions spending a loadgen's share of the
+// pre-seeded outputs. Shards seeded by shard-seeder from the same config
+// hold every output the corpus spends, so the load generators can replay
+// the corpus without generating or signing transactions themselves.
+auto main(int argc, char** argv) -> int {
+    auto args = cbdc::config::get_args(argc, argv);
+    if(args.size() < 4) {
+        std::cerr << "Usage: " << args[0]
+                  << " <config file> <gen ID> <corpus file> [<threads>]"
+                  << std::endl;
+        return -1;
+    }
+
+    auto cfg_or_err = cbdc::config::load_options(args[1]);
+    if(std::holds_alternative<std::string>(cfg_or_err)) {
+        std::cerr << "Error loading config file: "
+                  << std::get<std::string>(cfg_or_err) << std::endl;
+        return -1;
+    }
+    auto cfg = std::get<cbdc::config::options>(cfg_or_err);
+
+    auto gen_id = std::stoull(args[2]);
+    if(gen_id >= cfg.m_loadgen_count) {
+        std::cerr << "Gen ID not in config file" << std::endl;
+        return -1;
+    }
+
+    auto logger = std::make_shared<cbdc::logging::log>(
+        cfg.m_loadgen_loglevels[gen_id]);
+
+    if(cfg.m_seed_from == cfg.m_seed_to || !cfg.m_seed_privkey.has_value()) {
+        logger->error("A corpus requires pre-seeded outputs and a seed "
+                      "private key");
+        return -1;
+    }
+
+    auto n_threads = static_cast<size_t>(
+        std::max(std::thread::hardware_concurrency(), 1U));
+    if(args.size() > 4) {
+        n_threads = std::max(std::stoull(args[4]), 1ULL);
+    }
+
+    auto [range_start, range_end]
+        = cbdc::config::loadgen_seed_range(cfg, gen_id);
+
+    auto secp = std::unique_ptr<secp256k1_context,
+                                decltype(&secp256k1_context_destroy)>(
+        secp256k1_context_create(SECP256K1_CONTEXT_SIGN),
+        &secp256k1_context_destroy);
+    auto seed = cbdc::transaction::corpus_seed();
+    seed.m_seed_from = range_start;
+    seed.m_seed_to = range_end;
+    seed.m_seed_value = cfg.m_seed_value;
+    seed.m_seed_witness_commitment
+        = cbdc::transaction::validation::get_p2pk_witness_commitment(
+            cbdc::pubkey_from_privkey(cfg.m_seed_privkey.value(),
+                                      secp.get()));
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // Each thread spends a contiguous slice of the seed range with its own
+    // wallet, so the transactions are independent of each other and can be
+    // replayed in any order
+    auto n_seeds = range_end - range_start;
+    n_threads = std::min(n_threads, std::max(n_seeds, size_t{1}));
+    auto per_thread = n_seeds / n_threads;
+    auto txs = std::vector<std::vector<cbdc::buffer>>(n_threads);
+    auto failed = std::atomic<bool>(false);
+    auto threads = std::vector<std::thread>();
+    for(size_t t = 0; t < n_threads; t++) {
+        threads.emplace_back([&, t]() {
+            auto from = range_start + t * per_thread;
+            auto to = t == n_threads - 1 ? range_end : from + per_thread;
+            auto wallet = cbdc::transaction::wallet();
+            if(!wallet.seed(cfg.m_seed_privkey.value(),
+                            cfg.m_seed_value,
+                            from,
+                            to)) {
+                logger->error("Failed to seed wallet for range",
+                              from,
+                              "-",
+                              to);
+                failed = true;
+                return;
+            }
+
+            static constexpr auto send_amt = 5;
+            auto payee = wallet.generate_key();
+            while(true) {
+                auto tx = std::optional<cbdc::transaction::full_tx>();
+                if(cfg.m_fixed_tx_mode) {
+                    tx = wallet.send_to(cfg.m_input_count,
+                                        cfg.m_output_count,
+                                        payee,
+                                        true);
+                } else {
+                    tx = wallet.send_to(send_amt, payee, true);
+                }
+                if(!tx.has_value()) {
+                    break;
+                }
+                txs[t].push_back(cbdc::make_buffer(tx.value()));
+            }
+        });
+    }
+    for(auto& thread : threads) {
+        thread.join();
+    }
+
+    // Remove any partial or stale corpus so a failed run cannot be
+    // mistaken for a complete one
+    auto remove_corpus = [&]() {
+        auto err = std::error_code();
+        std::filesystem::remove(args[3], err);
+    };
+
+    if(failed) {
+        logger->error("Failed to generate corpus for seeds",
+                      range_start,
+                      "-",
+                      range_end);
+        remove_corpus();
+        return -1;
+    }
+
+    size_t count{0};
+    auto written = [&]() {
+        auto writer = cbdc::transaction::corpus_writer(args[3], seed);
+        for(auto& thread_txs : txs) {
+            for(auto& tx : thread_txs) {
+                if(!writer.add(tx)) {
+                    return false;
+                }
+                count++;
+            }
+            thread_txs.clear();
+        }
+        return writer.finish();
+    }();
+    if(!written) {
+        logger->error("Failed to write corpus file", args[3]);
+        remove_corpus();
+        return -1;
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    logger->info("Wrote",
+                 count,
+                 "transactions spending seeds",
+                 range_start,
+                 "-",
+                 range_end,
+                 "to",
+                 args[3],
+                 "in",
+                 elapsed.count(),
+                 "ms");
+
+    return 0;
+}
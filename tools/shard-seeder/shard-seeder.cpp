@@ -3,6 +3,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include "crypto/sha256.h"
 #include "uhs/transaction/transaction.hpp"
 #include "uhs/transaction/validation.hpp"
 #include "uhs/transaction/wallet.hpp"
@@ -22,6 +23,8 @@ static constexpr int leveldb_buffer_size
     = 16 * 1024 * 1024; // 16MB can hold ~ 500K UHS_IDs
 static constexpr int write_batch_size
     = 450000; // well within the write buffer size
+static constexpr size_t hash_batch_size
+    = 1024; // seeded outputs hashed together
 
 auto get_2pc_uhs_key(const cbdc::hash_t& uhs_id) -> std::string {
     auto ret = std::string();
@@ -48,6 +51,9 @@ auto main(int argc, char** argv) -> int {
     }
     auto cfg = std::get<cbdc::config::options>(cfg_or_err);
 
+    std::string sha2_impl(SHA256AutoDetect());
+    logger.info("using sha2:", sha2_impl);
+
     auto start = std::chrono::system_clock::now();
 
     auto unique_ranges
@@ -89,6 +95,34 @@ auto main(int argc, char** argv) -> int {
                         cbdc::config::shard_range_t::first_type>::max();
                 }
 
+                // Calls fn with the UHS ID of each seeded output in the
+                // shard's range. Seeded transactions are converted in
+                // batches so their outputs can be hashed together.
+                auto for_each_seed = [&](const auto& fn) {
+                    auto tx = wal.create_seeded_transaction(0).value();
+                    auto batch = std::vector<cbdc::transaction::full_tx>();
+                    for(size_t batch_start = 0; batch_start < num_utxos;
+                        batch_start += hash_batch_size) {
+                        const auto batch_end
+                            = std::min(batch_start + hash_batch_size,
+                                       static_cast<size_t>(num_utxos));
+                        batch.clear();
+                        for(size_t tx_idx = batch_start; tx_idx != batch_end;
+                            tx_idx++) {
+                            tx.m_inputs[0].m_prevout.m_index = tx_idx;
+                            batch.push_back(tx);
+                        }
+                        for(const auto& ctx :
+                            cbdc::transaction::compact_txs(batch)) {
+                            const auto& output_hash = ctx.m_uhs_outputs[0];
+                            if(output_hash[0] >= shard_start
+                               && output_hash[0] <= shard_end) {
+                                fn(output_hash);
+                            }
+                        }
+                    }
+                };
+
                 std::stringstream shard_db_dir;
                 if(cfg.m_twophase_mode) {
                     shard_db_dir << "2pc_";
@@ -123,30 +157,23 @@ auto main(int argc, char** argv) -> int {
                         return;
                     }
 
-                    auto tx = wal.create_seeded_transaction(0).value();
                     auto batch_size = 0;
                     leveldb::WriteBatch batch;
-                    for(size_t tx_idx = 0; tx_idx != num_utxos; tx_idx++) {
-                        tx.m_inputs[0].m_prevout.m_index = tx_idx;
-                        cbdc::transaction::compact_tx ctx(tx);
-                        const cbdc::hash_t& output_hash = ctx.m_uhs_outputs[0];
-                        if(output_hash[0] >= shard_start
-                           && output_hash[0] <= shard_end) {
-                            std::array<char, sizeof(output_hash)> hash_arr{};
-                            std::memcpy(hash_arr.data(),
-                                        output_hash.data(),
-                                        sizeof(output_hash));
-                            leveldb::Slice hash_key(hash_arr.data(),
-                                                    output_hash.size());
-                            batch.Put(hash_key, leveldb::Slice());
-                            batch_size++;
-                            if(batch_size >= write_batch_size) {
-                                db->Write(wopt, &batch);
-                                batch.Clear();
-                                batch_size = 0;
-                            }
+                    for_each_seed([&](const cbdc::hash_t& output_hash) {
+                        std::array<char, sizeof(output_hash)> hash_arr{};
+                        std::memcpy(hash_arr.data(),
+                                    output_hash.data(),
+                                    sizeof(output_hash));
+                        leveldb::Slice hash_key(hash_arr.data(),
+                                                output_hash.size());
+                        batch.Put(hash_key, leveldb::Slice());
+                        batch_size++;
+                        if(batch_size >= write_batch_size) {
+                            db->Write(wopt, &batch);
+                            batch.Clear();
+                            batch_size = 0;
                         }
-                    }
+                    });
                     if(batch_size > 0) {
                         db->Write(wopt, &batch);
                     }
@@ -158,17 +185,10 @@ auto main(int argc, char** argv) -> int {
                     // write dummy size
                     auto ser = cbdc::ostream_serializer(out);
                     ser << count;
-                    auto tx = wal.create_seeded_transaction(0).value();
-                    for(size_t tx_idx = 0; tx_idx != num_utxos; tx_idx++) {
-                        tx.m_inputs[0].m_prevout.m_index = tx_idx;
-                        cbdc::transaction::compact_tx ctx(tx);
-                        const cbdc::hash_t& output_hash = ctx.m_uhs_outputs[0];
-                        if(output_hash[0] >= shard_start
-                           && output_hash[0] <= shard_end) {
-                            ser << output_hash;
-                            count++;
-                        }
-                    }
+                    for_each_seed([&](const cbdc::hash_t& output_hash) {
+                        ser << output_hash;
+                        count++;
+                    });
                     ser.reset();
                     ser << count;
                 }